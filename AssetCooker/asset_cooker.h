@@ -0,0 +1,515 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <future>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <cstdlib>
+
+#define GLFW_INCLUDE_NONE
+#include <glfw3.h>
+#include <glad.h>
+#include <glm.hpp>
+#include <gtc/matrix_transform.hpp>
+#include <gtc/type_ptr.hpp>
+#include <gtc/constants.hpp>
+
+#include "model.h"
+#include "cooked_asset.h"
+#include "mesh_optimizer.h"
+#include "cluster_lod.h"
+#include "thread_pool.h"
+
+// Bump when cooked output of unchanged sources changes (invalidates the whole cache)
+#define ASSET_COOKER_VERSION "3"
+
+enum class AssetType
+{
+	Mesh,
+	Texture,
+	Shader,
+	ClusterLOD
+};
+
+struct CookSettings
+{
+	std::string packPath;			// Also write every cooked file into this asset pack
+	bool validateShaders = true;	// Compile shaders with the OpenGL driver
+	bool buildClusterLOD = false;	// Also cook meshes into streamed cluster hierarchies
+	unsigned threadCount = 0;		// 0 = hardware threads
+};
+
+// Converts source assets under Assets/ and Shaders/ into runtime formats under Cooked/.
+// Outputs are stored in content addressed cache, so unchanged (or reverted) inputs are not cooked again
+class AssetCooker
+{
+private:
+	enum class CookStatus
+	{
+		UpToDate,
+		FromCache,
+		Cooked,
+		Failed
+	};
+
+	struct CookJob
+	{
+		AssetType type = AssetType::Mesh;
+		std::string sourcePath;
+		std::string outputPath;
+	};
+
+	struct CookResult
+	{
+		CookStatus status = CookStatus::Failed;
+		uint64_t hash = 0;
+		std::vector<unsigned char> shaderSource;	// Shaders are validated and written on the main thread
+	};
+
+	CookSettings _settings;
+	std::string _cacheDirectory;
+	std::map<std::string, uint64_t> _manifest;		// Output path -> content hash of last successful cook
+
+public:
+	explicit AssetCooker(const CookSettings& settings)
+		: _settings(settings), _cacheDirectory(std::string(CookedAssets::CookedRoot) + "/.cache") {
+	}
+
+	// Returns false if any asset failed
+	bool run()
+	{
+		std::vector<CookJob> jobs = collectJobs();
+		loadManifest();
+
+		std::cout << "Cooking " << jobs.size() << " assets" << "\n";
+
+		std::filesystem::create_directories(_cacheDirectory + "/objects");
+
+		// Every asset is cooked on the worker threads
+		std::vector<std::future<CookResult>> futures;
+		{
+			ThreadPool workers(_settings.threadCount ? _settings.threadCount : std::max(1u, std::thread::hardware_concurrency()));
+
+			for (const auto& job : jobs)
+			{
+				auto task = std::make_shared<std::packaged_task<CookResult()>>([this, job]() { return cook(job); });
+				futures.push_back(task->get_future());
+				workers.submit([task]() { (*task)(); });
+			}
+		}
+
+		std::vector<CookResult> results;
+		for (auto& future : futures)
+			results.push_back(future.get());
+
+		finishShaders(jobs, results);
+
+		size_t counts[4] = {};
+		std::map<std::string, uint64_t> manifest;
+
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			counts[static_cast<int>(results[i].status)]++;
+			if (results[i].status != CookStatus::Failed)
+				manifest[jobs[i].outputPath] = results[i].hash;
+		}
+
+		_manifest = std::move(manifest);
+		saveManifest();
+
+		std::cout << "Cooked: " << counts[static_cast<int>(CookStatus::Cooked)]
+			<< ", from cache: " << counts[static_cast<int>(CookStatus::FromCache)]
+			<< ", up to date: " << counts[static_cast<int>(CookStatus::UpToDate)]
+			<< ", failed: " << counts[static_cast<int>(CookStatus::Failed)] << "\n";
+
+		bool success = counts[static_cast<int>(CookStatus::Failed)] == 0;
+
+		if (!_settings.packPath.empty())
+			success = writePack(jobs, results) && success;
+
+		return success;
+	}
+
+private:
+	std::vector<CookJob> collectJobs() const
+	{
+		std::vector<CookJob> jobs;
+
+		for (const char* root : { "Assets", "Shaders" })
+		{
+			std::error_code error;
+			if (!std::filesystem::is_directory(root, error))
+				continue;
+
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(root))
+			{
+				if (!entry.is_regular_file())
+					continue;
+
+				std::string path = entry.path().generic_string();
+				std::string extension = entry.path().extension().string();
+				std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+				CookJob job;
+				job.sourcePath = path;
+
+				if (extension == ".obj")
+				{
+					job.type = AssetType::Mesh;
+					job.outputPath = CookedAssets::getCookedMeshPath(path);
+				}
+				else if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp")
+				{
+					job.type = AssetType::Texture;
+					job.outputPath = CookedAssets::getCookedTexturePath(path);
+				}
+				else if (extension == ".vert" || extension == ".frag" || extension == ".geom" || extension == ".comp")
+				{
+					job.type = AssetType::Shader;
+					job.outputPath = CookedAssets::getCookedPath(path);
+				}
+				else
+				{
+					continue;
+				}
+
+				jobs.push_back(job);
+
+				// Same source, second output
+				if (job.type == AssetType::Mesh && _settings.buildClusterLOD)
+				{
+					job.type = AssetType::ClusterLOD;
+					job.outputPath = CookedAssets::getCookedClusterLODPath(path);
+					jobs.push_back(job);
+				}
+			}
+		}
+
+		// Stable order keeps logs and packs reproducible
+		std::sort(jobs.begin(), jobs.end(), [](const CookJob& a, const CookJob& b) { return a.sourcePath < b.sourcePath; });
+		return jobs;
+	}
+
+	CookResult cook(const CookJob& job) const
+	{
+		CookResult result;
+
+		std::vector<unsigned char> source;
+		if (!readFile(job.sourcePath, source))
+		{
+			std::cerr << "ERROR::ASSET_COOKER::READ_FAILED - " << job.sourcePath << "\n";
+			return result;
+		}
+
+		// Included files are part of preprocessed source, so they are covered by the hash
+		if (job.type == AssetType::Shader)
+		{
+			std::string preprocessed;
+			std::set<std::string> includeStack;
+			if (!Shader::preprocess(job.sourcePath, preprocessed, includeStack))
+				return result;
+
+			source.assign(preprocessed.begin(), preprocessed.end());
+		}
+
+		result.hash = hashContent(job.type, source);
+
+		if (job.type == AssetType::Shader)
+		{
+			result.shaderSource = std::move(source);
+			result.status = CookStatus::Cooked;
+			return result;
+		}
+
+		auto manifestEntry = _manifest.find(job.outputPath);
+		if (manifestEntry != _manifest.end() && manifestEntry->second == result.hash && std::filesystem::exists(job.outputPath))
+		{
+			result.status = CookStatus::UpToDate;
+			return result;
+		}
+
+		std::string objectPath = getObjectPath(result.hash);
+		std::vector<unsigned char> cooked;
+
+		if (readFile(objectPath, cooked))
+		{
+			result.status = writeFile(job.outputPath, cooked) ? CookStatus::FromCache : CookStatus::Failed;
+			return result;
+		}
+
+		AssetBlob blob(std::move(source));
+
+		if (job.type == AssetType::Mesh)
+			cooked = cookMesh(blob, job.sourcePath);
+		else if (job.type == AssetType::ClusterLOD)
+			cooked = cookClusterLOD(blob, job.sourcePath);
+		else
+			cooked = cookTexture(blob, job.sourcePath);
+
+		if (cooked.empty() || !writeFile(objectPath, cooked) || !writeFile(job.outputPath, cooked))
+		{
+			std::cerr << "ERROR::ASSET_COOKER::COOK_FAILED - " << job.sourcePath << "\n";
+			return result;
+		}
+
+		result.status = CookStatus::Cooked;
+		return result;
+	}
+
+	// Welded, cache optimized, meshlet split and fetch ordered binary meshes
+	static std::vector<unsigned char> cookMesh(const AssetBlob& source, const std::string& path)
+	{
+		std::vector<MeshData> meshes = Model::parseMeshData(source, path);
+		if (meshes.empty())
+			return {};
+
+		for (auto& mesh : meshes)
+		{
+			size_t sourceVertexCount = mesh.vertices.size();
+			float sourceACMR = MeshOptimizer::computeACMR(mesh.indices, mesh.vertices.size());
+
+			MeshOptimizer::weldVertices(mesh.vertices, mesh.indices);
+			MeshOptimizer::optimizeVertexCache(mesh.indices, mesh.vertices.size());
+
+			// Fetch ordering only remaps vertices, meshlet index ranges stay valid
+			mesh.meshlets = MeshletBuilder::build(mesh.vertices, mesh.indices);
+			MeshOptimizer::optimizeVertexFetch(mesh.vertices, mesh.indices);
+
+			std::cout << "  " << path << ": vertices " << sourceVertexCount << " -> " << mesh.vertices.size()
+				<< ", ACMR " << std::fixed << std::setprecision(2) << sourceACMR << " -> " << MeshOptimizer::computeACMR(mesh.indices, mesh.vertices.size())
+				<< ", meshlets " << mesh.meshlets.size() << "\n";
+		}
+
+		return CookedAssets::encodeMeshes(meshes);
+	}
+
+	// All shapes of the mesh in one cluster hierarchy, paged for streaming
+	static std::vector<unsigned char> cookClusterLOD(const AssetBlob& source, const std::string& path)
+	{
+		std::vector<MeshData> meshes = Model::parseMeshData(source, path);
+		if (meshes.empty())
+			return {};
+
+		MeshData merged;
+		for (const auto& mesh : meshes)
+		{
+			unsigned baseVertex = static_cast<unsigned>(merged.vertices.size());
+			merged.vertices.insert(merged.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+			for (unsigned index : mesh.indices)
+				merged.indices.push_back(baseVertex + index);
+		}
+
+		MeshOptimizer::weldVertices(merged.vertices, merged.indices);
+		std::vector<unsigned char> cooked = ClusterLODBuilder::build(merged.vertices, merged.indices);
+
+		std::cout << "  " << path << ": cluster LOD of " << merged.indices.size() / 3 << " triangles, " << cooked.size() << " bytes" << "\n";
+		return cooked;
+	}
+
+	// Full RGBA8 mip chain, LZ4 compressed
+	static std::vector<unsigned char> cookTexture(const AssetBlob& source, const std::string& path)
+	{
+		TextureData texture = TextureData::decode(source, path, true);
+		if (!texture.isValid())
+			return {};
+
+		return CookedAssets::encodeTexture(texture);
+	}
+
+	// Shaders are compiled by the driver in hidden window, failed ones are not written (engine falls back to source)
+	void finishShaders(const std::vector<CookJob>& jobs, std::vector<CookResult>& results)
+	{
+		bool hasContext = _settings.validateShaders && createValidationContext();
+		if (_settings.validateShaders && !hasContext)
+			std::cout << "ASSET_COOKER::SHADER_VALIDATION_SKIPPED - OpenGL context not available" << "\n";
+
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			const CookJob& job = jobs[i];
+			CookResult& result = results[i];
+
+			if (job.type != AssetType::Shader || result.status == CookStatus::Failed)
+				continue;
+
+			auto manifestEntry = _manifest.find(job.outputPath);
+			if (manifestEntry != _manifest.end() && manifestEntry->second == result.hash && std::filesystem::exists(job.outputPath))
+			{
+				result.status = CookStatus::UpToDate;
+				continue;
+			}
+
+			std::string source(result.shaderSource.begin(), result.shaderSource.end());
+			if (hasContext && !validateShader(job.sourcePath, source))
+			{
+				std::error_code error;
+				std::filesystem::remove(job.outputPath, error);
+				result.status = CookStatus::Failed;
+				continue;
+			}
+
+			if (!writeFile(job.outputPath, result.shaderSource))
+				result.status = CookStatus::Failed;
+		}
+
+		if (hasContext)
+		{
+			glfwDestroyWindow(glfwGetCurrentContext());
+			glfwTerminate();
+		}
+	}
+
+	static bool createValidationContext()
+	{
+		if (!glfwInit())
+			return false;
+
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+		GLFWwindow* window = glfwCreateWindow(1, 1, "AssetCooker", NULL, NULL);
+		if (!window)
+		{
+			glfwTerminate();
+			return false;
+		}
+
+		glfwMakeContextCurrent(window);
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+		{
+			glfwDestroyWindow(window);
+			glfwTerminate();
+			return false;
+		}
+
+		return true;
+	}
+
+	static bool validateShader(const std::string& path, const std::string& source)
+	{
+		std::string extension = std::filesystem::path(path).extension().string();
+
+		GLenum type = GL_VERTEX_SHADER;
+		if (extension == ".frag") type = GL_FRAGMENT_SHADER;
+		else if (extension == ".geom") type = GL_GEOMETRY_SHADER;
+		else if (extension == ".comp") type = GL_COMPUTE_SHADER;
+
+		GLuint shader = glCreateShader(type);
+		const char* code = source.c_str();
+		glShaderSource(shader, 1, &code, NULL);
+		glCompileShader(shader);
+
+		GLint success = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+		if (!success)
+		{
+			char infoLog[1024];
+			glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+			std::cerr << "ERROR::ASSET_COOKER::SHADER_COMPILATION_FAILED - " << path << "\n" << infoLog << "\n";
+		}
+
+		glDeleteShader(shader);
+		return success;
+	}
+
+	bool writePack(const std::vector<CookJob>& jobs, const std::vector<CookResult>& results) const
+	{
+		AssetPackWriter writer;
+
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			if (results[i].status == CookStatus::Failed)
+				continue;
+
+			// Cooked textures are LZ4 compressed already, cluster LOD pages too and they are read in place
+			PackCompression compression = (jobs[i].type == AssetType::Texture || jobs[i].type == AssetType::ClusterLOD) ? PackCompression::None : PackCompression::LZ4;
+			if (!writer.addFile(jobs[i].outputPath, jobs[i].outputPath, compression))
+				return false;
+		}
+
+		if (!writer.write(_settings.packPath))
+			return false;
+
+		std::cout << "Written asset pack: " << _settings.packPath << "\n";
+		return true;
+	}
+
+	static uint64_t hashContent(AssetType type, const std::vector<unsigned char>& data)
+	{
+		std::string salt = std::string(ASSET_COOKER_VERSION) + "|" + std::to_string(static_cast<int>(type));
+		uint64_t hash = hashFNV1a(salt.data(), salt.size());
+		return hashFNV1a(data.data(), data.size(), hash);
+	}
+
+	std::string getObjectPath(uint64_t hash) const
+	{
+		std::ostringstream name;
+		name << std::hex << std::setw(16) << std::setfill('0') << hash;
+		return _cacheDirectory + "/objects/" + name.str();
+	}
+
+	void loadManifest()
+	{
+		std::ifstream file(_cacheDirectory + "/manifest.txt");
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			size_t separator = line.find(' ');
+			if (separator == std::string::npos)
+				continue;
+
+			_manifest[line.substr(separator + 1)] = std::strtoull(line.substr(0, separator).c_str(), nullptr, 16);
+		}
+	}
+
+	void saveManifest() const
+	{
+		std::ofstream file(_cacheDirectory + "/manifest.txt", std::ios::trunc);
+		for (const auto& [path, hash] : _manifest)
+			file << std::hex << std::setw(16) << std::setfill('0') << hash << " " << path << "\n";
+	}
+
+	static bool readFile(const std::string& path, std::vector<unsigned char>& data)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	// Written to temporary file first, so interrupted cook never leaves truncated output
+	static bool writeFile(const std::string& path, const std::vector<unsigned char>& data)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+		// Same content can be written by two workers at once (e.g. duplicate source files)
+		std::string temporaryPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+				return false;
+
+			file.write(reinterpret_cast<const char*>(data.data()), data.size());
+			if (!file.good())
+				return false;
+		}
+
+		std::filesystem::rename(temporaryPath, path, error);
+		return !error;
+	}
+};
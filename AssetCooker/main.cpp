@@ -0,0 +1,43 @@
+#define STB_IMAGE_IMPLEMENTATION
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "asset_cooker.h"
+
+// Usage: AssetCooker [--root <engine directory>] [--pack <pack path>] [--no-validate] [--cluster-lod] [--threads <count>]
+int main(int argc, char** argv)
+{
+	CookSettings settings;
+	std::string root = ".";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+
+		if (argument == "--root" && i + 1 < argc)
+			root = argv[++i];
+		else if (argument == "--pack" && i + 1 < argc)
+			settings.packPath = argv[++i];
+		else if (argument == "--threads" && i + 1 < argc)
+			settings.threadCount = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--no-validate")
+			settings.validateShaders = false;
+		else if (argument == "--cluster-lod")
+			settings.buildClusterLOD = true;
+		else
+		{
+			std::cerr << "Usage: AssetCooker [--root <engine directory>] [--pack <pack path>] [--no-validate] [--cluster-lod] [--threads <count>]" << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Paths are relative to the engine directory, same as at runtime
+	std::error_code error;
+	std::filesystem::current_path(root, error);
+	if (error)
+	{
+		std::cerr << "ERROR::ASSET_COOKER::INVALID_ROOT - " << root << "\n";
+		return EXIT_FAILURE;
+	}
+
+	AssetCooker cooker(settings);
+	return cooker.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <glm.hpp>
+#include <gtc/matrix_transform.hpp>
+
+#include "test_framework.h"
+#include "aabb_tree.h"
+
+// Tree queries against the flat list cull they replace, before and after objects move
+class AABBTreeTests
+{
+private:
+	struct Scene
+	{
+		std::vector<glm::vec3> centers;
+		std::vector<float> radii;
+		std::vector<int32_t> proxies;
+		DynamicAABBTree tree;
+	};
+
+public:
+	static void run()
+	{
+		TestRunner::run("AABBTree.frustumMatchesFlatCull", frustumMatchesFlatCull);
+		TestRunner::run("AABBTree.queriesAfterMoveAndRefit", queriesAfterMoveAndRefit);
+		TestRunner::run("AABBTree.destroyedProxiesNotReported", destroyedProxiesNotReported);
+	}
+
+	// Frustum query and per-frame update throughput of the tree and of the flat list at growing object counts,
+	// camera sees about one percent of the scene
+	static void benchmark()
+	{
+		std::cout << "DynamicAABBTree\n";
+		Frustum frustum = makeFrustum();
+
+		for (size_t count : { size_t(1000), size_t(10000), size_t(100000), size_t(1000000) })
+		{
+			Scene scene = makeScene(count, 1);
+			std::string suffix = ", " + std::to_string(count / 1000) + "k objects";
+
+			std::vector<uint32_t> visible;
+			visible.reserve(count);
+
+			double flat = Benchmark::measureMilliseconds([&]() { cullFlat(scene, frustum, visible); });
+			Benchmark::report("flat list cull" + suffix, flat);
+
+			double tree = Benchmark::measureMilliseconds([&]() { cullTree(scene, frustum, visible); });
+			Benchmark::report("tree query" + suffix, tree, flat);
+
+			// Every object moves a bit each frame, like the animated objects of the demo scene
+			std::mt19937 random(2);
+			std::uniform_real_distribution<float> step(-0.05f, 0.05f);
+			std::vector<glm::vec3> offsets(count);
+			for (auto& offset : offsets)
+				offset = { step(random), step(random), step(random) };
+
+			double refit = Benchmark::measureMilliseconds([&]()
+				{
+					for (size_t i = 0; i < count; ++i)
+					{
+						scene.centers[i] += offsets[i];
+						scene.tree.refitProxy(scene.proxies[i], getBox(scene, i));
+					}
+				});
+			Benchmark::report("refitProxy all" + suffix, refit);
+
+			double move = Benchmark::measureMilliseconds([&]()
+				{
+					for (size_t i = 0; i < count; ++i)
+					{
+						scene.centers[i] += offsets[i];
+						scene.tree.moveProxy(scene.proxies[i], getBox(scene, i), offsets[i]);
+					}
+				});
+			Benchmark::report("moveProxy all" + suffix, move);
+
+			double afterUpdates = Benchmark::measureMilliseconds([&]() { cullTree(scene, frustum, visible); });
+			Benchmark::report("tree query after updates" + suffix, afterUpdates, flat);
+		}
+	}
+
+private:
+	static Frustum makeFrustum()
+	{
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		return Frustum::fromMatrix(projection * view);
+	}
+
+	static AABB getBox(const Scene& scene, size_t i)
+	{
+		glm::vec3 extent(scene.radii[i]);
+		return { scene.centers[i] - extent, scene.centers[i] + extent };
+	}
+
+	static Scene makeScene(size_t count, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+		std::uniform_real_distribution<float> radius(0.5f, 3.0f);
+
+		Scene scene;
+		for (size_t i = 0; i < count; ++i)
+		{
+			scene.centers.push_back({ position(random), position(random), position(random) });
+			scene.radii.push_back(radius(random));
+			scene.proxies.push_back(scene.tree.createProxy(getBox(scene, i), static_cast<uint32_t>(i)));
+		}
+		return scene;
+	}
+
+	static void cullFlat(const Scene& scene, const Frustum& frustum, std::vector<uint32_t>& visible)
+	{
+		visible.clear();
+		for (size_t i = 0; i < scene.centers.size(); ++i)
+		{
+			if (frustum.intersects(scene.centers[i], scene.radii[i]))
+				visible.push_back(static_cast<uint32_t>(i));
+		}
+	}
+
+	// Same as RenderWorld::cull: fat boxes from the tree, exact sphere test per reported object
+	static void cullTree(const Scene& scene, const Frustum& frustum, std::vector<uint32_t>& visible)
+	{
+		visible.clear();
+		scene.tree.queryFrustum(frustum, [&](uint32_t i)
+			{
+				if (frustum.intersects(scene.centers[i], scene.radii[i]))
+					visible.push_back(i);
+				return true;
+			});
+		std::sort(visible.begin(), visible.end());
+	}
+
+	static void frustumMatchesFlatCull()
+	{
+		Scene scene = makeScene(5000, 3);
+		Frustum frustum = makeFrustum();
+
+		std::vector<uint32_t> flat, tree;
+		cullFlat(scene, frustum, flat);
+		cullTree(scene, frustum, tree);
+
+		TEST_CHECK(!flat.empty());
+		TEST_CHECK(flat == tree);
+	}
+
+	static void queriesAfterMoveAndRefit()
+	{
+		Scene scene = makeScene(5000, 4);
+		Frustum frustum = makeFrustum();
+
+		std::mt19937 random(5);
+		std::uniform_real_distribution<float> step(-20.0f, 20.0f);
+
+		// Half of the objects are reinserted, the other half only refitted
+		for (int frame = 0; frame < 10; ++frame)
+		{
+			for (size_t i = 0; i < scene.centers.size(); ++i)
+			{
+				glm::vec3 offset(step(random), step(random), step(random));
+				scene.centers[i] += offset;
+
+				if (i % 2 == 0)
+					scene.tree.moveProxy(scene.proxies[i], getBox(scene, i), offset);
+				else
+					scene.tree.refitProxy(scene.proxies[i], getBox(scene, i));
+			}
+
+			std::vector<uint32_t> flat, tree;
+			cullFlat(scene, frustum, flat);
+			cullTree(scene, frustum, tree);
+			TEST_CHECK(flat == tree);
+		}
+
+		// Every reported box contains its object, so no object can be missed by overlap queries
+		bool isContained = true;
+		for (size_t i = 0; i < scene.centers.size(); ++i)
+			isContained &= scene.tree.getFatBounds(scene.proxies[i]).contains(getBox(scene, i));
+		TEST_CHECK(isContained);
+	}
+
+	static void destroyedProxiesNotReported()
+	{
+		Scene scene = makeScene(1000, 6);
+		for (size_t i = 0; i < scene.proxies.size(); i += 2)
+			scene.tree.destroyProxy(scene.proxies[i]);
+
+		TEST_CHECK(scene.tree.getProxyCount() == 500);
+
+		bool isOnlyOdd = true;
+		size_t reported = 0;
+		scene.tree.queryAABB({ glm::vec3(-2000.0f), glm::vec3(2000.0f) }, [&](uint32_t i)
+			{
+				isOnlyOdd &= i % 2 == 1;
+				reported++;
+				return true;
+			});
+
+		TEST_CHECK(isOnlyOdd);
+		TEST_CHECK(reported == 500);
+	}
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <cmath>
+#include <gtc/constants.hpp>
+
+#include "test_framework.h"
+#include "half_edge.h"
+
+// Topology of converted primitives and build/validate cost of HalfEdgeMesh on large meshes
+class HalfEdgeTests
+{
+public:
+	static void run()
+	{
+		TestRunner::run("HalfEdge.closedCubeTopology", closedCubeTopology);
+		TestRunner::run("HalfEdge.closedTorusTopology", closedTorusTopology);
+		TestRunner::run("HalfEdge.openPlaneBoundary", openPlaneBoundary);
+		TestRunner::run("HalfEdge.jobSystemGivesSameResult", jobSystemGivesSameResult);
+		TestRunner::run("HalfEdge.indexedRoundTrip", indexedRoundTrip);
+	}
+
+	// fromIndexed, validate and normals on 1M to 8M triangle meshes, serial and with a job system
+	static void benchmark()
+	{
+		std::cout << "HalfEdgeMesh (" << std::thread::hardware_concurrency() << " hardware threads)\n";
+		JobSystem jobSystem;
+
+		for (uint32_t rings : { 512u, 1024u, 1448u })
+		{
+			std::vector<Vertex> vertices;
+			std::vector<uint32_t> indices;
+			makeTorus(rings, rings * 2, vertices, indices);
+			std::string suffix = ", " + std::to_string(indices.size() / 3000) + "k triangles";
+
+			HalfEdgeMesh mesh;
+			double build = Benchmark::measureMilliseconds([&]() { mesh = HalfEdgeMesh::fromIndexed(vertices, indices); }, 3);
+			Benchmark::report("fromIndexed serial" + suffix, build);
+
+			double parallelBuild = Benchmark::measureMilliseconds([&]() { mesh = HalfEdgeMesh::fromIndexed(vertices, indices, &jobSystem); }, 3);
+			Benchmark::report("fromIndexed job system" + suffix, parallelBuild, build);
+
+			bool isValid = true;
+			double validate = Benchmark::measureMilliseconds([&]() { isValid &= mesh.validate(); }, 3);
+			Benchmark::report("validate serial" + suffix, validate);
+
+			double parallelValidate = Benchmark::measureMilliseconds([&]() { isValid &= mesh.validate(&jobSystem); }, 3);
+			Benchmark::report("validate job system" + suffix, parallelValidate, validate);
+
+			std::vector<glm::vec3> positions(mesh.getVertexCount());
+			for (uint32_t v = 0; v < positions.size(); ++v)
+				positions[v] = mesh.getPosition(v);
+
+			std::vector<glm::vec3> faceNormals, normals;
+			double normal = Benchmark::measureMilliseconds([&]() { mesh.computeVertexNormals(positions.data(), faceNormals, normals); }, 3);
+			Benchmark::report("vertex normals serial" + suffix, normal);
+
+			double parallelNormal = Benchmark::measureMilliseconds([&]() { mesh.computeVertexNormals(positions.data(), faceNormals, normals, &jobSystem); }, 3);
+			Benchmark::report("vertex normals job system" + suffix, parallelNormal, normal);
+
+			if (!isValid)
+				std::cerr << "ERROR::TEST::BENCHMARK - validate failed" << suffix << "\n";
+		}
+	}
+
+private:
+	// Closed grid torus, wrap around is done by indices so no welding is needed
+	static void makeTorus(uint32_t rings, uint32_t segments, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		vertices.clear();
+		indices.clear();
+		vertices.reserve(size_t(rings) * segments);
+		indices.reserve(size_t(rings) * segments * 6);
+
+		for (uint32_t i = 0; i < rings; ++i)
+		{
+			float phi = glm::two_pi<float>() * i / rings;
+			for (uint32_t j = 0; j < segments; ++j)
+			{
+				float theta = glm::two_pi<float>() * j / segments;
+				glm::vec3 tube(std::cos(theta) * std::cos(phi), std::sin(theta), std::cos(theta) * std::sin(phi));
+				glm::vec3 center(std::cos(phi), 0.0f, std::sin(phi));
+				vertices.push_back({ center + tube * 0.3f, tube, glm::vec3(1.0f), { float(j) / segments, float(i) / rings } });
+			}
+		}
+
+		for (uint32_t i = 0; i < rings; ++i)
+		{
+			for (uint32_t j = 0; j < segments; ++j)
+			{
+				uint32_t a = i * segments + j;
+				uint32_t b = ((i + 1) % rings) * segments + j;
+				uint32_t c = ((i + 1) % rings) * segments + (j + 1) % segments;
+				uint32_t d = i * segments + (j + 1) % segments;
+				indices.insert(indices.end(), { a, b, c, a, c, d });
+			}
+		}
+	}
+
+	// Face corners are welded by position, so the cube is closed with Euler characteristic 2
+	static void closedCubeTopology()
+	{
+		Cube cube;
+		HalfEdgeMesh mesh = HalfEdgeMesh::fromIndexed(cube.getVertices(), cube.getIndices());
+
+		TEST_CHECK(mesh.validate());
+		TEST_CHECK(mesh.getVertexCount() == 8);
+		TEST_CHECK(mesh.getFaceCount() == 12);
+		TEST_CHECK(mesh.getEdgeCount() == 18);
+		TEST_CHECK(mesh.countBoundaryEdges() == 0);
+	}
+
+	static void closedTorusTopology()
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		makeTorus(24, 48, vertices, indices);
+		HalfEdgeMesh mesh = HalfEdgeMesh::fromIndexed(vertices, indices);
+
+		TEST_CHECK(mesh.validate());
+		TEST_CHECK(mesh.countBoundaryEdges() == 0);
+		TEST_CHECK(mesh.getVertexCount() + mesh.getFaceCount() == mesh.getEdgeCount());
+	}
+
+	static void openPlaneBoundary()
+	{
+		Plane plane;
+		HalfEdgeMesh mesh = HalfEdgeMesh::fromIndexed(plane.getVertices(), plane.getIndices());
+
+		TEST_CHECK(mesh.validate());
+		TEST_CHECK(mesh.getVertexCount() == 4);
+		TEST_CHECK(mesh.getEdgeCount() == 5);
+		TEST_CHECK(mesh.countBoundaryEdges() == 4);
+	}
+
+	// Large enough for several batches, so jobs really split the work
+	static void jobSystemGivesSameResult()
+	{
+		JobSystem jobSystem(3);
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		makeTorus(128, 256, vertices, indices);
+
+		HalfEdgeMesh serial = HalfEdgeMesh::fromIndexed(vertices, indices);
+		HalfEdgeMesh parallel = HalfEdgeMesh::fromIndexed(vertices, indices, &jobSystem);
+
+		TEST_CHECK(parallel.validate(&jobSystem));
+		TEST_CHECK(serial.getVertexCount() == parallel.getVertexCount());
+		TEST_CHECK(serial.getEdgeCount() == parallel.getEdgeCount());
+
+		bool isSameTopology = serial.getHalfEdgeCount() == parallel.getHalfEdgeCount();
+		for (uint32_t h = 0; isSameTopology && h < serial.getHalfEdgeCount(); ++h)
+			isSameTopology = serial.getTwin(h) == parallel.getTwin(h) && serial.getEdge(h) == parallel.getEdge(h);
+		TEST_CHECK(isSameTopology);
+	}
+
+	static void indexedRoundTrip()
+	{
+		Cube cube;
+		HalfEdgeMesh mesh = HalfEdgeMesh::fromIndexed(cube.getVertices(), cube.getIndices());
+
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		mesh.toIndexed(vertices, indices);
+
+		TEST_CHECK(vertices.size() == cube.getVertices().size());
+		TEST_CHECK(indices.size() == cube.getIndices().size());
+
+		// Welded corners keep their own normals and texture coordinates
+		bool isSameCorner = indices.size() == cube.getIndices().size();
+		for (size_t i = 0; isSameCorner && i < indices.size(); ++i)
+		{
+			const Vertex& original = cube.getVertices()[cube.getIndices()[i]];
+			isSameCorner = vertices[indices[i]].normal == original.normal && vertices[indices[i]].textureCoord == original.textureCoord;
+		}
+		TEST_CHECK(isSameCorner);
+	}
+};
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <vector>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cmath>
+
+#include "test_framework.h"
+#include "job_system.h"
+
+// Dependencies, stealing, main thread jobs and parallelFor edge cases of JobSystem
+class JobSystemTests
+{
+public:
+	static void run()
+	{
+		TestRunner::run("JobSystem.dependencyRunsAfterCounter", dependencyRunsAfterCounter);
+		TestRunner::run("JobSystem.dependencyChain", dependencyChain);
+		TestRunner::run("JobSystem.finishedDependencyRunsImmediately", finishedDependencyRunsImmediately);
+		TestRunner::run("JobSystem.idleWorkersSteal", idleWorkersSteal);
+		TestRunner::run("JobSystem.mainThreadJobsFromWorkers", mainThreadJobsFromWorkers);
+		TestRunner::run("JobSystem.backgroundJobsOnWorkers", backgroundJobsOnWorkers);
+		TestRunner::run("JobSystem.parallelForEmpty", parallelForEmpty);
+		TestRunner::run("JobSystem.parallelForSingleBatch", parallelForSingleBatch);
+		TestRunner::run("JobSystem.parallelForCoversRange", parallelForCoversRange);
+		TestRunner::run("JobSystem.nestedParallelFor", nestedParallelFor);
+	}
+
+	// Throughput at 1 to 64 threads: scalable parallelFor work and scheduling overhead of tiny jobs
+	static void benchmark()
+	{
+		constexpr size_t ElementCount = 1 << 22;
+		constexpr size_t JobCount = 100000;
+
+		std::vector<float> values(ElementCount);
+		auto work = [&values](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+					values[i] = std::sqrt(float(i)) * std::sin(float(i) * 0.001f);
+			};
+
+		std::cout << "JobSystem (" << std::thread::hardware_concurrency() << " hardware threads)\n";
+
+		double serial = Benchmark::measureMilliseconds([&]() { work(0, ElementCount); });
+		Benchmark::report("parallelFor 4M elements, 1 thread (serial)", serial);
+
+		for (unsigned threads : { 2u, 4u, 8u, 16u, 32u, 64u })
+		{
+			// Calling thread is one of the threads
+			JobSystem jobSystem(threads - 1);
+
+			double parallel = Benchmark::measureMilliseconds([&]() { jobSystem.parallelFor(ElementCount, 16384, work); });
+			Benchmark::report("parallelFor 4M elements, " + std::to_string(threads) + " threads", parallel, serial);
+
+			double jobs = Benchmark::measureMilliseconds([&]()
+				{
+					JobCounter counter;
+					std::atomic<size_t> executed = 0;
+					for (size_t i = 0; i < JobCount; ++i)
+						jobSystem.run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+					jobSystem.wait(counter);
+				}, 3);
+			Benchmark::report("100k empty jobs, " + std::to_string(threads) + " threads", jobs);
+		}
+	}
+
+private:
+	static void dependencyRunsAfterCounter()
+	{
+		JobSystem jobSystem(3);
+		JobCounter first, second;
+		std::atomic<int> finished = 0;
+		std::atomic<int> seenByDependent = -1;
+
+		for (int i = 0; i < 64; ++i)
+		{
+			jobSystem.run([&finished]()
+				{
+					std::this_thread::sleep_for(std::chrono::microseconds(100));
+					finished++;
+				}, &first);
+		}
+
+		jobSystem.run([&]() { seenByDependent = finished.load(); }, &second, &first);
+		jobSystem.wait(second);
+
+		TEST_CHECK(first.isDone());
+		TEST_CHECK(seenByDependent == 64);
+	}
+
+	static void dependencyChain()
+	{
+		JobSystem jobSystem(3);
+		constexpr int Length = 32;
+
+		std::vector<std::unique_ptr<JobCounter>> counters;
+		for (int i = 0; i < Length; ++i)
+			counters.push_back(std::make_unique<JobCounter>());
+
+		std::mutex mutex;
+		std::vector<int> order;
+
+		// Every job waits for the previous one, slow jobs make sure dependents are queued while it is pending
+		for (int i = 0; i < Length; ++i)
+		{
+			JobCounter* dependency = (i > 0) ? counters[i - 1].get() : nullptr;
+			jobSystem.run([&, i]()
+				{
+					std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+					std::lock_guard<std::mutex> lock(mutex);
+					order.push_back(i);
+				}, counters[i].get(), dependency);
+		}
+
+		jobSystem.wait(*counters.back());
+
+		TEST_CHECK(order.size() == Length);
+		for (int i = 0; i < static_cast<int>(order.size()); ++i)
+			TEST_CHECK(order[i] == i);
+	}
+
+	static void finishedDependencyRunsImmediately()
+	{
+		JobSystem jobSystem(1);
+		JobCounter done, counter;
+		bool hasRun = false;
+
+		jobSystem.run([&hasRun]() { hasRun = true; }, &counter, &done);
+		jobSystem.wait(counter);
+
+		TEST_CHECK(hasRun);
+	}
+
+	static void idleWorkersSteal()
+	{
+		JobSystem jobSystem(3);
+		JobCounter counter;
+
+		std::mutex mutex;
+		std::set<std::thread::id> threads;
+		std::atomic<int> executed = 0;
+
+		// All jobs go to the main thread's deque, other threads only get them by stealing
+		for (int i = 0; i < 64; ++i)
+		{
+			jobSystem.run([&]()
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					executed++;
+
+					std::lock_guard<std::mutex> lock(mutex);
+					threads.insert(std::this_thread::get_id());
+				}, &counter);
+		}
+
+		jobSystem.wait(counter);
+
+		TEST_CHECK(executed == 64);
+		TEST_CHECK(threads.size() > 1);
+	}
+
+	static void mainThreadJobsFromWorkers()
+	{
+		JobSystem jobSystem(3);
+		JobCounter counter;
+		std::atomic<int> onMainThread = 0;
+		std::thread::id mainThread = std::this_thread::get_id();
+
+		for (int i = 0; i < 16; ++i)
+		{
+			jobSystem.run([&]()
+				{
+					jobSystem.runOnMainThread([&]()
+						{
+							if (std::this_thread::get_id() == mainThread)
+								onMainThread++;
+						}, &counter);
+				}, &counter);
+		}
+
+		jobSystem.wait(counter);
+
+		TEST_CHECK(onMainThread == 16);
+	}
+
+	// Main thread keeps waiting for frame work while background jobs are queued, it must not run them
+	static void backgroundJobsOnWorkers()
+	{
+		JobSystem jobSystem(2);
+		std::thread::id mainThread = std::this_thread::get_id();
+		std::atomic<int> onMainThread = 0;
+		std::atomic<int> executed = 0;
+
+		for (int i = 0; i < 32; ++i)
+		{
+			jobSystem.runBackground([&]()
+				{
+					std::this_thread::sleep_for(std::chrono::microseconds(500));
+					if (std::this_thread::get_id() == mainThread)
+						onMainThread++;
+					executed++;
+				});
+		}
+
+		std::atomic<size_t> covered = 0;
+		jobSystem.parallelFor(10000, 100, [&covered](size_t begin, size_t end) { covered += end - begin; });
+
+		while (executed < 32)
+		{
+			JobCounter counter;
+			jobSystem.run([]() {}, &counter);
+			jobSystem.wait(counter);
+		}
+
+		TEST_CHECK(covered == 10000);
+		TEST_CHECK(onMainThread == 0);
+	}
+
+	static void parallelForEmpty()
+	{
+		JobSystem jobSystem(3);
+		int calls = 0;
+
+		jobSystem.parallelFor(0, 64, [&calls](size_t, size_t) { calls++; });
+		TEST_CHECK(calls == 0);
+	}
+
+	// Count below the batch size runs as one call on the calling thread, zero batch size is treated as one
+	static void parallelForSingleBatch()
+	{
+		JobSystem jobSystem(3);
+		std::vector<std::pair<size_t, size_t>> calls;
+		std::thread::id caller = std::this_thread::get_id();
+		bool isOnCaller = true;
+
+		jobSystem.parallelFor(10, 64, [&](size_t begin, size_t end)
+			{
+				calls.push_back({ begin, end });
+				isOnCaller &= std::this_thread::get_id() == caller;
+			});
+
+		TEST_CHECK(calls.size() == 1 && calls[0].first == 0 && calls[0].second == 10);
+		TEST_CHECK(isOnCaller);
+
+		std::atomic<size_t> covered = 0;
+		jobSystem.parallelFor(5, 0, [&covered](size_t begin, size_t end) { covered += end - begin; });
+		TEST_CHECK(covered == 5);
+	}
+
+	static void parallelForCoversRange()
+	{
+		JobSystem jobSystem(3);
+
+		for (size_t count : { size_t(64), size_t(65), size_t(1000), size_t(100003) })
+		{
+			std::vector<std::atomic<int>> visits(count);
+			jobSystem.parallelFor(count, 64, [&visits](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; ++i)
+						visits[i]++;
+				});
+
+			bool isEachOnce = std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& value) { return value == 1; });
+			TEST_CHECK(isEachOnce);
+		}
+	}
+
+	static void nestedParallelFor()
+	{
+		JobSystem jobSystem(3);
+		std::atomic<size_t> total = 0;
+
+		jobSystem.parallelFor(16, 1, [&](size_t, size_t)
+			{
+				jobSystem.parallelFor(1000, 10, [&total](size_t begin, size_t end) { total += end - begin; });
+			});
+
+		TEST_CHECK(total == 16000);
+	}
+};
@@ -0,0 +1,63 @@
+#include <cstdlib>
+
+#include "test_framework.h"
+#include "job_system_tests.h"
+#include "aabb_tree_tests.h"
+#include "half_edge_tests.h"
+#include "subdivision_tests.h"
+
+// Usage: EngineTests [--bench] [--filter <name part>]
+int main(int argc, char** argv)
+{
+	bool runBenchmarks = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+
+		if (argument == "--bench")
+			runBenchmarks = true;
+		else if (argument == "--filter" && i + 1 < argc)
+			TestRunner::setFilter(argv[++i]);
+		else
+		{
+			std::cerr << "Usage: EngineTests [--bench] [--filter <name part>]" << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	JobSystemTests::run();
+	AABBTreeTests::run();
+	HalfEdgeTests::run();
+	SubdivisionTests::run();
+
+	if (runBenchmarks && TestRunner::isSelected("JobSystem"))
+	{
+		std::cout << "\n";
+		JobSystemTests::benchmark();
+	}
+
+	if (runBenchmarks && TestRunner::isSelected("AABBTree"))
+	{
+		std::cout << "\n";
+		AABBTreeTests::benchmark();
+	}
+
+	if (runBenchmarks && TestRunner::isSelected("HalfEdge"))
+	{
+		std::cout << "\n";
+		HalfEdgeTests::benchmark();
+	}
+
+	if (runBenchmarks && TestRunner::isSelected("Subdivision"))
+	{
+		std::cout << "\n";
+		SubdivisionTests::benchmark();
+	}
+
+	size_t failedTests = TestRunner::getFailedTestCount();
+	if (failedTests > 0)
+		std::cerr << failedTests << " test(s) failed\n";
+
+	return failedTests == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
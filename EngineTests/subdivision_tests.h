@@ -0,0 +1,213 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <cmath>
+#include <gtc/constants.hpp>
+
+#include "test_framework.h"
+#include "subdivision.h"
+
+// Stencils, topology and creases of Catmull-Clark refinement, and build/evaluate cost with and without a job system
+class SubdivisionTests
+{
+public:
+	static void run()
+	{
+		TestRunner::run("Subdivision.stencilRowsSumToOne", stencilRowsSumToOne);
+		TestRunner::run("Subdivision.jobSystemGivesSameResult", jobSystemGivesSameResult);
+		TestRunner::run("Subdivision.cubeLevelOneCounts", cubeLevelOneCounts);
+		TestRunner::run("Subdivision.infiniteCreaseKeepsCageEdge", infiniteCreaseKeepsCageEdge);
+	}
+
+	// build and evaluate of the finest level of a torus cage, serial and with a job system
+	static void benchmark()
+	{
+		std::cout << "SubdivisionSurface (" << std::thread::hardware_concurrency() << " hardware threads)\n";
+		JobSystem jobSystem;
+		SubdivisionCage cage = makeTorusCage(32, 64);
+
+		for (int maxLevel : { 3, 4 })
+		{
+			std::string suffix = ", level " + std::to_string(maxLevel);
+
+			SubdivisionSurface surface;
+			double build = Benchmark::measureMilliseconds([&]() { surface.build(cage, nullptr, maxLevel); }, 3);
+			Benchmark::report("build serial" + suffix, build);
+
+			double parallelBuild = Benchmark::measureMilliseconds([&]() { surface.build(cage, &jobSystem, maxLevel); }, 3);
+			Benchmark::report("build job system" + suffix, parallelBuild, build);
+
+			std::vector<Vertex> vertices;
+			double evaluate = Benchmark::measureMilliseconds([&]() { surface.evaluate(maxLevel, cage.positions, vertices); });
+			Benchmark::report("evaluate serial" + suffix, evaluate);
+
+			double parallelEvaluate = Benchmark::measureMilliseconds([&]() { surface.evaluate(maxLevel, cage.positions, vertices, &jobSystem); });
+			Benchmark::report("evaluate job system" + suffix, parallelEvaluate, evaluate);
+		}
+	}
+
+private:
+	// Unit cube of quads facing outwards, no texture coordinates
+	static SubdivisionCage makeCubeCage()
+	{
+		SubdivisionCage cage;
+		for (int i = 0; i < 8; ++i)
+			cage.positions.push_back(glm::vec3((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f));
+
+		cage.faceVertices = { 0, 2, 3, 1,  4, 5, 7, 6,  0, 1, 5, 4,  2, 6, 7, 3,  0, 4, 6, 2,  1, 3, 7, 5 };
+		cage.faceSizes.assign(6, 4);
+		return cage;
+	}
+
+	// Closed grid torus of quads, wrap around is done by indices
+	static SubdivisionCage makeTorusCage(uint32_t rings, uint32_t segments)
+	{
+		SubdivisionCage cage;
+		for (uint32_t i = 0; i < rings; ++i)
+		{
+			float phi = glm::two_pi<float>() * i / rings;
+			for (uint32_t j = 0; j < segments; ++j)
+			{
+				float theta = glm::two_pi<float>() * j / segments;
+				glm::vec3 tube(std::cos(theta) * std::cos(phi), std::sin(theta), std::cos(theta) * std::sin(phi));
+				cage.positions.push_back(glm::vec3(std::cos(phi), 0.0f, std::sin(phi)) + tube * 0.3f);
+			}
+		}
+
+		for (uint32_t i = 0; i < rings; ++i)
+		{
+			for (uint32_t j = 0; j < segments; ++j)
+			{
+				uint32_t next = (i + 1) % rings;
+				uint32_t nextSegment = (j + 1) % segments;
+				cage.faceVertices.insert(cage.faceVertices.end(), { i * segments + j, next * segments + j, next * segments + nextSegment, i * segments + nextSegment });
+				cage.faceSizes.push_back(4);
+			}
+		}
+		return cage;
+	}
+
+	// Every subdivided point is an affine combination of cage points
+	static void stencilRowsSumToOne()
+	{
+		SubdivisionCage cage = makeCubeCage();
+		cage.creaseEdges = { { 0, 1 }, { 1, 3 } };
+		cage.creaseSharpness = { 1.5f, SubdivisionCage::InfiniteSharpness };
+
+		SubdivisionSurface surface;
+		TEST_CHECK(surface.build(cage, nullptr, 3));
+
+		bool isAffine = true;
+		for (int level = 0; level <= surface.getMaxLevel(); ++level)
+		{
+			const StencilTable& stencils = surface.getStencils(level);
+			isAffine &= stencils.getRowCount() == surface.getTopology(level).getVertexCount();
+
+			for (size_t row = 0; isAffine && row < stencils.getRowCount(); ++row)
+			{
+				float sum = 0.0f;
+				for (uint32_t k = stencils.offsets[row]; k < stencils.offsets[row + 1]; ++k)
+					sum += stencils.weights[k];
+				isAffine = std::abs(sum - 1.0f) < 1e-4f;
+			}
+		}
+		TEST_CHECK(isAffine);
+	}
+
+	// Large enough for several batches, so jobs really split the work
+	static void jobSystemGivesSameResult()
+	{
+		JobSystem jobSystem(3);
+		SubdivisionCage cage = makeTorusCage(16, 32);
+
+		SubdivisionSurface serial, parallel;
+		TEST_CHECK(serial.build(cage, nullptr, 3));
+		TEST_CHECK(parallel.build(cage, &jobSystem, 3));
+		TEST_CHECK(serial.getMaxLevel() == parallel.getMaxLevel());
+
+		bool isSameStencils = true;
+		for (int level = 0; isSameStencils && level <= serial.getMaxLevel(); ++level)
+		{
+			const StencilTable& a = serial.getStencils(level);
+			const StencilTable& b = parallel.getStencils(level);
+			isSameStencils = a.offsets == b.offsets && a.indices == b.indices && a.weights == b.weights
+				&& serial.getIndices(level) == parallel.getIndices(level);
+		}
+		TEST_CHECK(isSameStencils);
+
+		std::vector<Vertex> serialVertices, parallelVertices;
+		serial.evaluate(3, cage.positions, serialVertices);
+		parallel.evaluate(3, cage.positions, parallelVertices, &jobSystem);
+
+		bool isSameVertices = serialVertices.size() == parallelVertices.size();
+		for (size_t i = 0; isSameVertices && i < serialVertices.size(); ++i)
+			isSameVertices = serialVertices[i].position == parallelVertices[i].position && serialVertices[i].normal == parallelVertices[i].normal;
+		TEST_CHECK(isSameVertices);
+	}
+
+	// Vertex points, edge points and face points of the cage, every quad split into four
+	static void cubeLevelOneCounts()
+	{
+		SubdivisionSurface surface;
+		TEST_CHECK(surface.build(makeCubeCage(), nullptr, 1));
+
+		const HalfEdgeMesh& topology = surface.getTopology(1);
+		TEST_CHECK(topology.validate());
+		TEST_CHECK(topology.getVertexCount() == 8 + 12 + 6);
+		TEST_CHECK(topology.getEdgeCount() == 2 * 12 + 4 * 6);
+		TEST_CHECK(topology.getFaceCount() == 4 * 6);
+		TEST_CHECK(topology.countBoundaryEdges() == 0);
+		TEST_CHECK(surface.getIndices(1).size() == 4 * 6 * 2 * 3);
+	}
+
+	// Cube with every edge infinitely sharp: corners stay, points on a cage edge stay on that edge at every level
+	static void infiniteCreaseKeepsCageEdge()
+	{
+		SubdivisionCage cage = makeCubeCage();
+		const std::vector<glm::uvec2> edges = { { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 }, { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 }, { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } };
+		cage.creaseEdges = edges;
+		cage.creaseSharpness.assign(edges.size(), SubdivisionCage::InfiniteSharpness);
+
+		const int maxLevel = 3;
+		SubdivisionSurface surface;
+		TEST_CHECK(surface.build(cage, nullptr, maxLevel));
+
+		std::vector<Vertex> vertices;
+		surface.evaluate(maxLevel, cage.positions, vertices);
+
+		// Cage vertices keep their index at every level
+		const StencilTable& stencils = surface.getStencils(maxLevel);
+		std::vector<glm::vec3> positions(stencils.getRowCount());
+		stencils.apply(cage.positions.data(), positions.data(), 0, positions.size());
+
+		bool isCornerKept = true;
+		for (uint32_t v = 0; v < 8; ++v)
+			isCornerKept &= glm::length(positions[v] - cage.positions[v]) < 1e-5f;
+		TEST_CHECK(isCornerKept);
+
+		// Points on the edge x = y = 0.5: 2^level + 1 of them, all on the segment
+		size_t edgePointCount = 0;
+		bool isOnEdge = true;
+		for (const Vertex& vertex : vertices)
+		{
+			if (std::abs(vertex.position.x - 0.5f) < 1e-5f && std::abs(vertex.position.y - 0.5f) < 1e-5f)
+			{
+				edgePointCount++;
+				isOnEdge &= std::abs(vertex.position.z) <= 0.5f + 1e-5f;
+			}
+		}
+		TEST_CHECK(isOnEdge);
+		TEST_CHECK(edgePointCount == (1u << maxLevel) + 1);
+
+		// Without creases the cube shrinks towards a rounded surface
+		SubdivisionSurface smooth;
+		smooth.build(makeCubeCage(), nullptr, maxLevel);
+		smooth.evaluate(maxLevel, cage.positions, vertices);
+
+		bool isRounded = true;
+		for (const Vertex& vertex : vertices)
+			isRounded &= !(std::abs(vertex.position.x - 0.5f) < 1e-5f && std::abs(vertex.position.y - 0.5f) < 1e-5f);
+		TEST_CHECK(isRounded);
+	}
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+
+// Minimal test runner: named test functions, checks that report the failing expression and keep going
+class TestRunner
+{
+private:
+	inline static size_t _checkCount = 0;
+	inline static size_t _failureCount = 0;
+	inline static size_t _failedTests = 0;
+	inline static std::string _filter;
+
+public:
+	// Only tests and benchmarks whose name contains the filter run
+	static void setFilter(const std::string& filter) { _filter = filter; }
+
+	static bool isSelected(const std::string& name) { return _filter.empty() || name.find(_filter) != std::string::npos; }
+
+	static size_t getFailedTestCount() { return _failedTests; }
+
+	static void check(bool condition, const char* expression, const char* file, int line)
+	{
+		_checkCount++;
+		if (condition)
+			return;
+
+		_failureCount++;
+		std::cerr << "ERROR::TEST::CHECK_FAILED - " << file << ":" << line << " " << expression << "\n";
+	}
+
+	static void run(const std::string& name, const std::function<void()>& test)
+	{
+		if (!isSelected(name))
+			return;
+
+		size_t failuresBefore = _failureCount;
+		test();
+
+		bool isPassed = _failureCount == failuresBefore;
+		if (!isPassed)
+			_failedTests++;
+
+		std::cout << (isPassed ? "[  OK  ] " : "[FAILED] ") << name << "\n";
+	}
+};
+
+#define TEST_CHECK(condition) TestRunner::check((condition), #condition, __FILE__, __LINE__)
+
+// Wall clock timing of benchmark cases, best of several runs filters out scheduling noise
+class Benchmark
+{
+public:
+	static double measureMilliseconds(const std::function<void()>& function, int repeats = 5)
+	{
+		double best = 1e30;
+		for (int i = 0; i < std::max(1, repeats); ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			auto end = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		return best;
+	}
+
+	static void report(const std::string& name, double milliseconds, double baselineMilliseconds = 0.0)
+	{
+		std::cout << "  " << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(3) << std::setw(10) << milliseconds << " ms";
+		if (baselineMilliseconds > 0.0)
+			std::cout << std::setprecision(2) << std::setw(8) << baselineMilliseconds / milliseconds << "x";
+		std::cout << "\n";
+	}
+};
@@ -9,13 +9,16 @@ struct Material
 
 	sampler2D diffuse_sampler;
 	sampler2D specular_sampler;
+	sampler2D normal_sampler;
 
-	bool hasDiffuseMap;
+	bool hasDiffuseMap;
 	bool hasSpecularMap;
+	bool hasNormalMap;
 };
 
 in vec3 vertex_position;
 in vec3 vertex_normal;
+in vec4 vertex_tangent;		// xyz = tangent, w = bitangent sign
 in vec3 vertex_color;
 in vec2 vertex_texture_coord;
 
@@ -30,6 +33,15 @@ void main()
 {
 	// --- Normalize everything ---
 	vec3 N = normalize(vertex_normal);
+
+	// Tangent space normal map, bitangent rebuilt from interpolated vectors as the tangents were generated (MikkTSpace)
+	if (material.hasNormalMap && dot(vertex_tangent.xyz, vertex_tangent.xyz) > 0.0)
+	{
+		vec3 tangentNormal = texture(material.normal_sampler, vertex_texture_coord).xyz * 2.0 - 1.0;
+		vec3 bitangent = vertex_tangent.w * cross(vertex_normal, vertex_tangent.xyz);
+		N = normalize(tangentNormal.x * vertex_tangent.xyz + tangentNormal.y * bitangent + tangentNormal.z * vertex_normal);
+	}
+
 	vec3 L = normalize(light_position - vertex_position);
 	vec3 V = normalize(camera_position - vertex_position);
 	vec3 H = normalize(L + V);// Blinn-Phong half vector (better & faster)
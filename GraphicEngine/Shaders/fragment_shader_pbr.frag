@@ -22,6 +22,7 @@ struct Material
 
 in vec3 vertex_position;
 in vec3 vertex_normal;
+in vec4 vertex_tangent;		// xyz = tangent, w = bitangent sign
 in vec2 vertex_texture_coord;
 
 out vec4 fragment_color;
@@ -92,6 +93,15 @@ void main()
 		ambientOcclusion *= texture(material.ambientOcclusionMap, vertex_texture_coord).r;
 
 	vec3 N = normalize(vertex_normal);
+
+	// Tangent space normal map, bitangent rebuilt from interpolated vectors as the tangents were generated (MikkTSpace)
+	if (material.hasNormalMap && dot(vertex_tangent.xyz, vertex_tangent.xyz) > 0.0)
+	{
+		vec3 tangentNormal = texture(material.normalMap, vertex_texture_coord).xyz * 2.0 - 1.0;
+		vec3 bitangent = vertex_tangent.w * cross(vertex_normal, vertex_tangent.xyz);
+		N = normalize(tangentNormal.x * vertex_tangent.xyz + tangentNormal.y * bitangent + tangentNormal.z * vertex_normal);
+	}
+
 	vec3 V = normalize(camera_position - vertex_position);
 	vec3 L = normalize(light_position - vertex_position);
 	vec3 H = normalize(V + L);
@@ -0,0 +1,164 @@
+#version 460 core
+
+struct TextureRef
+{
+	vec4 uv_rect;
+	int array_index;
+	int layer;
+};
+
+struct Material
+{
+	vec4 albedo_metallic;
+	vec4 roughness_occlusion;
+
+	// albedo, normal, metallic, roughness, ambient occlusion
+	TextureRef maps[5];
+};
+
+layout (std430, binding = 0) readonly buffer MaterialBuffer
+{
+	Material materials[];
+};
+
+in vec3 vertex_position;
+in vec3 vertex_normal;
+in vec4 vertex_tangent;		// xyz = tangent, w = bitangent sign
+in vec2 vertex_texture_coord;
+flat in uint vertex_material_index;
+
+out vec4 fragment_color;
+
+uniform sampler2DArray texture_arrays[8];
+uniform vec3 light_position;
+uniform vec3 light_color;
+uniform vec3 camera_position;
+
+const float PI = 3.14159265359;
+
+// Sampler arrays need constant index when it is not dynamically uniform
+vec4 sampleArray(int arrayIndex, vec3 coord, vec2 dx, vec2 dy)
+{
+	switch (arrayIndex)
+	{
+	case 0: return textureGrad(texture_arrays[0], coord, dx, dy);
+	case 1: return textureGrad(texture_arrays[1], coord, dx, dy);
+	case 2: return textureGrad(texture_arrays[2], coord, dx, dy);
+	case 3: return textureGrad(texture_arrays[3], coord, dx, dy);
+	case 4: return textureGrad(texture_arrays[4], coord, dx, dy);
+	case 5: return textureGrad(texture_arrays[5], coord, dx, dy);
+	case 6: return textureGrad(texture_arrays[6], coord, dx, dy);
+	case 7: return textureGrad(texture_arrays[7], coord, dx, dy);
+	}
+	return vec4(1.0);
+}
+
+// Atlas entries repeat inside their own rectangle, gradients come from unwrapped coordinates
+vec4 sampleMap(TextureRef ref, vec2 uv, vec2 dx, vec2 dy)
+{
+	vec2 coord = ref.uv_rect.xy + fract(uv) * ref.uv_rect.zw;
+	return sampleArray(ref.array_index, vec3(coord, ref.layer), dx * ref.uv_rect.zw, dy * ref.uv_rect.zw);
+}
+
+// vertex_normal Distribution function (GGX)
+float DistributionGGX(vec3 N, vec3 H, float roughness)
+{
+	float a = roughness * roughness;
+	float a2 = a * a;
+	float NdotH = max(dot(N, H), 0.0);
+	float NdotH2 = NdotH * NdotH;
+
+	float num = a2;
+	float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+	denom = PI * denom * denom;
+
+	return num / denom;
+}
+
+// Geometry function (Schlick-GGX)
+float GeometrySchlickGGX(float NdotV, float roughness)
+{
+	float r = roughness + 1.0;
+	float k = (r * r) / 8.0;
+	return NdotV / (NdotV * (1.0 - k) + k);
+}
+
+// Geometry function (Smith)
+float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
+{
+	float NdotV = max(dot(N, V), 0.0);
+	float NdotL = max(dot(N, L), 0.0);
+	float ggx1 = GeometrySchlickGGX(NdotV, roughness);
+	float ggx2 = GeometrySchlickGGX(NdotL, roughness);
+	return ggx1 * ggx2;
+}
+
+// Fresnel (Schlick)
+vec3 fresnelSchlick(float cosTheta, vec3 F0)
+{
+	return F0 + (1.0 - F0) * pow(1.0 - cosTheta, 5.0);
+}
+
+void main()
+{
+	Material material = materials[vertex_material_index];
+
+	// Derivatives have to be taken in uniform control flow
+	vec2 dx = dFdx(vertex_texture_coord);
+	vec2 dy = dFdy(vertex_texture_coord);
+
+	// Sample textures
+	vec3 albedo = material.albedo_metallic.rgb;
+	if (material.maps[0].array_index >= 0)
+		albedo *= sampleMap(material.maps[0], vertex_texture_coord, dx, dy).rgb;
+
+	float metallic = material.albedo_metallic.a;
+	if (material.maps[2].array_index >= 0)
+		metallic *= sampleMap(material.maps[2], vertex_texture_coord, dx, dy).r;
+
+	float roughness = material.roughness_occlusion.x;
+	if (material.maps[3].array_index >= 0)
+		roughness *= sampleMap(material.maps[3], vertex_texture_coord, dx, dy).r;
+
+	float ambientOcclusion = material.roughness_occlusion.y;
+	if (material.maps[4].array_index >= 0)
+		ambientOcclusion *= sampleMap(material.maps[4], vertex_texture_coord, dx, dy).r;
+
+	vec3 N = normalize(vertex_normal);
+
+	// Tangent space normal map, bitangent rebuilt from interpolated vectors as the tangents were generated (MikkTSpace)
+	if (material.maps[1].array_index >= 0 && dot(vertex_tangent.xyz, vertex_tangent.xyz) > 0.0)
+	{
+		vec3 tangentNormal = sampleMap(material.maps[1], vertex_texture_coord, dx, dy).xyz * 2.0 - 1.0;
+		vec3 bitangent = vertex_tangent.w * cross(vertex_normal, vertex_tangent.xyz);
+		N = normalize(tangentNormal.x * vertex_tangent.xyz + tangentNormal.y * bitangent + tangentNormal.z * vertex_normal);
+	}
+
+	vec3 V = normalize(camera_position - vertex_position);
+	vec3 L = normalize(light_position - vertex_position);
+	vec3 H = normalize(V + L);
+
+	float distance = length(light_position - vertex_position);
+	float attenuation = 1.0 / (distance * distance);
+	vec3 radiance = light_color * attenuation;
+
+	float NDF = DistributionGGX(N,H,roughness);
+	float G = GeometrySmith(N,V,L,roughness);
+	vec3 F0 = mix(vec3(0.04), albedo, metallic);
+	vec3 F = fresnelSchlick(max(dot(H,V),0.0), F0);
+
+	vec3 numerator = NDF * G * F;
+	float denominator = 4.0 * max(dot(N,V),0.0) * max(dot(N,L),0.0) + 0.001;
+	vec3 specular = numerator / denominator;
+
+	float NdotL = max(dot(N,L),0.0);
+	vec3 kS = F;
+	vec3 kD = vec3(1.0) - kS;
+	kD *= 1.0 - metallic;
+
+	vec3 diffuse = kD * albedo / PI;
+
+	vec3 result = (diffuse + specular) * radiance * NdotL * ambientOcclusion;
+
+	fragment_color = vec4(result, 1.0);
+}
@@ -0,0 +1,52 @@
+// Hi-Z occlusion test shared by the culling compute shaders (resolved by Shader and AssetCooker #include support)
+
+layout (binding = 0) uniform sampler2D depth_pyramid;
+
+uniform mat4 pyramid_view_projection;
+uniform vec2 pyramid_size;
+
+// Box projected with the camera of the last frame is compared with the farthest depth of last frame under it,
+// pyramid level is chosen so the box covers at most 2x2 texels
+bool isOccluded(vec3 center, vec3 extents)
+{
+	vec2 minUV = vec2(1.0f);
+	vec2 maxUV = vec2(0.0f);
+	float minDepth = 1.0f;
+
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		vec3 direction = vec3((corner & 1) != 0 ? 1.0f : -1.0f, (corner & 2) != 0 ? 1.0f : -1.0f, (corner & 4) != 0 ? 1.0f : -1.0f);
+		vec4 clip = pyramid_view_projection * vec4(center + extents * direction, 1.0f);
+
+		// Crosses the near plane of last frame
+		if (clip.w <= 1e-5f || clip.z < -clip.w)
+			return false;
+
+		vec3 ndc = clip.xyz / clip.w;
+		minUV = min(minUV, ndc.xy * 0.5f + 0.5f);
+		maxUV = max(maxUV, ndc.xy * 0.5f + 0.5f);
+		minDepth = min(minDepth, ndc.z * 0.5f + 0.5f);
+	}
+
+	// Not in last frame view, nothing known about it
+	if (any(lessThan(maxUV, vec2(0.0f))) || any(greaterThan(minUV, vec2(1.0f))))
+		return false;
+
+	ivec2 size = ivec2(pyramid_size);
+	ivec2 pixelMin = clamp(ivec2(floor(clamp(minUV, 0.0f, 1.0f) * pyramid_size)), ivec2(0), size - 1);
+	ivec2 pixelMax = clamp(ivec2(floor(clamp(maxUV, 0.0f, 1.0f) * pyramid_size)), ivec2(0), size - 1);
+
+	ivec2 span = pixelMax - pixelMin + 1;
+	int level = int(ceil(log2(float(max(span.x, span.y)))));
+	level = clamp(level, 0, textureQueryLevels(depth_pyramid) - 1);
+
+	ivec2 levelSize = textureSize(depth_pyramid, level);
+	ivec2 texelMin = min(pixelMin >> level, levelSize - 1);
+	ivec2 texelMax = min(pixelMax >> level, levelSize - 1);
+
+	float farthest = max(
+		max(texelFetch(depth_pyramid, texelMin, level).r, texelFetch(depth_pyramid, ivec2(texelMax.x, texelMin.y), level).r),
+		max(texelFetch(depth_pyramid, ivec2(texelMin.x, texelMax.y), level).r, texelFetch(depth_pyramid, texelMax, level).r));
+
+	return minDepth > farthest;
+}
@@ -0,0 +1,43 @@
+#version 460 core
+
+// Bounding box of one analytic shape, fragment shaders intersect the exact surface
+
+struct ImpostorData
+{
+	vec4 center_radius;
+	vec4 orientation;
+	vec4 color_minor_radius;
+};
+
+layout (std430, binding = 8) readonly buffer ImpostorBuffer
+{
+	ImpostorData impostors[];
+};
+
+out vec3 vertex_position;
+flat out uint vertex_instance;
+
+uniform mat4 view_matrix;
+uniform mat4 projection_matrix;
+
+vec3 rotateByQuaternion(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+	ImpostorData impostor = impostors[gl_InstanceID];
+
+	// Index is the corner, one bit per axis
+	vec3 corner = vec3(gl_VertexID & 1, (gl_VertexID >> 1) & 1, (gl_VertexID >> 2) & 1) * 2.0 - 1.0;
+
+	float radius = impostor.center_radius.w;
+	float minorRadius = impostor.color_minor_radius.w;
+	vec3 extents = (minorRadius > 0.0) ? vec3(radius + minorRadius, minorRadius, radius + minorRadius) : vec3(radius);
+
+	vertex_position = impostor.center_radius.xyz + rotateByQuaternion(impostor.orientation, corner * extents);
+	vertex_instance = uint(gl_InstanceID);
+
+	gl_Position = projection_matrix * view_matrix * vec4(vertex_position, 1.0f);
+}
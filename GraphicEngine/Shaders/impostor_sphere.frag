@@ -0,0 +1,78 @@
+#version 460 core
+
+struct ImpostorData
+{
+	vec4 center_radius;
+	vec4 orientation;
+	vec4 color_minor_radius;
+};
+
+layout (std430, binding = 8) readonly buffer ImpostorBuffer
+{
+	ImpostorData impostors[];
+};
+
+in vec3 vertex_position;
+flat in uint vertex_instance;
+
+out vec4 fragment_color;
+
+// Surface is always in front of the box back face, early depth test stays valid
+layout (depth_less) out float gl_FragDepth;
+
+uniform mat4 view_matrix;
+uniform mat4 projection_matrix;
+uniform vec3 light_position;
+uniform vec3 light_color;
+uniform vec3 camera_position;
+
+// Same lighting as fragment_shader_core.frag without textures
+vec3 shade(vec3 position, vec3 N, vec3 baseColor)
+{
+	vec3 L = normalize(light_position - position);
+	vec3 V = normalize(camera_position - position);
+	vec3 H = normalize(L + V);
+
+	vec3 ambient = 0.1 * baseColor;
+	vec3 diffuse = baseColor * max(dot(N, L), 0.0);
+	vec3 specular = vec3(0.2) * pow(max(dot(N, H), 0.0), 32.0);
+
+	float toLightDistance = length(light_position - position);
+	float attenuation = 1.0 / (1.0 + 0.09 * toLightDistance + 0.032 * toLightDistance * toLightDistance);
+
+	vec3 result = (ambient + diffuse + specular) * light_color * attenuation;
+	return pow(result, vec3(1.0/2.2));
+}
+
+void main()
+{
+	ImpostorData impostor = impostors[vertex_instance];
+	vec3 center = impostor.center_radius.xyz;
+	float radius = impostor.center_radius.w;
+
+	// Ray from the camera through this pixel of the box
+	vec3 rayDirection = normalize(vertex_position - camera_position);
+	vec3 offset = camera_position - center;
+
+	float b = dot(offset, rayDirection);
+	float c = dot(offset, offset) - radius * radius;
+	float discriminant = b * b - c;
+	if (discriminant < 0.0)
+		discard;
+
+	// Nearest hit in front of the camera, far one when the camera is inside
+	float root = sqrt(discriminant);
+	float t = -b - root;
+	if (t < 0.0)
+		t = -b + root;
+	if (t < 0.0)
+		discard;
+
+	vec3 hitPosition = camera_position + rayDirection * t;
+	vec3 normal = (hitPosition - center) / radius;
+
+	vec4 clipPosition = projection_matrix * view_matrix * vec4(hitPosition, 1.0);
+	gl_FragDepth = (clipPosition.z / clipPosition.w) * 0.5 + 0.5;
+
+	fragment_color = vec4(shade(hitPosition, normal, impostor.color_minor_radius.rgb), 1.0);
+}
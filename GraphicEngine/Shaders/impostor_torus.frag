@@ -0,0 +1,105 @@
+#version 460 core
+
+struct ImpostorData
+{
+	vec4 center_radius;
+	vec4 orientation;
+	vec4 color_minor_radius;
+};
+
+layout (std430, binding = 8) readonly buffer ImpostorBuffer
+{
+	ImpostorData impostors[];
+};
+
+in vec3 vertex_position;
+flat in uint vertex_instance;
+
+out vec4 fragment_color;
+
+// Surface is always in front of the box back face, early depth test stays valid
+layout (depth_less) out float gl_FragDepth;
+
+uniform mat4 view_matrix;
+uniform mat4 projection_matrix;
+uniform vec3 light_position;
+uniform vec3 light_color;
+uniform vec3 camera_position;
+
+const int MaxSteps = 96;
+
+vec3 rotateByQuaternion(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// Same lighting as fragment_shader_core.frag without textures
+vec3 shade(vec3 position, vec3 N, vec3 baseColor)
+{
+	vec3 L = normalize(light_position - position);
+	vec3 V = normalize(camera_position - position);
+	vec3 H = normalize(L + V);
+
+	vec3 ambient = 0.1 * baseColor;
+	vec3 diffuse = baseColor * max(dot(N, L), 0.0);
+	vec3 specular = vec3(0.2) * pow(max(dot(N, H), 0.0), 32.0);
+
+	float toLightDistance = length(light_position - position);
+	float attenuation = 1.0 / (1.0 + 0.09 * toLightDistance + 0.032 * toLightDistance * toLightDistance);
+
+	vec3 result = (ambient + diffuse + specular) * light_color * attenuation;
+	return pow(result, vec3(1.0/2.2));
+}
+
+float torusDistance(vec3 p, float majorRadius, float minorRadius)
+{
+	return length(vec2(length(p.xz) - majorRadius, p.y)) - minorRadius;
+}
+
+void main()
+{
+	ImpostorData impostor = impostors[vertex_instance];
+	float majorRadius = impostor.center_radius.w;
+	float minorRadius = impostor.color_minor_radius.w;
+
+	// March in torus space, inverse rotation is the conjugate quaternion
+	vec4 inverseOrientation = vec4(-impostor.orientation.xyz, impostor.orientation.w);
+	vec3 origin = rotateByQuaternion(inverseOrientation, camera_position - impostor.center_radius.xyz);
+	vec3 direction = rotateByQuaternion(inverseOrientation, normalize(vertex_position - camera_position));
+
+	// Part of the ray inside the bounding box
+	vec3 extents = vec3(majorRadius + minorRadius, minorRadius, majorRadius + minorRadius);
+	vec3 inverseDirection = 1.0 / direction;
+	vec3 t0 = (-extents - origin) * inverseDirection;
+	vec3 t1 = (extents - origin) * inverseDirection;
+	vec3 tMin = min(t0, t1);
+	vec3 tMax = max(t0, t1);
+	float t = max(max(max(tMin.x, tMin.y), tMin.z), 0.0);
+	float tExit = min(min(tMax.x, tMax.y), tMax.z);
+
+	// Sphere tracing, distance bound of the torus never overshoots the surface
+	bool isHit = false;
+	for (int i = 0; i < MaxSteps && t <= tExit; ++i)
+	{
+		float surfaceDistance = torusDistance(origin + direction * t, majorRadius, minorRadius);
+		if (surfaceDistance < 1e-4 * (1.0 + t))
+		{
+			isHit = true;
+			break;
+		}
+		t += surfaceDistance;
+	}
+
+	if (!isHit)
+		discard;
+
+	vec3 localHit = origin + direction * t;
+	vec3 ringPoint = majorRadius * normalize(vec3(localHit.x, 0.0, localHit.z));
+	vec3 normal = rotateByQuaternion(impostor.orientation, normalize(localHit - ringPoint));
+	vec3 hitPosition = camera_position + rotateByQuaternion(impostor.orientation, direction) * t;
+
+	vec4 clipPosition = projection_matrix * view_matrix * vec4(hitPosition, 1.0);
+	gl_FragDepth = (clipPosition.z / clipPosition.w) * 0.5 + 0.5;
+
+	fragment_color = vec4(shade(hitPosition, normal, impostor.color_minor_radius.rgb), 1.0);
+}
@@ -0,0 +1,44 @@
+#version 460 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec3 color;
+layout (location = 3) in vec2 texture_coord;
+layout (location = 4) in vec4 tangent;
+
+struct ObjectData
+{
+	mat4 model_matrix;
+	vec4 bounds_center;
+	vec4 bounds_extents;
+	uint material_index;
+	uint mesh_index;
+};
+
+layout (std430, binding = 1) readonly buffer ObjectBuffer
+{
+	ObjectData objects[];
+};
+
+out vec3 vertex_position;
+out vec3 vertex_normal;
+out vec4 vertex_tangent;
+out vec2 vertex_texture_coord;
+flat out uint vertex_material_index;
+
+uniform mat4 view_matrix;
+uniform mat4 projection_matrix;
+
+void main()
+{
+	// Every draw (or instance) reads its own object data
+	ObjectData objectData = objects[gl_BaseInstance + gl_InstanceID];
+
+	vertex_position = vec4(objectData.model_matrix * vec4(position, 1.0f)).xyz;
+	vertex_normal = mat3(objectData.model_matrix) * normal;
+	vertex_tangent = vec4(mat3(objectData.model_matrix) * tangent.xyz, tangent.w);
+	vertex_texture_coord = texture_coord;
+	vertex_material_index = objectData.material_index;
+
+	gl_Position = projection_matrix * view_matrix * vec4(vertex_position, 1.0f);
+}
@@ -0,0 +1,507 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <glm.hpp>
+
+#include "bounds.h"
+
+// Dynamic bounding volume hierarchy over object bounds. Leaves store enlarged ("fat") boxes,
+// so objects moving a little stay inside and need no tree update. Leaves are inserted next to
+// the sibling with lowest surface area cost and the tree is kept balanced with rotations
+class DynamicAABBTree
+{
+public:
+	static constexpr int32_t NullNode = -1;
+
+	// Fat boxes are predicted this many displacements ahead of a moving object
+	static constexpr float DisplacementMultiplier = 4.0f;
+
+private:
+	struct Node
+	{
+		AABB box;
+		uint32_t userData = 0;
+
+		int32_t parent = NullNode;		// Next free node when unused
+		int32_t child1 = NullNode;
+		int32_t child2 = NullNode;
+		int32_t height = 0;				// Leaf = 0, free node = -1
+
+		bool isLeaf() const { return child1 == NullNode; }
+	};
+
+	std::vector<Node> _nodes;
+	int32_t _root = NullNode;
+	int32_t _freeList = NullNode;
+	size_t _proxyCount = 0;
+
+	float _margin = 0.1f;
+
+public:
+	// Margin is added around leaf boxes on each side
+	explicit DynamicAABBTree(float margin = 0.1f)
+		: _margin(margin) {
+	}
+
+	size_t getProxyCount() const { return _proxyCount; }
+	int32_t getHeight() const { return _root == NullNode ? 0 : _nodes[_root].height; }
+
+	const AABB& getFatBounds(int32_t proxyId) const { return _nodes[proxyId].box; }
+	uint32_t getUserData(int32_t proxyId) const { return _nodes[proxyId].userData; }
+
+	void clear()
+	{
+		_nodes.clear();
+		_root = NullNode;
+		_freeList = NullNode;
+		_proxyCount = 0;
+	}
+
+	// Returns proxy ID, stays valid until destroyProxy()
+	int32_t createProxy(const AABB& box, uint32_t userData)
+	{
+		int32_t proxyId = allocateNode();
+
+		Node& node = _nodes[proxyId];
+		node.box = { box.min - glm::vec3(_margin), box.max + glm::vec3(_margin) };
+		node.userData = userData;
+		node.height = 0;
+
+		insertLeaf(proxyId);
+		_proxyCount++;
+		return proxyId;
+	}
+
+	void destroyProxy(int32_t proxyId)
+	{
+		removeLeaf(proxyId);
+		freeNode(proxyId);
+		_proxyCount--;
+	}
+
+	// Reinsert the proxy only when the box left its fat box, returns true if the tree changed
+	bool moveProxy(int32_t proxyId, const AABB& box, const glm::vec3& displacement = glm::vec3(0.0f))
+	{
+		if (_nodes[proxyId].box.contains(box))
+			return false;
+
+		removeLeaf(proxyId);
+
+		// Extend fat box in the direction of movement
+		AABB fatBox = { box.min - glm::vec3(_margin), box.max + glm::vec3(_margin) };
+		glm::vec3 prediction = displacement * DisplacementMultiplier;
+		fatBox.min += glm::min(prediction, glm::vec3(0.0f));
+		fatBox.max += glm::max(prediction, glm::vec3(0.0f));
+
+		_nodes[proxyId].box = fatBox;
+		insertLeaf(proxyId);
+		return true;
+	}
+
+	// Cheap alternative to moveProxy: leaf box is replaced and ancestors are enlarged without restructuring.
+	// Tree quality slowly drops, suited for many objects moving a bit every frame
+	void refitProxy(int32_t proxyId, const AABB& box)
+	{
+		if (_nodes[proxyId].box.contains(box))
+			return;
+
+		_nodes[proxyId].box = { box.min - glm::vec3(_margin), box.max + glm::vec3(_margin) };
+
+		for (int32_t index = _nodes[proxyId].parent; index != NullNode; index = _nodes[index].parent)
+		{
+			Node& node = _nodes[index];
+			AABB merged = AABB::merge(_nodes[node.child1].box, _nodes[node.child2].box);
+			if (node.box.contains(merged))
+				break;
+
+			node.box = AABB::merge(node.box, merged);
+		}
+	}
+
+	// Callback(userData) for every proxy whose fat box overlaps the box, returning false stops the query
+	template<typename Callback>
+	void queryAABB(const AABB& box, Callback&& callback) const
+	{
+		traverse([&box](const AABB& nodeBox) { return nodeBox.overlaps(box); }, callback);
+	}
+
+	template<typename Callback>
+	void querySphere(const glm::vec3& center, float radius, Callback&& callback) const
+	{
+		traverse([&center, radius](const AABB& nodeBox)
+			{
+				glm::vec3 closest = glm::clamp(center, nodeBox.min, nodeBox.max);
+				glm::vec3 offset = closest - center;
+				return glm::dot(offset, offset) <= radius * radius;
+			}, callback);
+	}
+
+	// Subtrees fully inside the frustum are reported without further plane tests
+	template<typename Callback>
+	void queryFrustum(const Frustum& frustum, Callback&& callback) const
+	{
+		if (_root == NullNode)
+			return;
+
+		std::vector<int32_t> stack;
+		stack.reserve(64);
+		stack.push_back(_root);
+
+		while (!stack.empty())
+		{
+			int32_t index = stack.back();
+			stack.pop_back();
+
+			const Node& node = _nodes[index];
+			glm::vec3 center = node.box.getCenter();
+			glm::vec3 extents = node.box.getExtents();
+
+			bool isInside = true;
+			bool isOutside = false;
+
+			for (const auto& plane : frustum.planes)
+			{
+				float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+				float radius = glm::dot(extents, glm::abs(glm::vec3(plane)));
+
+				if (distance < -radius)
+				{
+					isOutside = true;
+					break;
+				}
+
+				if (distance < radius)
+					isInside = false;
+			}
+
+			if (isOutside)
+				continue;
+
+			if (isInside)
+			{
+				if (!reportSubtree(index, callback))
+					return;
+				continue;
+			}
+
+			if (node.isLeaf())
+			{
+				if (!callback(node.userData))
+					return;
+				continue;
+			}
+
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+
+	// Callback(userData, boxDistance) for proxies whose fat box the ray enters within maxDistance.
+	// Callback returns new max distance: hit distance clips the ray (closest hit), negative value stops the query
+	template<typename Callback>
+	void queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Callback&& callback) const
+	{
+		if (_root == NullNode)
+			return;
+
+		glm::vec3 inverseDirection = 1.0f / direction;
+
+		std::vector<int32_t> stack;
+		stack.reserve(64);
+		stack.push_back(_root);
+
+		while (!stack.empty())
+		{
+			int32_t index = stack.back();
+			stack.pop_back();
+
+			const Node& node = _nodes[index];
+
+			float distance;
+			if (!intersectRay(node.box, origin, inverseDirection, maxDistance, distance))
+				continue;
+
+			if (node.isLeaf())
+			{
+				maxDistance = callback(node.userData, distance);
+				if (maxDistance < 0.0f)
+					return;
+				continue;
+			}
+
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+
+private:
+	int32_t allocateNode()
+	{
+		if (_freeList == NullNode)
+		{
+			_nodes.emplace_back();
+			return static_cast<int32_t>(_nodes.size() - 1);
+		}
+
+		int32_t index = _freeList;
+		_freeList = _nodes[index].parent;
+		_nodes[index] = Node();
+		return index;
+	}
+
+	void freeNode(int32_t index)
+	{
+		_nodes[index].parent = _freeList;
+		_nodes[index].height = -1;
+		_freeList = index;
+	}
+
+	void insertLeaf(int32_t leaf)
+	{
+		if (_root == NullNode)
+		{
+			_root = leaf;
+			_nodes[leaf].parent = NullNode;
+			return;
+		}
+
+		// Descend to the sibling with the lowest cost (area of new parent plus growth of all ancestors)
+		AABB leafBox = _nodes[leaf].box;
+		int32_t index = _root;
+
+		while (!_nodes[index].isLeaf())
+		{
+			const Node& node = _nodes[index];
+
+			float area = node.box.getSurfaceArea();
+			float combinedArea = AABB::merge(node.box, leafBox).getSurfaceArea();
+
+			// Cost of creating new parent for this node and the leaf
+			float cost = 2.0f * combinedArea;
+
+			// Minimum cost of pushing the leaf further down
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			float cost1 = getDescendCost(node.child1, leafBox) + inheritanceCost;
+			float cost2 = getDescendCost(node.child2, leafBox) + inheritanceCost;
+
+			if (cost < cost1 && cost < cost2)
+				break;
+
+			index = (cost1 < cost2) ? node.child1 : node.child2;
+		}
+
+		int32_t sibling = index;
+
+		int32_t oldParent = _nodes[sibling].parent;
+		int32_t newParent = allocateNode();
+		_nodes[newParent].parent = oldParent;
+		_nodes[newParent].box = AABB::merge(leafBox, _nodes[sibling].box);
+		_nodes[newParent].height = _nodes[sibling].height + 1;
+		_nodes[newParent].child1 = sibling;
+		_nodes[newParent].child2 = leaf;
+		_nodes[sibling].parent = newParent;
+		_nodes[leaf].parent = newParent;
+
+		if (oldParent == NullNode)
+			_root = newParent;
+		else if (_nodes[oldParent].child1 == sibling)
+			_nodes[oldParent].child1 = newParent;
+		else
+			_nodes[oldParent].child2 = newParent;
+
+		refitAncestors(newParent);
+	}
+
+	void removeLeaf(int32_t leaf)
+	{
+		if (leaf == _root)
+		{
+			_root = NullNode;
+			return;
+		}
+
+		int32_t parent = _nodes[leaf].parent;
+		int32_t grandParent = _nodes[parent].parent;
+		int32_t sibling = (_nodes[parent].child1 == leaf) ? _nodes[parent].child2 : _nodes[parent].child1;
+
+		// Sibling takes place of the parent
+		if (grandParent == NullNode)
+		{
+			_root = sibling;
+			_nodes[sibling].parent = NullNode;
+			freeNode(parent);
+			return;
+		}
+
+		if (_nodes[grandParent].child1 == parent)
+			_nodes[grandParent].child1 = sibling;
+		else
+			_nodes[grandParent].child2 = sibling;
+
+		_nodes[sibling].parent = grandParent;
+		freeNode(parent);
+
+		refitAncestors(grandParent);
+	}
+
+	float getDescendCost(int32_t child, const AABB& leafBox) const
+	{
+		const Node& node = _nodes[child];
+		float combinedArea = AABB::merge(leafBox, node.box).getSurfaceArea();
+		return node.isLeaf() ? combinedArea : combinedArea - node.box.getSurfaceArea();
+	}
+
+	// Walk up fixing heights and boxes, balancing every node on the way
+	void refitAncestors(int32_t index)
+	{
+		while (index != NullNode)
+		{
+			index = balance(index);
+
+			Node& node = _nodes[index];
+			node.height = 1 + std::max(_nodes[node.child1].height, _nodes[node.child2].height);
+			node.box = AABB::merge(_nodes[node.child1].box, _nodes[node.child2].box);
+
+			index = node.parent;
+		}
+	}
+
+	// Rotate node A when heights of its children differ by more than one, returns index of the subtree root
+	int32_t balance(int32_t a)
+	{
+		Node& nodeA = _nodes[a];
+		if (nodeA.isLeaf() || nodeA.height < 2)
+			return a;
+
+		int32_t b = nodeA.child1;
+		int32_t c = nodeA.child2;
+		int32_t balanceFactor = _nodes[c].height - _nodes[b].height;
+
+		if (balanceFactor > 1)
+			return rotateUp(a, c, b);
+
+		if (balanceFactor < -1)
+			return rotateUp(a, b, c);
+
+		return a;
+	}
+
+	// Higher child takes place of A, A takes the lower grandchild
+	int32_t rotateUp(int32_t a, int32_t high, int32_t low)
+	{
+		Node& nodeA = _nodes[a];
+		Node& nodeHigh = _nodes[high];
+
+		int32_t f = nodeHigh.child1;
+		int32_t g = nodeHigh.child2;
+
+		// Swap A and high child
+		nodeHigh.child1 = a;
+		nodeHigh.parent = nodeA.parent;
+		nodeA.parent = high;
+
+		if (nodeHigh.parent == NullNode)
+			_root = high;
+		else if (_nodes[nodeHigh.parent].child1 == a)
+			_nodes[nodeHigh.parent].child1 = high;
+		else
+			_nodes[nodeHigh.parent].child2 = high;
+
+		// Higher grandchild stays under the high node
+		if (_nodes[f].height < _nodes[g].height)
+			std::swap(f, g);
+
+		nodeHigh.child2 = f;
+
+		if (nodeA.child1 == high)
+			nodeA.child1 = g;
+		else
+			nodeA.child2 = g;
+
+		_nodes[g].parent = a;
+
+		nodeA.box = AABB::merge(_nodes[low].box, _nodes[g].box);
+		nodeA.height = 1 + std::max(_nodes[low].height, _nodes[g].height);
+
+		nodeHigh.box = AABB::merge(nodeA.box, _nodes[f].box);
+		nodeHigh.height = 1 + std::max(nodeA.height, _nodes[f].height);
+
+		return high;
+	}
+
+	template<typename Overlaps, typename Callback>
+	void traverse(const Overlaps& overlaps, Callback& callback) const
+	{
+		if (_root == NullNode)
+			return;
+
+		std::vector<int32_t> stack;
+		stack.reserve(64);
+		stack.push_back(_root);
+
+		while (!stack.empty())
+		{
+			int32_t index = stack.back();
+			stack.pop_back();
+
+			const Node& node = _nodes[index];
+			if (!overlaps(node.box))
+				continue;
+
+			if (node.isLeaf())
+			{
+				if (!callback(node.userData))
+					return;
+				continue;
+			}
+
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+
+	template<typename Callback>
+	bool reportSubtree(int32_t root, Callback& callback) const
+	{
+		std::vector<int32_t> stack;
+		stack.reserve(64);
+		stack.push_back(root);
+
+		while (!stack.empty())
+		{
+			const Node& node = _nodes[stack.back()];
+			stack.pop_back();
+
+			if (node.isLeaf())
+			{
+				if (!callback(node.userData))
+					return false;
+				continue;
+			}
+
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+
+		return true;
+	}
+
+	// Slab test, distance is where the ray enters the box (0 if it starts inside)
+	static bool intersectRay(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance)
+	{
+		glm::vec3 t1 = (box.min - origin) * inverseDirection;
+		glm::vec3 t2 = (box.max - origin) * inverseDirection;
+
+		glm::vec3 tMin = glm::min(t1, t2);
+		glm::vec3 tMax = glm::max(t1, t2);
+
+		float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+		float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+
+		distance = enter;
+		return enter <= exit;
+	}
+};
@@ -0,0 +1,459 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "mapped_file.h"
+#include "lz4_codec.h"
+
+// 64-bit FNV-1a, used for pack paths and content hashes
+inline uint64_t hashFNV1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+enum class PackCompression : uint32_t
+{
+	None = 0,
+	LZ4 = 1
+};
+
+// Pack layout: header, entry data (16 byte aligned), table of contents sorted by path hash, path strings
+struct PackHeader
+{
+	char magic[4] = { 'G', 'E', 'P', 'K' };
+	uint32_t version = 1;
+	uint32_t entryCount = 0;
+	uint32_t reserved = 0;
+	uint64_t tocOffset = 0;
+	uint64_t namesOffset = 0;
+};
+
+struct PackEntry
+{
+	uint64_t pathHash = 0;
+	uint64_t contentHash = 0;		// Of uncompressed data
+	uint64_t offset = 0;
+	uint64_t storedSize = 0;
+	uint64_t size = 0;
+	uint32_t nameOffset = 0;
+	uint32_t nameLength = 0;
+	PackCompression compression = PackCompression::None;
+	uint32_t reserved = 0;
+};
+
+static_assert(sizeof(PackHeader) == 32, "PackHeader layout");
+static_assert(sizeof(PackEntry) == 56, "PackEntry layout");
+
+// Asset bytes, either pointing directly into mapped pack or owning decompressed / loose file data
+class AssetBlob
+{
+private:
+	const unsigned char* _data = nullptr;
+	size_t _size = 0;
+	std::vector<unsigned char> _storage;
+	std::shared_ptr<void> _owner;		// Keeps external memory alive (e.g. I/O buffer)
+	bool _isValid = false;
+
+public:
+	AssetBlob() = default;
+
+	AssetBlob(const unsigned char* data, size_t size)
+		: _data(data), _size(size), _isValid(true) {
+	}
+
+	AssetBlob(const unsigned char* data, size_t size, std::shared_ptr<void> owner)
+		: _data(data), _size(size), _owner(std::move(owner)), _isValid(true) {
+	}
+
+	explicit AssetBlob(std::vector<unsigned char>&& storage)
+		: _data(storage.data()), _size(storage.size()), _storage(std::move(storage)), _isValid(true) {
+	}
+
+	// Moving vector keeps its buffer, so the data pointer stays valid
+	AssetBlob(AssetBlob&&) = default;
+	AssetBlob& operator=(AssetBlob&&) = default;
+
+	AssetBlob(const AssetBlob&) = delete;
+	AssetBlob& operator=(const AssetBlob&) = delete;
+
+	const unsigned char* data() const { return _data; }
+	size_t size() const { return _size; }
+	bool isValid() const { return _isValid; }
+
+	std::string toString() const { return _size ? std::string(reinterpret_cast<const char*>(_data), _size) : std::string(); }
+};
+
+// Read-only std::streambuf over memory (for parsers taking std::istream)
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+	MemoryStreamBuffer(const unsigned char* data, size_t size)
+	{
+		char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+		setg(begin, begin, begin + size);
+	}
+};
+
+// Memory mapped pack file
+class AssetPack
+{
+private:
+	std::string _path;
+	MappedFile _file;
+
+	const PackEntry* _entries = nullptr;
+	const char* _names = nullptr;
+	uint32_t _entryCount = 0;
+
+	// Uncompressed entries are hashed on first read only, later reads stay zero copy
+	std::unique_ptr<std::atomic<bool>[]> _isVerified;
+
+public:
+	explicit AssetPack(const std::string& path)
+		: _path(path)
+	{
+		if (!_file.open(path))
+			return;
+
+		if (!validate())
+		{
+			std::cerr << "ERROR::ASSET_PACK::INVALID_PACK - " << path << "\n";
+			_file.close();
+		}
+	}
+
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+
+	bool isValid() const { return _file.data() != nullptr; }
+	const std::string& getPath() const { return _path; }
+	uint32_t getEntryCount() const { return _entryCount; }
+
+	const PackEntry& getEntry(uint32_t index) const { return _entries[index]; }
+	std::string getEntryPath(uint32_t index) const { return std::string(_names + _entries[index].nameOffset, _entries[index].nameLength); }
+
+	// Pack paths are relative, forward slashes and lower case, so lookups do not depend on platform
+	static std::string normalizePath(const std::string& path)
+	{
+		std::string normalized = path;
+		std::replace(normalized.begin(), normalized.end(), '\\', '/');
+		normalized = std::filesystem::path(normalized).lexically_normal().generic_string();
+
+		while (normalized.rfind("./", 0) == 0)
+			normalized.erase(0, 2);
+
+		std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return normalized;
+	}
+
+	// Binary search by path hash, returns -1 if missing
+	int64_t find(const std::string& path) const
+	{
+		if (!isValid())
+			return -1;
+
+		std::string normalized = normalizePath(path);
+		uint64_t hash = hashFNV1a(normalized.data(), normalized.size());
+
+		const PackEntry* end = _entries + _entryCount;
+		const PackEntry* entry = std::lower_bound(_entries, end, hash, [](const PackEntry& e, uint64_t h) { return e.pathHash < h; });
+
+		// Hash collisions are resolved by comparing stored paths
+		for (; entry != end && entry->pathHash == hash; ++entry)
+		{
+			if (entry->nameLength == normalized.size() && std::memcmp(_names + entry->nameOffset, normalized.data(), normalized.size()) == 0)
+				return entry - _entries;
+		}
+
+		return -1;
+	}
+
+	// Uncompressed entries are returned without copy, blob is valid while the pack stays open
+	AssetBlob read(uint32_t index) const
+	{
+		const PackEntry& entry = _entries[index];
+		const unsigned char* stored = _file.data() + entry.offset;
+
+		if (entry.compression == PackCompression::None)
+		{
+			// Concurrent first reads may both hash the entry, which is harmless
+			if (!_isVerified[index].load(std::memory_order_acquire))
+			{
+				if (hashFNV1a(stored, entry.size) != entry.contentHash)
+				{
+					std::cerr << "ERROR::ASSET_PACK::CORRUPTED_ENTRY - " << getEntryPath(index) << "\n";
+					return AssetBlob();
+				}
+
+				_isVerified[index].store(true, std::memory_order_release);
+			}
+
+			return AssetBlob(stored, entry.size);
+		}
+
+		std::vector<unsigned char> data(entry.size);
+
+		if (entry.compression != PackCompression::LZ4 || !LZ4Codec::decompress(stored, entry.storedSize, data.data(), data.size())
+			|| hashFNV1a(data.data(), data.size()) != entry.contentHash)
+		{
+			std::cerr << "ERROR::ASSET_PACK::CORRUPTED_ENTRY - " << getEntryPath(index) << "\n";
+			return AssetBlob();
+		}
+
+		return AssetBlob(std::move(data));
+	}
+
+private:
+	bool validate()
+	{
+		const unsigned char* data = _file.data();
+		size_t size = _file.size();
+
+		if (!data || size < sizeof(PackHeader))
+			return false;
+
+		PackHeader header;
+		std::memcpy(&header, data, sizeof(header));
+
+		if (std::memcmp(header.magic, PackHeader().magic, 4) != 0 || header.version != PackHeader().version)
+			return false;
+
+		if (header.tocOffset % alignof(PackEntry) != 0 || header.tocOffset > size
+			|| header.entryCount > (size - header.tocOffset) / sizeof(PackEntry) || header.namesOffset > size)
+			return false;
+
+		_entries = reinterpret_cast<const PackEntry*>(data + header.tocOffset);
+		_names = reinterpret_cast<const char*>(data + header.namesOffset);
+		_entryCount = header.entryCount;
+
+		for (uint32_t i = 0; i < _entryCount; ++i)
+		{
+			const PackEntry& entry = _entries[i];
+			if (entry.offset > size || entry.storedSize > size - entry.offset
+				|| (entry.compression == PackCompression::None && entry.size != entry.storedSize)
+				|| entry.nameOffset + uint64_t(entry.nameLength) > size - header.namesOffset)
+				return false;
+		}
+
+		_isVerified = std::make_unique<std::atomic<bool>[]>(_entryCount);
+		return true;
+	}
+};
+
+// Builds pack files (offline, e.g. by asset cooking)
+class AssetPackWriter
+{
+private:
+	struct PendingEntry
+	{
+		std::string path;
+		std::vector<unsigned char> data;
+		PackCompression compression = PackCompression::None;
+	};
+
+	std::vector<PendingEntry> _entries;
+
+public:
+	// Compressed data is stored only if it is actually smaller (e.g. PNG files usually are not)
+	void add(const std::string& packPath, const void* data, size_t size, PackCompression compression = PackCompression::LZ4)
+	{
+		PendingEntry entry;
+		entry.path = AssetPack::normalizePath(packPath);
+		entry.data.assign(static_cast<const unsigned char*>(data), static_cast<const unsigned char*>(data) + size);
+		entry.compression = compression;
+
+		_entries.push_back(std::move(entry));
+	}
+
+	// Pack path defaults to the file path
+	bool addFile(const std::string& filePath, const std::string& packPath = "", PackCompression compression = PackCompression::LZ4)
+	{
+		std::ifstream file(filePath, std::ios::binary);
+		if (!file.is_open())
+		{
+			std::cerr << "ERROR::ASSET_PACK_WRITER::READ_FILE_FAILED - " << filePath << "\n";
+			return false;
+		}
+
+		std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		add(packPath.empty() ? filePath : packPath, data.data(), data.size(), compression);
+		return true;
+	}
+
+	bool write(const std::string& outputPath) const
+	{
+		std::ofstream file(outputPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cerr << "ERROR::ASSET_PACK_WRITER::WRITE_FILE_FAILED - " << outputPath << "\n";
+			return false;
+		}
+
+		PackHeader header;
+		header.entryCount = static_cast<uint32_t>(_entries.size());
+
+		std::vector<PackEntry> toc;
+		std::string names;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		uint64_t offset = sizeof(header);
+
+		for (const auto& pending : _entries)
+		{
+			PackEntry entry;
+			entry.pathHash = hashFNV1a(pending.path.data(), pending.path.size());
+			entry.contentHash = hashFNV1a(pending.data.data(), pending.data.size());
+			entry.size = pending.data.size();
+			entry.nameOffset = static_cast<uint32_t>(names.size());
+			entry.nameLength = static_cast<uint32_t>(pending.path.size());
+			names += pending.path;
+
+			std::vector<unsigned char> compressed;
+			if (pending.compression == PackCompression::LZ4)
+				compressed = LZ4Codec::compress(pending.data.data(), pending.data.size());
+
+			bool useCompressed = pending.compression == PackCompression::LZ4 && compressed.size() < pending.data.size();
+			const std::vector<unsigned char>& stored = useCompressed ? compressed : pending.data;
+
+			entry.compression = useCompressed ? PackCompression::LZ4 : PackCompression::None;
+			entry.storedSize = stored.size();
+
+			offset = writePadding(file, offset, 16);
+			entry.offset = offset;
+
+			file.write(reinterpret_cast<const char*>(stored.data()), stored.size());
+			offset += stored.size();
+
+			toc.push_back(entry);
+		}
+
+		std::sort(toc.begin(), toc.end(), [](const PackEntry& a, const PackEntry& b) { return a.pathHash < b.pathHash; });
+
+		header.tocOffset = writePadding(file, offset, 16);
+		file.write(reinterpret_cast<const char*>(toc.data()), toc.size() * sizeof(PackEntry));
+
+		header.namesOffset = header.tocOffset + toc.size() * sizeof(PackEntry);
+		file.write(names.data(), names.size());
+
+		// Header is complete only now
+		file.seekp(0);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		if (!file.good())
+		{
+			std::cerr << "ERROR::ASSET_PACK_WRITER::WRITE_FILE_FAILED - " << outputPath << "\n";
+			return false;
+		}
+
+		return true;
+	}
+
+private:
+	static uint64_t writePadding(std::ofstream& file, uint64_t offset, uint64_t alignment)
+	{
+		static const char zeros[16] = {};
+
+		uint64_t aligned = (offset + alignment - 1) / alignment * alignment;
+		file.write(zeros, aligned - offset);
+		return aligned;
+	}
+};
+
+// Asset reads go through mounted packs (last mounted wins) with fallback to loose files. Can be used from any thread
+class AssetFileSystem
+{
+private:
+	inline static std::vector<std::unique_ptr<AssetPack>> _packs;
+	inline static std::shared_mutex _mutex;
+
+public:
+	static bool mount(const std::string& packPath)
+	{
+		auto pack = std::make_unique<AssetPack>(packPath);
+		if (!pack->isValid())
+			return false;
+
+		std::cout << "Mounted asset pack: " << packPath << " (" << pack->getEntryCount() << " entries)\n";
+
+		std::unique_lock<std::shared_mutex> lock(_mutex);
+		_packs.push_back(std::move(pack));
+		return true;
+	}
+
+	// Blobs read from packs must not be used after unmounting
+	static void unmountAll()
+	{
+		std::unique_lock<std::shared_mutex> lock(_mutex);
+		_packs.clear();
+	}
+
+	static bool isInPack(const std::string& path)
+	{
+		std::shared_lock<std::shared_mutex> lock(_mutex);
+		for (const auto& pack : _packs)
+		{
+			if (pack->find(path) >= 0)
+				return true;
+		}
+		return false;
+	}
+
+	static bool exists(const std::string& path)
+	{
+		if (isInPack(path))
+			return true;
+
+		std::error_code error;
+		return std::filesystem::is_regular_file(path, error);
+	}
+
+	static AssetBlob read(const std::string& path)
+	{
+		{
+			std::shared_lock<std::shared_mutex> lock(_mutex);
+			for (auto pack = _packs.rbegin(); pack != _packs.rend(); ++pack)
+			{
+				int64_t index = (*pack)->find(path);
+				if (index >= 0)
+					return (*pack)->read(static_cast<uint32_t>(index));
+			}
+		}
+
+		return readLooseFile(path);
+	}
+
+private:
+	static AssetBlob readLooseFile(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+		{
+			std::cerr << "ERROR::ASSET_FILE_SYSTEM::READ_FILE_FAILED - " << path << "\n";
+			return AssetBlob();
+		}
+
+		std::vector<unsigned char> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+
+		return AssetBlob(std::move(data));
+	}
+};
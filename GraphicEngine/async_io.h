@@ -0,0 +1,583 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+
+#include "asset_pack.h"
+#include "thread_pool.h"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ASYNC_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#endif
+
+// Called with file contents (invalid blob on failure) on the I/O thread, should only hand the data over
+using IOReadCallback = std::function<void(AssetBlob&&)>;
+
+#ifdef ASYNC_IO_URING
+// Minimal io_uring wrapper over raw system calls (no liburing dependency)
+class IOUring
+{
+private:
+	int _fd = -1;
+
+	unsigned* _sqHead = nullptr;
+	unsigned* _sqTail = nullptr;
+	unsigned* _sqArray = nullptr;
+	unsigned _sqMask = 0;
+	unsigned _sqEntries = 0;
+	io_uring_sqe* _sqes = nullptr;
+
+	unsigned* _cqHead = nullptr;
+	unsigned* _cqTail = nullptr;
+	unsigned _cqMask = 0;
+	io_uring_cqe* _cqes = nullptr;
+
+	void* _sqRing = MAP_FAILED;
+	void* _cqRing = MAP_FAILED;
+	size_t _sqRingSize = 0;
+	size_t _cqRingSize = 0;
+	size_t _sqesSize = 0;
+
+	unsigned _queued = 0;
+
+public:
+	IOUring() = default;
+
+	~IOUring()
+	{
+		if (_sqes) munmap(_sqes, _sqesSize);
+		if (_cqRing != MAP_FAILED && _cqRing != _sqRing) munmap(_cqRing, _cqRingSize);
+		if (_sqRing != MAP_FAILED) munmap(_sqRing, _sqRingSize);
+		if (_fd >= 0) close(_fd);
+	}
+
+	IOUring(const IOUring&) = delete;
+	IOUring& operator=(const IOUring&) = delete;
+
+	// Fails when the kernel does not support io_uring or it is disabled
+	bool init(unsigned entries)
+	{
+		io_uring_params params{};
+		_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+		if (_fd < 0)
+			return false;
+
+		_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+		// Both rings share one mapping on newer kernels
+		bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+		if (singleMap)
+			_sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+
+		_sqRing = mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+		if (_sqRing == MAP_FAILED)
+			return false;
+
+		_cqRing = singleMap ? _sqRing : mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+		if (_cqRing == MAP_FAILED)
+			return false;
+
+		_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		void* sqes = mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+		if (sqes == MAP_FAILED)
+			return false;
+
+		_sqes = static_cast<io_uring_sqe*>(sqes);
+
+		char* sq = static_cast<char*>(_sqRing);
+		_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+		_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+		_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+		_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+		_sqEntries = params.sq_entries;
+
+		char* cq = static_cast<char*>(_cqRing);
+		_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+		_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+		_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+		_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+		return true;
+	}
+
+	// Pin buffers in the kernel so READ_FIXED skips per-request page mapping
+	bool registerBuffers(const iovec* buffers, unsigned count)
+	{
+		return syscall(__NR_io_uring_register, _fd, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+	}
+
+	unsigned getEntryCount() const { return _sqEntries; }
+
+	// Returns nullptr when submission queue is full
+	io_uring_sqe* getSqe()
+	{
+		unsigned head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+		unsigned tail = *_sqTail + _queued;
+
+		if (tail - head >= _sqEntries)
+			return nullptr;
+
+		unsigned index = tail & _sqMask;
+		_sqArray[index] = index;
+		_queued++;
+
+		io_uring_sqe* sqe = &_sqes[index];
+		std::memset(sqe, 0, sizeof(*sqe));
+		return sqe;
+	}
+
+	// Publish queued entries to the kernel
+	bool submit()
+	{
+		if (!_queued)
+			return true;
+
+		__atomic_store_n(_sqTail, *_sqTail + _queued, __ATOMIC_RELEASE);
+
+		unsigned toSubmit = _queued;
+		_queued = 0;
+
+		while (toSubmit > 0)
+		{
+			int submitted = static_cast<int>(syscall(__NR_io_uring_enter, _fd, toSubmit, 0, 0, nullptr, 0));
+			if (submitted < 0)
+			{
+				if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+					continue;
+				return false;
+			}
+
+			toSubmit -= submitted;
+		}
+
+		return true;
+	}
+
+	// Blocks until at least one completion is available
+	bool waitCompletion(io_uring_cqe& completion)
+	{
+		while (true)
+		{
+			unsigned head = *_cqHead;
+			if (head != __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE))
+			{
+				completion = _cqes[head & _cqMask];
+				__atomic_store_n(_cqHead, head + 1, __ATOMIC_RELEASE);
+				return true;
+			}
+
+			if (syscall(__NR_io_uring_enter, _fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+				return false;
+		}
+	}
+};
+#endif
+
+// Batched asynchronous whole-file reads. Uses io_uring on Linux (requests are kept in flight together,
+// small files are read into pre-registered buffers), otherwise pool of threads doing blocking reads
+class AsyncFileReader
+{
+private:
+	struct Request
+	{
+		std::string path;
+		IOReadCallback callback;
+
+		int fd = -1;
+		size_t size = 0;
+		size_t done = 0;
+
+		int bufferIndex = -1;
+		std::vector<unsigned char> heap;
+		unsigned char* target = nullptr;
+	};
+
+	// Buffers shared by both backends, files not fitting (or with every buffer in use) go to heap memory
+	size_t _bufferSize = 0;
+	std::vector<unsigned char> _bufferMemory;
+	std::vector<int> _freeBuffers;
+	std::mutex _bufferMutex;
+
+	// Requests not finished yet (including their callbacks)
+	size_t _outstanding = 0;
+	std::mutex _idleMutex;
+	std::condition_variable _idleCondition;
+
+	std::unique_ptr<ThreadPool> _fallbackWorkers;
+
+#ifdef ASYNC_IO_URING
+	std::unique_ptr<IOUring> _ring;
+	bool _buffersRegistered = false;
+
+	std::mutex _submitMutex;
+	std::deque<Request*> _pending;
+	unsigned _inFlight = 0;
+	unsigned _queueDepth = 0;
+
+	std::thread _completionThread;
+#endif
+
+public:
+	explicit AsyncFileReader(size_t bufferCount = 8, size_t bufferSize = 4ull * 1024 * 1024, unsigned queueDepth = 64, unsigned fallbackThreads = 4)
+		: _bufferSize(bufferSize)
+	{
+		_bufferMemory.resize(bufferCount * bufferSize);
+		for (int i = static_cast<int>(bufferCount) - 1; i >= 0; --i)
+			_freeBuffers.push_back(i);
+
+#ifdef ASYNC_IO_URING
+		auto ring = std::make_unique<IOUring>();
+		if (ring->init(queueDepth))
+		{
+			std::vector<iovec> buffers(bufferCount);
+			for (size_t i = 0; i < bufferCount; ++i)
+				buffers[i] = { _bufferMemory.data() + i * bufferSize, bufferSize };
+
+			// Can fail e.g. on low RLIMIT_MEMLOCK, buffers are then used with plain reads
+			_buffersRegistered = bufferCount > 0 && ring->registerBuffers(buffers.data(), static_cast<unsigned>(bufferCount));
+
+			_queueDepth = ring->getEntryCount();
+			_ring = std::move(ring);
+			_completionThread = std::thread([this]() { completionLoop(); });
+			return;
+		}
+
+		std::cout << "ASYNC_IO::IO_URING_UNAVAILABLE - using thread pool" << "\n";
+#endif
+		_fallbackWorkers = std::make_unique<ThreadPool>(fallbackThreads);
+	}
+
+	~AsyncFileReader()
+	{
+		waitIdle();
+
+#ifdef ASYNC_IO_URING
+		if (_ring)
+		{
+			// NOP with empty user data stops the completion thread
+			{
+				std::unique_lock<std::mutex> lock(_submitMutex);
+
+				// Full submission queue: submit what is queued and let the completion thread reap before retrying
+				io_uring_sqe* sqe;
+				while (!(sqe = _ring->getSqe()))
+				{
+					_ring->submit();
+					lock.unlock();
+					std::this_thread::yield();
+					lock.lock();
+				}
+
+				sqe->opcode = IORING_OP_NOP;
+				sqe->user_data = 0;
+				_ring->submit();
+			}
+
+			_completionThread.join();
+		}
+#endif
+	}
+
+	AsyncFileReader(const AsyncFileReader&) = delete;
+	AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+#ifdef ASYNC_IO_URING
+	bool isUsingIOUring() const { return _ring != nullptr; }
+#else
+	bool isUsingIOUring() const { return false; }
+#endif
+
+	// Read whole file, can be called from any thread. Blob handed to the callback may keep I/O buffer leased until destroyed
+	void read(const std::string& path, IOReadCallback callback)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_idleMutex);
+			_outstanding++;
+		}
+
+		auto request = std::make_unique<Request>();
+		request->path = path;
+		request->callback = std::move(callback);
+
+#ifdef ASYNC_IO_URING
+		if (_ring)
+		{
+			submitRing(request.release());
+			return;
+		}
+#endif
+		_fallbackWorkers->submit([this, request = std::shared_ptr<Request>(std::move(request))]()
+			{
+				readBlocking(*request);
+			});
+	}
+
+	// Block until every request is read and its callback returned
+	void waitIdle()
+	{
+		std::unique_lock<std::mutex> lock(_idleMutex);
+		_idleCondition.wait(lock, [this]() { return _outstanding == 0; });
+	}
+
+private:
+	unsigned char* getBuffer(int index) { return _bufferMemory.data() + size_t(index) * _bufferSize; }
+
+	// Returns buffer index or -1 if the file does not fit or no buffer is free
+	int acquireBuffer(size_t size)
+	{
+		if (size > _bufferSize)
+			return -1;
+
+		std::lock_guard<std::mutex> lock(_bufferMutex);
+		if (_freeBuffers.empty())
+			return -1;
+
+		int index = _freeBuffers.back();
+		_freeBuffers.pop_back();
+		return index;
+	}
+
+	void releaseBuffer(int index)
+	{
+		std::lock_guard<std::mutex> lock(_bufferMutex);
+		_freeBuffers.push_back(index);
+	}
+
+	void prepareTarget(Request& request)
+	{
+		request.bufferIndex = acquireBuffer(request.size);
+
+		if (request.bufferIndex >= 0)
+		{
+			request.target = getBuffer(request.bufferIndex);
+		}
+		else
+		{
+			request.heap.resize(request.size);
+			request.target = request.heap.data();
+		}
+	}
+
+	void finish(Request& request, bool success)
+	{
+		if (!success)
+			std::cerr << "ERROR::ASYNC_IO::READ_FAILED - " << request.path << "\n";
+
+		AssetBlob blob;
+
+		if (!success)
+		{
+			if (request.bufferIndex >= 0)
+				releaseBuffer(request.bufferIndex);
+		}
+		else if (request.bufferIndex >= 0)
+		{
+			// Buffer returns to the pool once the last blob referencing it is destroyed
+			int index = request.bufferIndex;
+			std::shared_ptr<void> lease(getBuffer(index), [this, index](void*) { releaseBuffer(index); });
+			blob = AssetBlob(request.target, request.size, std::move(lease));
+		}
+		else
+		{
+			blob = AssetBlob(std::move(request.heap));
+		}
+
+		request.callback(std::move(blob));
+
+		{
+			std::lock_guard<std::mutex> lock(_idleMutex);
+			_outstanding--;
+		}
+
+		_idleCondition.notify_all();
+	}
+
+#ifndef _WIN32
+	// Positioned reads do not share a file position, so they work the same for whole files and ranges of pack files
+	void readBlocking(Request& request)
+	{
+		request.fd = open(request.path.c_str(), O_RDONLY | O_CLOEXEC);
+
+		struct stat fileStat;
+		if (request.fd < 0 || fstat(request.fd, &fileStat) != 0)
+		{
+			if (request.fd >= 0)
+				close(request.fd);
+			finish(request, false);
+			return;
+		}
+
+		request.size = static_cast<size_t>(fileStat.st_size);
+		prepareTarget(request);
+
+		// Short reads continue from where they stopped, end of file before expected size is an error
+		bool success = true;
+		while (request.done < request.size)
+		{
+			size_t remaining = std::min<size_t>(request.size - request.done, 1u << 30);
+			ssize_t result = pread(request.fd, request.target + request.done, remaining, static_cast<off_t>(request.done));
+			if (result < 0 && errno == EINTR)
+				continue;
+
+			if (result <= 0)
+			{
+				success = false;
+				break;
+			}
+
+			request.done += static_cast<size_t>(result);
+		}
+
+		close(request.fd);
+		finish(request, success);
+	}
+#else
+	void readBlocking(Request& request)
+	{
+		std::ifstream file(request.path, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+		{
+			finish(request, false);
+			return;
+		}
+
+		request.size = static_cast<size_t>(file.tellg());
+		prepareTarget(request);
+
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(request.target), request.size);
+		finish(request, static_cast<size_t>(file.gcount()) == request.size);
+	}
+#endif
+
+#ifdef ASYNC_IO_URING
+	void submitRing(Request* request)
+	{
+		request->fd = open(request->path.c_str(), O_RDONLY | O_CLOEXEC);
+
+		struct stat fileStat;
+		if (request->fd < 0 || fstat(request->fd, &fileStat) != 0)
+		{
+			completeRing(request, false);
+			return;
+		}
+
+		request->size = static_cast<size_t>(fileStat.st_size);
+		prepareTarget(*request);
+
+		if (request->size == 0)
+		{
+			completeRing(request, true);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_submitMutex);
+			_pending.push_back(request);
+			pumpRing();
+		}
+	}
+
+	// Move pending requests into the ring while it has room (caller holds submit mutex)
+	void pumpRing()
+	{
+		while (!_pending.empty() && _inFlight < _queueDepth)
+		{
+			io_uring_sqe* sqe = _ring->getSqe();
+			if (!sqe)
+				break;
+
+			Request* request = _pending.front();
+			_pending.pop_front();
+
+			size_t remaining = request->size - request->done;
+
+			sqe->fd = request->fd;
+			sqe->addr = reinterpret_cast<uint64_t>(request->target + request->done);
+			sqe->len = static_cast<uint32_t>(std::min<size_t>(remaining, 1u << 30));
+			sqe->off = request->done;
+			sqe->user_data = reinterpret_cast<uint64_t>(request);
+
+			if (_buffersRegistered && request->bufferIndex >= 0)
+			{
+				sqe->opcode = IORING_OP_READ_FIXED;
+				sqe->buf_index = static_cast<uint16_t>(request->bufferIndex);
+			}
+			else
+			{
+				sqe->opcode = IORING_OP_READ;
+			}
+
+			_inFlight++;
+		}
+
+		if (!_ring->submit())
+			std::cerr << "ERROR::ASYNC_IO::SUBMIT_FAILED" << "\n";
+	}
+
+	void completeRing(Request* request, bool success)
+	{
+		if (request->fd >= 0)
+			close(request->fd);
+
+		finish(*request, success);
+		delete request;
+	}
+
+	void completionLoop()
+	{
+		io_uring_cqe completion;
+
+		while (_ring->waitCompletion(completion))
+		{
+			if (completion.user_data == 0)
+				return;
+
+			Request* request = reinterpret_cast<Request*>(completion.user_data);
+
+			bool retry = completion.res == -EAGAIN || completion.res == -EINTR;
+			if (completion.res > 0)
+				request->done += static_cast<size_t>(completion.res);
+
+			// Short reads continue from where they stopped, end of file before expected size is an error
+			bool isDone = completion.res >= 0 && request->done >= request->size;
+			bool isFailed = !retry && (completion.res < 0 || (completion.res == 0 && !isDone));
+
+			{
+				std::lock_guard<std::mutex> lock(_submitMutex);
+				_inFlight--;
+
+				if (!isDone && !isFailed)
+					_pending.push_front(request);
+
+				pumpRing();
+			}
+
+			if (isDone || isFailed)
+				completeRing(request, isDone);
+		}
+	}
+#endif
+};
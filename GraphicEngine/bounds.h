@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cfloat>
+#include <glm.hpp>
+
+// Axis aligned bounding box
+struct AABB
+{
+	glm::vec3 min = glm::vec3(FLT_MAX);
+	glm::vec3 max = glm::vec3(-FLT_MAX);
+
+	bool isValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+
+	glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+	glm::vec3 getExtents() const { return (max - min) * 0.5f; }
+
+	void expand(const glm::vec3& point)
+	{
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	void expand(const AABB& other)
+	{
+		min = glm::min(min, other.min);
+		max = glm::max(max, other.max);
+	}
+
+	// Cost metric of bounding volume hierarchies (probability of a random ray hitting the box)
+	float getSurfaceArea() const
+	{
+		glm::vec3 size = max - min;
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	bool contains(const AABB& other) const
+	{
+		return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+	}
+
+	bool overlaps(const AABB& other) const
+	{
+		return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+	}
+
+	static AABB merge(const AABB& a, const AABB& b)
+	{
+		return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+	}
+
+	// Bounds of this box after transformation (stays axis aligned)
+	AABB transformed(const glm::mat4& matrix) const
+	{
+		glm::vec3 center = glm::vec3(matrix * glm::vec4(getCenter(), 1.0f));
+		glm::vec3 extents = getExtents();
+
+		glm::mat3 absMatrix = glm::mat3(matrix);
+		for (int i = 0; i < 3; ++i)
+			absMatrix[i] = glm::abs(absMatrix[i]);
+
+		glm::vec3 newExtents = absMatrix * extents;
+		return { center - newExtents, center + newExtents };
+	}
+};
+
+struct BoundingSphere
+{
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 0.0f;
+};
+
+// View frustum planes (xyz = inward normal, w = distance), extracted from view-projection matrix
+struct Frustum
+{
+	glm::vec4 planes[6];
+
+	static Frustum fromMatrix(const glm::mat4& viewProjection)
+	{
+		glm::mat4 m = glm::transpose(viewProjection);
+
+		Frustum frustum;
+		frustum.planes[0] = m[3] + m[0];	// Left
+		frustum.planes[1] = m[3] - m[0];	// Right
+		frustum.planes[2] = m[3] + m[1];	// Bottom
+		frustum.planes[3] = m[3] - m[1];	// Top
+		frustum.planes[4] = m[3] + m[2];	// Near
+		frustum.planes[5] = m[3] - m[2];	// Far
+
+		for (auto& plane : frustum.planes)
+			plane /= glm::length(glm::vec3(plane));
+
+		return frustum;
+	}
+
+	bool intersects(const glm::vec3& center, float radius) const
+	{
+		for (const auto& plane : planes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				return false;
+		}
+		return true;
+	}
+
+	bool intersects(const BoundingSphere& sphere) const { return intersects(sphere.center, sphere.radius); }
+
+	bool intersects(const AABB& box) const
+	{
+		glm::vec3 center = box.getCenter();
+		glm::vec3 extents = box.getExtents();
+
+		for (const auto& plane : planes)
+		{
+			// Projected radius of the box onto plane normal
+			float radius = glm::dot(extents, glm::abs(glm::vec3(plane)));
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				return false;
+		}
+		return true;
+	}
+};
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <glad.h>
+#include <glm.hpp>
+
+#include "mesh.h"
+#include "bounds.h"
+#include "occlusion_culler.h"
+#include "depth_pyramid.h"
+#include "render_world.h"
+
+struct ClusterCullStats
+{
+	size_t testedCount = 0;
+	size_t frustumCulled = 0;
+	size_t backfaceCulled = 0;
+	size_t occlusionCulled = 0;
+};
+
+// Per-meshlet culling of individually drawn meshes. Every mesh added in a frame gets a range of indirect commands,
+// visible meshlets are written there either on the CPU (reference) or by meshlet_cull.comp and drawn with one
+// multi-draw per mesh. Meshes without meshlets are drawn whole
+class ClusterCuller
+{
+public:
+	static constexpr GLuint MeshletBindingPoint = 5;
+	static constexpr GLuint CommandBindingPoint = 6;
+	static constexpr GLuint DrawCountBindingPoint = 7;
+	static constexpr size_t CullGroupSize = 64;
+
+private:
+	struct ClusterDraw
+	{
+		Mesh* mesh = nullptr;
+		glm::mat4 modelMatrix = glm::mat4(1.0f);
+		size_t commandOffset = 0;
+		size_t commandCount = 0;
+	};
+
+	std::vector<ClusterDraw> _draws;
+	std::vector<DrawElementsIndirectCommand> _commands;
+
+	Frustum _frustum = {};
+	glm::vec3 _cameraPosition = glm::vec3(0.0f);
+	size_t _meshletCount = 0;
+
+	// Commands were written by the GPU, draw counts have to be read from the count buffer
+	bool _isCulledOnGPU = false;
+
+	GLuint _commandBuffer = 0;
+	size_t _commandCapacity = 0;
+	GLuint _drawCountBuffer = 0;
+	size_t _drawCountCapacity = 0;
+
+	ClusterCullStats _stats;
+
+public:
+	ClusterCuller() = default;
+
+	~ClusterCuller()
+	{
+		if (_commandBuffer) glDeleteBuffers(1, &_commandBuffer);
+		if (_drawCountBuffer) glDeleteBuffers(1, &_drawCountBuffer);
+	}
+
+	ClusterCuller(const ClusterCuller&) = delete;
+	ClusterCuller& operator=(const ClusterCuller&) = delete;
+
+	// Only tested count is known for GPU culling, results are not read back
+	const ClusterCullStats& getStats() const { return _stats; }
+
+	void beginFrame(const Frustum& frustum, const glm::vec3& cameraPosition)
+	{
+		_draws.clear();
+		_frustum = frustum;
+		_cameraPosition = cameraPosition;
+		_meshletCount = 0;
+		_stats = ClusterCullStats();
+	}
+
+	void add(Mesh& mesh, const glm::mat4& modelMatrix)
+	{
+		ClusterDraw draw;
+		draw.mesh = &mesh;
+		draw.modelMatrix = modelMatrix;
+		draw.commandOffset = _meshletCount;
+
+		_meshletCount += mesh.getMeshlets().size();
+		_draws.push_back(draw);
+	}
+
+	// Reference implementation, same tests as meshlet_cull.comp. Neighbouring visible meshlets are merged into one command
+	void cull(const OcclusionCuller* occlusion = nullptr)
+	{
+		_isCulledOnGPU = false;
+		_commands.clear();
+
+		for (auto& draw : _draws)
+		{
+			draw.commandOffset = _commands.size();
+
+			const std::vector<Meshlet>& meshlets = draw.mesh->getMeshlets();
+			if (meshlets.empty())
+			{
+				draw.commandCount = 0;
+				continue;
+			}
+
+			float maxScale;
+			bool useCone = hasUniformScale(draw.modelMatrix, maxScale);
+			glm::vec3 localCamera = glm::vec3(glm::inverse(draw.modelMatrix) * glm::vec4(_cameraPosition, 1.0f));
+
+			for (const auto& meshlet : meshlets)
+			{
+				_stats.testedCount++;
+
+				glm::vec3 center = glm::vec3(draw.modelMatrix * glm::vec4(glm::vec3(meshlet.boundingSphere), 1.0f));
+				if (!_frustum.intersects(center, meshlet.boundingSphere.w * maxScale))
+				{
+					_stats.frustumCulled++;
+					continue;
+				}
+
+				if (useCone && meshlet.isBackfacing(localCamera))
+				{
+					_stats.backfaceCulled++;
+					continue;
+				}
+
+				if (occlusion)
+				{
+					glm::vec3 extents(meshlet.boundingSphere.w);
+					AABB bounds{ glm::vec3(meshlet.boundingSphere) - extents, glm::vec3(meshlet.boundingSphere) + extents };
+					if (!occlusion->isVisible(bounds, draw.modelMatrix))
+					{
+						_stats.occlusionCulled++;
+						continue;
+					}
+				}
+
+				// Meshlets are consecutive in the index buffer
+				if (_commands.size() > draw.commandOffset && _commands.back().firstIndex + _commands.back().count == meshlet.firstIndex)
+				{
+					_commands.back().count += meshlet.indexCount;
+					continue;
+				}
+
+				DrawElementsIndirectCommand command;
+				command.count = meshlet.indexCount;
+				command.instanceCount = 1;
+				command.firstIndex = meshlet.firstIndex;
+				_commands.push_back(command);
+			}
+
+			draw.commandCount = _commands.size() - draw.commandOffset;
+		}
+
+		if (_commands.empty())
+			return;
+
+		reserveCommands(_commands.size());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _commandBuffer);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, _commands.size() * sizeof(DrawElementsIndirectCommand), _commands.data());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+	// One dispatch per mesh, commands are compacted into the mesh range and counted in the draw count buffer
+	void cullOnGPU(const Shader& cullShader, const DepthPyramid* depthPyramid = nullptr)
+	{
+		_isCulledOnGPU = true;
+
+		if (_draws.empty())
+			return;
+
+		reserveCommands(std::max<size_t>(_meshletCount, 1));
+		reserveDrawCounts(_draws.size());
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CommandBindingPoint, _commandBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DrawCountBindingPoint, _drawCountBuffer);
+
+		// Counts start at zero every frame, null data clears to zero
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _drawCountBuffer);
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+		cullShader.use();
+		for (int i = 0; i < 6; ++i)
+			cullShader.set("frustum_planes[" + std::to_string(i) + "]", _frustum.planes[i]);
+
+		bool useOcclusion = depthPyramid && depthPyramid->isValid();
+		cullShader.set("occlusion_enabled", useOcclusion);
+		if (useOcclusion)
+		{
+			depthPyramid->bind(0);
+			cullShader.set("pyramid_view_projection", depthPyramid->getViewProjection());
+			cullShader.set("pyramid_size", glm::vec2(depthPyramid->getWidth(), depthPyramid->getHeight()));
+		}
+
+		for (size_t drawIndex = 0; drawIndex < _draws.size(); ++drawIndex)
+		{
+			ClusterDraw& draw = _draws[drawIndex];
+			const std::vector<Meshlet>& meshlets = draw.mesh->getMeshlets();
+			draw.commandCount = meshlets.size();
+
+			if (meshlets.empty())
+				continue;
+
+			_stats.testedCount += meshlets.size();
+
+			float maxScale;
+			bool useCone = hasUniformScale(draw.modelMatrix, maxScale);
+
+			cullShader.set("model_matrix", draw.modelMatrix);
+			cullShader.set("max_scale", maxScale);
+			cullShader.set("cone_enabled", useCone);
+			cullShader.set("local_camera_position", glm::vec3(glm::inverse(draw.modelMatrix) * glm::vec4(_cameraPosition, 1.0f)));
+			cullShader.set("meshlet_count", static_cast<unsigned>(meshlets.size()));
+			cullShader.set("command_offset", static_cast<unsigned>(draw.commandOffset));
+			cullShader.set("draw_index", static_cast<unsigned>(drawIndex));
+
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MeshletBindingPoint, draw.mesh->getMeshletBuffer());
+			Shader::dispatch(static_cast<GLuint>((meshlets.size() + CullGroupSize - 1) / CullGroupSize));
+		}
+
+		// Commands and counts are consumed as indirect draw parameters
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+
+	// Draw visible meshlets of every added mesh with its model matrix
+	void render(const Shader& shader)
+	{
+		shader.use();
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _commandBuffer);
+		if (_isCulledOnGPU)
+			glBindBuffer(GL_PARAMETER_BUFFER, _drawCountBuffer);
+
+		for (size_t drawIndex = 0; drawIndex < _draws.size(); ++drawIndex)
+		{
+			const ClusterDraw& draw = _draws[drawIndex];
+
+			if (draw.mesh->getMeshlets().empty())
+			{
+				draw.mesh->render(shader);
+				continue;
+			}
+
+			if (draw.commandCount == 0)
+				continue;
+
+			shader.set("model_matrix", draw.modelMatrix);
+			glBindVertexArray(draw.mesh->getVAO());
+
+			void* commands = (void*)(draw.commandOffset * sizeof(DrawElementsIndirectCommand));
+			if (_isCulledOnGPU)
+				glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, commands, static_cast<GLintptr>(drawIndex * sizeof(GLuint)), static_cast<GLsizei>(draw.commandCount), 0);
+			else
+				glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, commands, static_cast<GLsizei>(draw.commandCount), 0);
+		}
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_PARAMETER_BUFFER, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+private:
+	// Normal cones are tested in mesh space, valid only if the transform keeps angles (uniform scale, no mirroring)
+	static bool hasUniformScale(const glm::mat4& modelMatrix, float& maxScale)
+	{
+		glm::vec3 scale(glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2])));
+		maxScale = glm::max(scale.x, glm::max(scale.y, scale.z));
+
+		float minScale = glm::min(scale.x, glm::min(scale.y, scale.z));
+		return minScale > 0.0f && maxScale - minScale <= 1e-3f * maxScale && glm::determinant(glm::mat3(modelMatrix)) > 0.0f;
+	}
+
+	void reserveCommands(size_t count)
+	{
+		if (!_commandBuffer)
+			glGenBuffers(1, &_commandBuffer);
+
+		if (count <= _commandCapacity)
+			return;
+
+		_commandCapacity = std::max(count, _commandCapacity * 2);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _commandBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, _commandCapacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+	void reserveDrawCounts(size_t count)
+	{
+		if (!_drawCountBuffer)
+			glGenBuffers(1, &_drawCountBuffer);
+
+		if (count <= _drawCountCapacity)
+			return;
+
+		_drawCountCapacity = std::max(count, _drawCountCapacity * 2);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _drawCountBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, _drawCountCapacity * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+};
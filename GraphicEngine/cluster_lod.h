@@ -0,0 +1,523 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <glm.hpp>
+
+#include "vertex.h"
+#include "bounds.h"
+#include "meshlet.h"
+#include "mesh_simplifier.h"
+#include "lz4_codec.h"
+#include "asset_pack.h"
+
+// Hierarchy of simplified clusters (DAG) stored in independently loadable pages.
+// Clusters of one level are joined into groups, a group is simplified to half of its triangles and split again into
+// clusters of the next level. Group borders stay locked, so any cut through the DAG is crack free. A group is drawn
+// refined (its input clusters instead of its output clusters) while its projected error is above the threshold.
+//
+// File layout: header, groups, group parents, page table, LZ4 compressed pages.
+// Page i < groupCount holds the input clusters of group i, remaining pages hold root clusters (never simplified further)
+struct ClusterLODHeader
+{
+	char magic[4] = { 'G', 'C', 'L', 'D' };
+	uint32_t version = 2;
+	uint32_t vertexSize = sizeof(Vertex);
+	uint32_t groupCount = 0;
+	uint32_t parentCount = 0;
+	uint32_t pageCount = 0;
+	uint32_t maxPageVertices = 0;
+	uint32_t maxPageIndices = 0;
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+};
+
+// Always resident, a few dozen bytes per group
+struct ClusterLODGroup
+{
+	glm::vec4 lodSphere = glm::vec4(0.0f);	// Contains lod spheres of all input clusters (error is measured from it)
+	float error = 0.0f;						// Object space error of output clusters, never smaller than error of inputs
+	uint32_t firstParent = 0;				// Groups consuming output clusters (outputs that are roots are not listed)
+	uint32_t parentCount = 0;
+	uint32_t padding = 0;
+};
+
+struct ClusterLODPageInfo
+{
+	uint64_t offset = 0;
+	uint32_t storedSize = 0;
+	uint32_t size = 0;
+};
+
+struct ClusterLODPageHeader
+{
+	uint32_t clusterCount = 0;
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	uint32_t padding = 0;
+};
+
+// Cluster inside of a page, indices are relative to page vertices
+struct ClusterLODCluster
+{
+	glm::vec4 boundingSphere = glm::vec4(0.0f);
+	glm::vec4 normalCone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	uint32_t producerGroup = UINT32_MAX;	// Group which created the cluster, UINT32_MAX for source clusters
+	uint32_t padding = 0;
+};
+
+// Decoded page, indices are relative to page vertices
+struct ClusterLODPage
+{
+	std::vector<ClusterLODCluster> clusters;
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+
+	static bool decode(const unsigned char* stored, const ClusterLODPageInfo& info, ClusterLODPage& page)
+	{
+		std::vector<unsigned char> data(info.size);
+		if (info.size < sizeof(ClusterLODPageHeader) || !LZ4Codec::decompress(stored, info.storedSize, data.data(), data.size()))
+			return false;
+
+		ClusterLODPageHeader header;
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		size_t expected = sizeof(header) + size_t(header.clusterCount) * sizeof(ClusterLODCluster)
+			+ size_t(header.vertexCount) * sizeof(Vertex) + size_t(header.indexCount) * sizeof(uint32_t);
+		if (expected != data.size())
+			return false;
+
+		const unsigned char* read = data.data() + sizeof(header);
+		page.clusters.resize(header.clusterCount);
+		page.vertices.resize(header.vertexCount);
+		page.indices.resize(header.indexCount);
+
+		std::memcpy(page.clusters.data(), read, page.clusters.size() * sizeof(ClusterLODCluster));
+		read += page.clusters.size() * sizeof(ClusterLODCluster);
+		std::memcpy(page.vertices.data(), read, page.vertices.size() * sizeof(Vertex));
+		read += page.vertices.size() * sizeof(Vertex);
+		std::memcpy(page.indices.data(), read, page.indices.size() * sizeof(uint32_t));
+
+		for (const auto& cluster : page.clusters)
+		{
+			if (static_cast<uint64_t>(cluster.firstIndex) + cluster.indexCount > page.indices.size())
+				return false;
+		}
+
+		for (uint32_t index : page.indices)
+		{
+			if (index >= page.vertices.size())
+				return false;
+		}
+
+		return true;
+	}
+};
+
+// Offline construction of the DAG (used by the asset cooker)
+class ClusterLODBuilder
+{
+public:
+	static constexpr size_t GroupSize = 8;		// Clusters joined for one simplification, also the page size in clusters
+	static constexpr size_t MaxLevels = 24;
+
+	// Group is kept only if simplification removed at least this fraction of triangles
+	static constexpr float MinReduction = 0.15f;
+
+private:
+	struct BuildCluster
+	{
+		std::vector<unsigned> indices;		// Into source vertices
+		glm::vec4 boundingSphere = glm::vec4(0.0f);
+		glm::vec4 normalCone = glm::vec4(0.0f);
+		glm::vec4 lodSphere = glm::vec4(0.0f);
+		float error = 0.0f;
+		uint32_t producerGroup = UINT32_MAX;
+		uint32_t consumerGroup = UINT32_MAX;
+	};
+
+	struct BuildGroup
+	{
+		std::vector<uint32_t> inputs;
+		std::vector<uint32_t> outputs;
+		glm::vec4 lodSphere = glm::vec4(0.0f);
+		float error = 0.0f;
+	};
+
+public:
+	// Vertices should be welded. Returns encoded file, empty on failure
+	static std::vector<unsigned char> build(const std::vector<Vertex>& vertices, const std::vector<unsigned>& sourceIndices)
+	{
+		if (sourceIndices.size() < 3 || vertices.empty())
+			return {};
+
+		std::vector<BuildCluster> clusters;
+		std::vector<BuildGroup> groups;
+
+		// Source level
+		std::vector<unsigned> indices = sourceIndices;
+		std::vector<Meshlet> meshlets = MeshletBuilder::build(vertices, indices);
+		std::vector<uint32_t> level;
+
+		for (const auto& meshlet : meshlets)
+		{
+			BuildCluster cluster;
+			cluster.indices.assign(indices.begin() + meshlet.firstIndex, indices.begin() + meshlet.firstIndex + meshlet.indexCount);
+			cluster.boundingSphere = meshlet.boundingSphere;
+			cluster.normalCone = meshlet.normalCone;
+			cluster.lodSphere = meshlet.boundingSphere;
+
+			level.push_back(static_cast<uint32_t>(clusters.size()));
+			clusters.push_back(std::move(cluster));
+		}
+
+		std::vector<uint32_t> positionIds = findPositionIds(vertices);
+
+		for (size_t depth = 0; depth < MaxLevels && level.size() > 1; ++depth)
+		{
+			std::vector<uint32_t> nextLevel;
+			bool isSimplified = false;
+
+			for (auto& groupClusters : partition(clusters, level, positionIds))
+			{
+				// Single clusters have locked borders all around, there is nothing to gain
+				if (groupClusters.size() == 1 || !simplifyGroup(vertices, clusters, groups, groupClusters, nextLevel))
+				{
+					nextLevel.insert(nextLevel.end(), groupClusters.begin(), groupClusters.end());
+					continue;
+				}
+
+				isSimplified = true;
+			}
+
+			level.swap(nextLevel);
+			if (!isSimplified)
+				break;
+		}
+
+		return encode(vertices, clusters, groups);
+	}
+
+private:
+	// Vertices split by attribute seams share the position id, clusters touching only through a seam are still neighbours
+	static std::vector<uint32_t> findPositionIds(const std::vector<Vertex>& vertices)
+	{
+		struct PositionHash
+		{
+			size_t operator()(const glm::vec3& p) const { return static_cast<size_t>(hashFNV1a(&p, sizeof(p))); }
+		};
+
+		std::unordered_map<glm::vec3, uint32_t, PositionHash> unique;
+		unique.reserve(vertices.size());
+
+		std::vector<uint32_t> ids(vertices.size());
+		for (size_t v = 0; v < vertices.size(); ++v)
+			ids[v] = unique.try_emplace(vertices[v].position, static_cast<uint32_t>(v)).first->second;
+		return ids;
+	}
+
+	// Groups of up to GroupSize clusters, grown from spatially sorted seeds by the number of shared vertices
+	static std::vector<std::vector<uint32_t>> partition(const std::vector<BuildCluster>& clusters, const std::vector<uint32_t>& level,
+		const std::vector<uint32_t>& positionIds)
+	{
+		// Clusters (positions in level) around every position
+		std::unordered_map<uint32_t, std::vector<uint32_t>> positionClusters;
+		for (uint32_t i = 0; i < level.size(); ++i)
+		{
+			for (unsigned index : clusters[level[i]].indices)
+			{
+				std::vector<uint32_t>& list = positionClusters[positionIds[index]];
+				if (list.empty() || list.back() != i)
+					list.push_back(i);
+			}
+		}
+
+		// Shared position counts between neighbouring clusters
+		std::vector<std::unordered_map<uint32_t, uint32_t>> neighbours(level.size());
+		for (const auto& [position, list] : positionClusters)
+		{
+			for (size_t a = 0; a < list.size(); ++a)
+			{
+				for (size_t b = a + 1; b < list.size(); ++b)
+				{
+					neighbours[list[a]][list[b]]++;
+					neighbours[list[b]][list[a]]++;
+				}
+			}
+		}
+
+		std::vector<glm::vec3> centers(level.size());
+		for (size_t i = 0; i < level.size(); ++i)
+			centers[i] = glm::vec3(clusters[level[i]].boundingSphere);
+
+		std::vector<uint32_t> seeds = MeshletBuilder::sortSpatially(centers);
+		std::vector<uint8_t> isGrouped(level.size(), 0);
+		std::vector<std::vector<uint32_t>> result;
+
+		for (uint32_t seed : seeds)
+		{
+			if (isGrouped[seed])
+				continue;
+
+			std::vector<uint32_t> group = { seed };
+			std::unordered_map<uint32_t, uint32_t> candidates;
+			isGrouped[seed] = 1;
+
+			while (group.size() < GroupSize)
+			{
+				for (const auto& [neighbour, shared] : neighbours[group.back()])
+				{
+					if (!isGrouped[neighbour])
+						candidates[neighbour] += shared;
+				}
+
+				uint32_t best = UINT32_MAX;
+				uint32_t bestShared = 0;
+				for (const auto& [candidate, shared] : candidates)
+				{
+					if (!isGrouped[candidate] && (shared > bestShared || (shared == bestShared && candidate < best)))
+					{
+						best = candidate;
+						bestShared = shared;
+					}
+				}
+
+				if (best == UINT32_MAX)
+					break;
+
+				isGrouped[best] = 1;
+				candidates.erase(best);
+				group.push_back(best);
+			}
+
+			for (auto& member : group)
+				member = level[member];
+
+			result.push_back(std::move(group));
+		}
+
+		return result;
+	}
+
+	// Merge, simplify to half and split into new clusters. False if the group could not be simplified enough
+	static bool simplifyGroup(const std::vector<Vertex>& vertices, std::vector<BuildCluster>& clusters, std::vector<BuildGroup>& groups,
+		const std::vector<uint32_t>& groupClusters, std::vector<uint32_t>& nextLevel)
+	{
+		// Local vertex numbering keeps the work proportional to the group size
+		std::unordered_map<unsigned, unsigned> localIds;
+		std::vector<unsigned> globalIds;
+		std::vector<glm::vec3> positions;
+		std::vector<unsigned> merged;
+
+		for (uint32_t clusterId : groupClusters)
+		{
+			for (unsigned index : clusters[clusterId].indices)
+			{
+				auto [it, inserted] = localIds.try_emplace(index, static_cast<unsigned>(globalIds.size()));
+				if (inserted)
+				{
+					globalIds.push_back(index);
+					positions.push_back(vertices[index].position);
+				}
+				merged.push_back(it->second);
+			}
+		}
+
+		float simplifyError = 0.0f;
+		size_t targetIndexCount = (merged.size() / 6) * 3;
+		std::vector<unsigned> simplified = MeshSimplifier::simplify(positions, merged, targetIndexCount, simplifyError);
+
+		if (simplified.empty() || simplified.size() > merged.size() * (1.0f - MinReduction))
+			return false;
+
+		BuildGroup group;
+		group.inputs = groupClusters;
+
+		// Error and bounds are monotonic along the DAG, so refinement decisions of parents and children never conflict
+		group.error = simplifyError;
+		group.lodSphere = clusters[groupClusters[0]].lodSphere;
+		for (uint32_t clusterId : groupClusters)
+		{
+			group.error = std::max(group.error, clusters[clusterId].error);
+			group.lodSphere = mergeSpheres(group.lodSphere, clusters[clusterId].lodSphere);
+		}
+
+		uint32_t groupId = static_cast<uint32_t>(groups.size());
+		for (uint32_t clusterId : groupClusters)
+			clusters[clusterId].consumerGroup = groupId;
+
+		std::vector<Vertex> localVertices(globalIds.size());
+		for (size_t i = 0; i < globalIds.size(); ++i)
+			localVertices[i] = vertices[globalIds[i]];
+
+		std::vector<Meshlet> meshlets = MeshletBuilder::build(localVertices, simplified);
+		for (const auto& meshlet : meshlets)
+		{
+			BuildCluster cluster;
+			cluster.indices.reserve(meshlet.indexCount);
+			for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; ++i)
+				cluster.indices.push_back(globalIds[simplified[i]]);
+
+			cluster.boundingSphere = meshlet.boundingSphere;
+			cluster.normalCone = meshlet.normalCone;
+			cluster.lodSphere = group.lodSphere;
+			cluster.error = group.error;
+			cluster.producerGroup = groupId;
+
+			group.outputs.push_back(static_cast<uint32_t>(clusters.size()));
+			nextLevel.push_back(static_cast<uint32_t>(clusters.size()));
+			clusters.push_back(std::move(cluster));
+		}
+
+		groups.push_back(std::move(group));
+		return true;
+	}
+
+	static glm::vec4 mergeSpheres(const glm::vec4& a, const glm::vec4& b)
+	{
+		glm::vec3 offset = glm::vec3(b) - glm::vec3(a);
+		float distance = glm::length(offset);
+
+		if (distance + b.w <= a.w)
+			return a;
+		if (distance + a.w <= b.w)
+			return b;
+
+		float radius = (distance + a.w + b.w) * 0.5f;
+		glm::vec3 center = glm::vec3(a) + offset * ((radius - a.w) / distance);
+		return glm::vec4(center, radius * 1.0001f);
+	}
+
+	static std::vector<unsigned char> encode(const std::vector<Vertex>& vertices, const std::vector<BuildCluster>& clusters, const std::vector<BuildGroup>& groups)
+	{
+		// Page contents: inputs of every group, then root clusters in chunks
+		std::vector<std::vector<uint32_t>> pages;
+		for (const auto& group : groups)
+			pages.push_back(group.inputs);
+
+		std::vector<uint32_t> roots;
+		for (uint32_t clusterId = 0; clusterId < clusters.size(); ++clusterId)
+		{
+			if (clusters[clusterId].consumerGroup == UINT32_MAX)
+				roots.push_back(clusterId);
+		}
+
+		for (size_t i = 0; i < roots.size(); i += GroupSize)
+			pages.emplace_back(roots.begin() + i, roots.begin() + std::min(roots.size(), i + GroupSize));
+
+		ClusterLODHeader header;
+		header.groupCount = static_cast<uint32_t>(groups.size());
+		header.pageCount = static_cast<uint32_t>(pages.size());
+		header.maxPageVertices = static_cast<uint32_t>(GroupSize * MeshletBuilder::MaxVertices);
+		header.maxPageIndices = static_cast<uint32_t>(GroupSize * MeshletBuilder::MaxTriangles * 3);
+
+		AABB bounds;
+		for (const auto& vertex : vertices)
+			bounds.expand(vertex.position);
+		header.boundsMin = bounds.min;
+		header.boundsMax = bounds.max;
+
+		std::vector<ClusterLODGroup> groupTable(groups.size());
+		std::vector<uint32_t> parents;
+		for (size_t g = 0; g < groups.size(); ++g)
+		{
+			groupTable[g].lodSphere = groups[g].lodSphere;
+			groupTable[g].error = groups[g].error;
+			groupTable[g].firstParent = static_cast<uint32_t>(parents.size());
+
+			for (uint32_t output : groups[g].outputs)
+			{
+				uint32_t consumer = clusters[output].consumerGroup;
+				if (consumer != UINT32_MAX && std::find(parents.begin() + groupTable[g].firstParent, parents.end(), consumer) == parents.end())
+					parents.push_back(consumer);
+			}
+
+			groupTable[g].parentCount = static_cast<uint32_t>(parents.size()) - groupTable[g].firstParent;
+		}
+		header.parentCount = static_cast<uint32_t>(parents.size());
+
+		std::vector<ClusterLODPageInfo> pageTable(pages.size());
+		std::vector<std::vector<unsigned char>> storedPages(pages.size());
+
+		for (size_t p = 0; p < pages.size(); ++p)
+		{
+			std::vector<unsigned char> data = encodePage(vertices, clusters, pages[p]);
+			storedPages[p] = LZ4Codec::compress(data.data(), data.size());
+			pageTable[p].size = static_cast<uint32_t>(data.size());
+			pageTable[p].storedSize = static_cast<uint32_t>(storedPages[p].size());
+		}
+
+		std::vector<unsigned char> output;
+		append(output, &header, sizeof(header));
+		append(output, groupTable.data(), groupTable.size() * sizeof(ClusterLODGroup));
+		append(output, parents.data(), parents.size() * sizeof(uint32_t));
+
+		uint64_t offset = output.size() + pageTable.size() * sizeof(ClusterLODPageInfo);
+		for (size_t p = 0; p < pages.size(); ++p)
+		{
+			pageTable[p].offset = offset;
+			offset += storedPages[p].size();
+		}
+
+		append(output, pageTable.data(), pageTable.size() * sizeof(ClusterLODPageInfo));
+		for (const auto& stored : storedPages)
+			append(output, stored.data(), stored.size());
+
+		return output;
+	}
+
+	static std::vector<unsigned char> encodePage(const std::vector<Vertex>& vertices, const std::vector<BuildCluster>& clusters, const std::vector<uint32_t>& pageClusters)
+	{
+		std::unordered_map<unsigned, uint32_t> localIds;
+		std::vector<Vertex> pageVertices;
+		std::vector<uint32_t> pageIndices;
+		std::vector<ClusterLODCluster> records;
+
+		for (uint32_t clusterId : pageClusters)
+		{
+			const BuildCluster& cluster = clusters[clusterId];
+
+			ClusterLODCluster record;
+			record.boundingSphere = cluster.boundingSphere;
+			record.normalCone = cluster.normalCone;
+			record.firstIndex = static_cast<uint32_t>(pageIndices.size());
+			record.indexCount = static_cast<uint32_t>(cluster.indices.size());
+			record.producerGroup = cluster.producerGroup;
+			records.push_back(record);
+
+			for (unsigned index : cluster.indices)
+			{
+				auto [it, inserted] = localIds.try_emplace(index, static_cast<uint32_t>(pageVertices.size()));
+				if (inserted)
+					pageVertices.push_back(vertices[index]);
+				pageIndices.push_back(it->second);
+			}
+		}
+
+		ClusterLODPageHeader header;
+		header.clusterCount = static_cast<uint32_t>(records.size());
+		header.vertexCount = static_cast<uint32_t>(pageVertices.size());
+		header.indexCount = static_cast<uint32_t>(pageIndices.size());
+
+		std::vector<unsigned char> output;
+		append(output, &header, sizeof(header));
+		append(output, records.data(), records.size() * sizeof(ClusterLODCluster));
+		append(output, pageVertices.data(), pageVertices.size() * sizeof(Vertex));
+		append(output, pageIndices.data(), pageIndices.size() * sizeof(uint32_t));
+		return output;
+	}
+
+	static void append(std::vector<unsigned char>& output, const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		output.insert(output.end(), bytes, bytes + size);
+	}
+};
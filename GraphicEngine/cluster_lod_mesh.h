@@ -0,0 +1,529 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <glad.h>
+#include <glm.hpp>
+
+#include "cluster_lod.h"
+#include "cooked_asset.h"
+#include "mapped_file.h"
+#include "job_system.h"
+#include "render_world.h"
+
+struct ClusterLODStats
+{
+	size_t groupCount = 0;
+	size_t pageCount = 0;
+	size_t residentPages = 0;
+	size_t pendingPages = 0;		// Being read and decoded
+	size_t loadedPages = 0;			// During last update
+	size_t evictedPages = 0;		// During last update
+	size_t drawnClusters = 0;
+	size_t drawnTriangles = 0;
+	size_t residentBytes = 0;
+	size_t budgetBytes = 0;
+};
+
+// Runtime of a cluster LOD file (see ClusterLODBuilder). Only group metadata is kept in memory, geometry pages are
+// decoded on worker threads from the memory mapped file when the view needs them and uploaded into a fixed pool
+// of GPU page slots, so memory use is bounded by the budget no matter how large the source mesh is.
+// Root pages (coarsest clusters) are always resident, finer pages are evicted least recently used first
+class ClusterLODMesh
+{
+private:
+	enum class PageState : uint8_t
+	{
+		Unloaded,
+		Loading,
+		Resident
+	};
+
+	struct PageEntry
+	{
+		PageState state = PageState::Unloaded;
+		uint32_t slot = UINT32_MAX;
+		uint64_t lastUsedFrame = 0;
+		std::vector<ClusterLODCluster> clusters;		// Kept for selection while resident
+	};
+
+	// Shared with loading jobs, which can outlive the mesh
+	struct LoadQueue
+	{
+		AssetBlob file;
+		std::mutex mutex;
+		std::vector<std::pair<uint32_t, ClusterLODPage>> completed;
+		std::vector<uint32_t> failed;
+	};
+
+	std::shared_ptr<LoadQueue> _loadQueue;
+	std::string _path;
+
+	ClusterLODHeader _header;
+	std::vector<ClusterLODGroup> _groups;
+	std::vector<uint32_t> _parents;
+	std::vector<ClusterLODPageInfo> _pageInfos;
+	std::vector<PageEntry> _pages;
+
+	std::vector<uint32_t> _freeSlots;
+	uint32_t _slotCount = 0;
+	size_t _slotBytes = 0;
+
+	size_t _budgetBytes = 0;
+	size_t _maxPendingPages = 0;
+	size_t _pendingPages = 0;
+	float _errorThreshold = 1.0f;		// Pixels
+	uint64_t _frame = 0;
+
+	std::vector<uint8_t> _isExpanded;
+	std::vector<DrawElementsIndirectCommand> _commands;
+
+	GLuint _vao = 0;
+	GLuint _vbo = 0;
+	GLuint _ebo = 0;
+	GLuint _indirectBuffer = 0;
+	size_t _indirectCapacity = 0;
+
+	glm::mat4 _modelMatrix = glm::mat4(1.0f);
+	ClusterLODStats _stats;
+
+public:
+	explicit ClusterLODMesh(size_t budgetBytes = 64ull * 1024 * 1024, size_t maxPendingPages = 16)
+		: _budgetBytes(budgetBytes), _maxPendingPages(maxPendingPages) {
+	}
+
+	~ClusterLODMesh()
+	{
+		release();
+	}
+
+	ClusterLODMesh(const ClusterLODMesh&) = delete;
+	ClusterLODMesh& operator=(const ClusterLODMesh&) = delete;
+
+	// Allowed projected error in pixels, bigger values stream less
+	void setErrorThreshold(float pixels) { _errorThreshold = std::max(pixels, 0.01f); }
+
+	bool isValid() const { return _vao != 0; }
+	const ClusterLODStats& getStats() const { return _stats; }
+	AABB getBounds() const { return { _header.boundsMin, _header.boundsMax }; }
+
+	// Opens cooked cluster LOD of the source mesh and uploads root pages, has to be called on the OpenGL context thread
+	bool open(const std::string& sourcePath)
+	{
+		release();
+
+		_path = CookedAssets::getCookedClusterLODPath(sourcePath);
+		_loadQueue = std::make_shared<LoadQueue>();
+
+		// Pages are read in place, pack entries are stored uncompressed
+		if (AssetFileSystem::isInPack(_path))
+		{
+			_loadQueue->file = AssetFileSystem::read(_path);
+		}
+		else
+		{
+			auto mapped = std::make_shared<MappedFile>();
+			if (mapped->open(_path))
+				_loadQueue->file = AssetBlob(mapped->data(), mapped->size(), mapped);
+		}
+
+		if (!readTables())
+		{
+			std::cerr << "ERROR::CLUSTER_LOD::INVALID_FILE - " << _path << "\n";
+			release();
+			return false;
+		}
+
+		// Pool fits at least the root pages and one page per group level below them
+		_slotBytes = size_t(_header.maxPageVertices) * sizeof(Vertex) + size_t(_header.maxPageIndices) * sizeof(uint32_t);
+		size_t rootPageCount = _pages.size() - _groups.size();
+		_slotCount = static_cast<uint32_t>(std::min(_pages.size(), std::max(rootPageCount + ClusterLODBuilder::MaxLevels, _budgetBytes / _slotBytes)));
+
+		createBuffers();
+		_isExpanded.assign(_groups.size(), 0);
+
+		for (uint32_t slot = _slotCount; slot > 0; --slot)
+			_freeSlots.push_back(slot - 1);
+
+		for (uint32_t page = static_cast<uint32_t>(_groups.size()); page < _pages.size(); ++page)
+		{
+			ClusterLODPage data;
+			if (!ClusterLODPage::decode(_loadQueue->file.data() + _pageInfos[page].offset, _pageInfos[page], data) || !upload(page, data))
+			{
+				std::cerr << "ERROR::CLUSTER_LOD::INVALID_PAGE - " << _path << "\n";
+				release();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Select clusters for the view, request missing pages and upload finished ones. Projection scale is
+	// viewport height / (2 * tan(fov / 2)), so errors are compared in pixels
+	void update(JobSystem& jobSystem, const glm::mat4& modelMatrix, const Frustum& frustum, const glm::vec3& cameraPosition, float projectionScale)
+	{
+		if (!isValid())
+			return;
+
+		_frame++;
+		_modelMatrix = modelMatrix;
+		_stats.loadedPages = 0;
+		_stats.evictedPages = 0;
+
+		uploadCompleted();
+
+		glm::vec3 worldScale(glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2])));
+		float maxScale = glm::max(worldScale.x, glm::max(worldScale.y, worldScale.z));
+
+		auto projectedError = [&](const ClusterLODGroup& group)
+			{
+				glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(glm::vec3(group.lodSphere), 1.0f));
+				float distance = glm::max(glm::length(center - cameraPosition) - group.lodSphere.w * maxScale, 1e-4f);
+				return group.error * maxScale * projectionScale / distance;
+			};
+
+		auto areParentsExpanded = [&](uint32_t groupId)
+			{
+				const ClusterLODGroup& group = _groups[groupId];
+				for (uint32_t i = group.firstParent; i < group.firstParent + group.parentCount; ++i)
+				{
+					if (!_isExpanded[_parents[i]])
+						return false;
+				}
+				return true;
+			};
+
+		// Parents were built after their children, so they are decided first. Group is refined only when it is
+		// resident and every group using its outputs is refined too, which keeps the cut consistent
+		for (size_t g = _groups.size(); g > 0; --g)
+		{
+			uint32_t groupId = static_cast<uint32_t>(g - 1);
+			_isExpanded[groupId] = _pages[groupId].state == PageState::Resident
+				&& projectedError(_groups[groupId]) > _errorThreshold && areParentsExpanded(groupId);
+		}
+
+		// Visible pages: roots and refined groups
+		_commands.clear();
+		_stats.drawnClusters = 0;
+		_stats.drawnTriangles = 0;
+
+		std::vector<std::pair<float, uint32_t>> requests;
+		bool useCone = glm::abs(worldScale.x - worldScale.y) <= 1e-3f * maxScale && glm::abs(worldScale.x - worldScale.z) <= 1e-3f * maxScale
+			&& glm::determinant(glm::mat3(modelMatrix)) > 0.0f;
+		glm::vec3 localCamera = glm::vec3(glm::inverse(modelMatrix) * glm::vec4(cameraPosition, 1.0f));
+
+		for (uint32_t page = 0; page < _pages.size(); ++page)
+		{
+			bool isRoot = page >= _groups.size();
+			if (!isRoot && !_isExpanded[page])
+				continue;
+
+			PageEntry& entry = _pages[page];
+			entry.lastUsedFrame = _frame;
+
+			for (const auto& cluster : entry.clusters)
+			{
+				uint32_t producer = cluster.producerGroup;
+				if (producer != UINT32_MAX && _isExpanded[producer])
+					continue;
+
+				// Finer clusters are wanted but not resident yet, nearest errors first
+				if (producer != UINT32_MAX && _pages[producer].state == PageState::Unloaded)
+				{
+					const ClusterLODGroup& group = _groups[producer];
+					glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(glm::vec3(group.lodSphere), 1.0f));
+					float error = projectedError(group);
+
+					if (error > _errorThreshold && frustum.intersects(center, group.lodSphere.w * maxScale) && areParentsExpanded(producer))
+						requests.push_back({ error, producer });
+				}
+
+				glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(glm::vec3(cluster.boundingSphere), 1.0f));
+				if (!frustum.intersects(center, cluster.boundingSphere.w * maxScale))
+					continue;
+
+				Meshlet bounds;
+				bounds.boundingSphere = cluster.boundingSphere;
+				bounds.normalCone = cluster.normalCone;
+				if (useCone && bounds.isBackfacing(localCamera))
+					continue;
+
+				DrawElementsIndirectCommand command;
+				command.count = cluster.indexCount;
+				command.instanceCount = 1;
+				command.firstIndex = entry.slot * _header.maxPageIndices + cluster.firstIndex;
+				command.baseVertex = static_cast<GLint>(entry.slot * _header.maxPageVertices);
+				_commands.push_back(command);
+
+				_stats.drawnClusters++;
+				_stats.drawnTriangles += cluster.indexCount / 3;
+			}
+		}
+
+		requestPages(jobSystem, requests);
+		uploadCommands();
+
+		_stats.groupCount = _groups.size();
+		_stats.pageCount = _pages.size();
+		_stats.residentPages = _slotCount - _freeSlots.size();
+		_stats.pendingPages = _pendingPages;
+		_stats.residentBytes = _stats.residentPages * _slotBytes;
+		_stats.budgetBytes = size_t(_slotCount) * _slotBytes;
+	}
+
+	// Clusters selected by last update()
+	void render(const Shader& shader)
+	{
+		if (_commands.empty())
+			return;
+
+		shader.use();
+		shader.set("model_matrix", _modelMatrix);
+
+		glBindVertexArray(_vao);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBuffer);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(_commands.size()), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindVertexArray(0);
+	}
+
+private:
+	bool readTables()
+	{
+		const AssetBlob& file = _loadQueue->file;
+		if (!file.isValid())
+			return false;
+
+		size_t offset = 0;
+		auto read = [&](void* target, size_t size)
+			{
+				if (offset + size > file.size())
+					return false;
+				std::memcpy(target, file.data() + offset, size);
+				offset += size;
+				return true;
+			};
+
+		if (!read(&_header, sizeof(_header)) || std::memcmp(_header.magic, ClusterLODHeader().magic, 4) != 0
+			|| _header.version != ClusterLODHeader().version || _header.vertexSize != sizeof(Vertex)
+			|| _header.pageCount < _header.groupCount || _header.maxPageVertices == 0 || _header.maxPageIndices == 0)
+			return false;
+
+		_groups.resize(_header.groupCount);
+		_parents.resize(_header.parentCount);
+		_pageInfos.resize(_header.pageCount);
+
+		if (!read(_groups.data(), _groups.size() * sizeof(ClusterLODGroup)) || !read(_parents.data(), _parents.size() * sizeof(uint32_t))
+			|| !read(_pageInfos.data(), _pageInfos.size() * sizeof(ClusterLODPageInfo)))
+			return false;
+
+		for (const auto& group : _groups)
+		{
+			if (static_cast<uint64_t>(group.firstParent) + group.parentCount > _parents.size())
+				return false;
+		}
+
+		for (size_t g = 0; g < _groups.size(); ++g)
+		{
+			const ClusterLODGroup& group = _groups[g];
+			for (uint32_t i = group.firstParent; i < group.firstParent + group.parentCount; ++i)
+			{
+				// Parents have to come later, selection relies on that order
+				if (_parents[i] <= g || _parents[i] >= _groups.size())
+					return false;
+			}
+		}
+
+		for (const auto& info : _pageInfos)
+		{
+			if (info.offset + info.storedSize > file.size())
+				return false;
+		}
+
+		_pages.resize(_header.pageCount);
+		return true;
+	}
+
+	void createBuffers()
+	{
+		glGenVertexArrays(1, &_vao);
+		glBindVertexArray(_vao);
+
+		glGenBuffers(1, &_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+		glBufferData(GL_ARRAY_BUFFER, size_t(_slotCount) * _header.maxPageVertices * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
+
+		glGenBuffers(1, &_ebo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, size_t(_slotCount) * _header.maxPageIndices * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+
+		Vertex::setupAttributes();
+
+		glBindVertexArray(0);
+
+		glGenBuffers(1, &_indirectBuffer);
+	}
+
+	void release()
+	{
+		if (_vao) glDeleteVertexArrays(1, &_vao);
+		if (_vbo) glDeleteBuffers(1, &_vbo);
+		if (_ebo) glDeleteBuffers(1, &_ebo);
+		if (_indirectBuffer) glDeleteBuffers(1, &_indirectBuffer);
+
+		_vao = _vbo = _ebo = _indirectBuffer = 0;
+		_indirectCapacity = 0;
+
+		_loadQueue.reset();
+		_groups.clear();
+		_parents.clear();
+		_pageInfos.clear();
+		_pages.clear();
+		_freeSlots.clear();
+		_commands.clear();
+		_slotCount = 0;
+		_pendingPages = 0;
+	}
+
+	void requestPages(JobSystem& jobSystem, std::vector<std::pair<float, uint32_t>>& requests)
+	{
+		std::sort(requests.begin(), requests.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+		// Pages of the current cut are never evicted, so a full pool stops streaming instead of thrashing
+		size_t room = _freeSlots.size();
+		for (uint32_t page = 0; page < _groups.size(); ++page)
+			room += _pages[page].state == PageState::Resident && _pages[page].lastUsedFrame < _frame;
+
+		for (const auto& [error, page] : requests)
+		{
+			if (_pendingPages >= std::min(_maxPendingPages, room))
+				break;
+
+			if (_pages[page].state != PageState::Unloaded)
+				continue;
+
+			_pages[page].state = PageState::Loading;
+			_pendingPages++;
+
+			jobSystem.run([queue = _loadQueue, page, info = _pageInfos[page]]()
+				{
+					ClusterLODPage data;
+					bool success = ClusterLODPage::decode(queue->file.data() + info.offset, info, data);
+
+					std::lock_guard<std::mutex> lock(queue->mutex);
+					if (success)
+						queue->completed.emplace_back(page, std::move(data));
+					else
+						queue->failed.push_back(page);
+				});
+		}
+	}
+
+	void uploadCompleted()
+	{
+		std::vector<std::pair<uint32_t, ClusterLODPage>> completed;
+		std::vector<uint32_t> failed;
+		{
+			std::lock_guard<std::mutex> lock(_loadQueue->mutex);
+			completed.swap(_loadQueue->completed);
+			failed.swap(_loadQueue->failed);
+		}
+
+		for (uint32_t page : failed)
+		{
+			// Stays marked as loading, so it is not requested again
+			std::cerr << "ERROR::CLUSTER_LOD::INVALID_PAGE - " << _path << " (page " << page << ")\n";
+			_pendingPages--;
+		}
+
+		for (auto& [page, data] : completed)
+		{
+			_pendingPages--;
+			_pages[page].state = PageState::Unloaded;
+
+			if (!upload(page, data))
+				std::cerr << "ERROR::CLUSTER_LOD::INVALID_PAGE - " << _path << " (page " << page << ")\n";
+		}
+	}
+
+	// Takes a free slot or evicts the least recently used page outside of the last selected cut
+	bool upload(uint32_t page, const ClusterLODPage& data)
+	{
+		if (data.vertices.size() > _header.maxPageVertices || data.indices.size() > _header.maxPageIndices)
+			return false;
+
+		if (_freeSlots.empty() && !evictPage())
+			return true;		// Requested again once there is room
+
+		PageEntry& entry = _pages[page];
+		entry.slot = _freeSlots.back();
+		_freeSlots.pop_back();
+
+		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+		glBufferSubData(GL_ARRAY_BUFFER, size_t(entry.slot) * _header.maxPageVertices * sizeof(Vertex), data.vertices.size() * sizeof(Vertex), data.vertices.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		// Element buffer binding is part of VAO state
+		glBindVertexArray(_vao);
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, size_t(entry.slot) * _header.maxPageIndices * sizeof(uint32_t), data.indices.size() * sizeof(uint32_t), data.indices.data());
+		glBindVertexArray(0);
+
+		entry.state = PageState::Resident;
+		entry.clusters = data.clusters;
+		entry.lastUsedFrame = _frame;
+		_stats.loadedPages++;
+		return true;
+	}
+
+	bool evictPage()
+	{
+		uint32_t victim = UINT32_MAX;
+		for (uint32_t page = 0; page < _groups.size(); ++page)
+		{
+			const PageEntry& entry = _pages[page];
+			if (entry.state != PageState::Resident || entry.lastUsedFrame + 1 >= _frame)
+				continue;
+
+			if (victim == UINT32_MAX || entry.lastUsedFrame < _pages[victim].lastUsedFrame)
+				victim = page;
+		}
+
+		if (victim == UINT32_MAX)
+			return false;
+
+		// Refinement of the group is dropped with the page, next selection falls back to its outputs
+		PageEntry& entry = _pages[victim];
+		_freeSlots.push_back(entry.slot);
+		entry.slot = UINT32_MAX;
+		entry.state = PageState::Unloaded;
+		entry.clusters.clear();
+		entry.clusters.shrink_to_fit();
+		_isExpanded[victim] = 0;
+
+		_stats.evictedPages++;
+		return true;
+	}
+
+	void uploadCommands()
+	{
+		if (_commands.empty())
+			return;
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBuffer);
+		if (_commands.size() > _indirectCapacity)
+		{
+			_indirectCapacity = std::max(_commands.size(), _indirectCapacity * 2);
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, _indirectCapacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+		}
+
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, _commands.size() * sizeof(DrawElementsIndirectCommand), _commands.data());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+};
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+
+#include "mesh.h"
+#include "texture.h"
+#include "asset_pack.h"
+
+// Binary formats written by the asset cooker. Cooked files live under Cooked/ mirroring source paths
+struct CookedMeshHeader
+{
+	char magic[4] = { 'G', 'M', 'S', 'H' };
+	uint32_t version = 3;
+	uint32_t meshCount = 0;
+	uint32_t vertexSize = sizeof(Vertex);
+};
+
+struct CookedMeshInfo
+{
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	uint32_t meshletCount = 0;
+};
+
+struct CookedTextureHeader
+{
+	char magic[4] = { 'G', 'T', 'E', 'X' };
+	uint32_t version = 1;
+	int32_t width = 0;
+	int32_t height = 0;
+	uint32_t mipCount = 0;
+	PackCompression compression = PackCompression::LZ4;		// RGBA8 mips
+};
+
+struct CookedMipInfo
+{
+	uint64_t storedSize = 0;
+	uint64_t size = 0;
+};
+
+class CookedAssets
+{
+public:
+	static constexpr const char* CookedRoot = "Cooked";
+
+	static std::string getCookedPath(const std::string& sourcePath)
+	{
+		std::string path = sourcePath;
+		std::replace(path.begin(), path.end(), '\\', '/');
+		return (std::filesystem::path(CookedRoot) / std::filesystem::path(path).lexically_normal()).generic_string();
+	}
+
+	static std::string getCookedMeshPath(const std::string& sourcePath) { return getCookedPath(sourcePath) + ".gmesh"; }
+	static std::string getCookedTexturePath(const std::string& sourcePath) { return getCookedPath(sourcePath) + ".gtex"; }
+	static std::string getCookedClusterLODPath(const std::string& sourcePath) { return getCookedPath(sourcePath) + ".gclod"; }
+
+	// Preprocessed shader if cooked, otherwise the source file
+	static std::string resolveShaderPath(const std::string& sourcePath)
+	{
+		if (sourcePath.empty())
+			return sourcePath;
+
+		std::string cookedPath = getCookedPath(sourcePath);
+		return AssetFileSystem::exists(cookedPath) ? cookedPath : sourcePath;
+	}
+
+	static std::vector<unsigned char> encodeMeshes(const std::vector<MeshData>& meshes)
+	{
+		std::vector<unsigned char> output;
+
+		CookedMeshHeader header;
+		header.meshCount = static_cast<uint32_t>(meshes.size());
+		append(output, &header, sizeof(header));
+
+		for (const auto& mesh : meshes)
+		{
+			CookedMeshInfo info{ static_cast<uint32_t>(mesh.vertices.size()), static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(mesh.meshlets.size()) };
+			append(output, &info, sizeof(info));
+		}
+
+		for (const auto& mesh : meshes)
+		{
+			append(output, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+			append(output, mesh.indices.data(), mesh.indices.size() * sizeof(GLuint));
+			append(output, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+		}
+
+		return output;
+	}
+
+	static std::vector<MeshData> decodeMeshes(const AssetBlob& file, const std::string& path)
+	{
+		std::vector<MeshData> meshes;
+
+		CookedMeshHeader header;
+		size_t offset = 0;
+
+		if (!read(file, offset, &header, sizeof(header)) || std::memcmp(header.magic, CookedMeshHeader().magic, 4) != 0
+			|| header.version != CookedMeshHeader().version || header.vertexSize != sizeof(Vertex))
+		{
+			std::cerr << "ERROR::COOKED_ASSET::INVALID_MESH - " << path << "\n";
+			return meshes;
+		}
+
+		std::vector<CookedMeshInfo> infos(header.meshCount);
+		if (!read(file, offset, infos.data(), infos.size() * sizeof(CookedMeshInfo)))
+		{
+			std::cerr << "ERROR::COOKED_ASSET::INVALID_MESH - " << path << "\n";
+			return meshes;
+		}
+
+		for (const auto& info : infos)
+		{
+			MeshData mesh;
+			mesh.vertices.resize(info.vertexCount);
+			mesh.indices.resize(info.indexCount);
+			mesh.meshlets.resize(info.meshletCount);
+
+			if (!read(file, offset, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex))
+				|| !read(file, offset, mesh.indices.data(), mesh.indices.size() * sizeof(GLuint))
+				|| !read(file, offset, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet)))
+			{
+				std::cerr << "ERROR::COOKED_ASSET::INVALID_MESH - " << path << "\n";
+				return {};
+			}
+
+			// Meshlet ranges are drawn directly, they must stay inside the index buffer
+			for (const auto& meshlet : mesh.meshlets)
+			{
+				if (static_cast<uint64_t>(meshlet.firstIndex) + meshlet.indexCount > mesh.indices.size())
+				{
+					std::cerr << "ERROR::COOKED_ASSET::INVALID_MESH - " << path << "\n";
+					return {};
+				}
+			}
+
+			meshes.push_back(std::move(mesh));
+		}
+
+		return meshes;
+	}
+
+	// Full mip chain has to be present
+	static std::vector<unsigned char> encodeTexture(const TextureData& texture)
+	{
+		std::vector<unsigned char> output;
+
+		CookedTextureHeader header;
+		header.width = texture.width;
+		header.height = texture.height;
+		header.mipCount = static_cast<uint32_t>(texture.mips.size());
+		append(output, &header, sizeof(header));
+
+		std::vector<std::vector<unsigned char>> compressed;
+		for (const auto& mip : texture.mips)
+			compressed.push_back(LZ4Codec::compress(mip.data(), mip.size()));
+
+		for (size_t level = 0; level < texture.mips.size(); ++level)
+		{
+			CookedMipInfo info{ compressed[level].size(), texture.mips[level].size() };
+			append(output, &info, sizeof(info));
+		}
+
+		for (const auto& mip : compressed)
+			append(output, mip.data(), mip.size());
+
+		return output;
+	}
+
+	static TextureData decodeTexture(const AssetBlob& file, const std::string& path)
+	{
+		TextureData texture;
+
+		CookedTextureHeader header;
+		size_t offset = 0;
+
+		if (!read(file, offset, &header, sizeof(header)) || std::memcmp(header.magic, CookedTextureHeader().magic, 4) != 0
+			|| header.version != CookedTextureHeader().version || header.compression != PackCompression::LZ4
+			|| header.width <= 0 || header.height <= 0 || header.mipCount != static_cast<uint32_t>(TextureData::computeMipCount(header.width, header.height)))
+		{
+			std::cerr << "ERROR::COOKED_ASSET::INVALID_TEXTURE - " << path << "\n";
+			return texture;
+		}
+
+		std::vector<CookedMipInfo> infos(header.mipCount);
+		if (!read(file, offset, infos.data(), infos.size() * sizeof(CookedMipInfo)))
+		{
+			std::cerr << "ERROR::COOKED_ASSET::INVALID_TEXTURE - " << path << "\n";
+			return texture;
+		}
+
+		texture.width = header.width;
+		texture.height = header.height;
+		texture.mips.resize(header.mipCount);
+
+		for (uint32_t level = 0; level < header.mipCount; ++level)
+		{
+			size_t expectedSize = size_t(std::max(1, header.width >> level)) * std::max(1, header.height >> level) * 4;
+			const CookedMipInfo& info = infos[level];
+
+			if (info.size != expectedSize || info.storedSize > file.size() - offset)
+			{
+				std::cerr << "ERROR::COOKED_ASSET::INVALID_TEXTURE - " << path << "\n";
+				return {};
+			}
+
+			texture.mips[level].resize(info.size);
+			if (!LZ4Codec::decompress(file.data() + offset, info.storedSize, texture.mips[level].data(), info.size))
+			{
+				std::cerr << "ERROR::COOKED_ASSET::INVALID_TEXTURE - " << path << "\n";
+				return {};
+			}
+
+			offset += info.storedSize;
+		}
+
+		return texture;
+	}
+
+private:
+	static void append(std::vector<unsigned char>& output, const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		output.insert(output.end(), bytes, bytes + size);
+	}
+
+	static bool read(const AssetBlob& file, size_t& offset, void* target, size_t size)
+	{
+		if (!file.isValid() || size > file.size() - offset)
+			return false;
+
+		if (size)
+			std::memcpy(target, file.data() + offset, size);
+
+		offset += size;
+		return true;
+	}
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <glad.h>
+#include <glm.hpp>
+
+#include "shader.h"
+
+// Hierarchical depth (Hi-Z) of the last rendered frame for occlusion tests on the GPU. Level 0 is a copy of the depth buffer,
+// blitted into a texture of the same format (depth blits require matching formats),
+// every next level keeps the farthest depth of the texels below it. Level sizes follow GL mip rules (halved and rounded down),
+// last texel of a level made from an odd size also covers the remaining row or column, so no depth is lost
+class DepthPyramid
+{
+public:
+	// Depth format of the default framebuffer, the window is created with matching depth and stencil bits
+	static constexpr GLenum SourceDepthFormat = GL_DEPTH24_STENCIL8;
+
+private:
+	GLuint _depthTexture = 0;
+	GLuint _depthFramebuffer = 0;
+	GLuint _pyramidTexture = 0;
+
+	int _width = 0;
+	int _height = 0;
+	int _levelCount = 0;
+
+	// Camera the pyramid was rendered with, occludees have to be projected with it
+	glm::mat4 _viewProjection = glm::mat4(1.0f);
+	bool _isValid = false;
+
+public:
+	DepthPyramid() = default;
+
+	~DepthPyramid()
+	{
+		release();
+	}
+
+	DepthPyramid(const DepthPyramid&) = delete;
+	DepthPyramid& operator=(const DepthPyramid&) = delete;
+
+	// False until first build(), culling must not use it before
+	bool isValid() const { return _isValid; }
+
+	int getWidth() const { return _width; }
+	int getHeight() const { return _height; }
+	int getLevelCount() const { return _levelCount; }
+	const glm::mat4& getViewProjection() const { return _viewProjection; }
+	GLuint getID() const { return _pyramidTexture; }
+
+	// Call after the frame is rendered, depth is read from currently bound read framebuffer (SourceDepthFormat).
+	// Shader is depth_pyramid.comp
+	void build(const Shader& shader, int width, int height, const glm::mat4& viewProjection)
+	{
+		if (width <= 0 || height <= 0)
+			return;
+
+		if (width != _width || height != _height)
+			resize(width, height);
+
+		GLint drawFramebuffer = 0;
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _depthFramebuffer);
+		glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, _depthTexture);
+
+		shader.use();
+
+		// Level 0 from depth texture
+		shader.set("copy_depth", true);
+		glBindImageTexture(1, _pyramidTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		Shader::dispatch((width + 7) / 8, (height + 7) / 8);
+
+		// Every level from the previous one
+		shader.set("copy_depth", false);
+		for (int level = 1; level < _levelCount; ++level)
+		{
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+			int levelWidth = std::max(1, width >> level);
+			int levelHeight = std::max(1, height >> level);
+
+			glBindImageTexture(0, _pyramidTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(1, _pyramidTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			Shader::dispatch((levelWidth + 7) / 8, (levelHeight + 7) / 8);
+		}
+
+		// Culling reads the pyramid with texelFetch
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		_viewProjection = viewProjection;
+		_isValid = true;
+	}
+
+	void bind(GLuint unit) const
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, _pyramidTexture);
+	}
+
+private:
+	void resize(int width, int height)
+	{
+		release();
+
+		_width = width;
+		_height = height;
+		_levelCount = 1 + static_cast<int>(glm::log2(static_cast<float>(std::max(width, height))));
+
+		glGenTextures(1, &_depthTexture);
+		glBindTexture(GL_TEXTURE_2D, _depthTexture);
+		glTexStorage2D(GL_TEXTURE_2D, 1, SourceDepthFormat, width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+		glTexParameteri(GL_TEXTURE_2D, GL_DEPTH_STENCIL_TEXTURE_MODE, GL_DEPTH_COMPONENT);
+
+		GLint drawFramebuffer = 0;
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+
+		glGenFramebuffers(1, &_depthFramebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _depthFramebuffer);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, _depthTexture, 0);
+		glDrawBuffer(GL_NONE);
+
+		if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cerr << "ERROR::DEPTH_PYRAMID::FRAMEBUFFER_INCOMPLETE\n";
+
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+
+		glGenTextures(1, &_pyramidTexture);
+		glBindTexture(GL_TEXTURE_2D, _pyramidTexture);
+		glTexStorage2D(GL_TEXTURE_2D, _levelCount, GL_R32F, width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	void release()
+	{
+		if (_depthFramebuffer) glDeleteFramebuffers(1, &_depthFramebuffer);
+		if (_depthTexture) glDeleteTextures(1, &_depthTexture);
+		if (_pyramidTexture) glDeleteTextures(1, &_pyramidTexture);
+
+		_depthFramebuffer = 0;
+		_depthTexture = 0;
+		_pyramidTexture = 0;
+		_isValid = false;
+	}
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+
+// Turns variable frame time into fixed simulation steps (accumulator), so simulation results and cost
+// do not depend on frame rate. Render state is blended between the last two steps using getAlpha()
+class FixedTimestep
+{
+private:
+	float _step = 1.0f / 60.0f;
+	int _maxSteps = 5;
+	float _accumulator = 0.0f;
+
+public:
+	explicit FixedTimestep(float tickRate = 60.0f, int maxSteps = 5)
+	{
+		setTickRate(tickRate);
+		setMaxSteps(maxSteps);
+	}
+
+	void setTickRate(float tickRate) { _step = 1.0f / std::max(tickRate, 1.0f); }
+	void setMaxSteps(int maxSteps) { _maxSteps = std::max(maxSteps, 1); }
+
+	float getStep() const { return _step; }
+	float getTickRate() const { return 1.0f / _step; }
+
+	// Number of steps to simulate for elapsed frame time. Time above maxSteps is dropped,
+	// otherwise a slow frame would need more steps next frame and simulation would never catch up
+	int advance(float deltaTime)
+	{
+		_accumulator += std::max(deltaTime, 0.0f);
+
+		int steps = static_cast<int>(_accumulator / _step);
+		if (steps > _maxSteps)
+		{
+			steps = _maxSteps;
+			_accumulator = std::fmod(_accumulator, _step);
+		}
+		else
+		{
+			_accumulator -= steps * _step;
+		}
+
+		return steps;
+	}
+
+	// Elapsed fraction of the step in progress (0 = last simulated state, 1 = next one)
+	float getAlpha() const { return std::clamp(_accumulator / _step, 0.0f, 1.0f); }
+};
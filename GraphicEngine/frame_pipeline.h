@@ -0,0 +1,109 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Runs simulation on its own thread one frame ahead of rendering. Simulation writes into the back snapshot
+// while the render thread reads the front one, buffers are swapped only at beginFrame() (the sync point),
+// so neither side ever sees a half written state. Render state lags simulation by one frame
+template<typename Snapshot>
+class FramePipeline
+{
+public:
+	// Advances simulation by delta time and fills the whole snapshot
+	using SimulateFunction = std::function<void(Snapshot&, float)>;
+
+private:
+	SimulateFunction _simulate;
+
+	Snapshot _snapshots[2];
+	size_t _renderIndex = 0;
+
+	std::thread _thread;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+
+	float _deltaTime = 0.0f;
+	bool _hasWork = false;
+	bool _isStopping = false;
+
+public:
+	FramePipeline(SimulateFunction simulate, const Snapshot& initialSnapshot)
+		: _simulate(std::move(simulate))
+	{
+		_snapshots[0] = initialSnapshot;
+		_snapshots[1] = initialSnapshot;
+
+		_thread = std::thread([this]() { simulationLoop(); });
+	}
+
+	~FramePipeline()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_isStopping = true;
+		}
+
+		_condition.notify_all();
+		_thread.join();
+	}
+
+	FramePipeline(const FramePipeline&) = delete;
+	FramePipeline& operator=(const FramePipeline&) = delete;
+
+	// Sync point (render thread): waits for simulation of the previous frame, publishes its snapshot
+	// and starts simulating the next frame. Returned snapshot stays valid until next beginFrame()
+	const Snapshot& beginFrame(float deltaTime)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_condition.wait(lock, [this]() { return !_hasWork; });
+
+		_renderIndex = 1 - _renderIndex;
+		_deltaTime = deltaTime;
+		_hasWork = true;
+
+		lock.unlock();
+		_condition.notify_all();
+
+		return _snapshots[_renderIndex];
+	}
+
+	// Wait until simulation in flight finishes (e.g. before changing state shared with simulation)
+	void waitForSimulation()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_condition.wait(lock, [this]() { return !_hasWork; });
+	}
+
+private:
+	void simulationLoop()
+	{
+		while (true)
+		{
+			Snapshot* target = nullptr;
+			float deltaTime = 0.0f;
+
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_condition.wait(lock, [this]() { return _isStopping || _hasWork; });
+
+				if (_isStopping)
+					return;
+
+				target = &_snapshots[1 - _renderIndex];
+				deltaTime = _deltaTime;
+			}
+
+			_simulate(*target, deltaTime);
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_hasWork = false;
+			}
+
+			_condition.notify_all();
+		}
+	}
+};
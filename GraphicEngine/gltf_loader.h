@@ -0,0 +1,1181 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <iostream>
+#include <glad.h>
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+
+#include "json.h"
+#include "meshopt_codec.h"
+#include "mapped_file.h"
+#include "asset_pack.h"
+#include "texture.h"
+#include "material.h"
+#include "mesh.h"
+#include "meshlet.h"
+#include "tangent_space.h"
+
+// Metallic-roughness material of glTF, image indices point into GltfSceneData::images
+struct GltfMaterialData
+{
+	glm::vec3 albedo = glm::vec3(1.0f);
+	float metallic = 1.0f;
+	float roughness = 1.0f;
+
+	int albedoImage = -1;
+	int normalImage = -1;
+	int metallicRoughnessImage = -1;	// Metallic in blue, roughness in green
+	int occlusionImage = -1;			// Occlusion in red
+};
+
+// One mesh primitive, either kept in its source layout (streams) or converted to Vertex (mesh)
+struct GltfPrimitiveData
+{
+	bool isStreamed = false;
+	StreamedMeshData streams;
+	MeshData mesh;
+	int material = -1;
+};
+
+// Primitive placed by scene node
+struct GltfMeshInstance
+{
+	uint32_t primitive = 0;
+	glm::mat4 matrix = glm::mat4(1.0f);
+};
+
+// CPU side of glTF scene, loaded on any thread. Streamed primitives point into mapped files and decoded data
+// owned by this object, so it has to stay alive until GltfLoader::upload()
+struct GltfSceneData
+{
+	std::vector<AssetBlob> buffers;
+	std::vector<std::vector<unsigned char>> decodedData;	// Meshopt decoded buffer views, sparse and data URI contents
+	std::vector<std::vector<GLuint>> indexData;			// Indices which were not 32 bit in the file
+
+	std::vector<GltfPrimitiveData> primitives;
+	std::vector<GltfMeshInstance> instances;
+	std::vector<GltfMaterialData> materials;
+	std::vector<TextureData> images;
+
+	bool isValid() const { return !primitives.empty(); }
+};
+
+// OpenGL objects of uploaded scene, geometries are indexed like GltfSceneData::primitives
+struct GltfSceneResources
+{
+	std::vector<std::shared_ptr<const MeshGeometry>> geometries;
+	std::vector<std::unique_ptr<Texture>> textures;
+	std::vector<PBRMaterial> materials;
+};
+
+// glTF 2.0 importer for .gltf and .glb files. GLB files are memory mapped and buffer views are uploaded straight
+// from the mapping when their layout can be read by the vertex fetch (any glTF accessor format, interleaved or not),
+// so loading of such files is bound by I/O. Primitives missing normals, texture coordinates or tangents needed by
+// normal maps are converted to Vertex instead. Supports EXT_meshopt_compression, KHR_mesh_quantization and
+// KHR_texture_basisu with uncompressed KTX2 images (Basis Universal payloads fall back to the texture source)
+class GltfLoader
+{
+private:
+	static constexpr uint32_t GLBMagic = 0x46546C67;		// "glTF"
+	static constexpr uint32_t GLBChunkJSON = 0x4E4F534A;
+	static constexpr uint32_t GLBChunkBinary = 0x004E4942;
+
+	// Decoded or materialized data is limited, malformed counts must not allocate arbitrary memory.
+	// Decoded views are also bounded by their declared byteLength
+	static constexpr size_t MaxDecodedSize = size_t(1) << 28;
+
+	// Triangles sampled for the texel density estimate of streamed primitives
+	static constexpr size_t MaxMetricTriangles = 4096;
+
+	struct ByteRange
+	{
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+	};
+
+	struct BufferView
+	{
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+		size_t stride = 0;
+	};
+
+	struct Accessor
+	{
+		bool isValid = false;
+		const unsigned char* data = nullptr;	// First element
+		const unsigned char* block = nullptr;	// Start of the buffer view (or materialized copy) the elements are in
+		size_t count = 0;
+		size_t stride = 0;
+		size_t elementSize = 0;
+		GLenum componentType = 0;
+		int componentCount = 0;
+		bool isNormalized = false;
+
+		bool hasBounds = false;
+		glm::vec3 min = glm::vec3(0.0f);
+		glm::vec3 max = glm::vec3(0.0f);
+	};
+
+	struct ParseState
+	{
+		const JsonValue& document;
+		GltfSceneData& scene;
+		std::string path;
+		std::string directory;
+
+		ByteRange binaryChunk;
+		std::vector<ByteRange> buffers;
+		std::vector<BufferView> views;
+
+		// Resolved on first use, shared by primitives
+		std::vector<Accessor> accessors;
+		std::vector<uint8_t> isAccessorResolved;
+
+		// -2 not decoded yet, -1 failed, otherwise index into GltfSceneData::images
+		std::vector<int> imageSlots;
+
+		// Scene primitive indices of every glTF mesh
+		std::vector<std::vector<uint32_t>> meshPrimitives;
+	};
+
+public:
+	static bool isGltfPath(const std::string& path)
+	{
+		std::string extension = path.substr(std::min(path.find_last_of('.'), path.size()));
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".gltf" || extension == ".glb";
+	}
+
+	// Maps loose files (asset pack entries are mapped already), parses and decodes on the calling thread
+	static GltfSceneData load(const std::string& path)
+	{
+		return parse(AssetFileSystem::isInPack(path) ? AssetFileSystem::read(path) : mapFile(path), path);
+	}
+
+	static GltfSceneData parse(AssetBlob&& file, const std::string& path)
+	{
+		GltfSceneData scene;
+
+		if (!file.isValid())
+		{
+			std::cerr << "ERROR::GLTF::READ_FAILED - " << path << "\n";
+			return scene;
+		}
+
+		std::string_view json;
+		ByteRange binaryChunk;
+		if (!readContainer(file, path, json, binaryChunk))
+			return scene;
+
+		JsonValue document;
+		if (!JsonValue::parse(json, document, path))
+			return scene;
+
+		if (!document["asset"]["version"].asString().starts_with("2"))
+		{
+			std::cerr << "ERROR::GLTF::UNSUPPORTED_VERSION - " << path << " (" << document["asset"]["version"].asString() << ")\n";
+			return scene;
+		}
+
+		for (const auto& extension : document["extensionsRequired"].getElements())
+		{
+			const std::string& name = extension.asString();
+			if (name != "EXT_meshopt_compression" && name != "KHR_mesh_quantization" && name != "KHR_texture_basisu")
+			{
+				std::cerr << "ERROR::GLTF::UNSUPPORTED_EXTENSION - " << path << " requires " << name << "\n";
+				return scene;
+			}
+		}
+
+		ParseState state{ document, scene, path, getDirectory(path), binaryChunk, {}, {}, {}, {}, {}, {} };
+
+		// Keeps the mapping alive, binary chunk and JSON point into it
+		scene.buffers.push_back(std::move(file));
+
+		if (!parseBuffers(state))
+			return GltfSceneData();
+
+		parseBufferViews(state);
+		parseMaterials(state);
+		parseMeshes(state);
+		parseNodes(state);
+
+		size_t streamedCount = std::count_if(scene.primitives.begin(), scene.primitives.end(), [](const GltfPrimitiveData& primitive) { return primitive.isStreamed; });
+		std::cout << "Loaded glTF: " << path << " (" << streamedCount << " of " << scene.primitives.size() << " primitives uploaded without conversion)\n";
+
+		return scene;
+	}
+
+	// Creates buffers, textures and materials, has to be called on the OpenGL context thread
+	static GltfSceneResources upload(GltfSceneData& scene)
+	{
+		GltfSceneResources resources;
+
+		for (const auto& primitive : scene.primitives)
+		{
+			if (primitive.isStreamed)
+				resources.geometries.push_back(std::make_shared<const MeshGeometry>(primitive.streams));
+			else
+				resources.geometries.push_back(std::make_shared<const MeshGeometry>(primitive.mesh.vertices, primitive.mesh.indices, primitive.mesh.meshlets));
+		}
+
+		// Texture per image and sampled channel, PBRMaterial reads metallic, roughness and occlusion from red
+		std::unordered_map<uint64_t, const Texture*> textures;
+		auto getTexture = [&](int image, GLint channel) -> const Texture*
+			{
+				if (image < 0)
+					return nullptr;
+
+				uint64_t key = (uint64_t(image) << 32) | uint32_t(channel);
+				auto it = textures.find(key);
+				if (it != textures.end())
+					return it->second;
+
+				// Copy, the image can be used by several materials and channels
+				auto& texture = resources.textures.emplace_back(std::make_unique<Texture>(TextureData(scene.images[image])));
+				if (channel != GL_RED)
+					texture->setSwizzle(channel, GL_GREEN, GL_BLUE, GL_ALPHA);
+
+				textures.emplace(key, texture.get());
+				return texture.get();
+			};
+
+		for (const auto& material : scene.materials)
+		{
+			resources.materials.emplace_back(material.albedo, material.metallic, material.roughness, 1.0f,
+				getTexture(material.albedoImage, GL_RED), getTexture(material.normalImage, GL_RED),
+				getTexture(material.metallicRoughnessImage, GL_BLUE), getTexture(material.metallicRoughnessImage, GL_GREEN),
+				getTexture(material.occlusionImage, GL_RED));
+		}
+
+		return resources;
+	}
+
+private:
+	static AssetBlob mapFile(const std::string& path)
+	{
+		auto mapping = std::make_shared<MappedFile>();
+		if (!mapping->open(path))
+			return AssetBlob();
+
+		if (mapping->size() == 0)
+		{
+			std::cerr << "ERROR::GLTF::EMPTY_FILE - " << path << "\n";
+			return AssetBlob();
+		}
+
+		const unsigned char* data = mapping->data();
+		size_t size = mapping->size();
+		return AssetBlob(data, size, std::move(mapping));
+	}
+
+	static uint32_t read32(const unsigned char* data)
+	{
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static size_t toSize(const JsonValue& value, size_t fallback = 0)
+	{
+		if (!value.isNumber())
+			return fallback;
+
+		// Negative and out of range values fail every bounds check
+		double number = value.asNumber();
+		return (number >= 0.0 && number < 9.0e15) ? static_cast<size_t>(number) : SIZE_MAX;
+	}
+
+	static std::string getDirectory(const std::string& path)
+	{
+		size_t separator = path.find_last_of("/\\");
+		return separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+	}
+
+	// GLB is 12 byte header followed by JSON chunk and optional binary chunk, anything else is treated as .gltf text
+	static bool readContainer(const AssetBlob& file, const std::string& path, std::string_view& json, ByteRange& binaryChunk)
+	{
+		const unsigned char* data = file.data();
+		size_t size = file.size();
+
+		if (size < 12 || read32(data) != GLBMagic)
+		{
+			json = std::string_view(reinterpret_cast<const char*>(data), size);
+			return true;
+		}
+
+		uint32_t version = read32(data + 4);
+		size_t length = std::min<size_t>(read32(data + 8), size);
+
+		if (version != 2)
+		{
+			std::cerr << "ERROR::GLTF::UNSUPPORTED_VERSION - " << path << " (GLB version " << version << ")\n";
+			return false;
+		}
+
+		size_t offset = 12;
+		while (offset + 8 <= length)
+		{
+			size_t chunkLength = read32(data + offset);
+			uint32_t chunkType = read32(data + offset + 4);
+			offset += 8;
+
+			if (chunkLength > length - offset)
+				break;
+
+			if (chunkType == GLBChunkJSON && json.empty())
+				json = std::string_view(reinterpret_cast<const char*>(data + offset), chunkLength);
+			else if (chunkType == GLBChunkBinary && !binaryChunk.data)
+				binaryChunk = { data + offset, chunkLength };
+
+			offset += (chunkLength + 3) & ~size_t(3);
+		}
+
+		if (json.empty())
+		{
+			std::cerr << "ERROR::GLTF::INVALID_GLB - " << path << " (no JSON chunk)\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	// Data URI or file relative to the glTF file
+	static AssetBlob readUri(const ParseState& state, const std::string& uri)
+	{
+		if (uri.starts_with("data:"))
+		{
+			size_t marker = uri.find(";base64,");
+			if (marker == std::string::npos)
+			{
+				std::cerr << "ERROR::GLTF::UNSUPPORTED_URI - " << state.path << " (data URI without base64)\n";
+				return AssetBlob();
+			}
+
+			return AssetBlob(decodeBase64(std::string_view(uri).substr(marker + 8)));
+		}
+
+		std::string path = state.directory + decodePercent(uri);
+		return AssetFileSystem::isInPack(path) ? AssetFileSystem::read(path) : mapFile(path);
+	}
+
+	static std::vector<unsigned char> decodeBase64(std::string_view text)
+	{
+		std::vector<unsigned char> result;
+		result.reserve(text.size() / 4 * 3);
+
+		uint32_t bits = 0;
+		int bitCount = 0;
+
+		for (char c : text)
+		{
+			int value;
+			if (c >= 'A' && c <= 'Z') value = c - 'A';
+			else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+			else if (c >= '0' && c <= '9') value = c - '0' + 52;
+			else if (c == '+' || c == '-') value = 62;
+			else if (c == '/' || c == '_') value = 63;
+			else continue;
+
+			bits = (bits << 6) | uint32_t(value);
+			bitCount += 6;
+
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				result.push_back(static_cast<unsigned char>(bits >> bitCount));
+			}
+		}
+
+		return result;
+	}
+
+	static std::string decodePercent(const std::string& uri)
+	{
+		std::string result;
+		result.reserve(uri.size());
+
+		for (size_t i = 0; i < uri.size(); ++i)
+		{
+			if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) && std::isxdigit(static_cast<unsigned char>(uri[i + 2])))
+			{
+				result += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+				i += 2;
+			}
+			else
+			{
+				result += uri[i];
+			}
+		}
+
+		return result;
+	}
+
+	static bool parseBuffers(ParseState& state)
+	{
+		const JsonValue& buffers = state.document["buffers"];
+
+		for (size_t i = 0; i < buffers.size(); ++i)
+		{
+			const JsonValue& buffer = buffers[i];
+			size_t byteLength = toSize(buffer["byteLength"], SIZE_MAX);
+
+			ByteRange range;
+			if (buffer["uri"].isString())
+			{
+				AssetBlob blob = readUri(state, buffer["uri"].asString());
+				if (blob.isValid())
+				{
+					range = { blob.data(), blob.size() };
+					state.scene.buffers.push_back(std::move(blob));
+				}
+			}
+			else if (i == 0 && state.binaryChunk.data)
+			{
+				range = state.binaryChunk;
+			}
+
+			// Buffers without data are allowed when only meshopt compressed views reference them (fallback buffers)
+			if (range.data && range.size < byteLength)
+			{
+				std::cerr << "ERROR::GLTF::BUFFER_TOO_SMALL - " << state.path << " (buffer " << i << ")\n";
+				return false;
+			}
+
+			range.size = range.data ? byteLength : 0;
+			state.buffers.push_back(range);
+		}
+
+		return true;
+	}
+
+	static void parseBufferViews(ParseState& state)
+	{
+		const JsonValue& views = state.document["bufferViews"];
+		state.views.resize(views.size());
+
+		for (size_t i = 0; i < views.size(); ++i)
+		{
+			const JsonValue& view = views[i];
+			BufferView& result = state.views[i];
+			result.stride = toSize(view["byteStride"], 0);
+
+			const JsonValue& meshopt = view["extensions"]["EXT_meshopt_compression"];
+			if (meshopt.isObject())
+			{
+				if (!decodeMeshoptView(state, view, meshopt, result))
+					std::cerr << "ERROR::GLTF::MESHOPT_DECODE_FAILED - " << state.path << " (buffer view " << i << ")\n";
+				continue;
+			}
+
+			ByteRange range = getBufferRange(state, view);
+			if (!range.data)
+				continue;
+
+			result.data = range.data;
+			result.size = range.size;
+		}
+	}
+
+	// Byte range of buffer, byteOffset and byteLength of view or extension object
+	static ByteRange getBufferRange(const ParseState& state, const JsonValue& view)
+	{
+		size_t bufferIndex = toSize(view["buffer"], SIZE_MAX);
+		size_t offset = toSize(view["byteOffset"], 0);
+		size_t length = toSize(view["byteLength"], SIZE_MAX);
+
+		if (bufferIndex >= state.buffers.size() || !state.buffers[bufferIndex].data)
+			return {};
+
+		const ByteRange& buffer = state.buffers[bufferIndex];
+		if (offset > buffer.size || length > buffer.size - offset)
+			return {};
+
+		return { buffer.data + offset, length };
+	}
+
+	static bool decodeMeshoptView(ParseState& state, const JsonValue& viewJson, const JsonValue& extension, BufferView& view)
+	{
+		ByteRange source = getBufferRange(state, extension);
+		size_t stride = toSize(extension["byteStride"], 0);
+		size_t count = toSize(extension["count"], SIZE_MAX);
+		size_t byteLength = toSize(viewJson["byteLength"], 0);
+
+		if (!source.data || stride == 0 || byteLength > MaxDecodedSize || count > byteLength / stride)
+			return false;
+
+		const std::string& mode = extension["mode"].asString();
+		const std::string& filterName = extension["filter"].isString() ? extension["filter"].asString() : std::string();
+
+		MeshoptCodec::Filter filter = MeshoptCodec::Filter::None;
+		if (filterName == "OCTAHEDRAL") filter = MeshoptCodec::Filter::Octahedral;
+		else if (filterName == "QUATERNION") filter = MeshoptCodec::Filter::Quaternion;
+		else if (filterName == "EXPONENTIAL") filter = MeshoptCodec::Filter::Exponential;
+		else if (!filterName.empty() && filterName != "NONE") return false;
+
+		std::vector<unsigned char> decoded(count * stride);
+
+		bool isDecoded = false;
+		if (mode == "ATTRIBUTES")
+			isDecoded = MeshoptCodec::decodeVertexBuffer(decoded.data(), count, stride, source.data, source.size) && MeshoptCodec::decodeFilter(filter, decoded.data(), count, stride);
+		else if (mode == "TRIANGLES")
+			isDecoded = MeshoptCodec::decodeIndexBuffer(decoded.data(), count, stride, source.data, source.size);
+		else if (mode == "INDICES")
+			isDecoded = MeshoptCodec::decodeIndexSequence(decoded.data(), count, stride, source.data, source.size);
+
+		if (!isDecoded)
+			return false;
+
+		// Moved vector keeps its memory, so the pointer stays valid
+		const std::vector<unsigned char>& stored = state.scene.decodedData.emplace_back(std::move(decoded));
+		view.data = stored.data();
+		view.size = stored.size();
+		return true;
+	}
+
+	static size_t getComponentSize(GLenum componentType)
+	{
+		switch (componentType)
+		{
+		case GL_BYTE: case GL_UNSIGNED_BYTE: return 1;
+		case GL_SHORT: case GL_UNSIGNED_SHORT: return 2;
+		case GL_UNSIGNED_INT: case GL_FLOAT: return 4;
+		default: return 0;
+		}
+	}
+
+	static int getComponentCount(const std::string& type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4" || type == "MAT2") return 4;
+		if (type == "MAT3") return 9;
+		if (type == "MAT4") return 16;
+		return 0;
+	}
+
+	static const Accessor& getAccessor(ParseState& state, const JsonValue& indexValue)
+	{
+		static const Accessor invalid;
+
+		const JsonValue& accessors = state.document["accessors"];
+		size_t index = toSize(indexValue, SIZE_MAX);
+		if (index >= accessors.size())
+			return invalid;
+
+		if (state.accessors.empty())
+		{
+			state.accessors.resize(accessors.size());
+			state.isAccessorResolved.resize(accessors.size(), 0);
+		}
+
+		if (!state.isAccessorResolved[index])
+		{
+			state.accessors[index] = resolveAccessor(state, accessors[index]);
+			state.isAccessorResolved[index] = 1;
+
+			if (!state.accessors[index].isValid)
+				std::cerr << "ERROR::GLTF::INVALID_ACCESSOR - " << state.path << " (accessor " << index << ")\n";
+		}
+
+		return state.accessors[index];
+	}
+
+	static Accessor resolveAccessor(ParseState& state, const JsonValue& json)
+	{
+		Accessor accessor;
+		accessor.componentType = static_cast<GLenum>(json["componentType"].asInt());
+		accessor.componentCount = getComponentCount(json["type"].asString());
+		accessor.count = toSize(json["count"], 0);
+		accessor.isNormalized = json["normalized"].asBool();
+
+		size_t componentSize = getComponentSize(accessor.componentType);
+		accessor.elementSize = componentSize * accessor.componentCount;
+
+		if (accessor.elementSize == 0 || accessor.count == 0)
+			return Accessor();
+
+		if (json.has("bufferView"))
+		{
+			size_t viewIndex = toSize(json["bufferView"], SIZE_MAX);
+			if (viewIndex >= state.views.size() || !state.views[viewIndex].data)
+				return Accessor();
+
+			const BufferView& view = state.views[viewIndex];
+			size_t offset = toSize(json["byteOffset"], 0);
+			accessor.stride = view.stride ? view.stride : accessor.elementSize;
+
+			if (offset > view.size || accessor.elementSize > view.size - offset || (accessor.count - 1) > (view.size - offset - accessor.elementSize) / accessor.stride)
+				return Accessor();
+
+			accessor.data = view.data + offset;
+			accessor.block = view.data;
+		}
+		else
+		{
+			// No buffer view means zeros (usually with sparse values), nothing else bounds the count
+			if (accessor.count > MaxDecodedSize / accessor.elementSize)
+				return Accessor();
+
+			const std::vector<unsigned char>& zeros = state.scene.decodedData.emplace_back(accessor.count * accessor.elementSize, 0);
+			accessor.data = accessor.block = zeros.data();
+			accessor.stride = accessor.elementSize;
+		}
+
+		if (json.has("sparse") && !applySparse(state, json["sparse"], accessor))
+			return Accessor();
+
+		const JsonValue& min = json["min"];
+		const JsonValue& max = json["max"];
+		if (accessor.componentCount == 3 && min.size() == 3 && max.size() == 3)
+		{
+			accessor.hasBounds = true;
+			accessor.min = { min[0].asFloat(), min[1].asFloat(), min[2].asFloat() };
+			accessor.max = { max[0].asFloat(), max[1].asFloat(), max[2].asFloat() };
+		}
+
+		accessor.isValid = true;
+		return accessor;
+	}
+
+	// Dense copy with replaced elements, the source view stays untouched
+	static bool applySparse(ParseState& state, const JsonValue& sparse, Accessor& accessor)
+	{
+		size_t count = toSize(sparse["count"], SIZE_MAX);
+		const JsonValue& indicesJson = sparse["indices"];
+		const JsonValue& valuesJson = sparse["values"];
+
+		size_t indicesView = toSize(indicesJson["bufferView"], SIZE_MAX);
+		size_t valuesView = toSize(valuesJson["bufferView"], SIZE_MAX);
+		if (indicesView >= state.views.size() || valuesView >= state.views.size() || count > accessor.count)
+			return false;
+
+		GLenum indexType = static_cast<GLenum>(indicesJson["componentType"].asInt());
+		size_t indexSize = getComponentSize(indexType);
+		if (indexType != GL_UNSIGNED_BYTE && indexType != GL_UNSIGNED_SHORT && indexType != GL_UNSIGNED_INT)
+			return false;
+
+		const BufferView& indices = state.views[indicesView];
+		const BufferView& values = state.views[valuesView];
+		size_t indicesOffset = toSize(indicesJson["byteOffset"], 0);
+		size_t valuesOffset = toSize(valuesJson["byteOffset"], 0);
+
+		if (!indices.data || !values.data || indicesOffset > indices.size || count > (indices.size - indicesOffset) / indexSize ||
+			valuesOffset > values.size || count > (values.size - valuesOffset) / accessor.elementSize)
+			return false;
+
+		std::vector<unsigned char> dense(accessor.count * accessor.elementSize);
+		for (size_t i = 0; i < accessor.count; ++i)
+			std::memcpy(&dense[i * accessor.elementSize], accessor.data + i * accessor.stride, accessor.elementSize);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			size_t target = readUnsigned(indices.data + indicesOffset + i * indexSize, indexType);
+			if (target >= accessor.count)
+				return false;
+
+			std::memcpy(&dense[target * accessor.elementSize], values.data + valuesOffset + i * accessor.elementSize, accessor.elementSize);
+		}
+
+		const std::vector<unsigned char>& stored = state.scene.decodedData.emplace_back(std::move(dense));
+		accessor.data = accessor.block = stored.data();
+		accessor.stride = accessor.elementSize;
+		return true;
+	}
+
+	static uint32_t readUnsigned(const unsigned char* data, GLenum componentType)
+	{
+		switch (componentType)
+		{
+		case GL_UNSIGNED_BYTE: return data[0];
+		case GL_UNSIGNED_SHORT: { uint16_t value; std::memcpy(&value, data, sizeof(value)); return value; }
+		default: return read32(data);
+		}
+	}
+
+	// Component as float, normalized integers are mapped to [0, 1] or [-1, 1]
+	static float readComponent(const unsigned char* data, GLenum componentType, bool isNormalized)
+	{
+		switch (componentType)
+		{
+		case GL_FLOAT: { float value; std::memcpy(&value, data, sizeof(value)); return value; }
+		case GL_UNSIGNED_BYTE: return isNormalized ? data[0] / 255.0f : float(data[0]);
+		case GL_BYTE: { float value = float(static_cast<int8_t>(data[0])); return isNormalized ? std::max(value / 127.0f, -1.0f) : value; }
+		case GL_UNSIGNED_SHORT: { uint16_t value; std::memcpy(&value, data, sizeof(value)); return isNormalized ? value / 65535.0f : float(value); }
+		case GL_SHORT: { int16_t value; std::memcpy(&value, data, sizeof(value)); return isNormalized ? std::max(value / 32767.0f, -1.0f) : float(value); }
+		case GL_UNSIGNED_INT: return float(read32(data));
+		default: return 0.0f;
+		}
+	}
+
+	static glm::vec4 readElement(const Accessor& accessor, size_t element)
+	{
+		glm::vec4 result(0.0f);
+		const unsigned char* data = accessor.data + element * accessor.stride;
+		size_t componentSize = getComponentSize(accessor.componentType);
+
+		for (int i = 0; i < std::min(accessor.componentCount, 4); ++i)
+			result[i] = readComponent(data + i * componentSize, accessor.componentType, accessor.isNormalized);
+
+		return result;
+	}
+
+	static void parseMaterials(ParseState& state)
+	{
+		const JsonValue& materials = state.document["materials"];
+		state.imageSlots.assign(state.document["images"].size(), -2);
+
+		for (const auto& material : materials.getElements())
+		{
+			GltfMaterialData data;
+			const JsonValue& pbr = material["pbrMetallicRoughness"];
+
+			const JsonValue& baseColor = pbr["baseColorFactor"];
+			if (baseColor.size() >= 3)
+				data.albedo = { baseColor[0].asFloat(1.0f), baseColor[1].asFloat(1.0f), baseColor[2].asFloat(1.0f) };
+
+			data.metallic = pbr["metallicFactor"].asFloat(1.0f);
+			data.roughness = pbr["roughnessFactor"].asFloat(1.0f);
+
+			data.albedoImage = resolveTexture(state, pbr["baseColorTexture"]);
+			data.metallicRoughnessImage = resolveTexture(state, pbr["metallicRoughnessTexture"]);
+			data.normalImage = resolveTexture(state, material["normalTexture"]);
+			data.occlusionImage = resolveTexture(state, material["occlusionTexture"]);
+
+			state.scene.materials.push_back(data);
+		}
+	}
+
+	// KTX2 image of KHR_texture_basisu is preferred, texture source is its fallback
+	static int resolveTexture(ParseState& state, const JsonValue& textureInfo)
+	{
+		if (!textureInfo.isObject())
+			return -1;
+
+		const JsonValue& texture = state.document["textures"][toSize(textureInfo["index"], SIZE_MAX)];
+		const JsonValue* sources[2] = { &texture["extensions"]["KHR_texture_basisu"]["source"], &texture["source"] };
+
+		for (const JsonValue* source : sources)
+		{
+			if (!source->isNumber())
+				continue;
+
+			int image = decodeImage(state, toSize(*source, SIZE_MAX));
+			if (image >= 0)
+				return image;
+		}
+
+		return -1;
+	}
+
+	static int decodeImage(ParseState& state, size_t imageIndex)
+	{
+		if (imageIndex >= state.imageSlots.size())
+			return -1;
+
+		int& slot = state.imageSlots[imageIndex];
+		if (slot != -2)
+			return slot;
+
+		slot = -1;
+
+		const JsonValue& image = state.document["images"][imageIndex];
+		std::string name = state.path + " (image " + std::to_string(imageIndex) + ")";
+
+		AssetBlob file;
+		ByteRange bytes;
+
+		if (image.has("bufferView"))
+		{
+			size_t viewIndex = toSize(image["bufferView"], SIZE_MAX);
+			if (viewIndex < state.views.size())
+				bytes = { state.views[viewIndex].data, state.views[viewIndex].size };
+		}
+		else if (image["uri"].isString())
+		{
+			file = readUri(state, image["uri"].asString());
+			if (file.isValid())
+				bytes = { file.data(), file.size() };
+		}
+
+		// Texture coordinates of glTF have their origin at the top left, so rows are kept top to bottom
+		TextureData textureData = TextureData::decode(bytes.data, bytes.size, name, false, false);
+		if (!textureData.isValid())
+			return slot;
+
+		slot = static_cast<int>(state.scene.images.size());
+		state.scene.images.push_back(std::move(textureData));
+		return slot;
+	}
+
+	static void parseMeshes(ParseState& state)
+	{
+		const JsonValue& meshes = state.document["meshes"];
+		state.meshPrimitives.resize(meshes.size());
+
+		for (size_t mesh = 0; mesh < meshes.size(); ++mesh)
+		{
+			for (const auto& primitive : meshes[mesh]["primitives"].getElements())
+			{
+				GltfPrimitiveData data;
+				if (!buildPrimitive(state, primitive, data))
+				{
+					std::cerr << "ERROR::GLTF::PRIMITIVE_SKIPPED - " << state.path << " (mesh " << mesh << ")\n";
+					continue;
+				}
+
+				state.meshPrimitives[mesh].push_back(static_cast<uint32_t>(state.scene.primitives.size()));
+				state.scene.primitives.push_back(std::move(data));
+			}
+		}
+	}
+
+	static bool buildPrimitive(ParseState& state, const JsonValue& primitive, GltfPrimitiveData& data)
+	{
+		// Triangles, strips and fans (points and lines are not drawn)
+		int64_t mode = primitive["mode"].asInt(4);
+		if (mode < 4 || mode > 6)
+			return false;
+
+		const JsonValue& attributes = primitive["attributes"];
+		const Accessor& position = getAccessor(state, attributes["POSITION"]);
+		if (!position.isValid || position.componentCount != 3)
+			return false;
+
+		// Attributes present with wrong type or count reject the primitive, missing ones are fine
+		auto getAttribute = [&](const char* name, int minComponents, int maxComponents, const Accessor*& result)
+			{
+				result = nullptr;
+				if (!attributes.has(name))
+					return true;
+
+				const Accessor& accessor = getAccessor(state, attributes[name]);
+				if (!accessor.isValid || accessor.count != position.count || accessor.componentCount < minComponents || accessor.componentCount > maxComponents)
+					return false;
+
+				result = &accessor;
+				return true;
+			};
+
+		const Accessor* normal = nullptr;
+		const Accessor* textureCoord = nullptr;
+		const Accessor* color = nullptr;
+		const Accessor* tangent = nullptr;
+
+		if (!getAttribute("NORMAL", 3, 3, normal) || !getAttribute("TEXCOORD_0", 2, 2, textureCoord) ||
+			!getAttribute("COLOR_0", 3, 4, color) || !getAttribute("TANGENT", 4, 4, tangent))
+			return false;
+
+		const Accessor* indices = nullptr;
+		if (primitive.has("indices"))
+		{
+			indices = &getAccessor(state, primitive["indices"]);
+			if (!indices->isValid || indices->componentCount != 1 || indices->componentType == GL_FLOAT || indices->componentType == GL_BYTE || indices->componentType == GL_SHORT)
+				return false;
+		}
+
+		size_t material = toSize(primitive["material"], SIZE_MAX);
+		data.material = (material < state.scene.materials.size()) ? static_cast<int>(material) : -1;
+		bool needsTangents = data.material >= 0 && state.scene.materials[data.material].normalImage >= 0;
+
+		// Source layout works when every attribute the shaders read is present
+		data.isStreamed = mode == 4 && normal && textureCoord && (tangent || !needsTangents);
+
+		if (data.isStreamed)
+			return buildStreams(state, position, normal, textureCoord, color, tangent, indices, data.streams);
+
+		return buildMeshData(static_cast<int>(mode), position, normal, textureCoord, color, tangent, indices, needsTangents, data.mesh);
+	}
+
+	// Triangle list with every index checked against the vertex count
+	static bool readTriangleList(const Accessor* indices, size_t vertexCount, int mode, std::vector<GLuint>& result)
+	{
+		size_t count = indices ? indices->count : vertexCount;
+		auto read = [&](size_t i) { return indices ? readUnsigned(indices->data + i * indices->stride, indices->componentType) : static_cast<uint32_t>(i); };
+
+		result.clear();
+
+		if (mode == 4)
+		{
+			result.resize(count - count % 3);
+			for (size_t i = 0; i < result.size(); ++i)
+				result[i] = read(i);
+		}
+		else
+		{
+			// Strips alternate winding, fans share the first vertex
+			result.reserve(count >= 3 ? (count - 2) * 3 : 0);
+			for (size_t i = 0; i + 2 < count; ++i)
+			{
+				if (mode == 6)
+					result.insert(result.end(), { read(0), read(i + 1), read(i + 2) });
+				else if (i % 2 == 0)
+					result.insert(result.end(), { read(i), read(i + 1), read(i + 2) });
+				else
+					result.insert(result.end(), { read(i + 1), read(i), read(i + 2) });
+			}
+		}
+
+		return std::all_of(result.begin(), result.end(), [&](GLuint index) { return index < vertexCount; });
+	}
+
+	static bool buildStreams(ParseState& state, const Accessor& position, const Accessor* normal, const Accessor* textureCoord,
+		const Accessor* color, const Accessor* tangent, const Accessor* indices, StreamedMeshData& streams)
+	{
+		streams.vertexCount = position.count;
+
+		// 32 bit indices are used in place, others are widened (indirect draws of the engine use 32 bit indices)
+		if (indices && indices->componentType == GL_UNSIGNED_INT && indices->stride == sizeof(GLuint) && reinterpret_cast<uintptr_t>(indices->data) % alignof(GLuint) == 0)
+		{
+			const GLuint* source = reinterpret_cast<const GLuint*>(indices->data);
+			size_t count = indices->count - indices->count % 3;
+
+			if (!std::all_of(source, source + count, [&](GLuint index) { return index < position.count; }))
+				return false;
+
+			streams.indices = source;
+			streams.indexCount = count;
+		}
+		else
+		{
+			std::vector<GLuint> widened;
+			if (!readTriangleList(indices, position.count, 4, widened))
+				return false;
+
+			const std::vector<GLuint>& stored = state.scene.indexData.emplace_back(std::move(widened));
+			streams.indices = stored.data();
+			streams.indexCount = stored.size();
+		}
+
+		// Attributes in the same buffer view share one vertex buffer covering all of them (interleaved layouts)
+		struct Source
+		{
+			const Accessor* accessor;
+			GLuint location;
+		};
+
+		const Source sources[5] = { { &position, 0 }, { normal, 1 }, { color, 2 }, { textureCoord, 3 }, { tangent, 4 } };
+		std::vector<const unsigned char*> blocks;
+		std::vector<std::pair<const unsigned char*, const unsigned char*>> spans;
+
+		for (const auto& source : sources)
+		{
+			if (!source.accessor)
+				continue;
+
+			const Accessor& accessor = *source.accessor;
+			const unsigned char* begin = accessor.data;
+			const unsigned char* end = accessor.data + (accessor.count - 1) * accessor.stride + accessor.elementSize;
+
+			size_t range = std::find(blocks.begin(), blocks.end(), accessor.block) - blocks.begin();
+			if (range == blocks.size())
+			{
+				blocks.push_back(accessor.block);
+				spans.push_back({ begin, end });
+			}
+			else
+			{
+				spans[range].first = std::min(spans[range].first, begin);
+				spans[range].second = std::max(spans[range].second, end);
+			}
+
+			VertexAttributeStream attribute;
+			attribute.location = source.location;
+			attribute.componentCount = accessor.componentCount;
+			attribute.componentType = accessor.componentType;
+			attribute.isNormalized = accessor.isNormalized ? GL_TRUE : GL_FALSE;
+			attribute.stride = static_cast<GLsizei>(accessor.stride);
+			attribute.offset = static_cast<size_t>(begin - accessor.block);		// Made relative to the span below
+			attribute.range = static_cast<uint32_t>(range);
+			streams.attributes.push_back(attribute);
+		}
+
+		for (auto& attribute : streams.attributes)
+			attribute.offset -= static_cast<size_t>(spans[attribute.range].first - blocks[attribute.range]);
+
+		for (const auto& span : spans)
+			streams.ranges.push_back({ span.first, static_cast<size_t>(span.second - span.first) });
+
+		// Bounds from accessor limits when they are in local units already (quantized positions are read)
+		if (position.hasBounds && position.componentType == GL_FLOAT)
+		{
+			streams.bounds.expand(position.min);
+			streams.bounds.expand(position.max);
+		}
+		else
+		{
+			for (size_t v = 0; v < position.count; ++v)
+				streams.bounds.expand(glm::vec3(readElement(position, v)));
+		}
+
+		streams.worldUnitsPerUV = estimateWorldUnitsPerUV(position, *textureCoord, streams.indices, streams.indexCount);
+		return true;
+	}
+
+	// Same metric as MeshGeometry computes from Vertex data, from evenly spaced sample of triangles
+	static float estimateWorldUnitsPerUV(const Accessor& position, const Accessor& textureCoord, const GLuint* indices, size_t indexCount)
+	{
+		size_t triangleCount = indexCount / 3;
+		size_t step = std::max<size_t>(1, triangleCount / MaxMetricTriangles);
+
+		float worldArea = 0.0f;
+		float uvArea = 0.0f;
+
+		for (size_t triangle = 0; triangle < triangleCount; triangle += step)
+		{
+			const GLuint* corners = indices + triangle * 3;
+
+			glm::vec3 a = readElement(position, corners[0]);
+			glm::vec3 b = readElement(position, corners[1]);
+			glm::vec3 c = readElement(position, corners[2]);
+			worldArea += 0.5f * glm::length(glm::cross(b - a, c - a));
+
+			glm::vec2 uvA = readElement(textureCoord, corners[0]);
+			glm::vec2 uvAB = glm::vec2(readElement(textureCoord, corners[1])) - uvA;
+			glm::vec2 uvAC = glm::vec2(readElement(textureCoord, corners[2])) - uvA;
+			uvArea += 0.5f * glm::abs(uvAB.x * uvAC.y - uvAB.y * uvAC.x);
+		}
+
+		return (uvArea > 0.0f) ? glm::sqrt(worldArea / uvArea) : 1.0f;
+	}
+
+	static bool buildMeshData(int mode, const Accessor& position, const Accessor* normal, const Accessor* textureCoord,
+		const Accessor* color, const Accessor* tangent, const Accessor* indices, bool needsTangents, MeshData& mesh)
+	{
+		std::vector<GLuint> triangleIndices;
+		if (!readTriangleList(indices, position.count, mode, triangleIndices))
+			return false;
+
+		std::vector<Vertex> vertices(position.count);
+		for (size_t v = 0; v < vertices.size(); ++v)
+		{
+			Vertex& vertex = vertices[v];
+			vertex.position = readElement(position, v);
+			vertex.normal = normal ? glm::vec3(readElement(*normal, v)) : glm::vec3(0.0f);
+			vertex.color = color ? glm::vec3(readElement(*color, v)) : glm::vec3(1.0f);
+			vertex.textureCoord = textureCoord ? glm::vec2(readElement(*textureCoord, v)) : glm::vec2(0.0f);
+
+			if (tangent)
+			{
+				glm::vec4 value = readElement(*tangent, v);
+				vertex.tangent = packTangent(glm::vec3(value), value.w);
+			}
+		}
+
+		// Missing normals mean flat shading, so every triangle gets its own vertices
+		if (!normal)
+		{
+			std::vector<Vertex> flatVertices;
+			flatVertices.reserve(triangleIndices.size());
+
+			for (size_t i = 0; i + 2 < triangleIndices.size(); i += 3)
+			{
+				const Vertex* corners[3] = { &vertices[triangleIndices[i]], &vertices[triangleIndices[i + 1]], &vertices[triangleIndices[i + 2]] };
+				glm::vec3 faceNormal = glm::cross(corners[1]->position - corners[0]->position, corners[2]->position - corners[0]->position);
+				float length = glm::length(faceNormal);
+				faceNormal = (length > 0.0f) ? faceNormal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+
+				for (const Vertex* corner : corners)
+				{
+					flatVertices.push_back(*corner);
+					flatVertices.back().normal = faceNormal;
+				}
+			}
+
+			vertices = std::move(flatVertices);
+			for (size_t i = 0; i < triangleIndices.size(); ++i)
+				triangleIndices[i] = static_cast<GLuint>(i);
+		}
+
+		if (!tangent && needsTangents)
+			TangentSpace::generate(vertices, triangleIndices);
+
+		mesh.meshlets = MeshletBuilder::build(vertices, triangleIndices);
+		mesh.vertices = std::move(vertices);
+		mesh.indices = std::move(triangleIndices);
+		return true;
+	}
+
+	static glm::mat4 getLocalMatrix(const JsonValue& node)
+	{
+		const JsonValue& matrix = node["matrix"];
+		if (matrix.size() == 16)
+		{
+			glm::mat4 result;
+			for (int i = 0; i < 16; ++i)
+				result[i / 4][i % 4] = matrix[i].asFloat();
+			return result;
+		}
+
+		const JsonValue& translation = node["translation"];
+		const JsonValue& rotation = node["rotation"];
+		const JsonValue& scale = node["scale"];
+
+		glm::vec3 t = (translation.size() == 3) ? glm::vec3(translation[0].asFloat(), translation[1].asFloat(), translation[2].asFloat()) : glm::vec3(0.0f);
+		glm::quat r = (rotation.size() == 4) ? glm::quat(rotation[3].asFloat(1.0f), rotation[0].asFloat(), rotation[1].asFloat(), rotation[2].asFloat()) : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		glm::vec3 s = (scale.size() == 3) ? glm::vec3(scale[0].asFloat(1.0f), scale[1].asFloat(1.0f), scale[2].asFloat(1.0f)) : glm::vec3(1.0f);
+
+		return glm::translate(glm::mat4(1.0f), t) * glm::mat4_cast(r) * glm::scale(glm::mat4(1.0f), s);
+	}
+
+	static void parseNodes(ParseState& state)
+	{
+		const JsonValue& nodes = state.document["nodes"];
+		const JsonValue& scenes = state.document["scenes"];
+		const JsonValue& scene = scenes[toSize(state.document["scene"], 0)];
+
+		// Files without scene show every mesh once
+		if (!scene.isObject())
+		{
+			for (const auto& primitives : state.meshPrimitives)
+			{
+				for (uint32_t primitive : primitives)
+					state.scene.instances.push_back({ primitive, glm::mat4(1.0f) });
+			}
+			return;
+		}
+
+		// Each node has at most one parent, visited flags also stop cycles of malformed files
+		std::vector<uint8_t> isVisited(nodes.size(), 0);
+		std::vector<std::pair<size_t, glm::mat4>> stack;
+
+		for (const auto& root : scene["nodes"].getElements())
+			stack.push_back({ toSize(root, SIZE_MAX), glm::mat4(1.0f) });
+
+		while (!stack.empty())
+		{
+			auto [nodeIndex, parentMatrix] = stack.back();
+			stack.pop_back();
+
+			if (nodeIndex >= nodes.size() || isVisited[nodeIndex])
+				continue;
+
+			isVisited[nodeIndex] = 1;
+
+			const JsonValue& node = nodes[nodeIndex];
+			glm::mat4 worldMatrix = parentMatrix * getLocalMatrix(node);
+
+			size_t mesh = toSize(node["mesh"], SIZE_MAX);
+			if (mesh < state.meshPrimitives.size())
+			{
+				for (uint32_t primitive : state.meshPrimitives[mesh])
+					state.scene.instances.push_back({ primitive, worldMatrix });
+			}
+
+			for (const auto& child : node["children"].getElements())
+				stack.push_back({ toSize(child, SIZE_MAX), worldMatrix });
+		}
+	}
+};
@@ -0,0 +1,432 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <glm.hpp>
+
+#include "primitives.h"
+#include "job_system.h"
+
+// Index based half-edge topology of a polygon mesh, stored as separate arrays (no per element allocations).
+// Half-edges of a face are consecutive in corner order, so next and previous follow from the face range.
+// Edges used by more than two faces or with inconsistent winding are left unpaired and behave like boundary.
+// Meshes converted from Vertex/index data also keep positions per vertex and the source vertex of every corner,
+// so attributes split along seams survive the round trip. Construction, validation and normals take an optional
+// job system and give the same result with or without it
+class HalfEdgeMesh
+{
+public:
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+private:
+	static constexpr size_t BatchSize = 4096;
+
+	// Indexed by half-edge
+	std::vector<uint32_t> _origins;
+	std::vector<uint32_t> _twins;
+	std::vector<uint32_t> _faces;
+	std::vector<uint32_t> _edges;
+
+	// Indexed by face, face count + 1 entries
+	std::vector<uint32_t> _faceOffsets;
+
+	// Indexed by edge, one of its half-edges
+	std::vector<uint32_t> _edgeHalfEdges;
+
+	// Outgoing half-edges of every vertex
+	std::vector<uint32_t> _vertexOffsets;
+	std::vector<uint32_t> _vertexHalfEdges;
+
+	// Geometry, empty for pure topology
+	std::vector<glm::vec3> _positions;				// Per vertex
+	std::vector<uint32_t> _cornerAttributes;		// Per half-edge, index into attributes
+	std::vector<Vertex> _attributes;
+
+public:
+	HalfEdgeMesh() = default;
+
+	// Faces are given by their sizes and vertex indices in corner order (counter clockwise)
+	static HalfEdgeMesh fromPolygons(size_t vertexCount, const std::vector<uint32_t>& faceSizes, const std::vector<uint32_t>& faceVertices, JobSystem* jobSystem = nullptr)
+	{
+		HalfEdgeMesh mesh;
+
+		mesh._faceOffsets.resize(faceSizes.size() + 1, 0);
+		for (size_t f = 0; f < faceSizes.size(); ++f)
+			mesh._faceOffsets[f + 1] = mesh._faceOffsets[f] + faceSizes[f];
+
+		size_t halfEdgeCount = mesh._faceOffsets.back();
+		mesh._origins.assign(faceVertices.begin(), faceVertices.begin() + halfEdgeCount);
+		mesh.build(vertexCount, jobSystem);
+		return mesh;
+	}
+
+	// Triangles of indexed vertices, vertices with the same position become one vertex.
+	// Triangles collapsed by that (two corners at one position) are dropped
+	static HalfEdgeMesh fromIndexed(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, JobSystem* jobSystem = nullptr)
+	{
+		HalfEdgeMesh mesh;
+		mesh._attributes = vertices;
+
+		// Welding through open addressing table of first vertices, -0 and +0 are the same position
+		auto hashPosition = [](const glm::vec3& p)
+			{
+				uint64_t hash = std::bit_cast<uint32_t>(p.x);
+				hash = (hash * 0x9e3779b97f4a7c15ull) ^ std::bit_cast<uint32_t>(p.y);
+				hash = (hash * 0x9e3779b97f4a7c15ull) ^ std::bit_cast<uint32_t>(p.z);
+				return hash * 0x9e3779b97f4a7c15ull;
+			};
+
+		size_t tableSize = std::bit_ceil(std::max<size_t>(vertices.size() * 2, 16));
+		std::vector<uint32_t> table(tableSize, InvalidIndex);
+		std::vector<uint32_t> vertexRemap(vertices.size());
+
+		for (uint32_t v = 0; v < vertices.size(); ++v)
+		{
+			glm::vec3 position = vertices[v].position + glm::vec3(0.0f);
+			size_t slot = (hashPosition(position) >> 16) & (tableSize - 1);
+
+			while (table[slot] != InvalidIndex && mesh._positions[table[slot]] != position)
+				slot = (slot + 1) & (tableSize - 1);
+
+			if (table[slot] == InvalidIndex)
+			{
+				table[slot] = static_cast<uint32_t>(mesh._positions.size());
+				mesh._positions.push_back(position);
+			}
+			vertexRemap[v] = table[slot];
+		}
+
+		mesh._faceOffsets.reserve(indices.size() / 3 + 1);
+		mesh._faceOffsets.push_back(0);
+		mesh._origins.reserve(indices.size() - indices.size() % 3);
+		mesh._cornerAttributes.reserve(indices.size() - indices.size() % 3);
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			uint32_t a = vertexRemap[indices[i]], b = vertexRemap[indices[i + 1]], c = vertexRemap[indices[i + 2]];
+			if (a == b || b == c || c == a)
+				continue;
+
+			mesh._origins.insert(mesh._origins.end(), { a, b, c });
+			mesh._cornerAttributes.insert(mesh._cornerAttributes.end(), { indices[i], indices[i + 1], indices[i + 2] });
+			mesh._faceOffsets.push_back(static_cast<uint32_t>(mesh._origins.size()));
+		}
+
+		mesh.build(mesh._positions.size(), jobSystem);
+		return mesh;
+	}
+
+	// Back to triangles (polygons as fans), positions come from the mesh, other attributes from the source corners.
+	// Pure topology with positions gets one vertex per mesh vertex with averaged normals
+	void toIndexed(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, JobSystem* jobSystem = nullptr) const
+	{
+		if (_cornerAttributes.empty())
+		{
+			std::vector<glm::vec3> faceNormals, normals;
+			if (!_positions.empty())
+				computeVertexNormals(_positions.data(), faceNormals, normals, jobSystem);
+
+			vertices.resize(getVertexCount());
+			for (size_t v = 0; v < vertices.size(); ++v)
+			{
+				vertices[v].position = _positions.empty() ? glm::vec3(0.0f) : _positions[v];
+				vertices[v].normal = normals.empty() ? glm::vec3(0.0f, 1.0f, 0.0f) : normals[v];
+				vertices[v].color = glm::vec3(1.0f);
+				vertices[v].textureCoord = glm::vec2(0.0f);
+			}
+		}
+		else
+		{
+			vertices = _attributes;
+			forEach(jobSystem, _origins.size(), [&](size_t begin, size_t end)
+				{
+					// Corners sharing a source vertex have the same origin, so concurrent writes store the same value
+					for (size_t h = begin; h < end; ++h)
+						vertices[_cornerAttributes[h]].position = _positions[_origins[h]];
+				});
+		}
+
+		const std::vector<uint32_t>& cornerVertices = _cornerAttributes.empty() ? _origins : _cornerAttributes;
+
+		indices.clear();
+		indices.reserve(3 * (_origins.size() - 2 * getFaceCount()));
+		for (uint32_t f = 0; f < getFaceCount(); ++f)
+		{
+			uint32_t first = _faceOffsets[f];
+			for (uint32_t i = 1; i + 1 < getFaceSize(f); ++i)
+				indices.insert(indices.end(), { cornerVertices[first], cornerVertices[first + i], cornerVertices[first + i + 1] });
+		}
+	}
+
+	size_t getVertexCount() const { return _vertexOffsets.empty() ? 0 : _vertexOffsets.size() - 1; }
+	size_t getFaceCount() const { return _faceOffsets.empty() ? 0 : _faceOffsets.size() - 1; }
+	size_t getEdgeCount() const { return _edgeHalfEdges.size(); }
+	size_t getHalfEdgeCount() const { return _origins.size(); }
+
+	uint32_t getOrigin(uint32_t halfEdge) const { return _origins[halfEdge]; }
+	uint32_t getTarget(uint32_t halfEdge) const { return _origins[getNext(halfEdge)]; }
+	uint32_t getTwin(uint32_t halfEdge) const { return _twins[halfEdge]; }
+	uint32_t getFace(uint32_t halfEdge) const { return _faces[halfEdge]; }
+	uint32_t getEdge(uint32_t halfEdge) const { return _edges[halfEdge]; }
+	bool isBoundary(uint32_t halfEdge) const { return _twins[halfEdge] == InvalidIndex; }
+
+	uint32_t getNext(uint32_t halfEdge) const
+	{
+		uint32_t face = _faces[halfEdge];
+		return (halfEdge + 1 < _faceOffsets[face + 1]) ? halfEdge + 1 : _faceOffsets[face];
+	}
+
+	uint32_t getPrev(uint32_t halfEdge) const
+	{
+		uint32_t face = _faces[halfEdge];
+		return (halfEdge > _faceOffsets[face]) ? halfEdge - 1 : _faceOffsets[face + 1] - 1;
+	}
+
+	// Half-edges of the face are [first, first + size)
+	uint32_t getFaceHalfEdge(uint32_t face) const { return _faceOffsets[face]; }
+	uint32_t getFaceSize(uint32_t face) const { return _faceOffsets[face + 1] - _faceOffsets[face]; }
+
+	uint32_t getEdgeHalfEdge(uint32_t edge) const { return _edgeHalfEdges[edge]; }
+	bool isBoundaryEdge(uint32_t edge) const { return isBoundary(_edgeHalfEdges[edge]); }
+
+	// Half-edges starting in the vertex, one per incident face corner
+	std::span<const uint32_t> getOutgoing(uint32_t vertex) const
+	{
+		return { _vertexHalfEdges.data() + _vertexOffsets[vertex], _vertexOffsets[vertex + 1] - _vertexOffsets[vertex] };
+	}
+
+	bool hasPositions() const { return !_positions.empty(); }
+	const glm::vec3& getPosition(uint32_t vertex) const { return _positions[vertex]; }
+	void setPosition(uint32_t vertex, const glm::vec3& position) { _positions[vertex] = position; }
+
+	void setPositions(std::vector<glm::vec3> positions)
+	{
+		if (positions.size() == getVertexCount())
+			_positions = std::move(positions);
+	}
+
+	// Source vertex of a corner, InvalidIndex for pure topology
+	uint32_t getCornerAttribute(uint32_t halfEdge) const { return _cornerAttributes.empty() ? InvalidIndex : _cornerAttributes[halfEdge]; }
+
+	size_t countBoundaryEdges() const
+	{
+		return std::count_if(_edgeHalfEdges.begin(), _edgeHalfEdges.end(), [&](uint32_t h) { return isBoundary(h); });
+	}
+
+	// Area weighted normals of vertices at the given positions (Newell normals of faces, so polygons work too)
+	void computeVertexNormals(const glm::vec3* positions, std::vector<glm::vec3>& faceNormals, std::vector<glm::vec3>& normals, JobSystem* jobSystem = nullptr) const
+	{
+		faceNormals.resize(getFaceCount());
+		forEach(jobSystem, faceNormals.size(), [&](size_t begin, size_t end)
+			{
+				for (uint32_t f = static_cast<uint32_t>(begin); f < end; ++f)
+				{
+					glm::vec3 normal(0.0f);
+					for (uint32_t h = _faceOffsets[f]; h < _faceOffsets[f + 1]; ++h)
+						normal += glm::cross(positions[_origins[h]], positions[getTarget(h)]);
+					faceNormals[f] = 0.5f * normal;
+				}
+			});
+
+		normals.resize(getVertexCount());
+		forEach(jobSystem, normals.size(), [&](size_t begin, size_t end)
+			{
+				for (uint32_t v = static_cast<uint32_t>(begin); v < end; ++v)
+				{
+					glm::vec3 normal(0.0f);
+					for (uint32_t h : getOutgoing(v))
+						normal += faceNormals[_faces[h]];
+
+					float length = glm::length(normal);
+					normals[v] = (length > 0.0f) ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+				}
+			});
+	}
+
+	// Checks every connectivity invariant, reports the first broken one
+	bool validate(JobSystem* jobSystem = nullptr) const
+	{
+		if (_faceOffsets.empty() || _faceOffsets.back() != _origins.size() || _twins.size() != _origins.size()
+			|| _faces.size() != _origins.size() || _edges.size() != _origins.size() || _vertexOffsets.empty())
+		{
+			std::cerr << "ERROR::HALF_EDGE::VALIDATE - array sizes do not match\n";
+			return false;
+		}
+
+		size_t halfEdgeCount = _origins.size();
+		uint32_t vertexCount = static_cast<uint32_t>(getVertexCount());
+
+		// First failure of every batch, the lowest one is reported
+		std::vector<std::pair<uint32_t, const char*>> failures((halfEdgeCount + BatchSize - 1) / BatchSize, { InvalidIndex, nullptr });
+
+		forEach(jobSystem, halfEdgeCount, [&](size_t begin, size_t end)
+			{
+				for (uint32_t h = static_cast<uint32_t>(begin); h < end; ++h)
+				{
+					const char* failure = nullptr;
+					uint32_t twin = _twins[h];
+
+					if (_origins[h] >= vertexCount)
+						failure = "origin out of range";
+					else if (_faces[h] >= getFaceCount() || h < _faceOffsets[_faces[h]] || h >= _faceOffsets[_faces[h] + 1])
+						failure = "half-edge outside of its face";
+					else if (getFaceSize(_faces[h]) < 3)
+						failure = "face with less than 3 corners";
+					else if (_origins[h] == getTarget(h))
+						failure = "degenerate edge";
+					else if (_edges[h] >= _edgeHalfEdges.size() || _edges[_edgeHalfEdges[_edges[h]]] != _edges[h])
+						failure = "edge does not reference back";
+					else if (twin != InvalidIndex && (twin >= halfEdgeCount || _twins[twin] != h))
+						failure = "twin does not reference back";
+					else if (twin != InvalidIndex && (_origins[twin] != getTarget(h) || getTarget(twin) != _origins[h]))
+						failure = "twin endpoints do not match";
+					else if (twin != InvalidIndex && _edges[twin] != _edges[h])
+						failure = "twins on different edges";
+
+					if (failure)
+					{
+						failures[begin / BatchSize] = { h, failure };
+						return;
+					}
+				}
+			});
+
+		for (const auto& [halfEdge, failure] : failures)
+		{
+			if (failure)
+			{
+				std::cerr << "ERROR::HALF_EDGE::VALIDATE - " << failure << " (half-edge " << halfEdge << ")\n";
+				return false;
+			}
+		}
+
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			for (uint32_t h : getOutgoing(v))
+			{
+				if (_origins[h] != v)
+				{
+					std::cerr << "ERROR::HALF_EDGE::VALIDATE - outgoing half-edge of other vertex (vertex " << v << ")\n";
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+private:
+	template<typename Function>
+	static void forEach(JobSystem* jobSystem, size_t count, const Function& function)
+	{
+		if (jobSystem)
+			jobSystem->parallelFor(count, BatchSize, function);
+		else if (count > 0)
+			function(size_t(0), count);
+	}
+
+	// Stable counting sort of items by key, items with key k are items[offsets[k], offsets[k + 1])
+	template<typename KeyFunction>
+	static void groupBy(size_t itemCount, size_t keyCount, const KeyFunction& key, std::vector<uint32_t>& offsets, std::vector<uint32_t>& items)
+	{
+		offsets.assign(keyCount + 1, 0);
+		for (uint32_t i = 0; i < itemCount; ++i)
+			offsets[key(i) + 1]++;
+		for (size_t k = 0; k < keyCount; ++k)
+			offsets[k + 1] += offsets[k];
+
+		items.resize(itemCount);
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (uint32_t i = 0; i < itemCount; ++i)
+			items[fill[key(i)]++] = i;
+	}
+
+	// Origins and face offsets are set
+	void build(size_t vertexCount, JobSystem* jobSystem)
+	{
+		_faces.resize(_origins.size());
+		forEach(jobSystem, getFaceCount(), [&](size_t begin, size_t end)
+			{
+				for (size_t f = begin; f < end; ++f)
+					std::fill(_faces.begin() + _faceOffsets[f], _faces.begin() + _faceOffsets[f + 1], static_cast<uint32_t>(f));
+			});
+
+		groupBy(_origins.size(), vertexCount, [&](uint32_t h) { return _origins[h]; }, _vertexOffsets, _vertexHalfEdges);
+		pairHalfEdges(vertexCount, jobSystem);
+	}
+
+	// Half-edges with the same endpoints in opposite directions become twins, every endpoint pair is one edge.
+	// Endpoint pairs are found among outgoing and incoming half-edges of their smaller vertex, so vertices are
+	// processed independently. Edges are numbered by (smaller, larger) endpoint
+	void pairHalfEdges(size_t vertexCount, JobSystem* jobSystem)
+	{
+		size_t halfEdgeCount = _origins.size();
+		_twins.assign(halfEdgeCount, InvalidIndex);
+		_edges.assign(halfEdgeCount, InvalidIndex);
+
+		std::vector<uint32_t> targets(halfEdgeCount);
+		forEach(jobSystem, halfEdgeCount, [&](size_t begin, size_t end)
+			{
+				for (uint32_t h = static_cast<uint32_t>(begin); h < end; ++h)
+					targets[h] = getTarget(h);
+			});
+
+		std::vector<uint32_t> groupOffsets, groupHalfEdges;
+		groupBy(halfEdgeCount, vertexCount, [&](uint32_t h) { return std::min(_origins[h], targets[h]); }, groupOffsets, groupHalfEdges);
+
+		auto otherVertex = [&](uint32_t h) { return std::max(_origins[h], targets[h]); };
+
+		// Sort groups by other endpoint and count distinct edges
+		std::vector<uint32_t> edgeOffsets(vertexCount + 1, 0);
+		forEach(jobSystem, vertexCount, [&](size_t begin, size_t end)
+			{
+				for (size_t v = begin; v < end; ++v)
+				{
+					auto first = groupHalfEdges.begin() + groupOffsets[v], last = groupHalfEdges.begin() + groupOffsets[v + 1];
+					std::sort(first, last, [&](uint32_t a, uint32_t b) { return std::make_pair(otherVertex(a), a) < std::make_pair(otherVertex(b), b); });
+
+					uint32_t count = 0;
+					for (auto it = first; it != last; ++it)
+						count += (it == first || otherVertex(*it) != otherVertex(*(it - 1)));
+					edgeOffsets[v + 1] = count;
+				}
+			});
+
+		for (size_t v = 0; v < vertexCount; ++v)
+			edgeOffsets[v + 1] += edgeOffsets[v];
+		_edgeHalfEdges.resize(edgeOffsets.back());
+
+		forEach(jobSystem, vertexCount, [&](size_t begin, size_t end)
+			{
+				for (size_t v = begin; v < end; ++v)
+				{
+					uint32_t edge = edgeOffsets[v];
+					for (uint32_t i = groupOffsets[v]; i < groupOffsets[v + 1];)
+					{
+						uint32_t last = i + 1;
+						while (last < groupOffsets[v + 1] && otherVertex(groupHalfEdges[last]) == otherVertex(groupHalfEdges[i]))
+							last++;
+
+						_edgeHalfEdges[edge] = groupHalfEdges[i];
+						for (uint32_t j = i; j < last; ++j)
+							_edges[groupHalfEdges[j]] = edge;
+
+						uint32_t a = groupHalfEdges[i];
+						if (last - i == 2 && _origins[a] != _origins[groupHalfEdges[i + 1]])
+						{
+							_twins[a] = groupHalfEdges[i + 1];
+							_twins[groupHalfEdges[i + 1]] = a;
+						}
+
+						edge++;
+						i = last;
+					}
+				}
+			});
+	}
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <glad.h>
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+
+#include "shader.h"
+
+// One analytic shape drawn as impostor (std430 layout, see impostor.vert)
+struct ImpostorInstance
+{
+	glm::vec4 centerRadius = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);		// xyz = center, w = sphere radius or torus major radius
+	glm::vec4 orientation = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);		// Quaternion (x, y, z, w), torus axis is local y
+	glm::vec4 colorMinorRadius = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);	// rgb = color, w = torus minor radius
+};
+
+// Spheres and tori without tessellation: every instance is the back faces of its bounding box, the fragment
+// shader intersects the view ray with the exact surface and writes its depth, so impostors intersect meshes
+// correctly. All instances of one shape are one instanced draw reading a storage buffer, which scales to
+// millions of spheres. Instances are not culled on the CPU, boxes outside of the view are clipped by the GPU
+class ImpostorRenderer
+{
+public:
+	static constexpr GLuint InstanceBindingPoint = 8;
+
+private:
+	struct InstanceSet
+	{
+		std::vector<ImpostorInstance> instances;
+		GLuint buffer = 0;
+		size_t capacity = 0;
+		bool isDirty = false;
+	};
+
+	InstanceSet _spheres;
+	InstanceSet _tori;
+
+	// Unit box, corners come from gl_VertexID bits
+	GLuint _vao = 0;
+	GLuint _ebo = 0;
+
+public:
+	ImpostorRenderer()
+	{
+		// Outward facing counter clockwise triangles of corners (x = bit 0, y = bit 1, z = bit 2)
+		const GLuint boxIndices[36] =
+		{
+			4, 6, 2, 4, 2, 0,
+			1, 3, 7, 1, 7, 5,
+			0, 1, 5, 0, 5, 4,
+			6, 7, 3, 6, 3, 2,
+			2, 3, 1, 2, 1, 0,
+			4, 5, 7, 4, 7, 6
+		};
+
+		glGenVertexArrays(1, &_vao);
+		glBindVertexArray(_vao);
+
+		glGenBuffers(1, &_ebo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(boxIndices), boxIndices, GL_STATIC_DRAW);
+
+		glBindVertexArray(0);
+	}
+
+	~ImpostorRenderer()
+	{
+		glDeleteVertexArrays(1, &_vao);
+		glDeleteBuffers(1, &_ebo);
+
+		for (InstanceSet* set : { &_spheres, &_tori })
+		{
+			if (set->buffer)
+				glDeleteBuffers(1, &set->buffer);
+		}
+	}
+
+	ImpostorRenderer(const ImpostorRenderer&) = delete;
+	ImpostorRenderer& operator=(const ImpostorRenderer&) = delete;
+
+	size_t getSphereCount() const { return _spheres.instances.size(); }
+	size_t getTorusCount() const { return _tori.instances.size(); }
+
+	void reserveSpheres(size_t count) { _spheres.instances.reserve(count); }
+
+	// Returns index for later updates
+	uint32_t addSphere(const glm::vec3& center, float radius, const glm::vec3& color)
+	{
+		ImpostorInstance instance;
+		instance.centerRadius = glm::vec4(center, radius);
+		instance.colorMinorRadius = glm::vec4(color, 0.0f);
+		return add(_spheres, instance);
+	}
+
+	// Rotation in degrees (same order as Transform), torus lies in local xz plane
+	uint32_t addTorus(const glm::vec3& center, const glm::vec3& rotation, float majorRadius, float minorRadius, const glm::vec3& color)
+	{
+		ImpostorInstance instance;
+		instance.centerRadius = glm::vec4(center, majorRadius);
+		instance.orientation = toOrientation(rotation);
+		instance.colorMinorRadius = glm::vec4(color, minorRadius);
+		return add(_tori, instance);
+	}
+
+	void setSphere(uint32_t index, const glm::vec3& center, float radius)
+	{
+		_spheres.instances[index].centerRadius = glm::vec4(center, radius);
+		_spheres.isDirty = true;
+	}
+
+	void setTorus(uint32_t index, const glm::vec3& center, const glm::vec3& rotation)
+	{
+		_tori.instances[index].centerRadius = glm::vec4(center, _tori.instances[index].centerRadius.w);
+		_tori.instances[index].orientation = toOrientation(rotation);
+		_tori.isDirty = true;
+	}
+
+	void clear()
+	{
+		for (InstanceSet* set : { &_spheres, &_tori })
+		{
+			set->instances.clear();
+			set->isDirty = true;
+		}
+	}
+
+	// Both shaders use impostor.vert, view and light uniforms have to be set by the caller
+	void render(const Shader& sphereShader, const Shader& torusShader)
+	{
+		// Only back faces are drawn, so every covered pixel is shaded once even with the camera inside the box
+		glCullFace(GL_FRONT);
+		glBindVertexArray(_vao);
+
+		draw(_spheres, sphereShader);
+		draw(_tori, torusShader);
+
+		glBindVertexArray(0);
+		glCullFace(GL_BACK);
+	}
+
+private:
+	static glm::vec4 toOrientation(const glm::vec3& rotation)
+	{
+		// Same rotation as Transform::compose (Rx * Ry * Rz)
+		glm::quat orientation = glm::angleAxis(glm::radians(rotation.x), glm::vec3(1, 0, 0))
+			* glm::angleAxis(glm::radians(rotation.y), glm::vec3(0, 1, 0))
+			* glm::angleAxis(glm::radians(rotation.z), glm::vec3(0, 0, 1));
+		return glm::vec4(orientation.x, orientation.y, orientation.z, orientation.w);
+	}
+
+	static uint32_t add(InstanceSet& set, const ImpostorInstance& instance)
+	{
+		set.instances.push_back(instance);
+		set.isDirty = true;
+		return static_cast<uint32_t>(set.instances.size() - 1);
+	}
+
+	static void draw(InstanceSet& set, const Shader& shader)
+	{
+		if (set.isDirty)
+			upload(set);
+
+		if (set.instances.empty())
+			return;
+
+		shader.use();
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, InstanceBindingPoint, set.buffer);
+		glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(set.instances.size()));
+	}
+
+	static void upload(InstanceSet& set)
+	{
+		set.isDirty = false;
+		if (set.instances.empty())
+			return;
+
+		if (!set.buffer)
+			glGenBuffers(1, &set.buffer);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, set.buffer);
+		if (set.instances.size() > set.capacity)
+		{
+			set.capacity = std::max(set.instances.size(), set.capacity * 2);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, set.capacity * sizeof(ImpostorInstance), nullptr, GL_DYNAMIC_DRAW);
+		}
+
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, set.instances.size() * sizeof(ImpostorInstance), set.instances.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+};
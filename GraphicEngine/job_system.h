@@ -0,0 +1,341 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+
+// Number of unfinished jobs in a group, jobs can also be scheduled to start after a counter reaches zero
+class JobCounter
+{
+	friend class JobSystem;
+
+private:
+	struct Continuation
+	{
+		std::function<void()> function;
+		JobCounter* counter = nullptr;
+	};
+
+	std::atomic<uint32_t> _value = 0;
+
+	std::mutex _mutex;
+	std::vector<Continuation> _continuations;
+
+public:
+	JobCounter() = default;
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool isDone() const { return _value.load(std::memory_order_acquire) == 0; }
+};
+
+// Work-stealing scheduler: every thread has its own deque, owner takes newest jobs from the back (cache warm),
+// idle threads steal oldest jobs from the front of other deques. Thread creating the system (main/OpenGL thread)
+// is worker 0, it runs jobs while waiting for counters and is the only one running jobs pinned to it
+class JobSystem
+{
+private:
+	struct Job
+	{
+		std::function<void()> function;
+		JobCounter* counter = nullptr;
+	};
+
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<std::unique_ptr<WorkerQueue>> _queues;
+	WorkerQueue _mainThreadQueue;
+	WorkerQueue _backgroundQueue;
+	std::vector<std::thread> _threads;
+	std::thread::id _mainThread = std::this_thread::get_id();
+
+	std::atomic<bool> _isRunning = true;
+
+	// Sleeping workers wake up when stealable jobs are queued
+	std::atomic<int64_t> _queuedJobs = 0;
+	std::mutex _sleepMutex;
+	std::condition_variable _wakeCondition;
+
+	inline static thread_local const JobSystem* _currentSystem = nullptr;
+	inline static thread_local size_t _workerIndex = 0;
+
+public:
+	// Worker threads besides the calling thread
+	explicit JobSystem(unsigned threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1)
+	{
+		threadCount = std::max(1u, threadCount);
+
+		for (unsigned i = 0; i <= threadCount; ++i)
+			_queues.push_back(std::make_unique<WorkerQueue>());
+
+		_currentSystem = this;
+		_workerIndex = 0;
+
+		for (unsigned i = 1; i <= threadCount; ++i)
+			_threads.emplace_back([this, i]() { workerLoop(i); });
+	}
+
+	~JobSystem()
+	{
+		_isRunning = false;
+
+		{
+			std::lock_guard<std::mutex> lock(_sleepMutex);
+		}
+		_wakeCondition.notify_all();
+
+		for (auto& thread : _threads)
+			thread.join();
+
+		if (_currentSystem == this)
+			_currentSystem = nullptr;
+	}
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Including the main thread
+	size_t getWorkerCount() const { return _queues.size(); }
+
+	bool isMainThread() const { return std::this_thread::get_id() == _mainThread; }
+
+	// Counter (optional) is incremented now and decremented when the job finishes.
+	// Job with a dependency is queued only after the dependency counter reaches zero
+	void run(std::function<void()> function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr)
+	{
+		if (counter)
+			counter->_value.fetch_add(1, std::memory_order_relaxed);
+
+		if (dependency)
+		{
+			std::lock_guard<std::mutex> lock(dependency->_mutex);
+			if (!dependency->isDone())
+			{
+				dependency->_continuations.push_back({ std::move(function), counter });
+				return;
+			}
+		}
+
+		enqueue({ std::move(function), counter });
+	}
+
+	// Job executed only by the main thread (OpenGL calls), in wait() or executeMainThreadJobs()
+	void runOnMainThread(std::function<void()> function, JobCounter* counter = nullptr)
+	{
+		if (counter)
+			counter->_value.fetch_add(1, std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock(_mainThreadQueue.mutex);
+		_mainThreadQueue.jobs.push_back({ std::move(function), counter });
+	}
+
+	// Long job (e.g. asset decoding) taken in FIFO order only by idle worker threads, never by a thread waiting
+	// for a counter, so frame work is not held up by it
+	void runBackground(std::function<void()> function)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_backgroundQueue.mutex);
+			_backgroundQueue.jobs.push_back({ std::move(function), nullptr });
+		}
+
+		_queuedJobs.fetch_add(1, std::memory_order_release);
+
+		{
+			std::lock_guard<std::mutex> lock(_sleepMutex);
+		}
+		_wakeCondition.notify_one();
+	}
+
+	// Help executing jobs until the counter reaches zero
+	void wait(JobCounter& counter)
+	{
+		while (!counter.isDone())
+		{
+			if (!(isMainThread() && executeMainThreadJob()) && !executeOneJob())
+				std::this_thread::yield();
+		}
+
+		// Last finishing job may still hold the mutex, counter can be destroyed only after it is released
+		std::lock_guard<std::mutex> lock(counter._mutex);
+	}
+
+	size_t executeMainThreadJobs()
+	{
+		size_t executed = 0;
+		while (executeMainThreadJob())
+			executed++;
+		return executed;
+	}
+
+	// Split [0, count) into batches processed in parallel, function(begin, end) is called per batch.
+	// Returns after all batches finished, the calling thread takes part
+	template<typename Function>
+	void parallelFor(size_t count, size_t batchSize, const Function& function)
+	{
+		if (count == 0)
+			return;
+
+		batchSize = std::max<size_t>(1, batchSize);
+		if (count <= batchSize)
+		{
+			function(size_t(0), count);
+			return;
+		}
+
+		JobCounter counter;
+		for (size_t begin = batchSize; begin < count; begin += batchSize)
+		{
+			size_t end = std::min(count, begin + batchSize);
+			run([&function, begin, end]() { function(begin, end); }, &counter);
+		}
+
+		// First batch on this thread, its data is most likely in cache
+		function(size_t(0), std::min(count, batchSize));
+		wait(counter);
+	}
+
+private:
+	void enqueue(Job job)
+	{
+		size_t index = (_currentSystem == this) ? _workerIndex : 0;
+
+		{
+			std::lock_guard<std::mutex> lock(_queues[index]->mutex);
+			_queues[index]->jobs.push_back(std::move(job));
+		}
+
+		_queuedJobs.fetch_add(1, std::memory_order_release);
+
+		{
+			std::lock_guard<std::mutex> lock(_sleepMutex);
+		}
+		_wakeCondition.notify_one();
+	}
+
+	bool popJob(Job& job, bool allowBackground)
+	{
+		size_t self = (_currentSystem == this) ? _workerIndex : 0;
+
+		// Own queue first (newest job)
+		{
+			WorkerQueue& queue = *_queues[self];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty())
+			{
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+				_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		// Steal oldest job, victims are visited starting next to us so thieves spread out
+		for (size_t i = 1; i < _queues.size(); ++i)
+		{
+			WorkerQueue& queue = *_queues[(self + i) % _queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty())
+			{
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+				_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		if (allowBackground)
+		{
+			std::lock_guard<std::mutex> lock(_backgroundQueue.mutex);
+			if (!_backgroundQueue.jobs.empty())
+			{
+				job = std::move(_backgroundQueue.jobs.front());
+				_backgroundQueue.jobs.pop_front();
+				_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool executeOneJob(bool allowBackground = false)
+	{
+		Job job;
+		if (!popJob(job, allowBackground))
+			return false;
+
+		execute(job);
+		return true;
+	}
+
+	bool executeMainThreadJob()
+	{
+		Job job;
+
+		{
+			std::lock_guard<std::mutex> lock(_mainThreadQueue.mutex);
+			if (_mainThreadQueue.jobs.empty())
+				return false;
+
+			job = std::move(_mainThreadQueue.jobs.front());
+			_mainThreadQueue.jobs.pop_front();
+		}
+
+		execute(job);
+		return true;
+	}
+
+	void execute(Job& job)
+	{
+		job.function();
+
+		if (job.counter)
+			finish(*job.counter);
+	}
+
+	void finish(JobCounter& counter)
+	{
+		// Counter is not touched after the lock is released (waiting thread may destroy it right away)
+		std::vector<JobCounter::Continuation> continuations;
+		{
+			std::lock_guard<std::mutex> lock(counter._mutex);
+			if (counter._value.fetch_sub(1, std::memory_order_acq_rel) != 1)
+				return;
+
+			// Counter reached zero, release jobs waiting for it
+			continuations.swap(counter._continuations);
+		}
+
+		for (auto& continuation : continuations)
+			enqueue({ std::move(continuation.function), continuation.counter });
+	}
+
+	void workerLoop(size_t index)
+	{
+		_currentSystem = this;
+		_workerIndex = index;
+
+		while (_isRunning.load(std::memory_order_acquire))
+		{
+			if (executeOneJob(true))
+				continue;
+
+			std::unique_lock<std::mutex> lock(_sleepMutex);
+			_wakeCondition.wait(lock, [this]()
+				{
+					return !_isRunning.load(std::memory_order_acquire) || _queuedJobs.load(std::memory_order_acquire) > 0;
+				});
+		}
+	}
+};
@@ -0,0 +1,379 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+// Minimal JSON document (RFC 8259) for asset descriptions like glTF. Objects keep member order and are
+// searched linearly, which is fine for the small objects of asset files. Missing members and wrong types
+// resolve to null values instead of failing, so lookups can be chained
+class JsonValue
+{
+public:
+	enum class Type : uint8_t { Null, Boolean, Number, String, Array, Object };
+
+private:
+	Type _type = Type::Null;
+	bool _boolean = false;
+	double _number = 0.0;
+	std::string _string;
+	std::vector<JsonValue> _elements;
+	std::vector<std::pair<std::string, JsonValue>> _members;
+
+	static constexpr int MaxDepth = 256;
+
+public:
+	JsonValue() = default;
+
+	Type getType() const { return _type; }
+	bool isNull() const { return _type == Type::Null; }
+	bool isBoolean() const { return _type == Type::Boolean; }
+	bool isNumber() const { return _type == Type::Number; }
+	bool isString() const { return _type == Type::String; }
+	bool isArray() const { return _type == Type::Array; }
+	bool isObject() const { return _type == Type::Object; }
+
+	bool asBool(bool fallback = false) const { return isBoolean() ? _boolean : fallback; }
+	double asNumber(double fallback = 0.0) const { return isNumber() ? _number : fallback; }
+	float asFloat(float fallback = 0.0f) const { return isNumber() ? static_cast<float>(_number) : fallback; }
+	int64_t asInt(int64_t fallback = 0) const { return isNumber() ? static_cast<int64_t>(_number) : fallback; }
+	const std::string& asString() const { return _string; }
+
+	// Element count of arrays, member count of objects
+	size_t size() const { return isArray() ? _elements.size() : (isObject() ? _members.size() : 0); }
+
+	bool has(std::string_view key) const { return find(key) != nullptr; }
+
+	const JsonValue& operator[](std::string_view key) const
+	{
+		const JsonValue* value = find(key);
+		return value ? *value : getNull();
+	}
+
+	const JsonValue& operator[](size_t index) const
+	{
+		return (isArray() && index < _elements.size()) ? _elements[index] : getNull();
+	}
+
+	const std::vector<JsonValue>& getElements() const { return _elements; }
+	const std::vector<std::pair<std::string, JsonValue>>& getMembers() const { return _members; }
+
+	// Returns false on malformed input (error is reported with its byte offset)
+	static bool parse(std::string_view text, JsonValue& value, const std::string& sourceName = "")
+	{
+		Parser parser{ text.data(), text.data() + text.size(), text.data() };
+		value = JsonValue();
+
+		parser.skipWhitespace();
+		bool success = parser.parseValue(value, 0);
+
+		parser.skipWhitespace();
+		if (success && parser.position != parser.end)
+			success = parser.fail("unexpected data after document");
+
+		if (!success)
+		{
+			std::cerr << "ERROR::JSON::PARSE_FAILED - " << sourceName << " at byte " << (parser.errorPosition - parser.begin) << ": " << parser.error << "\n";
+			value = JsonValue();
+		}
+
+		return success;
+	}
+
+private:
+	const JsonValue* find(std::string_view key) const
+	{
+		for (const auto& member : _members)
+		{
+			if (member.first == key)
+				return &member.second;
+		}
+
+		return nullptr;
+	}
+
+	static const JsonValue& getNull()
+	{
+		static const JsonValue null;
+		return null;
+	}
+
+	struct Parser
+	{
+		const char* position;
+		const char* end;
+		const char* begin;
+
+		const char* error = "";
+		const char* errorPosition = nullptr;
+
+		bool fail(const char* message)
+		{
+			error = message;
+			errorPosition = position;
+			return false;
+		}
+
+		void skipWhitespace()
+		{
+			while (position != end && (*position == ' ' || *position == '\t' || *position == '\n' || *position == '\r'))
+				position++;
+		}
+
+		bool consume(std::string_view literal)
+		{
+			if (size_t(end - position) < literal.size() || std::string_view(position, literal.size()) != literal)
+				return false;
+
+			position += literal.size();
+			return true;
+		}
+
+		bool parseValue(JsonValue& value, int depth)
+		{
+			if (depth > MaxDepth)
+				return fail("nesting too deep");
+
+			if (position == end)
+				return fail("unexpected end of document");
+
+			switch (*position)
+			{
+			case '{': return parseObject(value, depth);
+			case '[': return parseArray(value, depth);
+			case '"': value._type = Type::String; return parseString(value._string);
+			case 't': value._type = Type::Boolean; value._boolean = true; return consume("true") || fail("invalid literal");
+			case 'f': value._type = Type::Boolean; value._boolean = false; return consume("false") || fail("invalid literal");
+			case 'n': value._type = Type::Null; return consume("null") || fail("invalid literal");
+			default: return parseNumber(value);
+			}
+		}
+
+		bool parseObject(JsonValue& value, int depth)
+		{
+			value._type = Type::Object;
+			position++;
+
+			skipWhitespace();
+			if (position != end && *position == '}')
+			{
+				position++;
+				return true;
+			}
+
+			while (true)
+			{
+				skipWhitespace();
+				if (position == end || *position != '"')
+					return fail("expected member name");
+
+				value._members.emplace_back();
+				if (!parseString(value._members.back().first))
+					return false;
+
+				skipWhitespace();
+				if (position == end || *position++ != ':')
+					return fail("expected ':'");
+
+				skipWhitespace();
+				if (!parseValue(value._members.back().second, depth + 1))
+					return false;
+
+				skipWhitespace();
+				if (position == end)
+					return fail("unterminated object");
+
+				char separator = *position++;
+				if (separator == '}')
+					return true;
+				if (separator != ',')
+					return fail("expected ',' or '}'");
+			}
+		}
+
+		bool parseArray(JsonValue& value, int depth)
+		{
+			value._type = Type::Array;
+			position++;
+
+			skipWhitespace();
+			if (position != end && *position == ']')
+			{
+				position++;
+				return true;
+			}
+
+			while (true)
+			{
+				skipWhitespace();
+				value._elements.emplace_back();
+				if (!parseValue(value._elements.back(), depth + 1))
+					return false;
+
+				skipWhitespace();
+				if (position == end)
+					return fail("unterminated array");
+
+				char separator = *position++;
+				if (separator == ']')
+					return true;
+				if (separator != ',')
+					return fail("expected ',' or ']'");
+			}
+		}
+
+		bool parseNumber(JsonValue& value)
+		{
+			// Validate JSON number grammar first, strtod accepts more (hex, inf, leading '+')
+			const char* start = position;
+			const char* cursor = position;
+
+			auto digits = [&]()
+				{
+					const char* first = cursor;
+					while (cursor != end && *cursor >= '0' && *cursor <= '9')
+						cursor++;
+					return cursor != first;
+				};
+
+			if (cursor != end && *cursor == '-')
+				cursor++;
+
+			if (cursor != end && *cursor == '0')
+				cursor++;
+			else if (!digits())
+				return fail("invalid value");
+
+			if (cursor != end && *cursor == '.')
+			{
+				cursor++;
+				if (!digits())
+					return fail("invalid number");
+			}
+
+			if (cursor != end && (*cursor == 'e' || *cursor == 'E'))
+			{
+				cursor++;
+				if (cursor != end && (*cursor == '+' || *cursor == '-'))
+					cursor++;
+				if (!digits())
+					return fail("invalid number");
+			}
+
+			// Copy keeps strtod from reading past the end of not null terminated input
+			value._type = Type::Number;
+			value._number = std::strtod(std::string(start, cursor).c_str(), nullptr);
+			position = cursor;
+			return true;
+		}
+
+		bool parseString(std::string& result)
+		{
+			position++;
+
+			while (true)
+			{
+				// Copy plain runs at once
+				const char* run = position;
+				while (position != end && *position != '"' && *position != '\\' && static_cast<unsigned char>(*position) >= 0x20)
+					position++;
+				result.append(run, position);
+
+				if (position == end)
+					return fail("unterminated string");
+
+				char c = *position++;
+				if (c == '"')
+					return true;
+				if (c != '\\')
+					return fail("control character in string");
+
+				if (position == end)
+					return fail("unterminated string");
+
+				switch (*position++)
+				{
+				case '"': result += '"'; break;
+				case '\\': result += '\\'; break;
+				case '/': result += '/'; break;
+				case 'b': result += '\b'; break;
+				case 'f': result += '\f'; break;
+				case 'n': result += '\n'; break;
+				case 'r': result += '\r'; break;
+				case 't': result += '\t'; break;
+				case 'u':
+				{
+					uint32_t codePoint = 0;
+					if (!parseHex(codePoint))
+						return false;
+
+					// Surrogate pair
+					if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+					{
+						uint32_t low = 0;
+						if (!consume("\\u") || !parseHex(low) || low < 0xDC00 || low > 0xDFFF)
+							return fail("invalid surrogate pair");
+
+						codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					}
+
+					appendUTF8(result, codePoint);
+					break;
+				}
+				default:
+					return fail("invalid escape sequence");
+				}
+			}
+		}
+
+		bool parseHex(uint32_t& value)
+		{
+			if (end - position < 4)
+				return fail("invalid unicode escape");
+
+			value = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				char c = *position++;
+				value <<= 4;
+
+				if (c >= '0' && c <= '9') value |= c - '0';
+				else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+				else return fail("invalid unicode escape");
+			}
+
+			return true;
+		}
+
+		static void appendUTF8(std::string& result, uint32_t codePoint)
+		{
+			if (codePoint < 0x80)
+			{
+				result += static_cast<char>(codePoint);
+			}
+			else if (codePoint < 0x800)
+			{
+				result += static_cast<char>(0xC0 | (codePoint >> 6));
+				result += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else if (codePoint < 0x10000)
+			{
+				result += static_cast<char>(0xE0 | (codePoint >> 12));
+				result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				result += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else
+			{
+				result += static_cast<char>(0xF0 | (codePoint >> 18));
+				result += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+				result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				result += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+		}
+	};
+};
@@ -1,23 +1,41 @@
-#pragma once
-
-#include <string>
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <vector>
-#include <unordered_map>
-#include <type_traits>
-
-#define GLFW_INCLUDE_NONE
-#include <glfw3.h>
-#include <glad.h>
-#include <glm.hpp>
-#include <gtc/matrix_transform.hpp>
-#include <gtc/type_ptr.hpp>
-#include <gtc/constants.hpp>
-
-#define STB_IMAGE_IMPLEMENTATION
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "model.h"
-#include "material.h"
-#include "camera.h"
\ No newline at end of file
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <unordered_map>
+#include <type_traits>
+
+#define GLFW_INCLUDE_NONE
+#include <glfw3.h>
+#include <glad.h>
+#include <glm.hpp>
+#include <gtc/matrix_transform.hpp>
+#include <gtc/type_ptr.hpp>
+#include <gtc/constants.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "model.h"
+#include "primitive_registry.h"
+#include "scene_graph.h"
+#include "material.h"
+#include "camera.h"
+#include "texture_streamer.h"
+#include "material_table.h"
+#include "object_buffer.h"
+#include "job_system.h"
+#include "frame_pipeline.h"
+#include "fixed_timestep.h"
+#include "occlusion_culler.h"
+#include "cluster_culler.h"
+#include "cluster_lod_mesh.h"
+#include "subdivision_mesh.h"
+#include "static_batch.h"
+#include "impostor_renderer.h"
+#include "depth_pyramid.h"
+#include "render_world.h"
+#include "resource_manager.h"
\ No newline at end of file
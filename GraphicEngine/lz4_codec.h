@@ -0,0 +1,169 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+// LZ4 block format (no frame header), compatible with LZ4_compress_default / LZ4_decompress_safe
+class LZ4Codec
+{
+private:
+	static constexpr size_t MinMatch = 4;
+	static constexpr size_t LastLiterals = 5;		// Last bytes of block are always literals
+	static constexpr size_t MatchFindLimit = 12;	// Last match has to start this far from the end
+	static constexpr size_t MaxOffset = 65535;
+	static constexpr int HashBits = 16;
+
+public:
+	static size_t getMaxCompressedSize(size_t size) { return size + size / 255 + 16; }
+
+	// Greedy single pass compression with hash table of 4 byte sequences
+	static std::vector<unsigned char> compress(const unsigned char* source, size_t size)
+	{
+		std::vector<unsigned char> output;
+		output.reserve(getMaxCompressedSize(size));
+
+		size_t anchor = 0;
+
+		if (size >= MatchFindLimit + 1)
+		{
+			std::vector<int64_t> table(size_t(1) << HashBits, -1);
+
+			size_t position = 0;
+			size_t matchLimit = size - LastLiterals;
+
+			while (position + MatchFindLimit <= size)
+			{
+				uint32_t sequence = read32(source + position);
+				uint32_t hash = (sequence * 2654435761u) >> (32 - HashBits);
+
+				int64_t candidate = table[hash];
+				table[hash] = static_cast<int64_t>(position);
+
+				if (candidate < 0 || position - candidate > MaxOffset || read32(source + candidate) != sequence)
+				{
+					position++;
+					continue;
+				}
+
+				size_t matchLength = MinMatch;
+				while (position + matchLength < matchLimit && source[candidate + matchLength] == source[position + matchLength])
+					matchLength++;
+
+				writeSequence(output, source + anchor, position - anchor, static_cast<uint16_t>(position - candidate), matchLength);
+
+				position += matchLength;
+				anchor = position;
+			}
+		}
+
+		// Last sequence has only literals
+		writeSequence(output, source + anchor, size - anchor, 0, 0);
+		return output;
+	}
+
+	// Returns false on malformed input or if the output size does not match exactly
+	static bool decompress(const unsigned char* source, size_t sourceSize, unsigned char* target, size_t targetSize)
+	{
+		size_t in = 0;
+		size_t out = 0;
+
+		while (in < sourceSize)
+		{
+			unsigned char token = source[in++];
+
+			size_t literalLength = token >> 4;
+			if (literalLength == 15 && !readLength(source, sourceSize, in, literalLength))
+				return false;
+
+			if (literalLength > sourceSize - in || literalLength > targetSize - out)
+				return false;
+
+			std::memcpy(target + out, source + in, literalLength);
+			in += literalLength;
+			out += literalLength;
+
+			// Block ends with literals
+			if (in == sourceSize)
+				break;
+
+			if (sourceSize - in < 2)
+				return false;
+
+			size_t offset = source[in] | (source[in + 1] << 8);
+			in += 2;
+
+			if (offset == 0 || offset > out)
+				return false;
+
+			size_t matchLength = token & 15;
+			if (matchLength == 15 && !readLength(source, sourceSize, in, matchLength))
+				return false;
+
+			matchLength += MinMatch;
+			if (matchLength > targetSize - out)
+				return false;
+
+			// Byte by byte, match can overlap the output being written
+			for (size_t i = 0; i < matchLength; ++i, ++out)
+				target[out] = target[out - offset];
+		}
+
+		return out == targetSize;
+	}
+
+private:
+	static uint32_t read32(const unsigned char* data)
+	{
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static void writeLength(std::vector<unsigned char>& output, size_t length)
+	{
+		while (length >= 255)
+		{
+			output.push_back(255);
+			length -= 255;
+		}
+
+		output.push_back(static_cast<unsigned char>(length));
+	}
+
+	static bool readLength(const unsigned char* source, size_t sourceSize, size_t& in, size_t& length)
+	{
+		unsigned char value;
+		do
+		{
+			if (in >= sourceSize)
+				return false;
+
+			value = source[in++];
+			length += value;
+		} while (value == 255);
+
+		return true;
+	}
+
+	static void writeSequence(std::vector<unsigned char>& output, const unsigned char* literals, size_t literalLength, uint16_t offset, size_t matchLength)
+	{
+		size_t matchCode = matchLength ? matchLength - MinMatch : 0;
+
+		output.push_back(static_cast<unsigned char>(((literalLength < 15 ? literalLength : 15) << 4) | (matchCode < 15 ? matchCode : 15)));
+
+		if (literalLength >= 15)
+			writeLength(output, literalLength - 15);
+
+		output.insert(output.end(), literals, literals + literalLength);
+
+		if (!matchLength)
+			return;
+
+		output.push_back(static_cast<unsigned char>(offset & 0xFF));
+		output.push_back(static_cast<unsigned char>(offset >> 8));
+
+		if (matchCode >= 15)
+			writeLength(output, matchCode - 15);
+	}
+};
@@ -1,371 +1,643 @@
-#include "libs.h"
-
-
-// ------------------------------------------------
-//  GLOBALS
-// ------------------------------------------------
-const char* WINDOW_TITLE = "Graphic Engine";
-const int SCREEN_WIDTH = 1280;
-const int SCREEN_HEIGHT = 720;
-const int OPENGL_MAJOR_VERSION = 4;
-const int OPENGL_MINOR_VERSION = 6;
-
-int framebufferWidth = 0;
-int framebufferHeight = 0;
-
-bool firstMouseMove = true;
-float lastMouseX = SCREEN_WIDTH * 0.5f;
-float lastMouseY = SCREEN_HEIGHT * 0.5f;
-
-Direction_Movement cameraDirFlag = Direction_Movement::NONE;
-
-Camera camera({ -15.0f, 25.0f, 35.0f }, { 0.0f, 1.0f, 0.0f }, -40.0f, -70.0f);
-
-// ------------------------------------------------
-//  FUNCTIONS
-// ------------------------------------------------
-void updateWindowStats(GLFWwindow* window, float deltaTime, size_t vertexCount)
-{
-	// Static variables to not go out of scope after function ends
-	static float timer = 0.0f;
-	static int frames = 0;
-
-	timer += deltaTime;
-	frames++;
-
-	// Update window stats only once per second
-	if (timer >= 1.0f)
-	{
-		// Calculate FPS
-		int fps = glm::round(frames / timer);
-
-		std::stringstream ss;
-		ss << WINDOW_TITLE << " | FPS: " << fps << " | Vertices: " << vertexCount;
-
-		// Update stats
-		glfwSetWindowTitle(window, ss.str().c_str());
-
-		// Resets timers
-		timer = 0.0f;
-		frames = 0;
-	}
-}
-
-void processCameraDirectionMovement(Direction_Movement direction, int action)
-{
-	if (action == GLFW_PRESS)
-		cameraDirFlag |= direction;
-	else if (action == GLFW_RELEASE)
-		cameraDirFlag &= ~direction;
-}
-
-
-// ------------------------------------------------
-//  CALLBACKS
-// ------------------------------------------------
-void keyboard_input_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
-{
-	switch (key)
-	{
-	case GLFW_KEY_ESCAPE:
-		glfwSetWindowShouldClose(window, true);
-		break;
-	case GLFW_KEY_TAB:
-		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-		break;
-	case GLFW_KEY_W:
-		processCameraDirectionMovement(Direction_Movement::FORWARD, action);
-		break;
-	case GLFW_KEY_S:
-		processCameraDirectionMovement(Direction_Movement::BACKWARD, action);
-		break;
-	case GLFW_KEY_A:
-		processCameraDirectionMovement(Direction_Movement::LEFT, action);
-		break;
-	case GLFW_KEY_D:
-		processCameraDirectionMovement(Direction_Movement::RIGHT, action);
-		break;
-	case GLFW_KEY_SPACE:
-		processCameraDirectionMovement(Direction_Movement::UP, action);
-		break;
-	case GLFW_KEY_LEFT_CONTROL:
-		processCameraDirectionMovement(Direction_Movement::DOWN, action);
-		break;
-	case GLFW_KEY_Q:
-		processCameraDirectionMovement(Direction_Movement::ROLL_LEFT, action);
-		break;
-	case GLFW_KEY_E:
-		processCameraDirectionMovement(Direction_Movement::ROLL_RIGHT, action);
-		break;
-	case GLFW_KEY_LEFT_SHIFT:
-		camera.MovementSpeed += 0.5f;
-		break;
-	}
-}
-
-void mouse_movement_callback(GLFWwindow* window, double mousePosX, double mousePosY)
-{
-	if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
-		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-	if (firstMouseMove)
-	{
-		lastMouseX = mousePosX;
-		lastMouseY = mousePosY;
-		firstMouseMove = false;
-	}
-
-	float deltaX = static_cast<float>(mousePosX) - lastMouseX;
-	float deltaY = lastMouseY - static_cast<float>(mousePosY);
-
-	lastMouseX = mousePosX;
-	lastMouseY = mousePosY;
-
-	camera.processMouseMovement(deltaX, deltaY);
-}
-
-void mouse_scroll_callback(GLFWwindow* window, double deltaX, double deltaY)
-{
-	camera.processMouseScroll(deltaY);
-}
-
-void framebuffer_resize_callback(GLFWwindow* window, int width, int height)
-{
-	framebufferWidth = width;
-	framebufferHeight = height;
-	glViewport(0, 0, width, height);
-}
-
-
-// ------------------------------------------------
-//  INITIALIZATION
-// ------------------------------------------------
-bool initializeOpenGLEngine(GLFWwindow*& window, int& fbW, int& fbH)
-{
-	std::cout << "INITIALIZING::GLFW::LIBRARY\n";
-	if (!glfwInit()) {
-		std::cerr << "ERROR::GLFW_INIT\n";
-		return false;
-	}
-
-	// OpenGL version hints
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, OPENGL_MAJOR_VERSION);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, OPENGL_MINOR_VERSION);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-	// Create window
-	std::cout << "CREATING::GLFW::WINDOW\n";
-	window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, WINDOW_TITLE, nullptr, nullptr);
-	if (!window)
-	{
-		std::cerr << "ERROR::GLFW_CREATE_WINDOW\n";
-		glfwTerminate();
-		return false;
-	}
-
-	// Make OpenGL context current
-	glfwMakeContextCurrent(window);
-	// Enable v-sync
-	glfwSwapInterval(0);
-
-	// Load OpenGL functions
-	std::cout << "INITIALIZING::GLAD\n";
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-	{
-		std::cerr << "ERROR::GLAD_LOAD_GL\n";
-		glfwDestroyWindow(window);
-		glfwTerminate();
-		return false;
-	}
-
-	// Set initial viewport
-	glfwGetFramebufferSize(window, &fbW, &fbH);
-	glViewport(0, 0, fbW, fbH);
-
-	// Set GLFW callbacks and input modes
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glfwSetKeyCallback(window, keyboard_input_callback);
-	glfwSetCursorPosCallback(window, mouse_movement_callback);
-	glfwSetScrollCallback(window, mouse_scroll_callback);
-	glfwSetFramebufferSizeCallback(window, framebuffer_resize_callback);
-
-	// Enable common OpenGL states
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-	glFrontFace(GL_CCW);
-
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-	return true;
-}
-
-
-// ------------------------------------------------
-//  MAIN
-// ------------------------------------------------
-int main()
-{
-	GLFWwindow* window = nullptr;
-
-	if (!initializeOpenGLEngine(window, framebufferWidth, framebufferHeight))
-		return EXIT_FAILURE;
-
-	// Load Shaders
-	Shader shaderPBRProgram("Shaders/vertex_shader_core.vert", "Shaders/fragment_shader_pbr.frag");
-	Shader shaderPhongProgram("Shaders/vertex_shader_core.vert", "Shaders/fragment_shader_core.frag");
-
-	// Load Textures
-	Texture albedoTex("Assets/Textures/Metal_color.png", GL_TEXTURE_2D);
-	Texture normalTex("Assets/Textures/Metal_normal_gl.png", GL_TEXTURE_2D);
-	Texture metallicTex("Assets/Textures/Metal_metalness.png", GL_TEXTURE_2D);
-	Texture roughnessTex("Assets/Textures/Metal_roughness.png", GL_TEXTURE_2D);
-	Texture ambientOcclusionTex("Assets/Textures/Metal_ambient_occlusion.png", GL_TEXTURE_2D);
-
-	// Default position and color of light
-	glm::vec3 lightPosition(0.0f, 0.0f, 5.0f);
-	glm::vec3 lightColor(5.0f, 5.0f, 5.0f);
-
-	// Creating PBR material for testing
-	PBRMaterial pbrMaterial(glm::vec3(1.0f), 0.0f, 0.5f, 1.0f, &albedoTex, &normalTex, &metallicTex, &roughnessTex, &ambientOcclusionTex);
-	PhongMaterial baseMaterial(glm::vec3(0.1f), glm::vec3(1.0f), glm::vec3(1.0f), 32.0f);
-	PhongMaterial metalMaterial(glm::vec3(0.1f), glm::vec3(1.0f), glm::vec3(1.0f), 32.0f, &albedoTex, &metallicTex);
-
-	// Setup primitives
-	Plane plane(150.0f, 150.0f);
-	Cube cube(6.0f);
-	Sphere sphere(1.6f, 64U, 64U);
-	Torus torus(18.0f, 1.5f, 64U, 64U);
-
-	Mesh planeGrid(plane);
-	Mesh cubeTest(cube);
-	Mesh sphereTest(sphere);
-	Mesh torusTest(torus);
-
-	planeGrid.setPosition({ 0.0f,-30.0f, 0.0f });
-	cubeTest.setPosition({ 0.0f, 0.0f, 0.0f });
-	sphereTest.setPosition({ 0.0f, 0.0f, 0.0f });
-	torusTest.setPosition({ 0.0f, 0.0f, 0.0f });
-	torusTest.setRotation({ 30.0f, 0.0f, 0.0f });
-
-	// Load model
-	Model model("Assets/Models/catmark_torus_creases0.obj");
-
-	model.scale({ 10.0f, 10.0f, 10.0f });
-
-	// Camera matrices
-	glm::mat4 viewMatrix;
-	glm::mat4 projectionMatrix;
-
-	// Simulation of time (for fixed or delta time update)
-	float deltaTime = 0.0f;
-	float lastFrame = 0.0f;
-
-	// Render Loop
-	while (!glfwWindowShouldClose(window))
-	{
-		// Calculate delta time
-		float currentFrame = glfwGetTime();
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
-
-		// Call any callbacks in the queue
-		glfwPollEvents();
-
-		// Camera update
-		camera.processMovement(cameraDirFlag, deltaTime);
-
-		// Update view and projection matrices
-		viewMatrix = camera.getViewMatrix();
-		projectionMatrix = camera.getProjectionMatrix(static_cast<float>(framebufferWidth) / framebufferHeight);
-
-		// Re-color & clear buffers
-		glClearColor(0.2f, 0.2f, 0.2f, 1.f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// Mesh animations
-		cubeTest.rotate({
-			0.0f,
-			10.0f * deltaTime,
-			0.0f
-			});
-
-		sphereTest.setPosition({
-			glm::cos(currentFrame * 0.5f) * 10,
-			glm::sin(currentFrame * 0.5f) * 10,
-			0.0f
-			});
-		sphereTest.rotate({
-			0.0f,
-			deltaTime * 100,
-			0.0f
-			});
-
-		torusTest.rotate({
-			20.0f * deltaTime,
-			0.0f,
-			10.0f * deltaTime
-			});
-
-		// Light movement
-		lightPosition.x += glm::cos(currentFrame) * 10 * deltaTime;
-		lightPosition.y += glm::cos(currentFrame) * 5 * deltaTime;
-
-		// Using shader program and apply scene changes to Vertex and Fragment shader
-		//shaderPBRProgram.use();
-		//shaderPBRProgram.set("view_matrix", viewMatrix);
-		//shaderPBRProgram.set("projection_matrix", projectionMatrix);
-		//shaderPBRProgram.set("light_position", lightPosition);
-		//shaderPBRProgram.set("light_color", lightColor);
-		//shaderPBRProgram.set("camera_position", camera.Position);
-
-		//pbrMaterial.apply(shaderPBRProgram);
-		//sphereTest.render(shaderPBRProgram);
-		//torusTest.render(shaderPBRProgram);
-		//model.render(shaderPBRProgram);
-
-		shaderPhongProgram.use();
-		shaderPhongProgram.set("view_matrix", viewMatrix);
-		shaderPhongProgram.set("projection_matrix", projectionMatrix);
-		shaderPhongProgram.set("light_position", lightPosition);
-		shaderPhongProgram.set("light_color", lightColor);
-		shaderPhongProgram.set("camera_position", camera.Position);
-
-		baseMaterial.apply(shaderPhongProgram);
-		planeGrid.render(shaderPhongProgram);
-		torusTest.render(shaderPhongProgram);
-
-		metalMaterial.apply(shaderPhongProgram);
-		cubeTest.render(shaderPhongProgram);
-		sphereTest.render(shaderPhongProgram);
-		model.render(shaderPhongProgram);
-		for (size_t i = 0; i < 1; i++)
-		{
-			//sphereTest.render(shaderPhongProgram);
-			//sphereTest.move({ 5.0f, 0.0f, 0.0f });
-		}
-
-		size_t totalVertexCount = (
-			planeGrid.getVertexCount() +
-			cubeTest.getVertexCount() +
-			sphereTest.getVertexCount() +
-			torusTest.getVertexCount() +
-			model.getTotalVertexCount() +
-			0
-			);
-
-		// Update stats (in window title) like fps and count of vertices in the scene
-		updateWindowStats(window, deltaTime, totalVertexCount);
-
-		// Enable swaping buffers (double buffered scene)
-		glfwSwapBuffers(window);
-	}
-
-	// Cleanup and call destructors
-	glfwDestroyWindow(window);
-	glfwTerminate();
-	return EXIT_SUCCESS;
+#include "libs.h"
+
+
+// ------------------------------------------------
+//  GLOBALS
+// ------------------------------------------------
+const char* WINDOW_TITLE = "Graphic Engine";
+const int SCREEN_WIDTH = 1280;
+const int SCREEN_HEIGHT = 720;
+const int OPENGL_MAJOR_VERSION = 4;
+const int OPENGL_MINOR_VERSION = 6;
+
+// Simulation runs at fixed rate independent of frame rate, at most this many steps per frame
+const float SIMULATION_TICK_RATE = 60.0f;
+const int SIMULATION_MAX_STEPS = 5;
+
+// Render world visibility computed by compute shader (GPU), otherwise by job system with CPU occlusion culling
+const bool GPU_CULLING = true;
+
+int framebufferWidth = 0;
+int framebufferHeight = 0;
+
+bool firstMouseMove = true;
+float lastMouseX = SCREEN_WIDTH * 0.5f;
+float lastMouseY = SCREEN_HEIGHT * 0.5f;
+
+Direction_Movement cameraDirFlag = Direction_Movement::NONE;
+
+Camera camera({ -15.0f, 25.0f, 35.0f }, { 0.0f, 1.0f, 0.0f }, -40.0f, -70.0f);
+
+// Animated scene state, advanced on the simulation thread and read by the render thread as a snapshot
+struct SceneSnapshot
+{
+	float time = 0.0f;
+
+	glm::vec3 cubeRotation = { 0.0f, 0.0f, 0.0f };
+	glm::vec3 sphereRotation = { 0.0f, 0.0f, 0.0f };
+	glm::vec3 torusRotation = { 30.0f, 0.0f, 0.0f };
+	float orbitAngle = 0.0f;
+	float spinAngle = 0.0f;
+
+	glm::vec3 lightPosition = { 0.0f, 0.0f, 5.0f };
+};
+
+// ------------------------------------------------
+//  FUNCTIONS
+// ------------------------------------------------
+void updateWindowStats(GLFWwindow* window, float deltaTime, size_t vertexCount, size_t occludedCount, size_t testedCount, float occlusionMs)
+{
+	// Static variables to not go out of scope after function ends
+	static float timer = 0.0f;
+	static int frames = 0;
+
+	timer += deltaTime;
+	frames++;
+
+	// Update window stats only once per second
+	if (timer >= 1.0f)
+	{
+		// Calculate FPS
+		int fps = glm::round(frames / timer);
+
+		std::stringstream ss;
+		ss << WINDOW_TITLE << " | FPS: " << fps << " | Vertices: " << vertexCount;
+
+		// Share of objects inside the frustum culled by occluders and time spent rasterizing them
+		int occludedPercent = testedCount ? static_cast<int>(glm::round(100.0f * occludedCount / testedCount)) : 0;
+		ss << " | Occluded: " << occludedCount << " (" << occludedPercent << "%, " << std::fixed << std::setprecision(2) << occlusionMs << " ms)";
+
+		// Update stats
+		glfwSetWindowTitle(window, ss.str().c_str());
+
+		// Resets timers
+		timer = 0.0f;
+		frames = 0;
+	}
+}
+
+// Scene animations (runs on the simulation thread, must not touch OpenGL or render objects)
+void simulateScene(SceneSnapshot& state, float deltaTime)
+{
+	state.time += deltaTime;
+
+	state.cubeRotation.y += 10.0f * deltaTime;
+	state.sphereRotation.y += 100.0f * deltaTime;
+	state.torusRotation += glm::vec3(20.0f, 0.0f, 10.0f) * deltaTime;
+	state.orbitAngle = state.time * 0.5f;
+	state.spinAngle += 90.0f * deltaTime;
+
+	// Light movement
+	state.lightPosition.x += glm::cos(state.time) * 10 * deltaTime;
+	state.lightPosition.y += glm::cos(state.time) * 5 * deltaTime;
+}
+
+// Blend between two simulation steps for rendering
+SceneSnapshot interpolateScene(const SceneSnapshot& previous, const SceneSnapshot& current, float alpha)
+{
+	SceneSnapshot result;
+	result.time = glm::mix(previous.time, current.time, alpha);
+	result.cubeRotation = glm::mix(previous.cubeRotation, current.cubeRotation, alpha);
+	result.sphereRotation = glm::mix(previous.sphereRotation, current.sphereRotation, alpha);
+	result.torusRotation = glm::mix(previous.torusRotation, current.torusRotation, alpha);
+	result.orbitAngle = glm::mix(previous.orbitAngle, current.orbitAngle, alpha);
+	result.spinAngle = glm::mix(previous.spinAngle, current.spinAngle, alpha);
+	result.lightPosition = glm::mix(previous.lightPosition, current.lightPosition, alpha);
+	return result;
+}
+
+void processCameraDirectionMovement(Direction_Movement direction, int action)
+{
+	if (action == GLFW_PRESS)
+		cameraDirFlag |= direction;
+	else if (action == GLFW_RELEASE)
+		cameraDirFlag &= ~direction;
+}
+
+
+// ------------------------------------------------
+//  CALLBACKS
+// ------------------------------------------------
+void keyboard_input_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	switch (key)
+	{
+	case GLFW_KEY_ESCAPE:
+		glfwSetWindowShouldClose(window, true);
+		break;
+	case GLFW_KEY_TAB:
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+		break;
+	case GLFW_KEY_W:
+		processCameraDirectionMovement(Direction_Movement::FORWARD, action);
+		break;
+	case GLFW_KEY_S:
+		processCameraDirectionMovement(Direction_Movement::BACKWARD, action);
+		break;
+	case GLFW_KEY_A:
+		processCameraDirectionMovement(Direction_Movement::LEFT, action);
+		break;
+	case GLFW_KEY_D:
+		processCameraDirectionMovement(Direction_Movement::RIGHT, action);
+		break;
+	case GLFW_KEY_SPACE:
+		processCameraDirectionMovement(Direction_Movement::UP, action);
+		break;
+	case GLFW_KEY_LEFT_CONTROL:
+		processCameraDirectionMovement(Direction_Movement::DOWN, action);
+		break;
+	case GLFW_KEY_Q:
+		processCameraDirectionMovement(Direction_Movement::ROLL_LEFT, action);
+		break;
+	case GLFW_KEY_E:
+		processCameraDirectionMovement(Direction_Movement::ROLL_RIGHT, action);
+		break;
+	case GLFW_KEY_LEFT_SHIFT:
+		camera.MovementSpeed += 0.5f;
+		break;
+	}
+}
+
+void mouse_movement_callback(GLFWwindow* window, double mousePosX, double mousePosY)
+{
+	if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	if (firstMouseMove)
+	{
+		lastMouseX = mousePosX;
+		lastMouseY = mousePosY;
+		firstMouseMove = false;
+	}
+
+	float deltaX = static_cast<float>(mousePosX) - lastMouseX;
+	float deltaY = lastMouseY - static_cast<float>(mousePosY);
+
+	lastMouseX = mousePosX;
+	lastMouseY = mousePosY;
+
+	camera.processMouseMovement(deltaX, deltaY);
+}
+
+void mouse_scroll_callback(GLFWwindow* window, double deltaX, double deltaY)
+{
+	camera.processMouseScroll(deltaY);
+}
+
+void framebuffer_resize_callback(GLFWwindow* window, int width, int height)
+{
+	framebufferWidth = width;
+	framebufferHeight = height;
+	glViewport(0, 0, width, height);
+}
+
+
+// ------------------------------------------------
+//  INITIALIZATION
+// ------------------------------------------------
+bool initializeOpenGLEngine(GLFWwindow*& window, int& fbW, int& fbH)
+{
+	std::cout << "INITIALIZING::GLFW::LIBRARY\n";
+	if (!glfwInit()) {
+		std::cerr << "ERROR::GLFW_INIT\n";
+		return false;
+	}
+
+	// OpenGL version hints
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, OPENGL_MAJOR_VERSION);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, OPENGL_MINOR_VERSION);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	// Depth pyramid blits the depth buffer, so its format has to stay DepthPyramid::SourceDepthFormat
+	glfwWindowHint(GLFW_DEPTH_BITS, 24);
+	glfwWindowHint(GLFW_STENCIL_BITS, 8);
+	glfwWindowHint(GLFW_SAMPLES, 0);
+
+	// Create window
+	std::cout << "CREATING::GLFW::WINDOW\n";
+	window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, WINDOW_TITLE, nullptr, nullptr);
+	if (!window)
+	{
+		std::cerr << "ERROR::GLFW_CREATE_WINDOW\n";
+		glfwTerminate();
+		return false;
+	}
+
+	// Make OpenGL context current
+	glfwMakeContextCurrent(window);
+	// Enable v-sync
+	glfwSwapInterval(0);
+
+	// Load OpenGL functions
+	std::cout << "INITIALIZING::GLAD\n";
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cerr << "ERROR::GLAD_LOAD_GL\n";
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return false;
+	}
+
+	// Set initial viewport
+	glfwGetFramebufferSize(window, &fbW, &fbH);
+	glViewport(0, 0, fbW, fbH);
+
+	// Set GLFW callbacks and input modes
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	glfwSetKeyCallback(window, keyboard_input_callback);
+	glfwSetCursorPosCallback(window, mouse_movement_callback);
+	glfwSetScrollCallback(window, mouse_scroll_callback);
+	glfwSetFramebufferSizeCallback(window, framebuffer_resize_callback);
+
+	// Enable common OpenGL states
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+	glFrontFace(GL_CCW);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	return true;
+}
+
+
+// ------------------------------------------------
+//  MAIN
+// ------------------------------------------------
+int main()
+{
+	GLFWwindow* window = nullptr;
+
+	if (!initializeOpenGLEngine(window, framebufferWidth, framebufferHeight))
+		return EXIT_FAILURE;
+
+	// Frame work (transforms, culling) is split across all cores, this thread takes part while waiting.
+	// Asset decoding runs on the same workers as background jobs
+	JobSystem& jobSystem = ResourceManager::getJobSystem();
+
+	// Assets are read from the pack when present, otherwise from loose files
+	if (std::filesystem::exists("Assets.pack"))
+		AssetFileSystem::mount("Assets.pack");
+
+	// Resources not referenced anymore are evicted (least recently released first) above these budgets
+	ResourceManager::setTextureBudget(256ull * 1024 * 1024);
+	ResourceManager::setMeshBudget(128ull * 1024 * 1024);
+
+	// Every GL object owned by main lives in this scope, so it is destroyed while the context still exists
+	{
+		// Load Shaders
+		Shader& shaderPhongProgram = *ResourceManager::get(ResourceManager::loadShader("Shaders/vertex_shader_core.vert", "Shaders/fragment_shader_core.frag"));
+		Shader& shaderBatchedProgram = *ResourceManager::get(ResourceManager::loadShader("Shaders/vertex_shader_batched.vert", "Shaders/fragment_shader_pbr_batched.frag"));
+		Shader& shaderCullProgram = *ResourceManager::get(ResourceManager::loadComputeShader("Shaders/gpu_cull.comp"));
+		Shader& shaderDepthPyramidProgram = *ResourceManager::get(ResourceManager::loadComputeShader("Shaders/depth_pyramid.comp"));
+		Shader& shaderMeshletCullProgram = *ResourceManager::get(ResourceManager::loadComputeShader("Shaders/meshlet_cull.comp"));
+		Shader& shaderImpostorSphereProgram = *ResourceManager::get(ResourceManager::loadShader("Shaders/impostor.vert", "Shaders/impostor_sphere.frag"));
+		Shader& shaderImpostorTorusProgram = *ResourceManager::get(ResourceManager::loadShader("Shaders/impostor.vert", "Shaders/impostor_torus.frag"));
+
+		// Load Textures (streamed, only small mips are resident until requested), decoded in parallel on worker threads
+		auto albedoLoad = ResourceManager::loadTextureAsync("Assets/Textures/Metal_color.png", GL_TEXTURE_2D, true);
+		auto normalLoad = ResourceManager::loadTextureAsync("Assets/Textures/Metal_normal_gl.png", GL_TEXTURE_2D, true);
+		auto metallicLoad = ResourceManager::loadTextureAsync("Assets/Textures/Metal_metalness.png", GL_TEXTURE_2D, true);
+
+		Texture* albedoTex = ResourceManager::get(ResourceManager::wait(albedoLoad));
+		Texture* normalTex = ResourceManager::get(ResourceManager::wait(normalLoad));
+		Texture* metallicTex = ResourceManager::get(ResourceManager::wait(metallicLoad));
+
+		// Texture streaming with 64 MB of VRAM for texture mips
+		TextureStreamer textureStreamer(64ull * 1024 * 1024);
+		textureStreamer.add(albedoTex);
+		textureStreamer.add(normalTex);
+		textureStreamer.add(metallicTex);
+
+		// Default color of light (position is animated)
+		glm::vec3 lightColor(5.0f, 5.0f, 5.0f);
+
+		// Creating materials (streamer requests every texture of metal material, normal map included)
+		PhongMaterial baseMaterial(glm::vec3(0.1f), glm::vec3(1.0f), glm::vec3(1.0f), 32.0f);
+		PhongMaterial metalMaterial(glm::vec3(0.1f), glm::vec3(1.0f), glm::vec3(1.0f), 32.0f, albedoTex, metallicTex, normalTex);
+
+		// Setup primitives (generated and uploaded once per parameters, meshes share the buffers)
+		const Primitive& plane = PrimitiveRegistry::plane(150.0f, 150.0f);
+		const Primitive& cube = PrimitiveRegistry::cube(6.0f);
+		const Primitive& sphere = PrimitiveRegistry::sphere(1.6f, 64U, 64U);
+		const Primitive& torus = PrimitiveRegistry::torus(18.0f, 1.5f, 64U, 64U);
+
+		Mesh planeGrid(PrimitiveRegistry::geometry(plane));
+		Mesh cubeTest(PrimitiveRegistry::geometry(cube));
+		Mesh sphereTest(PrimitiveRegistry::geometry(sphere));
+		Mesh torusTest(PrimitiveRegistry::geometry(torus));
+
+		planeGrid.setPosition({ 0.0f,-30.0f, 0.0f });
+		cubeTest.setPosition({ 0.0f, 0.0f, 0.0f });
+		sphereTest.setPosition({ 10.0f, 0.0f, 0.0f });
+		torusTest.setPosition({ 0.0f, 0.0f, 0.0f });
+
+		// Never moving geometry merged per material and chunk: floor and a ring of pillars with spheres on top
+		const Primitive& pillar = PrimitiveRegistry::cube(1.0f);
+		const Primitive& pillarTop = PrimitiveRegistry::sphere(1.0f, 16U, 16U);
+
+		StaticBatcher<PhongMaterial> staticBatcher;
+		staticBatcher.add(plane, baseMaterial, planeGrid.getModelMatrix());
+
+		const int pillarCount = 120;
+		for (int i = 0; i < pillarCount; ++i)
+		{
+			float angle = glm::two_pi<float>() * i / pillarCount;
+			glm::vec3 base = glm::vec3(glm::cos(angle), 0.0f, glm::sin(angle)) * 70.0f + glm::vec3(0.0f, -30.0f, 0.0f);
+
+			staticBatcher.add(pillar, baseMaterial, Transform::compose(base + glm::vec3(0.0f, 4.0f, 0.0f), { 0.0f, -glm::degrees(angle), 0.0f }, { 1.2f, 8.0f, 1.2f }));
+			staticBatcher.add(pillarTop, metalMaterial, Transform::compose(base + glm::vec3(0.0f, 9.0f, 0.0f), glm::vec3(0.0f), glm::vec3(1.0f)));
+		}
+
+		// Lattice of sphere impostors (64k spheres in one instanced draw) and a few ray-marched tori
+		ImpostorRenderer impostorRenderer;
+
+		const int latticeSize = 40;
+		impostorRenderer.reserveSpheres(latticeSize * latticeSize * latticeSize);
+		for (int z = 0; z < latticeSize; ++z)
+		{
+			for (int y = 0; y < latticeSize; ++y)
+			{
+				for (int x = 0; x < latticeSize; ++x)
+				{
+					glm::vec3 cell = glm::vec3(x, y, z) / float(latticeSize - 1);
+					impostorRenderer.addSphere(glm::vec3(80.0f, -20.0f, -20.0f) + cell * 40.0f, 0.35f, glm::mix(glm::vec3(0.2f, 0.4f, 1.0f), glm::vec3(1.0f, 0.5f, 0.2f), cell));
+				}
+			}
+		}
+
+		for (int i = 0; i < 8; ++i)
+			impostorRenderer.addTorus({ 100.0f, 30.0f, -20.0f + i * 6.0f }, { 90.0f, 0.0f, i * 22.5f }, 2.5f, 0.6f, glm::vec3(0.9f, 0.8f, 0.3f));
+
+		// Load model
+		Model& model = *ResourceManager::get(ResourceManager::loadModel("Assets/Models/catmark_torus_creases0.obj"));
+
+		model.scale({ 10.0f, 10.0f, 10.0f });
+
+		// Same model as streamed cluster hierarchy, present only when cooked with --cluster-lod
+		ClusterLODMesh clusterLODModel;
+		glm::mat4 clusterLODMatrix = glm::scale(glm::translate(glm::mat4(1.0f), { -40.0f, 0.0f, 0.0f }), glm::vec3(10.0f));
+		if (AssetFileSystem::exists(CookedAssets::getCookedClusterLODPath("Assets/Models/catmark_torus_creases0.obj")))
+			clusterLODModel.open("Assets/Models/catmark_torus_creases0.obj");
+
+		// Same cage as Catmull-Clark surface with creases, subdivided further the closer it gets
+		SubdivisionMesh subdivisionModel;
+		glm::mat4 subdivisionMatrix = glm::scale(glm::translate(glm::mat4(1.0f), { 40.0f, 0.0f, 0.0f }), glm::vec3(10.0f));
+		subdivisionModel.open("Assets/Models/catmark_torus_creases0.obj", jobSystem);
+
+		// Scene hierarchy (sphere orbits around its parent node, model is attached to the scene root)
+		SceneGraph sceneGraph;
+		SceneNodeID sceneRoot = sceneGraph.createNode();
+		SceneNodeID orbitNode = sceneGraph.createNode(sceneRoot);
+		SceneNodeID modelNode = sceneGraph.createNode(sceneRoot);
+
+		// Field of small cubes stored in render world, drawn with one multi-draw through batched shader
+		TextureArrayBuilder textureArrays;
+		int batchedAlbedoMap = textureArrays.add("Assets/Textures/Metal_color.png");
+		int batchedNormalMap = textureArrays.add("Assets/Textures/Metal_normal_gl.png");
+		textureArrays.build();
+
+		MaterialTable materialTable(textureArrays);
+		uint32_t batchedMaterial = materialTable.add({ glm::vec3(1.0f), 0.8f, 0.4f, 1.0f, batchedAlbedoMap, batchedNormalMap });
+
+		Mesh smallCubeMesh(PrimitiveRegistry::geometry(PrimitiveRegistry::cube(1.0f)));
+
+		RenderWorld renderWorld;
+		std::vector<EntityID> spinningEntities;
+
+		// Large scene objects hide parts of the field, they are rasterized on the CPU each frame
+		OcclusionCuller occlusionCuller;
+
+		// Depth of the last frame for occlusion culling on the GPU
+		DepthPyramid depthPyramid;
+
+		// Model is drawn per meshlet, hidden and back facing clusters are skipped
+		ClusterCuller clusterCuller;
+
+		const int fieldSize = 64;
+		renderWorld.reserve(fieldSize * fieldSize);
+		for (int z = 0; z < fieldSize; ++z)
+		{
+			for (int x = 0; x < fieldSize; ++x)
+			{
+				Transform transform;
+				transform.position = { (x - fieldSize / 2) * 2.0f, -28.0f, (z - fieldSize / 2) * 2.0f };
+
+				EntityID entity = renderWorld.createEntity(smallCubeMesh, batchedMaterial, transform);
+
+				// Only some objects move, the rest is uploaded once
+				if ((x + z) % 8 == 0)
+					spinningEntities.push_back(entity);
+			}
+		}
+
+		// Camera matrices
+		glm::mat4 viewMatrix;
+		glm::mat4 projectionMatrix;
+
+		// Simulation runs on its own thread one frame ahead in fixed steps, it keeps its own state
+		// and publishes state interpolated between the last two steps
+		FramePipeline<SceneSnapshot> framePipeline(
+			[previous = SceneSnapshot(), current = SceneSnapshot(), timestep = FixedTimestep(SIMULATION_TICK_RATE, SIMULATION_MAX_STEPS)]
+			(SceneSnapshot& snapshot, float deltaTime) mutable
+			{
+				int steps = timestep.advance(deltaTime);
+				for (int step = 0; step < steps; ++step)
+				{
+					previous = current;
+					simulateScene(current, timestep.getStep());
+				}
+
+				snapshot = interpolateScene(previous, current, timestep.getAlpha());
+			}, SceneSnapshot());
+
+		// Simulation of time (for fixed or delta time update)
+		float deltaTime = 0.0f;
+		float lastFrame = 0.0f;
+
+		// Render Loop
+		while (!glfwWindowShouldClose(window))
+		{
+			// Calculate delta time
+			float currentFrame = glfwGetTime();
+			deltaTime = currentFrame - lastFrame;
+			lastFrame = currentFrame;
+
+			// Call any callbacks in the queue
+			glfwPollEvents();
+
+			// Finish resource loads and apply resource budgets
+			ResourceManager::update();
+
+			// Camera update
+			camera.processMovement(cameraDirFlag, deltaTime);
+
+			// Update view and projection matrices
+			viewMatrix = camera.getViewMatrix();
+			projectionMatrix = camera.getProjectionMatrix(static_cast<float>(framebufferWidth) / framebufferHeight);
+
+			// Re-color & clear buffers
+			glClearColor(0.2f, 0.2f, 0.2f, 1.f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			// Sync point: take snapshot simulated during last frame and start simulating next one
+			const SceneSnapshot& snapshot = framePipeline.beginFrame(deltaTime);
+
+			// Apply animated state to render objects
+			cubeTest.setRotation(snapshot.cubeRotation);
+			sphereTest.setRotation(snapshot.sphereRotation);
+			torusTest.setRotation(snapshot.torusRotation);
+			sceneGraph.setRotation(orbitNode, { 0.0f, 0.0f, glm::degrees(snapshot.orbitAngle) });
+
+			for (EntityID entity : spinningEntities)
+				renderWorld.setRotation(entity, { 0.0f, snapshot.spinAngle, 0.0f });
+
+			const glm::vec3& lightPosition = snapshot.lightPosition;
+
+			// Recompute changed world matrices and pass them to attached objects
+			sceneGraph.update();
+			for (SceneNodeID node : sceneGraph.getUpdatedNodes())
+			{
+				if (node == orbitNode)
+					sphereTest.setParentMatrix(sceneGraph.getWorldMatrix(node));
+				else if (node == modelNode)
+					model.setParentMatrix(sceneGraph.getWorldMatrix(node));
+			}
+
+			// Request texture mips needed by visible materials and stream them in
+			textureStreamer.beginFrame();
+			textureStreamer.requestMaterial(metalMaterial, cubeTest, camera, static_cast<float>(framebufferHeight));
+			textureStreamer.requestMaterial(metalMaterial, sphereTest, camera, static_cast<float>(framebufferHeight));
+			for (const Mesh* mesh : model.getMeshes())
+				textureStreamer.requestMaterial(metalMaterial, *mesh, camera, static_cast<float>(framebufferHeight));
+			textureStreamer.update();
+
+			// Camera used by all culling this frame
+			glm::mat4 viewProjectionMatrix = projectionMatrix * viewMatrix;
+			Frustum frustum = Frustum::fromMatrix(viewProjectionMatrix);
+
+			if (!GPU_CULLING)
+			{
+				// Occlusion depth from the biggest objects, tiles rasterized on worker threads
+				occlusionCuller.beginFrame(viewProjectionMatrix);
+				occlusionCuller.addOccluder(plane, planeGrid.getModelMatrix(), planeGrid.getBounds());
+				occlusionCuller.addOccluder(cube, cubeTest.getModelMatrix(), cubeTest.getBounds());
+				occlusionCuller.addOccluder(torus, torusTest.getModelMatrix(), torusTest.getBounds());
+				occlusionCuller.rasterize(jobSystem);
+			}
+
+			// Meshlets of the model (before materials are bound, GPU culling uses texture unit 0 for depth pyramid)
+			clusterCuller.beginFrame(frustum, camera.Position);
+			for (Mesh* mesh : model.getMeshes())
+				clusterCuller.add(*mesh, mesh->getModelMatrix());
+
+			if (GPU_CULLING)
+				clusterCuller.cullOnGPU(shaderMeshletCullProgram, &depthPyramid);
+			else
+				clusterCuller.cull(&occlusionCuller);
+
+			// Cut through cluster hierarchy with at most one pixel of error, missing pages are streamed in
+			clusterLODModel.update(jobSystem, clusterLODMatrix, frustum, camera.Position, framebufferHeight * projectionMatrix[1][1] * 0.5f);
+			subdivisionModel.update(jobSystem, subdivisionMatrix, camera.Position, framebufferHeight * projectionMatrix[1][1] * 0.5f);
+
+			// Using shader program and apply scene changes to Vertex and Fragment shader
+			shaderPhongProgram.use();
+			shaderPhongProgram.set("view_matrix", viewMatrix);
+			shaderPhongProgram.set("projection_matrix", projectionMatrix);
+			shaderPhongProgram.set("light_position", lightPosition);
+			shaderPhongProgram.set("light_color", lightColor);
+			shaderPhongProgram.set("camera_position", camera.Position);
+
+			// Static chunks bind their own materials
+			staticBatcher.update();
+			staticBatcher.render(shaderPhongProgram, frustum);
+
+			baseMaterial.apply(shaderPhongProgram);
+			torusTest.render(shaderPhongProgram);
+
+			metalMaterial.apply(shaderPhongProgram);
+			cubeTest.render(shaderPhongProgram);
+			sphereTest.render(shaderPhongProgram);
+			clusterCuller.render(shaderPhongProgram);
+			clusterLODModel.render(shaderPhongProgram);
+			subdivisionModel.render(shaderPhongProgram);
+			for (size_t i = 0; i < 1; i++)
+			{
+				//sphereTest.render(shaderPhongProgram);
+				//sphereTest.move({ 5.0f, 0.0f, 0.0f });
+			}
+
+			// Impostors write their own depth, so they intersect meshes correctly
+			for (Shader* impostorShader : { &shaderImpostorSphereProgram, &shaderImpostorTorusProgram })
+			{
+				impostorShader->use();
+				impostorShader->set("view_matrix", viewMatrix);
+				impostorShader->set("projection_matrix", projectionMatrix);
+				impostorShader->set("light_position", lightPosition);
+				impostorShader->set("light_color", lightColor);
+				impostorShader->set("camera_position", camera.Position);
+			}
+			impostorRenderer.render(shaderImpostorSphereProgram, shaderImpostorTorusProgram);
+
+			// Changed transforms of render world on worker threads
+			renderWorld.updateTransforms(jobSystem);
+
+			if (GPU_CULLING)
+			{
+				// Frustum, last frame depth and LOD tests in compute shader, draws are compacted on the GPU
+				renderWorld.cullOnGPU(shaderCullProgram, frustum, camera.Position, projectionMatrix[1][1], &depthPyramid);
+			}
+			else
+			{
+				// Culling and sorted draw list on worker threads, GL calls are made only in render() on this thread
+				renderWorld.buildDrawList(frustum, jobSystem, &occlusionCuller);
+			}
+
+			shaderBatchedProgram.use();
+			shaderBatchedProgram.set("view_matrix", viewMatrix);
+			shaderBatchedProgram.set("projection_matrix", projectionMatrix);
+			shaderBatchedProgram.set("light_position", lightPosition);
+			shaderBatchedProgram.set("light_color", lightColor);
+			shaderBatchedProgram.set("camera_position", camera.Position);
+
+			materialTable.bind(shaderBatchedProgram);
+			if (GPU_CULLING)
+				renderWorld.renderOnGPU();
+			else
+				renderWorld.render();
+
+			// Depth of this frame is used for occlusion tests of the next one
+			if (GPU_CULLING)
+				depthPyramid.build(shaderDepthPyramidProgram, framebufferWidth, framebufferHeight, viewProjectionMatrix);
+
+			// Render world counts of GPU culling are read back a few frames late
+			size_t totalVertexCount = (
+				staticBatcher.getVertexCount() +
+				cubeTest.getVertexCount() +
+				sphereTest.getVertexCount() +
+				torusTest.getVertexCount() +
+				model.getTotalVertexCount() +
+				renderWorld.getVisibleCount() * smallCubeMesh.getVertexCount() +
+				0
+				);
+
+			// Update stats (in window title) like fps and count of vertices in the scene
+			updateWindowStats(window, deltaTime, totalVertexCount, renderWorld.getOccludedCount(),
+				renderWorld.getVisibleCount() + renderWorld.getOccludedCount(), occlusionCuller.getStats().rasterizeMs);
+
+			// Enable swaping buffers (double buffered scene)
+			glfwSwapBuffers(window);
+		}
+	}
+
+	// Cleanup and call destructors (GPU resources have to go before the context)
+	ResourceManager::clear();
+	PrimitiveRegistry::clear();
+	AssetFileSystem::unmountAll();
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return EXIT_SUCCESS;
 }
\ No newline at end of file
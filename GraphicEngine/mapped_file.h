@@ -0,0 +1,136 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of whole file
+class MappedFile
+{
+private:
+	const unsigned char* _data = nullptr;
+	size_t _size = 0;
+
+#ifdef _WIN32
+	HANDLE _file = INVALID_HANDLE_VALUE;
+	HANDLE _mapping = NULL;
+#else
+	int _file = -1;
+#endif
+
+public:
+	MappedFile() = default;
+
+	explicit MappedFile(const std::string& path)
+	{
+		open(path);
+	}
+
+	~MappedFile()
+	{
+		close();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path)
+	{
+		close();
+
+#ifdef _WIN32
+		_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+		if (_file == INVALID_HANDLE_VALUE)
+			return fail(path);
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(_file, &fileSize))
+			return fail(path);
+
+		_size = static_cast<size_t>(fileSize.QuadPart);
+
+		// Empty files cannot be mapped
+		if (_size == 0)
+			return true;
+
+		_mapping = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!_mapping)
+			return fail(path);
+
+		_data = static_cast<const unsigned char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!_data)
+			return fail(path);
+#else
+		_file = ::open(path.c_str(), O_RDONLY);
+		if (_file < 0)
+			return fail(path);
+
+		struct stat fileStat;
+		if (fstat(_file, &fileStat) != 0)
+			return fail(path);
+
+		_size = static_cast<size_t>(fileStat.st_size);
+
+		// Empty files cannot be mapped
+		if (_size == 0)
+			return true;
+
+		void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+		if (data == MAP_FAILED)
+			return fail(path);
+
+		_data = static_cast<const unsigned char*>(data);
+#endif
+		return true;
+	}
+
+	void close()
+	{
+#ifdef _WIN32
+		if (_data) UnmapViewOfFile(_data);
+		if (_mapping) CloseHandle(_mapping);
+		if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+
+		_mapping = NULL;
+		_file = INVALID_HANDLE_VALUE;
+#else
+		if (_data) munmap(const_cast<unsigned char*>(_data), _size);
+		if (_file >= 0) ::close(_file);
+
+		_file = -1;
+#endif
+		_data = nullptr;
+		_size = 0;
+	}
+
+#ifdef _WIN32
+	bool isOpen() const { return _file != INVALID_HANDLE_VALUE; }
+#else
+	bool isOpen() const { return _file >= 0; }
+#endif
+
+	const unsigned char* data() const { return _data; }
+	size_t size() const { return _size; }
+
+private:
+	bool fail(const std::string& path)
+	{
+		std::cerr << "ERROR::MAPPED_FILE::OPEN_FAILED - " << path << "\n";
+		close();
+		return false;
+	}
+};
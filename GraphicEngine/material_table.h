@@ -0,0 +1,121 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+#include <glad.h>
+#include <glm.hpp>
+
+#include "shader.h"
+#include "texture_array.h"
+
+// PBR material with textures referenced by ids returned from TextureArrayBuilder::add (-1 = no texture)
+struct BatchedPBRMaterial
+{
+	glm::vec3 albedo = glm::vec3(1.0f);
+	float metallic = 0.0f;
+	float roughness = 0.5f;
+	float ambientOcclusion = 1.0f;
+
+	int albedoMap = -1;
+	int normalMap = -1;
+	int metallicMap = -1;
+	int roughnessMap = -1;
+	int ambientOcclusionMap = -1;
+};
+
+// std430 layout, must match fragment_shader_pbr_batched.frag
+struct GPUTextureRef
+{
+	glm::vec4 uvRect = { 0.0f, 0.0f, 1.0f, 1.0f };
+	int32_t arrayIndex = -1;
+	int32_t layer = 0;
+	int32_t padding[2] = {};
+};
+
+struct GPUMaterial
+{
+	glm::vec4 albedoMetallic = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+	glm::vec4 roughnessOcclusion = glm::vec4(0.5f, 1.0f, 0.0f, 0.0f);
+	GPUTextureRef maps[5];		// albedo, normal, metallic, roughness, ambient occlusion
+};
+
+// All materials of the scene in one SSBO, so draws with different materials can share one multi-draw call
+class MaterialTable
+{
+public:
+	static constexpr GLuint BindingPoint = 0;
+	static constexpr int MaxTextureArrays = 8;
+
+private:
+	const TextureArrayBuilder& _textures;
+
+	std::vector<GPUMaterial> _materials;
+	GLuint _ssbo = 0;
+	bool _isDirty = true;
+
+public:
+	explicit MaterialTable(const TextureArrayBuilder& textures)
+		: _textures(textures)
+	{
+		glGenBuffers(1, &_ssbo);
+	}
+
+	~MaterialTable()
+	{
+		if (_ssbo) glDeleteBuffers(1, &_ssbo);
+	}
+
+	MaterialTable(const MaterialTable&) = delete;
+	MaterialTable& operator=(const MaterialTable&) = delete;
+
+	size_t size() const { return _materials.size(); }
+
+	// Returns material index used in GPUObjectData::materialIndex (textures have to be built already)
+	uint32_t add(const BatchedPBRMaterial& material)
+	{
+		GPUMaterial gpuMaterial;
+		gpuMaterial.albedoMetallic = glm::vec4(material.albedo, material.metallic);
+		gpuMaterial.roughnessOcclusion = glm::vec4(material.roughness, material.ambientOcclusion, 0.0f, 0.0f);
+
+		const int maps[5] = { material.albedoMap, material.normalMap, material.metallicMap, material.roughnessMap, material.ambientOcclusionMap };
+		for (int i = 0; i < 5; ++i)
+		{
+			const TextureRef& ref = _textures.getRef(maps[i]);
+			gpuMaterial.maps[i].uvRect = ref.uvRect;
+			gpuMaterial.maps[i].arrayIndex = ref.arrayIndex;
+			gpuMaterial.maps[i].layer = ref.layer;
+		}
+
+		_materials.push_back(gpuMaterial);
+		_isDirty = true;
+		return static_cast<uint32_t>(_materials.size() - 1);
+	}
+
+	// Upload materials if needed, bind SSBO and texture arrays (arrays use units from firstTextureUnit)
+	void bind(const Shader& shader, int firstTextureUnit = 0)
+	{
+		if (_isDirty)
+		{
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, _ssbo);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, _materials.size() * sizeof(GPUMaterial), _materials.data(), GL_STATIC_DRAW);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			_isDirty = false;
+		}
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindingPoint, _ssbo);
+
+		const auto& arrays = _textures.getArrays();
+		if (arrays.size() > MaxTextureArrays)
+			std::cerr << "ERROR::MATERIAL_TABLE::TOO_MANY_TEXTURE_ARRAYS - " << arrays.size() << "\n";
+
+		shader.use();
+		for (size_t i = 0; i < arrays.size() && i < MaxTextureArrays; ++i)
+		{
+			int textureUnit = firstTextureUnit + static_cast<int>(i);
+			arrays[i]->bind(textureUnit);
+			shader.set("texture_arrays[" + std::to_string(i) + "]", textureUnit);
+		}
+	}
+};
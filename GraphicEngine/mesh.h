@@ -1,140 +1,429 @@
-#pragma once
-
-#include "primitives.h"
-#include "shader.h"
-
-class Mesh
-{
-private:
-	GLuint _vao = 0;
-	GLuint _vbo = 0;
-	GLuint _ebo = 0;
-
-	size_t _vertexCount = 0;
-	size_t _indexCount = 0;
-
-	glm::vec3 _position = { 0, 0, 0 };
-	glm::vec3 _rotation = { 0, 0, 0 };
-	glm::vec3 _scale = { 1, 1, 1 };
-
-	glm::mat4 _modelMatrix = glm::mat4(1.0f);
-
-public:
-	// Allow moving
-	Mesh(Mesh&& other) noexcept
-	{
-		*this = std::move(other);
-	}
-
-	// By Mesh reference passing we want to prevent copying, this is so called "double deletion protection"
-	Mesh(const Mesh&) = delete;
-
-	// Constructor for Primitive parameter
-	Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
-	{
-		initBuffers(vertices, indices);
-		updateModelMatrix();
-	}
-
-	// Constructor for Primitive parameter
-	Mesh(const Primitive& primitive)
-	{
-		initBuffers(primitive.getVertices(), primitive.getIndices());
-		updateModelMatrix();
-	}
-
-	// Destructor for buffers
-	~Mesh()
-	{
-		glDeleteVertexArrays(1, &_vao);
-		glDeleteBuffers(1, &_vbo);
-		glDeleteBuffers(1, &_ebo);
-	}
-
-	// Operator overloads
-	Mesh& operator=(const Mesh&) = delete;
-	Mesh& operator=(Mesh&& other) noexcept
-	{
-		std::swap(_vao, other._vao);
-		std::swap(_vbo, other._vbo);
-		std::swap(_ebo, other._ebo);
-		std::swap(_vertexCount, other._vertexCount);
-		std::swap(_indexCount, other._indexCount);
-
-		return *this;
-	}
-
-	// Functions to set and modify transform
-	void setPosition(const glm::vec3& position) { _position = position; }
-	void setRotation(const glm::vec3& rotation) { _rotation = rotation; }
-	void setScale(const glm::vec3& scale) { _scale = scale; }
-	void move(const glm::vec3& deltaPosition) { _position += deltaPosition; }
-	void rotate(const glm::vec3& deltaRotation) { _rotation += deltaRotation; }
-	void scale(const glm::vec3& deltaScale) { _scale += deltaScale; }
-
-	// Get count of vertices and indices mesh
-	size_t getVertexCount() const { return _vertexCount; }
-	size_t getIndexCount() const { return _indexCount; }
-
-	// Render function
-	void render(const Shader& shader)
-	{
-		updateModelMatrix();
-
-		shader.use();
-		shader.set("model_matrix", _modelMatrix);
-
-		glBindVertexArray(_vao);
-
-		if (_indexCount > 0)
-			glDrawElements(GL_TRIANGLES, _indexCount, GL_UNSIGNED_INT, NULL);
-		else
-			glDrawArrays(GL_TRIANGLES, 0, _vertexCount);
-	}
-
-private:
-	void initBuffers(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
-	{
-		_vertexCount = vertices.size();
-		_indexCount = indices.size();
-
-		glGenVertexArrays(1, &_vao);
-		glBindVertexArray(_vao);
-
-		glGenBuffers(1, &_vbo);
-		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-		glBufferData(GL_ARRAY_BUFFER, _vertexCount * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-		glGenBuffers(1, &_ebo);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indexCount * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-		// Position
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-
-		// Normal
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-
-		// Color
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
-
-		// Texture Coord
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, textureCoord));
-
-		glBindVertexArray(0);
-	}
-
-	void updateModelMatrix()
-	{
-		_modelMatrix = glm::mat4(1.0f);
-		_modelMatrix = glm::translate(_modelMatrix, _position);
-		_modelMatrix = glm::rotate(_modelMatrix, glm::radians(_rotation.x), { 1,0,0 });
-		_modelMatrix = glm::rotate(_modelMatrix, glm::radians(_rotation.y), { 0,1,0 });
-		_modelMatrix = glm::rotate(_modelMatrix, glm::radians(_rotation.z), { 0,0,1 });
-		_modelMatrix = glm::scale(_modelMatrix, _scale);
-	}
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include "primitives.h"
+#include "shader.h"
+#include "bounds.h"
+#include "meshlet.h"
+
+// Vertex and index data of one mesh, can be loaded on any thread and uploaded on the OpenGL context thread.
+// Meshlets are optional, when present indices are ordered by meshlet
+struct MeshData
+{
+	std::vector<Vertex> vertices;
+	std::vector<GLuint> indices;
+	std::vector<Meshlet> meshlets;
+};
+
+// Vertex attribute read by the GPU in its source layout, locations are the same as of Vertex attributes
+struct VertexAttributeStream
+{
+	GLuint location = 0;
+	GLint componentCount = 0;
+	GLenum componentType = GL_FLOAT;
+	GLboolean isNormalized = GL_FALSE;
+	GLsizei stride = 0;
+	size_t offset = 0;		// First element within the byte range
+	uint32_t range = 0;		// Index into StreamedMeshData::ranges
+};
+
+// Mesh uploaded straight from loader memory (e.g. mapped glTF buffers) without conversion to Vertex.
+// Pointers are owned by the loader and have to stay valid until the geometry is created
+struct StreamedMeshData
+{
+	struct ByteRange
+	{
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+	};
+
+	std::vector<ByteRange> ranges;		// Every range becomes one vertex buffer
+	std::vector<VertexAttributeStream> attributes;
+	size_t vertexCount = 0;
+
+	const GLuint* indices = nullptr;
+	size_t indexCount = 0;
+
+	AABB bounds;
+	float worldUnitsPerUV = 1.0f;
+};
+
+inline void Vertex::setupAttributes()
+{
+	// Position
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+
+	// Normal
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+
+	// Color
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+
+	// Texture Coord
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, textureCoord));
+
+	// Tangent and bitangent sign
+	glEnableVertexAttribArray(4);
+	glVertexAttribPointer(4, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
+}
+
+// GPU buffers and surface data of one mesh, immutable after upload. Meshes created from the same geometry
+// share it, buffers are deleted with the last mesh
+class MeshGeometry
+{
+private:
+	GLuint _vao = 0;
+	GLuint _vbo = 0;
+	GLuint _ebo = 0;
+	std::vector<GLuint> _streamBuffers;
+
+	size_t _vertexCount = 0;
+	size_t _indexCount = 0;
+	size_t _gpuBytes = 0;
+
+	// Clusters for per-meshlet culling, kept on CPU for the reference path and in a storage buffer for compute culling
+	std::vector<Meshlet> _meshlets;
+	GLuint _meshletBuffer = 0;
+
+	// Local space bounds and average world units covered by one UV unit (used for mip selection)
+	AABB _bounds;
+	float _worldUnitsPerUV = 1.0f;
+
+public:
+	// Has to be created on the OpenGL context thread
+	MeshGeometry(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, const std::vector<Meshlet>& meshlets = {})
+	{
+		initBuffers(vertices, indices);
+		initMeshlets(meshlets);
+	}
+
+	// Vertex attributes in their source layout, has to be created on the OpenGL context thread
+	explicit MeshGeometry(const StreamedMeshData& data)
+	{
+		initStreams(data);
+	}
+
+	~MeshGeometry()
+	{
+		glDeleteVertexArrays(1, &_vao);
+		glDeleteBuffers(1, &_vbo);
+		glDeleteBuffers(1, &_ebo);
+
+		if (!_streamBuffers.empty())
+			glDeleteBuffers(static_cast<GLsizei>(_streamBuffers.size()), _streamBuffers.data());
+
+		if (_meshletBuffer)
+			glDeleteBuffers(1, &_meshletBuffer);
+	}
+
+	MeshGeometry(const MeshGeometry&) = delete;
+	MeshGeometry& operator=(const MeshGeometry&) = delete;
+
+	size_t getVertexCount() const { return _vertexCount; }
+	size_t getIndexCount() const { return _indexCount; }
+	GLuint getVAO() const { return _vao; }
+	size_t getGPUBytes() const { return _gpuBytes; }
+	const std::vector<Meshlet>& getMeshlets() const { return _meshlets; }
+	GLuint getMeshletBuffer() const { return _meshletBuffer; }
+	const AABB& getBounds() const { return _bounds; }
+	float getWorldUnitsPerUV() const { return _worldUnitsPerUV; }
+
+	void draw() const
+	{
+		glBindVertexArray(_vao);
+
+		if (_indexCount > 0)
+			glDrawElements(GL_TRIANGLES, _indexCount, GL_UNSIGNED_INT, NULL);
+		else
+			glDrawArrays(GL_TRIANGLES, 0, _vertexCount);
+	}
+
+private:
+	void initBuffers(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+	{
+		_vertexCount = vertices.size();
+		_indexCount = indices.size();
+		_gpuBytes += _vertexCount * sizeof(Vertex) + _indexCount * sizeof(GLuint);
+
+		computeSurfaceMetrics(vertices, indices);
+
+		glGenVertexArrays(1, &_vao);
+		glBindVertexArray(_vao);
+
+		glGenBuffers(1, &_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+		glBufferData(GL_ARRAY_BUFFER, _vertexCount * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+
+		glGenBuffers(1, &_ebo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indexCount * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+		Vertex::setupAttributes();
+
+		glBindVertexArray(0);
+	}
+
+	void initMeshlets(const std::vector<Meshlet>& meshlets)
+	{
+		_meshlets = meshlets;
+		if (_meshlets.empty())
+			return;
+
+		glGenBuffers(1, &_meshletBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _meshletBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, _meshlets.size() * sizeof(Meshlet), _meshlets.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		_gpuBytes += _meshlets.size() * sizeof(Meshlet);
+	}
+
+	void initStreams(const StreamedMeshData& data)
+	{
+		_vertexCount = data.vertexCount;
+		_indexCount = data.indexCount;
+		_bounds = data.bounds;
+		_worldUnitsPerUV = data.worldUnitsPerUV;
+
+		glGenVertexArrays(1, &_vao);
+		glBindVertexArray(_vao);
+
+		// Ranges are copied by the driver as they are, no per-vertex work on the CPU
+		_streamBuffers.resize(data.ranges.size());
+		if (!_streamBuffers.empty())
+			glGenBuffers(static_cast<GLsizei>(_streamBuffers.size()), _streamBuffers.data());
+
+		for (size_t i = 0; i < data.ranges.size(); ++i)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, _streamBuffers[i]);
+			glBufferData(GL_ARRAY_BUFFER, data.ranges[i].size, data.ranges[i].data, GL_STATIC_DRAW);
+			_gpuBytes += data.ranges[i].size;
+		}
+
+		bool hasColor = false;
+		bool hasTangent = false;
+		for (const auto& attribute : data.attributes)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, _streamBuffers[attribute.range]);
+			glEnableVertexAttribArray(attribute.location);
+			glVertexAttribPointer(attribute.location, attribute.componentCount, attribute.componentType, attribute.isNormalized, attribute.stride, (void*)attribute.offset);
+
+			hasColor |= attribute.location == 2;
+			hasTangent |= attribute.location == 4;
+		}
+
+		// Missing attributes come from a buffer owned by this vertex array instead of the context wide generic values:
+		// white color like loaded OBJ meshes, zero tangent skips normal mapping. Per vertex, because indirect draws use
+		// baseInstance as object index and an instanced attribute would be read out of range
+		if (!hasColor || !hasTangent)
+		{
+			size_t colorBytes = hasColor ? 0 : _vertexCount * 4;
+			size_t tangentBytes = hasTangent ? 0 : _vertexCount * sizeof(uint32_t);
+
+			std::vector<unsigned char> defaults(colorBytes + tangentBytes, 0);
+			std::fill(defaults.begin(), defaults.begin() + colorBytes, 255);
+
+			GLuint buffer = 0;
+			glGenBuffers(1, &buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			glBufferData(GL_ARRAY_BUFFER, defaults.size(), defaults.data(), GL_STATIC_DRAW);
+			_streamBuffers.push_back(buffer);
+			_gpuBytes += defaults.size();
+
+			if (!hasColor)
+			{
+				glEnableVertexAttribArray(2);
+				glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4, (void*)0);
+			}
+
+			if (!hasTangent)
+			{
+				glEnableVertexAttribArray(4);
+				glVertexAttribPointer(4, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(uint32_t), (void*)colorBytes);
+			}
+		}
+
+		glGenBuffers(1, &_ebo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indexCount * sizeof(GLuint), data.indices, GL_STATIC_DRAW);
+		_gpuBytes += _indexCount * sizeof(GLuint);
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void computeSurfaceMetrics(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+	{
+		_bounds = AABB();
+		for (const auto& vertex : vertices)
+			_bounds.expand(vertex.position);
+
+		// Compare summed triangle area in object space against the area it covers in UV space
+		float worldArea = 0.0f;
+		float uvArea = 0.0f;
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const Vertex& a = vertices[indices[i + 0]];
+			const Vertex& b = vertices[indices[i + 1]];
+			const Vertex& c = vertices[indices[i + 2]];
+
+			worldArea += 0.5f * glm::length(glm::cross(b.position - a.position, c.position - a.position));
+
+			glm::vec2 uvAB = b.textureCoord - a.textureCoord;
+			glm::vec2 uvAC = c.textureCoord - a.textureCoord;
+			uvArea += 0.5f * glm::abs(uvAB.x * uvAC.y - uvAB.y * uvAC.x);
+		}
+
+		_worldUnitsPerUV = (uvArea > 0.0f) ? glm::sqrt(worldArea / uvArea) : 1.0f;
+	}
+};
+
+class Mesh
+{
+private:
+	std::shared_ptr<const MeshGeometry> _geometry;
+
+	glm::vec3 _position = { 0, 0, 0 };
+	glm::vec3 _rotation = { 0, 0, 0 };
+	glm::vec3 _scale = { 1, 1, 1 };
+
+	// World matrix of the owning model or scene node, applied on top of the local transform
+	glm::mat4 _parentMatrix = glm::mat4(1.0f);
+	glm::mat4 _modelMatrix = glm::mat4(1.0f);
+
+public:
+	// Allow moving
+	Mesh(Mesh&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	// By Mesh reference passing we want to prevent copying, this is so called "double deletion protection"
+	Mesh(const Mesh&) = delete;
+
+	// Constructor for Primitive parameter
+	Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+		: _geometry(std::make_shared<MeshGeometry>(vertices, indices))
+	{
+		updateModelMatrix();
+	}
+
+	// Constructor for loaded mesh data, uploads meshlets as well
+	explicit Mesh(const MeshData& data)
+		: _geometry(std::make_shared<MeshGeometry>(data.vertices, data.indices, data.meshlets))
+	{
+		updateModelMatrix();
+	}
+
+	// Constructor for Primitive parameter
+	Mesh(const Primitive& primitive)
+		: _geometry(std::make_shared<MeshGeometry>(primitive.getVertices(), primitive.getIndices()))
+	{
+		updateModelMatrix();
+	}
+
+	// Mesh with its own transform drawing already uploaded geometry (see PrimitiveRegistry)
+	explicit Mesh(std::shared_ptr<const MeshGeometry> geometry)
+		: _geometry(std::move(geometry))
+	{
+		updateModelMatrix();
+	}
+
+	// Operator overloads
+	Mesh& operator=(const Mesh&) = delete;
+	Mesh& operator=(Mesh&& other) noexcept
+	{
+		std::swap(_geometry, other._geometry);
+
+		return *this;
+	}
+
+	// Functions to set and modify transform
+	void setPosition(const glm::vec3& position) { _position = position; }
+	void setRotation(const glm::vec3& rotation) { _rotation = rotation; }
+	void setScale(const glm::vec3& scale) { _scale = scale; }
+	void move(const glm::vec3& deltaPosition) { _position += deltaPosition; }
+	void rotate(const glm::vec3& deltaRotation) { _rotation += deltaRotation; }
+	void scale(const glm::vec3& deltaScale) { _scale += deltaScale; }
+	void setParentMatrix(const glm::mat4& parentMatrix) { _parentMatrix = parentMatrix; }
+
+	// Get count of vertices and indices mesh
+	size_t getVertexCount() const { return _geometry->getVertexCount(); }
+	size_t getIndexCount() const { return _geometry->getIndexCount(); }
+
+	// Vertex array with bound index buffer, for draws issued outside of render()
+	GLuint getVAO() const { return _geometry->getVAO(); }
+
+	// Size of vertex and index buffers in GPU memory (shared geometry is counted by every mesh)
+	size_t getGPUBytes() const { return _geometry->getGPUBytes(); }
+
+	// Meshlets in index order, empty for meshes built without them
+	const std::vector<Meshlet>& getMeshlets() const { return _geometry->getMeshlets(); }
+	GLuint getMeshletBuffer() const { return _geometry->getMeshletBuffer(); }
+
+	const std::shared_ptr<const MeshGeometry>& getGeometry() const { return _geometry; }
+
+	// Get transform and surface data
+	const glm::vec3& getPosition() const { return _position; }
+	const glm::vec3& getRotation() const { return _rotation; }
+	const glm::vec3& getScale() const { return _scale; }
+	const AABB& getBounds() const { return _geometry->getBounds(); }
+	float getWorldUnitsPerUV() const { return _geometry->getWorldUnitsPerUV(); }
+	const glm::mat4& getParentMatrix() const { return _parentMatrix; }
+	glm::mat4 getModelMatrix() const { return computeModelMatrix(); }
+
+	// Scale along local axes including parent scale
+	glm::vec3 getWorldScale() const
+	{
+		glm::mat4 modelMatrix = computeModelMatrix();
+		return { glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2])) };
+	}
+
+	// Bounding sphere in world space
+	BoundingSphere getWorldBoundingSphere() const
+	{
+		glm::mat4 modelMatrix = computeModelMatrix();
+		glm::vec3 worldScale = getWorldScale();
+		float maxScale = glm::max(worldScale.x, glm::max(worldScale.y, worldScale.z));
+
+		BoundingSphere sphere;
+		sphere.center = glm::vec3(modelMatrix * glm::vec4(getBounds().getCenter(), 1.0f));
+		sphere.radius = glm::length(getBounds().getExtents()) * maxScale;
+		return sphere;
+	}
+
+	// Render function
+	void render(const Shader& shader)
+	{
+		updateModelMatrix();
+
+		shader.use();
+		shader.set("model_matrix", _modelMatrix);
+
+		_geometry->draw();
+	}
+
+private:
+	glm::mat4 computeModelMatrix() const
+	{
+		glm::mat4 modelMatrix = _parentMatrix;
+		modelMatrix = glm::translate(modelMatrix, _position);
+		modelMatrix = glm::rotate(modelMatrix, glm::radians(_rotation.x), { 1,0,0 });
+		modelMatrix = glm::rotate(modelMatrix, glm::radians(_rotation.y), { 0,1,0 });
+		modelMatrix = glm::rotate(modelMatrix, glm::radians(_rotation.z), { 0,0,1 });
+		modelMatrix = glm::scale(modelMatrix, _scale);
+		return modelMatrix;
+	}
+
+	void updateModelMatrix()
+	{
+		_modelMatrix = computeModelMatrix();
+	}
 };
\ No newline at end of file
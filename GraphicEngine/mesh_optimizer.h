@@ -0,0 +1,229 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <glm.hpp>
+
+#include "primitives.h"
+#include "asset_pack.h"
+
+// Offline mesh processing: vertex welding, post-transform cache and vertex fetch ordering
+class MeshOptimizer
+{
+public:
+	static constexpr int CacheSize = 32;
+
+	// Merge bitwise identical vertices (OBJ loading emits one vertex per index)
+	static void weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+	{
+		struct VertexHash
+		{
+			size_t operator()(const Vertex& v) const { return static_cast<size_t>(hashFNV1a(&v, sizeof(Vertex))); }
+		};
+
+		struct VertexEqual
+		{
+			bool operator()(const Vertex& a, const Vertex& b) const { return std::memcmp(&a, &b, sizeof(Vertex)) == 0; }
+		};
+
+		std::unordered_map<Vertex, unsigned, VertexHash, VertexEqual> unique;
+		unique.reserve(vertices.size());
+
+		std::vector<Vertex> welded;
+		welded.reserve(vertices.size());
+
+		std::vector<unsigned> remap(vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			auto [it, inserted] = unique.try_emplace(vertices[i], static_cast<unsigned>(welded.size()));
+			if (inserted)
+				welded.push_back(vertices[i]);
+
+			remap[i] = it->second;
+		}
+
+		for (auto& index : indices)
+			index = remap[index];
+
+		vertices = std::move(welded);
+	}
+
+	// Reorder triangles for better post-transform vertex cache hit rate (Forsyth's linear-speed algorithm)
+	static void optimizeVertexCache(std::vector<unsigned>& indices, size_t vertexCount)
+	{
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return;
+
+		// Triangles using each vertex
+		std::vector<unsigned> adjacencyOffsets(vertexCount + 1, 0);
+		std::vector<unsigned> remainingTriangles(vertexCount, 0);
+
+		for (unsigned index : indices)
+			remainingTriangles[index]++;
+
+		for (size_t v = 0; v < vertexCount; ++v)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingTriangles[v];
+
+		std::vector<unsigned> adjacency(indices.size());
+		std::vector<unsigned> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			for (int k = 0; k < 3; ++k)
+				adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned>(t);
+		}
+
+		std::vector<float> vertexScore(vertexCount);
+		for (size_t v = 0; v < vertexCount; ++v)
+			vertexScore[v] = getVertexScore(-1, remainingTriangles[v]);
+
+		std::vector<bool> isEmitted(triangleCount, false);
+
+		std::vector<unsigned> result;
+		result.reserve(indices.size());
+
+		std::vector<unsigned> cache;
+		std::vector<unsigned> newCache;
+		cache.reserve(CacheSize + 3);
+		newCache.reserve(CacheSize + 3);
+
+		size_t scanCursor = 0;
+		int64_t bestTriangle = -1;
+
+		for (size_t emitted = 0; emitted < triangleCount; ++emitted)
+		{
+			// Nothing adjacent to the cache, continue with next unused triangle
+			if (bestTriangle < 0)
+			{
+				while (isEmitted[scanCursor])
+					scanCursor++;
+				bestTriangle = static_cast<int64_t>(scanCursor);
+			}
+
+			size_t triangle = static_cast<size_t>(bestTriangle);
+			isEmitted[triangle] = true;
+
+			newCache.clear();
+			for (int k = 0; k < 3; ++k)
+			{
+				unsigned v = indices[triangle * 3 + k];
+				result.push_back(v);
+				newCache.push_back(v);
+
+				// Remove triangle from vertex adjacency
+				unsigned* begin = &adjacency[adjacencyOffsets[v]];
+				unsigned* end = begin + remainingTriangles[v];
+				std::iter_swap(std::find(begin, end, static_cast<unsigned>(triangle)), end - 1);
+				remainingTriangles[v]--;
+			}
+
+			for (unsigned v : cache)
+			{
+				if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+					newCache.push_back(v);
+			}
+
+			// Vertices falling out of the cache
+			for (size_t i = CacheSize; i < newCache.size(); ++i)
+				vertexScore[newCache[i]] = getVertexScore(-1, remainingTriangles[newCache[i]]);
+
+			newCache.resize(std::min<size_t>(newCache.size(), CacheSize));
+			std::swap(cache, newCache);
+
+			for (size_t i = 0; i < cache.size(); ++i)
+				vertexScore[cache[i]] = getVertexScore(static_cast<int>(i), remainingTriangles[cache[i]]);
+
+			// Rescore triangles touching the cache and pick the best one
+			bestTriangle = -1;
+			float bestScore = -1.0f;
+
+			for (unsigned v : cache)
+			{
+				for (unsigned a = adjacencyOffsets[v]; a < adjacencyOffsets[v] + remainingTriangles[v]; ++a)
+				{
+					unsigned t = adjacency[a];
+					float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = t;
+					}
+				}
+			}
+		}
+
+		indices = std::move(result);
+	}
+
+	// Reorder vertices by first use, so vertex fetches are mostly sequential
+	static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+	{
+		std::vector<unsigned> remap(vertices.size(), UINT32_MAX);
+		std::vector<Vertex> reordered;
+		reordered.reserve(vertices.size());
+
+		for (auto& index : indices)
+		{
+			if (remap[index] == UINT32_MAX)
+			{
+				remap[index] = static_cast<unsigned>(reordered.size());
+				reordered.push_back(vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		// Unreferenced vertices are dropped
+		vertices = std::move(reordered);
+	}
+
+	// Average cache miss ratio (transformed vertices per triangle) for FIFO cache of given size
+	static float computeACMR(const std::vector<unsigned>& indices, size_t vertexCount, int cacheSize = 16)
+	{
+		if (indices.size() < 3)
+			return 0.0f;
+
+		std::vector<int64_t> timestamps(vertexCount, INT64_MIN / 2);
+		int64_t time = 0;
+		size_t misses = 0;
+
+		for (unsigned index : indices)
+		{
+			if (time - timestamps[index] > cacheSize)
+			{
+				timestamps[index] = time++;
+				misses++;
+			}
+		}
+
+		return static_cast<float>(misses) / (indices.size() / 3);
+	}
+
+private:
+	static float getVertexScore(int cachePosition, unsigned remainingTriangles)
+	{
+		// No triangles left to use this vertex
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+
+		if (cachePosition >= 0)
+		{
+			// Vertices of the last triangle are scored lower, so the strip does not fold back
+			if (cachePosition < 3)
+				score = 0.75f;
+			else
+				score = std::pow(1.0f - (cachePosition - 3) / float(CacheSize - 3), 1.5f);
+		}
+
+		// Bonus for vertices with few remaining triangles, so they get finished and leave the cache
+		score += 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+		return score;
+	}
+};
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <glm.hpp>
+
+// Offline mesh simplification by quadric error edge collapses. Vertices are only collapsed onto their neighbours
+// (no new vertices), so attributes stay valid and the vertex buffer can be shared by all levels.
+// Vertices on open edges never move, which keeps borders of partial meshes (and attribute seams) intact
+class MeshSimplifier
+{
+private:
+	// Symmetric 4x4 plane quadric
+	struct Quadric
+	{
+		double a2 = 0, ab = 0, ac = 0, ad = 0;
+		double b2 = 0, bc = 0, bd = 0;
+		double c2 = 0, cd = 0;
+		double d2 = 0;
+
+		static Quadric fromPlane(const glm::dvec3& normal, double distance)
+		{
+			Quadric q;
+			q.a2 = normal.x * normal.x; q.ab = normal.x * normal.y; q.ac = normal.x * normal.z; q.ad = normal.x * distance;
+			q.b2 = normal.y * normal.y; q.bc = normal.y * normal.z; q.bd = normal.y * distance;
+			q.c2 = normal.z * normal.z; q.cd = normal.z * distance;
+			q.d2 = distance * distance;
+			return q;
+		}
+
+		void add(const Quadric& q)
+		{
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+		}
+
+		// Sum of squared distances to the planes
+		double evaluate(const glm::dvec3& p) const
+		{
+			double error = a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+				+ b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+				+ c2 * p.z * p.z + 2 * cd * p.z
+				+ d2;
+			return std::max(error, 0.0);
+		}
+	};
+
+	struct Collapse
+	{
+		double cost = 0;
+		uint32_t from = 0;
+		uint32_t to = 0;
+	};
+
+public:
+	// Collapse edges until index count drops to target or nothing can be collapsed. Returns simplified indices,
+	// error is an upper bound of distance between simplified and source surface
+	static std::vector<unsigned> simplify(const std::vector<glm::vec3>& positions, const std::vector<unsigned>& sourceIndices,
+		size_t targetIndexCount, float& resultError)
+	{
+		std::vector<unsigned> indices = sourceIndices;
+		resultError = 0.0f;
+
+		size_t vertexCount = positions.size();
+		if (indices.size() <= targetIndexCount || vertexCount == 0)
+			return indices;
+
+		std::vector<uint8_t> isLocked = findBorderVertices(indices, vertexCount);
+
+		// Planes of source triangles accumulate in vertices and move with collapses
+		std::vector<Quadric> quadrics(vertexCount);
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			glm::dvec3 a = positions[indices[i]], b = positions[indices[i + 1]], c = positions[indices[i + 2]];
+			glm::dvec3 normal = glm::cross(b - a, c - a);
+			double length = glm::length(normal);
+			if (length <= 0.0)
+				continue;
+
+			normal /= length;
+			Quadric quadric = Quadric::fromPlane(normal, -glm::dot(normal, a));
+			for (int k = 0; k < 3; ++k)
+				quadrics[indices[i + k]].add(quadric);
+		}
+
+		std::vector<uint32_t> remap(vertexCount);
+		for (size_t v = 0; v < vertexCount; ++v)
+			remap[v] = static_cast<uint32_t>(v);
+
+		double maxCost = 0.0;
+
+		// Every pass collapses cheapest edges whose neighbourhoods do not overlap, then adjacency is rebuilt
+		while (indices.size() > targetIndexCount)
+		{
+			std::vector<uint32_t> offsets, triangles;
+			buildVertexTriangles(indices, vertexCount, offsets, triangles);
+
+			std::vector<Collapse> collapses;
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				for (int k = 0; k < 3; ++k)
+				{
+					uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+					if (!isLocked[a])
+						collapses.push_back({ collapseCost(quadrics, positions, a, b), a, b });
+					if (!isLocked[b])
+						collapses.push_back({ collapseCost(quadrics, positions, b, a), b, a });
+				}
+			}
+
+			if (collapses.empty())
+				break;
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+			std::vector<uint8_t> isTouched(vertexCount, 0);
+			size_t triangleCount = indices.size() / 3;
+			size_t targetTriangles = targetIndexCount / 3;
+			size_t performed = 0;
+
+			for (const auto& collapse : collapses)
+			{
+				if (triangleCount <= targetTriangles)
+					break;
+
+				if (isTouched[collapse.from] || isTouched[collapse.to] || remap[collapse.from] != collapse.from)
+					continue;
+
+				if (!isCollapseValid(positions, indices, offsets, triangles, collapse.from, collapse.to))
+					continue;
+
+				// Whole neighbourhood of both vertices changes
+				for (uint32_t vertex : { collapse.from, collapse.to })
+				{
+					for (uint32_t t = offsets[vertex]; t < offsets[vertex + 1]; ++t)
+					{
+						for (int k = 0; k < 3; ++k)
+							isTouched[indices[triangles[t] * 3 + k]] = 1;
+					}
+				}
+
+				remap[collapse.from] = collapse.to;
+				quadrics[collapse.to].add(quadrics[collapse.from]);
+				maxCost = std::max(maxCost, collapse.cost);
+
+				for (uint32_t t = offsets[collapse.from]; t < offsets[collapse.from + 1]; ++t)
+				{
+					const unsigned* triangle = &indices[triangles[t] * 3];
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+						triangleCount--;
+				}
+
+				performed++;
+			}
+
+			if (performed == 0)
+				break;
+
+			// Apply collapses and drop triangles which lost an edge
+			size_t write = 0;
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				unsigned a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+				if (a == b || b == c || a == c)
+					continue;
+
+				indices[write++] = a;
+				indices[write++] = b;
+				indices[write++] = c;
+			}
+			indices.resize(write);
+		}
+
+		resultError = static_cast<float>(std::sqrt(maxCost));
+		return indices;
+	}
+
+private:
+	// Vertices on open or non-manifold edges (edges not shared by exactly two triangles)
+	static std::vector<uint8_t> findBorderVertices(const std::vector<unsigned>& indices, size_t vertexCount)
+	{
+		std::unordered_map<uint64_t, uint32_t> edgeCounts;
+		edgeCounts.reserve(indices.size());
+
+		auto edgeKey = [](uint32_t a, uint32_t b) { return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b); };
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			for (int k = 0; k < 3; ++k)
+				edgeCounts[edgeKey(indices[i + k], indices[i + (k + 1) % 3])]++;
+		}
+
+		std::vector<uint8_t> isBorder(vertexCount, 0);
+		for (const auto& [key, count] : edgeCounts)
+		{
+			if (count != 2)
+			{
+				isBorder[key >> 32] = 1;
+				isBorder[key & 0xFFFFFFFFu] = 1;
+			}
+		}
+
+		return isBorder;
+	}
+
+	static void buildVertexTriangles(const std::vector<unsigned>& indices, size_t vertexCount, std::vector<uint32_t>& offsets, std::vector<uint32_t>& triangles)
+	{
+		offsets.assign(vertexCount + 1, 0);
+		for (unsigned index : indices)
+			offsets[index + 1]++;
+		for (size_t v = 0; v < vertexCount; ++v)
+			offsets[v + 1] += offsets[v];
+
+		triangles.resize(indices.size());
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i)
+			triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	static double collapseCost(const std::vector<Quadric>& quadrics, const std::vector<glm::vec3>& positions, uint32_t from, uint32_t to)
+	{
+		Quadric quadric = quadrics[from];
+		quadric.add(quadrics[to]);
+		return quadric.evaluate(positions[to]);
+	}
+
+	// Triangles around the removed vertex must not flip or degenerate
+	static bool isCollapseValid(const std::vector<glm::vec3>& positions, const std::vector<unsigned>& indices,
+		const std::vector<uint32_t>& offsets, const std::vector<uint32_t>& triangles, uint32_t from, uint32_t to)
+	{
+		for (uint32_t t = offsets[from]; t < offsets[from + 1]; ++t)
+		{
+			const unsigned* triangle = &indices[triangles[t] * 3];
+			if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+				continue;
+
+			glm::vec3 before[3], after[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				before[k] = positions[triangle[k]];
+				after[k] = (triangle[k] == from) ? positions[to] : before[k];
+			}
+
+			glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+			glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+			float lengthBefore = glm::length(normalBefore);
+			float lengthAfter = glm::length(normalAfter);
+			if (lengthAfter <= 1e-3f * lengthBefore || glm::dot(normalBefore, normalAfter) <= 0.25f * lengthBefore * lengthAfter)
+				return false;
+		}
+
+		return true;
+	}
+};
@@ -0,0 +1,311 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <glm.hpp>
+
+#include "vertex.h"
+
+// Cluster of neighbouring triangles stored as a contiguous index range of its mesh, so visible clusters are drawn
+// with one indirect command each. Bounds and normal cone allow culling whole clusters (std430 layout, see meshlet_cull.comp)
+struct Meshlet
+{
+	glm::vec4 boundingSphere = glm::vec4(0.0f);			// xyz = center, w = radius (local space)
+	glm::vec4 normalCone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);	// xyz = axis, w = cutoff (1 = never culled as backfacing)
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	uint32_t vertexCount = 0;
+	uint32_t padding = 0;
+
+	// All triangles face away from the viewer (position in the same space as bounds)
+	bool isBackfacing(const glm::vec3& viewerPosition) const
+	{
+		glm::vec3 offset = glm::vec3(boundingSphere) - viewerPosition;
+		return glm::dot(offset, glm::vec3(normalCone)) >= normalCone.w * glm::length(offset) + boundingSphere.w;
+	}
+};
+
+// Import-time clustering: triangles are grown into meshlets by adjacency, preferring triangles which add
+// no new vertices, then ones close to the meshlet and facing the same way (tighter normal cones cull better).
+// Seeds are taken in Morton order of triangle centroids, which also joins nearby unconnected triangles (flat shaded meshes)
+class MeshletBuilder
+{
+public:
+	static constexpr size_t MaxVertices = 64;
+	static constexpr size_t MaxTriangles = 124;
+
+	// Weight of normal deviation against distance when choosing the next triangle
+	static constexpr float ConeWeight = 0.5f;
+
+	// Indices are reordered so every meshlet is one range, vertices are not touched
+	static std::vector<Meshlet> build(const std::vector<Vertex>& vertices, std::vector<unsigned>& indices,
+		size_t maxVertices = MaxVertices, size_t maxTriangles = MaxTriangles)
+	{
+		std::vector<Meshlet> meshlets;
+
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0 || vertices.empty())
+			return meshlets;
+
+		maxVertices = std::max<size_t>(maxVertices, 3);
+		maxTriangles = std::max<size_t>(maxTriangles, 1);
+
+		// Triangles around every vertex
+		std::vector<uint32_t> adjacencyOffsets(vertices.size() + 1, 0);
+		for (unsigned index : indices)
+			adjacencyOffsets[index + 1]++;
+		for (size_t v = 0; v < vertices.size(); ++v)
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+		std::vector<uint32_t> adjacency(adjacencyOffsets.back());
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			for (int k = 0; k < 3; ++k)
+				adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+		}
+
+		std::vector<glm::vec3> centroids(triangleCount);
+		std::vector<glm::vec3> normals(triangleCount);
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			const glm::vec3& a = vertices[indices[t * 3 + 0]].position;
+			const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+			const glm::vec3& c = vertices[indices[t * 3 + 2]].position;
+
+			centroids[t] = (a + b + c) / 3.0f;
+
+			glm::vec3 normal = glm::cross(b - a, c - a);
+			float length = glm::length(normal);
+			normals[t] = (length > 0.0f) ? normal / length : glm::vec3(0.0f);
+		}
+
+		std::vector<uint32_t> seedOrder = sortSpatially(centroids);
+
+		std::vector<uint8_t> isEmitted(triangleCount, 0);
+		std::vector<uint32_t> vertexMeshlet(vertices.size(), UINT32_MAX);	// Meshlet the vertex was last added to
+
+		std::vector<unsigned> reordered;
+		reordered.reserve(indices.size());
+
+		std::vector<uint32_t> triangles;
+		std::vector<uint32_t> candidates;
+		size_t meshletVertexCount = 0;
+		glm::vec3 centroidSum(0.0f);
+		glm::vec3 normalSum(0.0f);
+		size_t seedCursor = 0;
+
+		auto countNewVertices = [&](size_t triangle)
+			{
+				size_t count = 0;
+				for (int k = 0; k < 3; ++k)
+					count += vertexMeshlet[indices[triangle * 3 + k]] != meshlets.size();
+				return count;
+			};
+
+		auto finishMeshlet = [&]()
+			{
+				Meshlet meshlet;
+				meshlet.firstIndex = static_cast<uint32_t>(reordered.size());
+				meshlet.indexCount = static_cast<uint32_t>(triangles.size() * 3);
+				meshlet.vertexCount = static_cast<uint32_t>(meshletVertexCount);
+
+				for (uint32_t triangle : triangles)
+				{
+					for (int k = 0; k < 3; ++k)
+						reordered.push_back(indices[triangle * 3 + k]);
+				}
+
+				computeBounds(vertices, reordered.data() + meshlet.firstIndex, meshlet.indexCount, normals, triangles, meshlet);
+				meshlets.push_back(meshlet);
+
+				triangles.clear();
+				candidates.clear();
+				meshletVertexCount = 0;
+				centroidSum = glm::vec3(0.0f);
+				normalSum = glm::vec3(0.0f);
+			};
+
+		for (size_t emitted = 0; emitted < triangleCount; ++emitted)
+		{
+			// Best adjacent triangle: fewest new vertices, then closest in position and orientation
+			int64_t best = -1;
+			size_t bestNewVertices = SIZE_MAX;
+			float bestCost = FLT_MAX;
+
+			if (!triangles.empty())
+			{
+				glm::vec3 center = centroidSum / static_cast<float>(triangles.size());
+				float normalLength = glm::length(normalSum);
+				glm::vec3 averageNormal = (normalLength > 0.0f) ? normalSum / normalLength : glm::vec3(0.0f);
+
+				// Distances are relative to the current meshlet size
+				float radius = 1e-6f;
+				for (uint32_t triangle : triangles)
+				{
+					for (int k = 0; k < 3; ++k)
+						radius = std::max(radius, glm::length(vertices[indices[triangle * 3 + k]].position - center));
+				}
+
+				size_t kept = 0;
+				for (uint32_t candidate : candidates)
+				{
+					if (isEmitted[candidate])
+						continue;
+					candidates[kept++] = candidate;
+
+					size_t newVertices = countNewVertices(candidate);
+					if (meshletVertexCount + newVertices > maxVertices || newVertices > bestNewVertices)
+						continue;
+
+					float cost = glm::length(centroids[candidate] - center) / radius
+						+ ConeWeight * (1.0f - glm::dot(normals[candidate], averageNormal));
+
+					if (newVertices < bestNewVertices || cost < bestCost)
+					{
+						best = candidate;
+						bestNewVertices = newVertices;
+						bestCost = cost;
+					}
+				}
+				candidates.resize(kept);
+
+				// Nothing connected fits, take the next seed if it has room and lies close, otherwise start a new meshlet
+				if (best < 0)
+				{
+					size_t seed = nextSeed(seedOrder, isEmitted, seedCursor);
+					if (meshletVertexCount + 3 <= maxVertices && glm::length(centroids[seed] - center) <= 2.0f * radius)
+						best = static_cast<int64_t>(seed);
+					else
+						finishMeshlet();
+				}
+			}
+
+			if (best < 0)
+				best = static_cast<int64_t>(nextSeed(seedOrder, isEmitted, seedCursor));
+
+			size_t triangle = static_cast<size_t>(best);
+			isEmitted[triangle] = 1;
+			triangles.push_back(static_cast<uint32_t>(triangle));
+			centroidSum += centroids[triangle];
+			normalSum += normals[triangle];
+
+			for (int k = 0; k < 3; ++k)
+			{
+				unsigned vertex = indices[triangle * 3 + k];
+				if (vertexMeshlet[vertex] == meshlets.size())
+					continue;
+
+				vertexMeshlet[vertex] = static_cast<uint32_t>(meshlets.size());
+				meshletVertexCount++;
+
+				for (uint32_t i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex + 1]; ++i)
+				{
+					if (!isEmitted[adjacency[i]])
+						candidates.push_back(adjacency[i]);
+				}
+			}
+
+			if (triangles.size() == maxTriangles)
+				finishMeshlet();
+		}
+
+		if (!triangles.empty())
+			finishMeshlet();
+
+		indices.swap(reordered);
+		return meshlets;
+	}
+
+	// Indices of points (e.g. triangle centroids) sorted by 30 bit Morton code in their bounds, used to seed spatially coherent clusters
+	static std::vector<uint32_t> sortSpatially(const std::vector<glm::vec3>& centroids)
+	{
+		glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+		for (const auto& centroid : centroids)
+		{
+			min = glm::min(min, centroid);
+			max = glm::max(max, centroid);
+		}
+
+		glm::vec3 scale = 1023.0f / glm::max(max - min, glm::vec3(1e-20f));
+
+		auto spreadBits = [](uint32_t value)
+			{
+				value = (value | (value << 16)) & 0x030000FF;
+				value = (value | (value << 8)) & 0x0300F00F;
+				value = (value | (value << 4)) & 0x030C30C3;
+				value = (value | (value << 2)) & 0x09249249;
+				return value;
+			};
+
+		std::vector<std::pair<uint32_t, uint32_t>> keys(centroids.size());
+		for (size_t t = 0; t < centroids.size(); ++t)
+		{
+			glm::uvec3 cell = glm::uvec3(glm::clamp((centroids[t] - min) * scale, glm::vec3(0.0f), glm::vec3(1023.0f)));
+			keys[t] = { spreadBits(cell.x) | (spreadBits(cell.y) << 1) | (spreadBits(cell.z) << 2), static_cast<uint32_t>(t) };
+		}
+
+		std::sort(keys.begin(), keys.end());
+
+		std::vector<uint32_t> order(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i)
+			order[i] = keys[i].second;
+		return order;
+	}
+
+private:
+	static size_t nextSeed(const std::vector<uint32_t>& seedOrder, const std::vector<uint8_t>& isEmitted, size_t& cursor)
+	{
+		while (isEmitted[seedOrder[cursor]])
+			cursor++;
+		return seedOrder[cursor];
+	}
+
+	static void computeBounds(const std::vector<Vertex>& vertices, const unsigned* indices, size_t indexCount,
+		const std::vector<glm::vec3>& normals, const std::vector<uint32_t>& triangles, Meshlet& meshlet)
+	{
+		// Sphere around the box center
+		glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			min = glm::min(min, vertices[indices[i]].position);
+			max = glm::max(max, vertices[indices[i]].position);
+		}
+
+		glm::vec3 center = (min + max) * 0.5f;
+		float radius = 0.0f;
+		for (size_t i = 0; i < indexCount; ++i)
+			radius = std::max(radius, glm::length(vertices[indices[i]].position - center));
+
+		meshlet.boundingSphere = glm::vec4(center, radius);
+
+		// Cone around face normals: axis is their average, cutoff comes from the widest normal.
+		// Cones wider than about 84 degrees are not worth testing
+		glm::vec3 axis(0.0f);
+		for (uint32_t triangle : triangles)
+			axis += normals[triangle];
+
+		float axisLength = glm::length(axis);
+		if (axisLength <= 0.0f)
+			return;
+		axis /= axisLength;
+
+		float minDot = 1.0f;
+		for (uint32_t triangle : triangles)
+		{
+			if (normals[triangle] != glm::vec3(0.0f))
+				minDot = std::min(minDot, glm::dot(normals[triangle], axis));
+		}
+
+		if (minDot <= 0.1f)
+		{
+			meshlet.normalCone = glm::vec4(axis, 1.0f);
+			return;
+		}
+
+		meshlet.normalCone = glm::vec4(axis, std::sqrt(1.0f - minDot * minDot));
+	}
+};
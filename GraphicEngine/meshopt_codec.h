@@ -0,0 +1,494 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+// Decoders of meshoptimizer vertex and index codecs, the formats of glTF EXT_meshopt_compression
+// (bitstream version 0 for vertices, versions 0 and 1 for indices). Compatible with meshopt_decodeVertexBuffer,
+// meshopt_decodeIndexBuffer, meshopt_decodeIndexSequence and meshopt_decodeFilter* of the reference library.
+// Every function returns false on malformed input instead of reading out of bounds
+class MeshoptCodec
+{
+public:
+	enum class Filter { None, Octahedral, Quaternion, Exponential };
+
+private:
+	static constexpr unsigned char VertexHeader = 0xA0;
+	static constexpr unsigned char IndexHeader = 0xE0;
+	static constexpr unsigned char SequenceHeader = 0xD0;
+
+	static constexpr size_t ByteGroupSize = 16;
+	static constexpr size_t VertexBlockMaxSize = 256;
+	static constexpr size_t VertexBlockSizeBytes = 8192;
+	static constexpr size_t TailMaxSize = 32;
+
+public:
+	// Byte-wise delta coded attribute stream, vertexSize has to be multiple of 4 and at most 256
+	static bool decodeVertexBuffer(unsigned char* target, size_t vertexCount, size_t vertexSize, const unsigned char* source, size_t sourceSize)
+	{
+		if (vertexSize == 0 || vertexSize > 256 || vertexSize % 4 != 0)
+			return false;
+
+		const unsigned char* data = source;
+		const unsigned char* dataEnd = source + sourceSize;
+
+		if (sourceSize < 1 + vertexSize || (*data & 0xF0) != VertexHeader || (*data & 0x0F) != 0)
+			return false;
+
+		data++;
+
+		// First vertex is stored at the end, it is the baseline of the first block
+		unsigned char lastVertex[256];
+		std::memcpy(lastVertex, dataEnd - vertexSize, vertexSize);
+
+		size_t blockSize = std::min((VertexBlockSizeBytes / vertexSize) & ~(ByteGroupSize - 1), VertexBlockMaxSize);
+
+		for (size_t offset = 0; offset < vertexCount; offset += blockSize)
+		{
+			size_t count = std::min(blockSize, vertexCount - offset);
+			data = decodeVertexBlock(data, dataEnd, target + offset * vertexSize, count, vertexSize, lastVertex);
+			if (!data)
+				return false;
+		}
+
+		// Only the padded tail with the first vertex may follow
+		size_t tailSize = std::max(vertexSize, TailMaxSize);
+		return size_t(dataEnd - data) == tailSize;
+	}
+
+	// Triangle list coded with edge and vertex FIFOs, indexSize is 2 or 4
+	static bool decodeIndexBuffer(void* target, size_t indexCount, size_t indexSize, const unsigned char* source, size_t sourceSize)
+	{
+		if (indexCount % 3 != 0 || (indexSize != 2 && indexSize != 4))
+			return false;
+
+		if (sourceSize < 1 + indexCount / 3 + 16 || (source[0] & 0xF0) != IndexHeader)
+			return false;
+
+		int version = source[0] & 0x0F;
+		if (version > 1)
+			return false;
+
+		uint32_t edgeFifo[16][2];
+		uint32_t vertexFifo[16];
+		std::memset(edgeFifo, 0xFF, sizeof(edgeFifo));
+		std::memset(vertexFifo, 0xFF, sizeof(vertexFifo));
+
+		size_t edgeFifoOffset = 0;
+		size_t vertexFifoOffset = 0;
+
+		uint32_t next = 0;
+		uint32_t last = 0;
+
+		// Version 1 codes +1 / -1 deltas of free indices as 13 and 14
+		int maxFifoCode = version >= 1 ? 13 : 15;
+
+		// One code byte per triangle, then variable data, then 16 byte table of common aux codes
+		const unsigned char* code = source + 1;
+		const unsigned char* data = code + indexCount / 3;
+		const unsigned char* dataSafeEnd = source + sourceSize - 16;
+		const unsigned char* codeAuxTable = dataSafeEnd;
+
+		auto pushVertex = [&](uint32_t v, bool condition = true)
+			{
+				vertexFifo[vertexFifoOffset] = v;
+				vertexFifoOffset = (vertexFifoOffset + (condition ? 1 : 0)) & 15;
+			};
+
+		auto pushEdge = [&](uint32_t a, uint32_t b)
+			{
+				edgeFifo[edgeFifoOffset][0] = a;
+				edgeFifo[edgeFifoOffset][1] = b;
+				edgeFifoOffset = (edgeFifoOffset + 1) & 15;
+			};
+
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			// Triangle reads at most 16 bytes (aux code and three 5 byte indices), the table guarantees they are present
+			if (data > dataSafeEnd)
+				return false;
+
+			unsigned char codeTriangle = *code++;
+
+			if (codeTriangle < 0xF0)
+			{
+				// Edge from FIFO plus vertex from FIFO, next new vertex or free index
+				int fe = codeTriangle >> 4;
+				uint32_t a = edgeFifo[(edgeFifoOffset - 1 - fe) & 15][0];
+				uint32_t b = edgeFifo[(edgeFifoOffset - 1 - fe) & 15][1];
+
+				int fec = codeTriangle & 15;
+				uint32_t c;
+
+				if (fec < maxFifoCode)
+				{
+					bool isNew = fec == 0;
+					c = isNew ? next : vertexFifo[(vertexFifoOffset - 1 - fec) & 15];
+					next += isNew ? 1 : 0;
+
+					pushVertex(c, isNew);
+				}
+				else
+				{
+					// Free indices are delta coded against the last one
+					last = c = (fec != 15) ? last + (fec - (fec ^ 3)) : decodeIndex(data, last);
+
+					pushVertex(c);
+				}
+
+				writeTriangle(target, i, indexSize, a, b, c);
+				pushEdge(c, b);
+				pushEdge(a, c);
+			}
+			else if (codeTriangle < 0xFE)
+			{
+				// Three vertices without shared edge, aux code comes from the table
+				unsigned char codeAux = codeAuxTable[codeTriangle & 15];
+				int feb = codeAux >> 4;
+				int fec = codeAux & 15;
+
+				uint32_t a = next++;
+
+				uint32_t b = (feb == 0) ? next : vertexFifo[(vertexFifoOffset - feb) & 15];
+				next += (feb == 0) ? 1 : 0;
+
+				uint32_t c = (fec == 0) ? next : vertexFifo[(vertexFifoOffset - fec) & 15];
+				next += (fec == 0) ? 1 : 0;
+
+				writeTriangle(target, i, indexSize, a, b, c);
+
+				pushVertex(a);
+				pushVertex(b, feb == 0);
+				pushVertex(c, fec == 0);
+
+				pushEdge(b, a);
+				pushEdge(c, b);
+				pushEdge(a, c);
+			}
+			else
+			{
+				// Aux code stored explicitly, 0xFF marks free first index
+				unsigned char codeAux = *data++;
+				int fea = codeTriangle == 0xFE ? 0 : 15;
+				int feb = codeAux >> 4;
+				int fec = codeAux & 15;
+
+				// Zero aux code restarts vertex numbering
+				if (codeAux == 0)
+					next = 0;
+
+				uint32_t a = (fea == 0) ? next++ : 0;
+				uint32_t b = (feb == 0) ? next++ : vertexFifo[(vertexFifoOffset - feb) & 15];
+				uint32_t c = (fec == 0) ? next++ : vertexFifo[(vertexFifoOffset - fec) & 15];
+
+				if (fea == 15) last = a = decodeIndex(data, last);
+				if (feb == 15) last = b = decodeIndex(data, last);
+				if (fec == 15) last = c = decodeIndex(data, last);
+
+				writeTriangle(target, i, indexSize, a, b, c);
+
+				pushVertex(a);
+				pushVertex(b, feb == 0 || feb == 15);
+				pushVertex(c, fec == 0 || fec == 15);
+
+				pushEdge(b, a);
+				pushEdge(c, b);
+				pushEdge(a, c);
+			}
+		}
+
+		// All data has to be consumed exactly up to the table
+		return data == dataSafeEnd;
+	}
+
+	// Arbitrary index list coded as zigzag deltas against one of two baselines, indexSize is 2 or 4
+	static bool decodeIndexSequence(void* target, size_t indexCount, size_t indexSize, const unsigned char* source, size_t sourceSize)
+	{
+		if (indexSize != 2 && indexSize != 4)
+			return false;
+
+		if (sourceSize < 1 + indexCount + 4 || (source[0] & 0xF0) != SequenceHeader || (source[0] & 0x0F) > 1)
+			return false;
+
+		const unsigned char* data = source + 1;
+		const unsigned char* dataSafeEnd = source + sourceSize - 4;
+
+		uint32_t last[2] = {};
+
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			// Index reads at most 5 bytes, the 4 byte tail keeps them in bounds
+			if (data >= dataSafeEnd)
+				return false;
+
+			uint32_t v = decodeVByte(data);
+
+			uint32_t baseline = v & 1;
+			v >>= 1;
+
+			uint32_t index = last[baseline] + ((v >> 1) ^ (0u - (v & 1)));
+			last[baseline] = index;
+
+			if (indexSize == 2)
+				static_cast<uint16_t*>(target)[i] = static_cast<uint16_t>(index);
+			else
+				static_cast<uint32_t*>(target)[i] = index;
+		}
+
+		return data == dataSafeEnd;
+	}
+
+	// Inverse of the encoding filters, applied in place to decoded vertex data
+	static bool decodeFilter(Filter filter, unsigned char* data, size_t count, size_t stride)
+	{
+		switch (filter)
+		{
+		case Filter::None:
+			return true;
+
+		case Filter::Octahedral:
+			if (stride == 4)
+				decodeOctahedral(reinterpret_cast<int8_t*>(data), count);
+			else if (stride == 8)
+				decodeOctahedral(reinterpret_cast<int16_t*>(data), count);
+			else
+				return false;
+			return true;
+
+		case Filter::Quaternion:
+			if (stride != 8)
+				return false;
+			decodeQuaternion(reinterpret_cast<int16_t*>(data), count);
+			return true;
+
+		case Filter::Exponential:
+			if (stride % 4 != 0)
+				return false;
+			decodeExponential(reinterpret_cast<uint32_t*>(data), count * (stride / 4));
+			return true;
+		}
+
+		return false;
+	}
+
+private:
+	static const unsigned char* decodeVertexBlock(const unsigned char* data, const unsigned char* dataEnd, unsigned char* target,
+		size_t vertexCount, size_t vertexSize, unsigned char lastVertex[256])
+	{
+		unsigned char buffer[VertexBlockMaxSize];
+		size_t alignedCount = (vertexCount + ByteGroupSize - 1) & ~(ByteGroupSize - 1);
+
+		// Every byte of the vertex is its own stream of zigzag deltas
+		for (size_t k = 0; k < vertexSize; ++k)
+		{
+			data = decodeBytes(data, dataEnd, buffer, alignedCount);
+			if (!data)
+				return nullptr;
+
+			unsigned char previous = lastVertex[k];
+			for (size_t i = 0; i < vertexCount; ++i)
+			{
+				unsigned char delta = buffer[i];
+				unsigned char value = static_cast<unsigned char>(((0u - (delta & 1)) ^ (delta >> 1)) + previous);
+
+				target[i * vertexSize + k] = value;
+				previous = value;
+			}
+		}
+
+		std::memcpy(lastVertex, target + (vertexCount - 1) * vertexSize, vertexSize);
+		return data;
+	}
+
+	// Groups of 16 bytes packed with 0, 2, 4 or 8 bits each, 2 bit header per group
+	static const unsigned char* decodeBytes(const unsigned char* data, const unsigned char* dataEnd, unsigned char* buffer, size_t bufferSize)
+	{
+		const unsigned char* header = data;
+		size_t headerSize = (bufferSize / ByteGroupSize + 3) / 4;
+		if (size_t(dataEnd - data) < headerSize)
+			return nullptr;
+
+		data += headerSize;
+
+		for (size_t i = 0; i < bufferSize; i += ByteGroupSize)
+		{
+			size_t group = i / ByteGroupSize;
+			int bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+
+			data = decodeBytesGroup(data, dataEnd, buffer + i, bitsLog2);
+			if (!data)
+				return nullptr;
+		}
+
+		return data;
+	}
+
+	static const unsigned char* decodeBytesGroup(const unsigned char* data, const unsigned char* dataEnd, unsigned char* buffer, int bitsLog2)
+	{
+		if (bitsLog2 == 0)
+		{
+			std::memset(buffer, 0, ByteGroupSize);
+			return data;
+		}
+
+		if (bitsLog2 == 3)
+		{
+			if (size_t(dataEnd - data) < ByteGroupSize)
+				return nullptr;
+
+			std::memcpy(buffer, data, ByteGroupSize);
+			return data + ByteGroupSize;
+		}
+
+		// Values equal to all ones are escapes, the real byte follows the packed bits
+		int bits = bitsLog2 == 1 ? 2 : 4;
+		size_t packedSize = ByteGroupSize * bits / 8;
+		unsigned int sentinel = (1u << bits) - 1;
+
+		if (size_t(dataEnd - data) < packedSize)
+			return nullptr;
+
+		const unsigned char* escapes = data + packedSize;
+
+		for (size_t i = 0; i < ByteGroupSize; ++i)
+		{
+			unsigned int shift = 8 - bits - static_cast<unsigned int>((i * bits) % 8);
+			unsigned int value = (data[i * bits / 8] >> shift) & sentinel;
+
+			if (value == sentinel)
+			{
+				if (escapes == dataEnd)
+					return nullptr;
+				value = *escapes++;
+			}
+
+			buffer[i] = static_cast<unsigned char>(value);
+		}
+
+		return escapes;
+	}
+
+	static uint32_t decodeVByte(const unsigned char*& data)
+	{
+		unsigned char lead = *data++;
+		if (lead < 128)
+			return lead;
+
+		// At most 4 more bytes, so malformed data cannot run away
+		uint32_t result = lead & 127;
+		uint32_t shift = 7;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			unsigned char group = *data++;
+			result |= uint32_t(group & 127) << shift;
+			shift += 7;
+
+			if (group < 128)
+				break;
+		}
+
+		return result;
+	}
+
+	static uint32_t decodeIndex(const unsigned char*& data, uint32_t last)
+	{
+		uint32_t v = decodeVByte(data);
+		return last + ((v >> 1) ^ (0u - (v & 1)));
+	}
+
+	static void writeTriangle(void* target, size_t offset, size_t indexSize, uint32_t a, uint32_t b, uint32_t c)
+	{
+		if (indexSize == 2)
+		{
+			uint16_t* indices = static_cast<uint16_t*>(target) + offset;
+			indices[0] = static_cast<uint16_t>(a);
+			indices[1] = static_cast<uint16_t>(b);
+			indices[2] = static_cast<uint16_t>(c);
+		}
+		else
+		{
+			uint32_t* indices = static_cast<uint32_t*>(target) + offset;
+			indices[0] = a;
+			indices[1] = b;
+			indices[2] = c;
+		}
+	}
+
+	// Octahedral encoded unit vectors, the third component carries the encoding of 1.0 and the fourth is kept
+	template<typename T>
+	static void decodeOctahedral(T* data, size_t count)
+	{
+		const float maxValue = float((1 << (sizeof(T) * 8 - 1)) - 1);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			float x = float(data[i * 4 + 0]);
+			float y = float(data[i * 4 + 1]);
+			float z = float(data[i * 4 + 2]) - std::fabs(x) - std::fabs(y);
+
+			// Fold back the lower hemisphere
+			float t = std::min(z, 0.0f);
+			x += (x >= 0.0f) ? t : -t;
+			y += (y >= 0.0f) ? t : -t;
+
+			float scale = maxValue / std::sqrt(x * x + y * y + z * z);
+
+			data[i * 4 + 0] = T(roundToInt(x * scale));
+			data[i * 4 + 1] = T(roundToInt(y * scale));
+			data[i * 4 + 2] = T(roundToInt(z * scale));
+		}
+	}
+
+	// Three smallest components plus index of the largest one (low 2 bits of the fourth component, the rest is scale)
+	static void decodeQuaternion(int16_t* data, size_t count)
+	{
+		const float scale = 1.0f / std::sqrt(2.0f);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			int componentScale = data[i * 4 + 3] | 3;
+			float s = scale / float(componentScale);
+
+			float x = float(data[i * 4 + 0]) * s;
+			float y = float(data[i * 4 + 1]) * s;
+			float z = float(data[i * 4 + 2]) * s;
+
+			float ww = 1.0f - x * x - y * y - z * z;
+			float w = std::sqrt(std::max(ww, 0.0f));
+
+			int largest = data[i * 4 + 3] & 3;
+
+			data[i * 4 + ((largest + 1) & 3)] = int16_t(roundToInt(x * 32767.0f));
+			data[i * 4 + ((largest + 2) & 3)] = int16_t(roundToInt(y * 32767.0f));
+			data[i * 4 + ((largest + 3) & 3)] = int16_t(roundToInt(z * 32767.0f));
+			data[i * 4 + ((largest + 0) & 3)] = int16_t(roundToInt(w * 32767.0f));
+		}
+	}
+
+	// 24 bit mantissa and 8 bit exponent per value, decoded into float
+	static void decodeExponential(uint32_t* data, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint32_t v = data[i];
+			int32_t mantissa = static_cast<int32_t>(v << 8) >> 8;
+			int32_t exponent = static_cast<int32_t>(v) >> 24;
+
+			// ldexp(mantissa, exponent) through the float exponent bits
+			uint32_t powerBits = static_cast<uint32_t>(exponent + 127) << 23;
+			float power;
+			std::memcpy(&power, &powerBits, sizeof(float));
+
+			float value = power * float(mantissa);
+			std::memcpy(&data[i], &value, sizeof(float));
+		}
+	}
+
+	static int roundToInt(float value)
+	{
+		return int(value + (value >= 0.0f ? 0.5f : -0.5f));
+	}
+};
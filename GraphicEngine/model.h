@@ -1,139 +1,280 @@
-#pragma once
-
-#include "mesh.h"
-#include "tiny_obj_loader.h"
-
-class Model
-{
-private:
-	std::vector<Mesh*> _meshes;
-
-public:
-	Model() = default;
-
-	explicit Model(const std::string& filepath)
-	{
-		loadModelData(filepath);
-	}
-
-	~Model()
-	{
-		for (auto* m : _meshes)
-			delete m;
-	}
-
-	void setPosition(const glm::vec3& position) { for (auto m : _meshes) m->setPosition(position); }
-	void setRotation(const glm::vec3& rotation) { for (auto m : _meshes) m->setRotation(rotation); }
-	void setScale(const glm::vec3& scale) { for (auto m : _meshes) m->setScale(scale); }
-	void move(const glm::vec3& deltaPosition) { for (auto m : _meshes) m->move(deltaPosition); }
-	void rotate(const glm::vec3& deltaRotation) { for (auto m : _meshes) m->rotate(deltaRotation); }
-	void scale(const glm::vec3& deltaScale) { for (auto m : _meshes) m->scale(deltaScale); }
-
-	size_t getTotalVertexCount() const
-	{
-		size_t total = 0;
-		for (auto m : _meshes)
-			total += m->getVertexCount();
-		return total;
-	}
-
-	void render(const Shader& shader)
-	{
-		for (auto* mesh : _meshes)
-			mesh->render(shader);
-	}
-
-private:
-	void loadModelData(const std::string& filepath)
-	{
-		tinyobj::attrib_t vertexAttributes;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warn, err;
-
-		// Try to load *.Obj and pass the data as Vertex, Meshes (shapes), Materials and messages
-		bool success = tinyobj::LoadObj(&vertexAttributes, &shapes, &materials, &warn, &err, filepath.c_str(), nullptr, true);
-
-		// Load check and output any warnings/errors
-		if (!warn.empty())
-			std::cout << "TinyObj WARN: " << warn << "\n";
-
-		if (!err.empty())
-			std::cerr << "TinyObj ERR: " << err << "\n";
-
-		if (!success)
-		{
-			std::cerr << "Failed to load OBJ file: " << filepath << "\n";
-			return;
-		}
-
-		std::cout << "Loaded OBJ: " << filepath << "\n";
-
-		bool hasNormals = !vertexAttributes.normals.empty();
-		bool hasTexcoords = !vertexAttributes.texcoords.empty();
-
-		// Process shapes (each shape is mesh)
-		for (const auto& shape : shapes)
-		{
-			std::vector<Vertex> vertices;
-			std::vector<GLuint> indices;
-
-			vertices.reserve(shape.mesh.indices.size());
-			indices.reserve(shape.mesh.indices.size());
-
-			for (const auto& index : shape.mesh.indices)
-			{
-				Vertex vertex{};
-
-				// POSITION
-				vertex.position =
-				{
-					vertexAttributes.vertices[3 * index.vertex_index + 0],
-					vertexAttributes.vertices[3 * index.vertex_index + 1],
-					vertexAttributes.vertices[3 * index.vertex_index + 2]
-				};
-
-				// NORMAL
-				if (hasNormals && index.normal_index >= 0)
-				{
-					vertex.normal =
-					{
-						vertexAttributes.normals[3 * index.normal_index + 0],
-						vertexAttributes.normals[3 * index.normal_index + 1],
-						vertexAttributes.normals[3 * index.normal_index + 2]
-					};
-				}
-				else
-				{
-					// fallback
-					vertex.normal = { 0, 0, 1 };
-				}
-
-				// TEXCOORD
-				if (hasTexcoords && index.texcoord_index >= 0)
-				{
-					vertex.textureCoord =
-					{
-						vertexAttributes.texcoords[2 * index.texcoord_index + 0],
-						1.0f - vertexAttributes.texcoords[2 * index.texcoord_index + 1]
-					};
-				}
-				else
-				{
-					// fallback
-					vertex.textureCoord = { 0, 0 };
-				}
-
-				// COLOR default (OBJ does not store vertex colors)
-				vertex.color = { 1, 1, 1 };
-
-				vertices.push_back(vertex);
-				indices.push_back(indices.size());
-			}
-
-			// Create mesh
-			Mesh* mesh = new Mesh(vertices, indices);
-			_meshes.push_back(mesh);
-		}
-	}
+#pragma once
+
+#include <unordered_set>
+
+#include "mesh.h"
+#include "mesh_optimizer.h"
+#include "tiny_obj_loader.h"
+#include "asset_pack.h"
+#include "scene_graph.h"
+#include "gltf_loader.h"
+
+class Model
+{
+private:
+	std::vector<Mesh*> _meshes;
+
+	// glTF models own their textures and materials, OBJ models are drawn with the caller's material
+	std::vector<std::unique_ptr<Texture>> _textures;
+	std::vector<PBRMaterial> _materials;
+	std::vector<int> _meshMaterials;
+
+	// Transform of the whole model, meshes keep their own transforms relative to it
+	Transform _transform;
+	glm::mat4 _parentMatrix = glm::mat4(1.0f);
+
+public:
+	Model() = default;
+
+	explicit Model(const std::string& filepath)
+	{
+		if (GltfLoader::isGltfPath(filepath))
+			createFromScene(GltfLoader::load(filepath));
+		else
+			createFromMeshData(loadMeshData(filepath));
+	}
+
+	// Create meshes from already loaded data (has to be called on the OpenGL context thread)
+	explicit Model(const std::vector<MeshData>& meshes)
+	{
+		createFromMeshData(meshes);
+	}
+
+	// Create meshes, textures and materials of loaded glTF scene (has to be called on the OpenGL context thread)
+	explicit Model(GltfSceneData&& scene)
+	{
+		createFromScene(std::move(scene));
+	}
+
+	~Model()
+	{
+		for (auto* m : _meshes)
+			delete m;
+	}
+
+	void setPosition(const glm::vec3& position) { _transform.position = position; updateMeshMatrices(); }
+	void setRotation(const glm::vec3& rotation) { _transform.rotation = rotation; updateMeshMatrices(); }
+	void setScale(const glm::vec3& scale) { _transform.scale = scale; updateMeshMatrices(); }
+	void move(const glm::vec3& deltaPosition) { _transform.position += deltaPosition; updateMeshMatrices(); }
+	void rotate(const glm::vec3& deltaRotation) { _transform.rotation += deltaRotation; updateMeshMatrices(); }
+	void scale(const glm::vec3& deltaScale) { _transform.scale += deltaScale; updateMeshMatrices(); }
+
+	// World matrix of the scene node the model is attached to
+	void setParentMatrix(const glm::mat4& parentMatrix) { _parentMatrix = parentMatrix; updateMeshMatrices(); }
+
+	const Transform& getTransform() const { return _transform; }
+	glm::mat4 getModelMatrix() const { return _parentMatrix * _transform.toMatrix(); }
+
+	const std::vector<Mesh*>& getMeshes() const { return _meshes; }
+
+	// Material of mesh from the model file, nullptr when it has none
+	const PBRMaterial* getMaterial(size_t meshIndex) const
+	{
+		int material = (meshIndex < _meshMaterials.size()) ? _meshMaterials[meshIndex] : -1;
+		return (material >= 0) ? &_materials[material] : nullptr;
+	}
+
+	size_t getTotalVertexCount() const
+	{
+		size_t total = 0;
+		for (auto m : _meshes)
+			total += m->getVertexCount();
+		return total;
+	}
+
+	size_t getGPUBytes() const
+	{
+		// glTF instances share geometry, each buffer is counted once
+		size_t total = 0;
+		std::unordered_set<const MeshGeometry*> counted;
+		for (auto m : _meshes)
+		{
+			if (counted.insert(m->getGeometry().get()).second)
+				total += m->getGPUBytes();
+		}
+
+		for (const auto& texture : _textures)
+			total += texture->getResidentBytes();
+		return total;
+	}
+
+	void render(const Shader& shader)
+	{
+		for (auto* mesh : _meshes)
+			mesh->render(shader);
+	}
+
+	// Apply each mesh's own material before drawing it, meshes without one use the currently applied material
+	void renderWithMaterials(Shader& shader)
+	{
+		for (size_t i = 0; i < _meshes.size(); ++i)
+		{
+			if (const PBRMaterial* material = getMaterial(i))
+				material->apply(shader);
+
+			_meshes[i]->render(shader);
+		}
+	}
+
+	// Parse OBJ file into mesh data (no OpenGL calls)
+	static std::vector<MeshData> loadMeshData(const std::string& filepath)
+	{
+		// Asset pack entry or loose file
+		return buildMeshlets(parseMeshData(AssetFileSystem::read(filepath), filepath));
+	}
+
+	// Weld vertices and split meshes into meshlets, cooked meshes already come with them
+	static std::vector<MeshData> buildMeshlets(std::vector<MeshData> meshes)
+	{
+		for (auto& mesh : meshes)
+		{
+			MeshOptimizer::weldVertices(mesh.vertices, mesh.indices);
+			mesh.meshlets = MeshletBuilder::build(mesh.vertices, mesh.indices);
+		}
+
+		return meshes;
+	}
+
+	// Parse OBJ file already in memory
+	static std::vector<MeshData> parseMeshData(const AssetBlob& file, const std::string& filepath)
+	{
+		std::vector<MeshData> meshes;
+
+		tinyobj::attrib_t vertexAttributes;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+
+		if (!file.isValid())
+		{
+			std::cerr << "Failed to load OBJ file: " << filepath << "\n";
+			return meshes;
+		}
+
+		MemoryStreamBuffer buffer(file.data(), file.size());
+		std::istream stream(&buffer);
+
+		// Try to load *.Obj and pass the data as Vertex, Meshes (shapes), Materials and messages
+		bool success = tinyobj::LoadObj(&vertexAttributes, &shapes, &materials, &warn, &err, &stream, nullptr, true);
+
+		// Load check and output any warnings/errors
+		if (!warn.empty())
+			std::cout << "TinyObj WARN: " << warn << "\n";
+
+		if (!err.empty())
+			std::cerr << "TinyObj ERR: " << err << "\n";
+
+		if (!success)
+		{
+			std::cerr << "Failed to load OBJ file: " << filepath << "\n";
+			return meshes;
+		}
+
+		std::cout << "Loaded OBJ: " << filepath << "\n";
+
+		bool hasNormals = !vertexAttributes.normals.empty();
+		bool hasTexcoords = !vertexAttributes.texcoords.empty();
+
+		// Process shapes (each shape is mesh)
+		for (const auto& shape : shapes)
+		{
+			std::vector<Vertex> vertices;
+			std::vector<GLuint> indices;
+
+			vertices.reserve(shape.mesh.indices.size());
+			indices.reserve(shape.mesh.indices.size());
+
+			for (const auto& index : shape.mesh.indices)
+			{
+				Vertex vertex{};
+
+				// POSITION
+				vertex.position =
+				{
+					vertexAttributes.vertices[3 * index.vertex_index + 0],
+					vertexAttributes.vertices[3 * index.vertex_index + 1],
+					vertexAttributes.vertices[3 * index.vertex_index + 2]
+				};
+
+				// NORMAL
+				if (hasNormals && index.normal_index >= 0)
+				{
+					vertex.normal =
+					{
+						vertexAttributes.normals[3 * index.normal_index + 0],
+						vertexAttributes.normals[3 * index.normal_index + 1],
+						vertexAttributes.normals[3 * index.normal_index + 2]
+					};
+				}
+				else
+				{
+					// fallback
+					vertex.normal = { 0, 0, 1 };
+				}
+
+				// TEXCOORD
+				if (hasTexcoords && index.texcoord_index >= 0)
+				{
+					vertex.textureCoord =
+					{
+						vertexAttributes.texcoords[2 * index.texcoord_index + 0],
+						1.0f - vertexAttributes.texcoords[2 * index.texcoord_index + 1]
+					};
+				}
+				else
+				{
+					// fallback
+					vertex.textureCoord = { 0, 0 };
+				}
+
+				// COLOR default (OBJ does not store vertex colors)
+				vertex.color = { 1, 1, 1 };
+
+				vertices.push_back(vertex);
+				indices.push_back(indices.size());
+			}
+
+			// Tangents are generated before welding, so vertices only merge where tangents match
+			TangentSpace::generate(vertices, indices);
+
+			meshes.push_back({ std::move(vertices), std::move(indices), {} });
+		}
+
+		return meshes;
+	}
+
+private:
+	void createFromMeshData(const std::vector<MeshData>& meshes)
+	{
+		for (const auto& meshData : meshes)
+			_meshes.push_back(new Mesh(meshData));
+	}
+
+	void createFromScene(GltfSceneData&& scene)
+	{
+		GltfSceneResources resources = GltfLoader::upload(scene);
+		_textures = std::move(resources.textures);
+		_materials = std::move(resources.materials);
+
+		// Instances of one primitive share its geometry, node transforms become mesh transforms
+		for (const auto& instance : scene.instances)
+		{
+			Mesh* mesh = new Mesh(resources.geometries[instance.primitive]);
+
+			Transform transform = Transform::decompose(instance.matrix);
+			mesh->setPosition(transform.position);
+			mesh->setRotation(transform.rotation);
+			mesh->setScale(transform.scale);
+
+			_meshes.push_back(mesh);
+			_meshMaterials.push_back(scene.primitives[instance.primitive].material);
+		}
+	}
+
+	void updateMeshMatrices()
+	{
+		glm::mat4 modelMatrix = getModelMatrix();
+		for (auto* mesh : _meshes)
+			mesh->setParentMatrix(modelMatrix);
+	}
 };
\ No newline at end of file
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <glad.h>
+#include <glm.hpp>
+
+// Per-object data read by batched shaders at index gl_BaseInstance + gl_InstanceID (std430 layout).
+// Local bounds and mesh index are used by GPU culling (gpu_cull.comp)
+struct GPUObjectData
+{
+	glm::mat4 modelMatrix = glm::mat4(1.0f);
+	glm::vec4 boundsCenter = glm::vec4(0.0f);	// xyz, local space
+	glm::vec4 boundsExtents = glm::vec4(0.0f);
+	uint32_t materialIndex = 0;
+	uint32_t meshIndex = 0;
+	uint32_t padding[2] = {};
+};
+
+class ObjectBuffer
+{
+public:
+	static constexpr GLuint BindingPoint = 1;
+
+	// Dirty objects closer than this are uploaded in one call together with the clean ones between them
+	static constexpr size_t MaxUploadGap = 8;
+
+private:
+	GLuint _ssbo = 0;
+	size_t _capacity = 0;
+
+	std::vector<GPUObjectData> _objects;
+
+	// Objects changed since last upload
+	std::vector<uint32_t> _dirtyIndices;
+	std::vector<uint8_t> _isDirty;
+
+public:
+	ObjectBuffer()
+	{
+		glGenBuffers(1, &_ssbo);
+	}
+
+	~ObjectBuffer()
+	{
+		if (_ssbo) glDeleteBuffers(1, &_ssbo);
+	}
+
+	ObjectBuffer(const ObjectBuffer&) = delete;
+	ObjectBuffer& operator=(const ObjectBuffer&) = delete;
+
+	size_t size() const { return _objects.size(); }
+	GLuint getID() const { return _ssbo; }
+
+	// Returns index of the object in the buffer
+	uint32_t add(const GPUObjectData& data)
+	{
+		_objects.push_back(data);
+		_isDirty.push_back(0);
+		markDirty(_objects.size() - 1);
+		return static_cast<uint32_t>(_objects.size() - 1);
+	}
+
+	void set(uint32_t index, const GPUObjectData& data)
+	{
+		_objects[index] = data;
+		markDirty(index);
+	}
+
+	void setModelMatrix(uint32_t index, const glm::mat4& modelMatrix)
+	{
+		_objects[index].modelMatrix = modelMatrix;
+		markDirty(index);
+	}
+
+	const GPUObjectData& get(uint32_t index) const { return _objects[index]; }
+
+	// Remove last object (used for swap and pop removal together with set)
+	void removeLast()
+	{
+		_objects.pop_back();
+		_isDirty.pop_back();
+	}
+
+	void reserve(size_t count)
+	{
+		_objects.reserve(count);
+		_isDirty.reserve(count);
+	}
+
+	void clear()
+	{
+		_objects.clear();
+		_isDirty.clear();
+		_dirtyIndices.clear();
+	}
+
+	size_t getDirtyCount() const { return _dirtyIndices.size(); }
+
+	// Send changed objects to GPU (whole buffer is reallocated only when it has to grow)
+	void upload()
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _ssbo);
+
+		if (_objects.size() > _capacity)
+		{
+			_capacity = std::max(_objects.size(), _capacity * 2);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, _capacity * sizeof(GPUObjectData), nullptr, GL_DYNAMIC_DRAW);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, _objects.size() * sizeof(GPUObjectData), _objects.data());
+		}
+		else if (!_dirtyIndices.empty() && _dirtyIndices.size() * 2 >= _objects.size())
+		{
+			// Most objects changed, sorting is not worth it
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, _objects.size() * sizeof(GPUObjectData), _objects.data());
+		}
+		else if (!_dirtyIndices.empty())
+		{
+			// Merge sorted dirty indices into runs, each run is one upload
+			std::sort(_dirtyIndices.begin(), _dirtyIndices.end());
+
+			size_t i = 0;
+			while (i < _dirtyIndices.size() && _dirtyIndices[i] < _objects.size())
+			{
+				size_t begin = _dirtyIndices[i];
+				size_t end = begin + 1;
+
+				while (++i < _dirtyIndices.size() && _dirtyIndices[i] < _objects.size() && _dirtyIndices[i] <= end + MaxUploadGap)
+					end = _dirtyIndices[i] + 1;
+
+				glBufferSubData(GL_SHADER_STORAGE_BUFFER, begin * sizeof(GPUObjectData), (end - begin) * sizeof(GPUObjectData), _objects.data() + begin);
+			}
+		}
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		// Indices of removed objects may still be in the list
+		for (uint32_t index : _dirtyIndices)
+		{
+			if (index < _isDirty.size())
+				_isDirty[index] = 0;
+		}
+		_dirtyIndices.clear();
+	}
+
+	void bind() const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindingPoint, _ssbo);
+	}
+
+private:
+	void markDirty(size_t index)
+	{
+		if (_isDirty[index])
+			return;
+
+		_isDirty[index] = 1;
+		_dirtyIndices.push_back(static_cast<uint32_t>(index));
+	}
+};
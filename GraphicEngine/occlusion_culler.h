@@ -0,0 +1,435 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_CULLER_SSE
+#endif
+
+#include "vertex.h"
+#include "primitives.h"
+#include "bounds.h"
+#include "job_system.h"
+
+// Occluders rasterized in the last frame
+struct OcclusionStats
+{
+	size_t occluderCount = 0;
+	size_t occluderTriangles = 0;
+	float rasterizeMs = 0.0f;
+};
+
+// Software occlusion culling, runs entirely on the CPU (no GPU readback). Few large occluders are rasterized
+// into a small depth buffer, tiles are filled in parallel on worker threads, 4 pixels at a time with SSE.
+// Depth is conservative: a pixel is written only when the triangle covers it completely and it gets the farthest
+// depth of the triangle inside the pixel. Occludees test their projected bounds against farthest depth per 8x8 block
+// first and against pixels only where the block test is not decisive. Visible objects are never culled,
+// some hidden ones may still be drawn
+class OcclusionCuller
+{
+public:
+	static constexpr int TileWidth = 32;
+	static constexpr int TileHeight = 16;
+	static constexpr int BlockSize = 8;
+
+private:
+	struct Occluder
+	{
+		const Primitive* geometry = nullptr;
+		glm::mat4 modelMatrix = glm::mat4(1.0f);
+		float screenSize = 0.0f;
+	};
+
+	// Edge functions (inside when a * x + b * y + c >= bias) and depth plane in buffer pixels
+	struct Triangle
+	{
+		float edgeA[3], edgeB[3], edgeC[3], edgeBias[3];
+		float depthA, depthB, depthC, depthMax;
+		int minX, minY, maxX, maxY;
+	};
+
+	int _width = 0;
+	int _height = 0;
+	int _tilesX = 0;
+	int _tilesY = 0;
+	int _blocksX = 0;
+	int _blocksY = 0;
+
+	size_t _maxTriangles = 16384;
+
+	glm::mat4 _viewProjection = glm::mat4(1.0f);
+	Frustum _frustum;
+
+	std::vector<Occluder> _occluders;
+	std::vector<glm::vec4> _clipVertices;
+	std::vector<Triangle> _triangles;
+	std::vector<std::vector<uint32_t>> _tileBins;
+
+	std::vector<float> _depth;			// Nearest occluder depth (NDC) per pixel, row major
+	std::vector<float> _blockDepth;		// Farthest value of _depth per block
+
+	OcclusionStats _stats;
+
+public:
+	// Resolution is independent of the window, it is rounded up to whole tiles
+	explicit OcclusionCuller(int width = 320, int height = 192)
+	{
+		setResolution(width, height);
+	}
+
+	void setResolution(int width, int height)
+	{
+		_tilesX = std::max(1, (width + TileWidth - 1) / TileWidth);
+		_tilesY = std::max(1, (height + TileHeight - 1) / TileHeight);
+		_width = _tilesX * TileWidth;
+		_height = _tilesY * TileHeight;
+		_blocksX = _width / BlockSize;
+		_blocksY = _height / BlockSize;
+
+		_depth.assign(size_t(_width) * _height, 1.0f);
+		_blockDepth.assign(size_t(_blocksX) * _blocksY, 1.0f);
+		_tileBins.resize(size_t(_tilesX) * _tilesY);
+		_triangles.clear();
+	}
+
+	// Occluders are taken by screen size until the triangle budget is used up
+	void setMaxOccluderTriangles(size_t count) { _maxTriangles = count; }
+
+	int getWidth() const { return _width; }
+	int getHeight() const { return _height; }
+	const std::vector<float>& getDepthBuffer() const { return _depth; }
+	const OcclusionStats& getStats() const { return _stats; }
+
+	void beginFrame(const glm::mat4& viewProjection)
+	{
+		_viewProjection = viewProjection;
+		_frustum = Frustum::fromMatrix(viewProjection);
+		_occluders.clear();
+	}
+
+	// Occluder candidate, geometry has to stay alive until rasterize(). Closed, large and simple meshes work best
+	void addOccluder(const Primitive& geometry, const glm::mat4& modelMatrix, const AABB& localBounds)
+	{
+		if (geometry.getIndices().size() < 3 || !localBounds.isValid())
+			return;
+
+		AABB worldBounds = localBounds.transformed(modelMatrix);
+		glm::vec3 center = worldBounds.getCenter();
+		float radius = glm::length(worldBounds.getExtents());
+
+		if (!_frustum.intersects(center, radius))
+			return;
+
+		// Projected size, camera inside or right next to the bounds makes it the first choice
+		float distance = (_viewProjection * glm::vec4(center, 1.0f)).w;
+		float screenSize = (distance > radius) ? radius / distance : FLT_MAX;
+
+		_occluders.push_back({ &geometry, modelMatrix, screenSize });
+	}
+
+	// Fill depth buffer with occluders added since beginFrame()
+	void rasterize(JobSystem& jobs)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		std::sort(_occluders.begin(), _occluders.end(), [](const Occluder& a, const Occluder& b) { return a.screenSize > b.screenSize; });
+
+		_triangles.clear();
+		for (auto& bin : _tileBins)
+			bin.clear();
+
+		_stats.occluderCount = 0;
+		_stats.occluderTriangles = 0;
+
+		for (const Occluder& occluder : _occluders)
+		{
+			size_t triangleCount = occluder.geometry->getIndices().size() / 3;
+			if (_stats.occluderTriangles + triangleCount > _maxTriangles)
+				continue;
+
+			addTriangles(occluder);
+			_stats.occluderCount++;
+			_stats.occluderTriangles += triangleCount;
+		}
+
+		jobs.parallelFor(_tileBins.size(), 1, [this](size_t begin, size_t end)
+			{
+				for (size_t tile = begin; tile < end; ++tile)
+					rasterizeTile(static_cast<int>(tile));
+			});
+
+		_stats.rasterizeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// False only when the box is hidden behind occluders for sure. Read only, can be called from many threads
+	bool isVisible(const AABB& bounds, const glm::mat4& modelMatrix = glm::mat4(1.0f)) const
+	{
+		if (_triangles.empty())
+			return true;
+
+		// Corners in clip space as origin plus multiples of the box axes
+		glm::mat4 matrix = _viewProjection * modelMatrix;
+		glm::vec3 size = bounds.max - bounds.min;
+		glm::vec4 origin = matrix * glm::vec4(bounds.min, 1.0f);
+		glm::vec4 axisX = matrix[0] * size.x;
+		glm::vec4 axisY = matrix[1] * size.y;
+		glm::vec4 axisZ = matrix[2] * size.z;
+
+		float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+		float minDepth = FLT_MAX;
+
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			glm::vec4 clip = origin;
+			if (corner & 1) clip += axisX;
+			if (corner & 2) clip += axisY;
+			if (corner & 4) clip += axisZ;
+
+			// Crosses the near plane, covers the camera
+			if (clip.w <= 1e-5f || clip.z < -clip.w)
+				return true;
+
+			float invW = 1.0f / clip.w;
+			float x = (clip.x * invW * 0.5f + 0.5f) * _width;
+			float y = (clip.y * invW * 0.5f + 0.5f) * _height;
+
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			minDepth = std::min(minDepth, clip.z * invW);
+		}
+
+		// Every pixel touched by the rectangle
+		if (maxX < 0.0f || maxY < 0.0f || minX >= _width || minY >= _height)
+			return true;
+
+		int x0 = static_cast<int>(std::max(minX, 0.0f));
+		int y0 = static_cast<int>(std::max(minY, 0.0f));
+		int x1 = static_cast<int>(std::min(maxX, _width - 1.0f));
+		int y1 = static_cast<int>(std::min(maxY, _height - 1.0f));
+
+		for (int blockY = y0 / BlockSize; blockY <= y1 / BlockSize; ++blockY)
+		{
+			for (int blockX = x0 / BlockSize; blockX <= x1 / BlockSize; ++blockX)
+			{
+				if (minDepth > _blockDepth[size_t(blockY) * _blocksX + blockX])
+					continue;
+
+				// Block is not hidden as a whole, check pixels under the rectangle
+				int px0 = std::max(x0, blockX * BlockSize), px1 = std::min(x1, blockX * BlockSize + BlockSize - 1);
+				int py0 = std::max(y0, blockY * BlockSize), py1 = std::min(y1, blockY * BlockSize + BlockSize - 1);
+
+				for (int y = py0; y <= py1; ++y)
+				{
+					const float* row = &_depth[size_t(y) * _width];
+					for (int x = px0; x <= px1; ++x)
+					{
+						if (minDepth <= row[x])
+							return true;
+					}
+				}
+			}
+		}
+
+		return false;
+	}
+
+private:
+	void addTriangles(const Occluder& occluder)
+	{
+		const std::vector<Vertex>& vertices = occluder.geometry->getVertices();
+		const std::vector<unsigned>& indices = occluder.geometry->getIndices();
+
+		glm::mat4 matrix = _viewProjection * occluder.modelMatrix;
+
+		_clipVertices.resize(vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i)
+			_clipVertices[i] = matrix * glm::vec4(vertices[i].position, 1.0f);
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			glm::vec4 polygon[4];
+			int count = clipNear(_clipVertices[indices[i]], _clipVertices[indices[i + 1]], _clipVertices[indices[i + 2]], polygon);
+
+			// Clipped triangle is a triangle or a quad
+			if (count >= 3)
+				setupTriangle(polygon[0], polygon[1], polygon[2]);
+			if (count == 4)
+				setupTriangle(polygon[0], polygon[2], polygon[3]);
+		}
+	}
+
+	// Cut away the part in front of the near plane (z < -w), the rest gets positive w
+	static int clipNear(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, glm::vec4 result[4])
+	{
+		const glm::vec4 input[3] = { a, b, c };
+		int count = 0;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			const glm::vec4& current = input[i];
+			const glm::vec4& next = input[(i + 1) % 3];
+			float currentDistance = current.z + current.w;
+			float nextDistance = next.z + next.w;
+
+			if (currentDistance >= 0.0f)
+				result[count++] = current;
+
+			if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+				result[count++] = glm::mix(current, next, currentDistance / (currentDistance - nextDistance));
+		}
+
+		return count;
+	}
+
+	void setupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+	{
+		glm::vec3 v[3];
+		const glm::vec4* clip[3] = { &a, &b, &c };
+		for (int i = 0; i < 3; ++i)
+		{
+			float w = std::max(clip[i]->w, 1e-5f);
+			v[i] = glm::vec3((clip[i]->x / w * 0.5f + 0.5f) * _width, (clip[i]->y / w * 0.5f + 0.5f) * _height, clip[i]->z / w);
+		}
+
+		float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+		if (std::abs(area) < 1e-6f)
+			return;
+
+		Triangle triangle;
+		// Clamped before conversion, vertices close to the near plane can project far outside
+		triangle.minX = static_cast<int>(std::clamp(std::floor(std::min({ v[0].x, v[1].x, v[2].x })), 0.0f, float(_width)));
+		triangle.minY = static_cast<int>(std::clamp(std::floor(std::min({ v[0].y, v[1].y, v[2].y })), 0.0f, float(_height)));
+		triangle.maxX = static_cast<int>(std::clamp(std::ceil(std::max({ v[0].x, v[1].x, v[2].x })), 0.0f, float(_width))) - 1;
+		triangle.maxY = static_cast<int>(std::clamp(std::ceil(std::max({ v[0].y, v[1].y, v[2].y })), 0.0f, float(_height))) - 1;
+
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+			return;
+
+		// Both windings are rasterized, edges are flipped to be positive inside
+		float sign = (area > 0.0f) ? 1.0f : -1.0f;
+		for (int i = 0; i < 3; ++i)
+		{
+			const glm::vec3& from = v[i];
+			const glm::vec3& to = v[(i + 1) % 3];
+
+			triangle.edgeA[i] = (from.y - to.y) * sign;
+			triangle.edgeB[i] = (to.x - from.x) * sign;
+			triangle.edgeC[i] = -(triangle.edgeA[i] * from.x + triangle.edgeB[i] * from.y);
+
+			// Pixel center this far inside means the whole pixel is covered
+			triangle.edgeBias[i] = 0.5f * (std::abs(triangle.edgeA[i]) + std::abs(triangle.edgeB[i]));
+		}
+
+		// Depth plane, shifted to the farthest value inside a pixel
+		float depth1 = v[1].z - v[0].z;
+		float depth2 = v[2].z - v[0].z;
+		triangle.depthA = (depth1 * (v[2].y - v[0].y) - depth2 * (v[1].y - v[0].y)) / area;
+		triangle.depthB = (depth2 * (v[1].x - v[0].x) - depth1 * (v[2].x - v[0].x)) / area;
+		triangle.depthC = v[0].z - triangle.depthA * v[0].x - triangle.depthB * v[0].y
+			+ 0.5f * (std::abs(triangle.depthA) + std::abs(triangle.depthB));
+		triangle.depthMax = std::max({ v[0].z, v[1].z, v[2].z });
+
+		uint32_t index = static_cast<uint32_t>(_triangles.size());
+		_triangles.push_back(triangle);
+
+		for (int tileY = triangle.minY / TileHeight; tileY <= triangle.maxY / TileHeight; ++tileY)
+		{
+			for (int tileX = triangle.minX / TileWidth; tileX <= triangle.maxX / TileWidth; ++tileX)
+				_tileBins[size_t(tileY) * _tilesX + tileX].push_back(index);
+		}
+	}
+
+	// Tiles do not share pixels, so they are rasterized without synchronization
+	void rasterizeTile(int tile)
+	{
+		int tileX0 = (tile % _tilesX) * TileWidth;
+		int tileY0 = (tile / _tilesX) * TileHeight;
+
+		for (int y = tileY0; y < tileY0 + TileHeight; ++y)
+			std::fill_n(&_depth[size_t(y) * _width + tileX0], TileWidth, 1.0f);
+
+		for (uint32_t index : _tileBins[tile])
+		{
+			const Triangle& triangle = _triangles[index];
+
+			// Start at group of 4 pixels, groups never leave the tile
+			int x0 = std::max(triangle.minX, tileX0) & ~3;
+			int x1 = std::min(triangle.maxX, tileX0 + TileWidth - 1);
+			int y0 = std::max(triangle.minY, tileY0);
+			int y1 = std::min(triangle.maxY, tileY0 + TileHeight - 1);
+
+			for (int y = y0; y <= y1; ++y)
+				rasterizeRow(triangle, y, x0, x1);
+		}
+
+		// Hierarchical level: farthest depth per block
+		for (int blockY = tileY0 / BlockSize; blockY < (tileY0 + TileHeight) / BlockSize; ++blockY)
+		{
+			for (int blockX = tileX0 / BlockSize; blockX < (tileX0 + TileWidth) / BlockSize; ++blockX)
+			{
+				float farthest = -FLT_MAX;
+				for (int y = blockY * BlockSize; y < (blockY + 1) * BlockSize; ++y)
+				{
+					const float* row = &_depth[size_t(y) * _width + blockX * BlockSize];
+					farthest = std::max(farthest, *std::max_element(row, row + BlockSize));
+				}
+
+				_blockDepth[size_t(blockY) * _blocksX + blockX] = farthest;
+			}
+		}
+	}
+
+	void rasterizeRow(const Triangle& triangle, int y, int x0, int x1)
+	{
+		float* row = &_depth[size_t(y) * _width];
+		float centerY = y + 0.5f;
+
+		float rowEdge[3];
+		for (int i = 0; i < 3; ++i)
+			rowEdge[i] = triangle.edgeB[i] * centerY + triangle.edgeC[i];
+		float rowDepth = triangle.depthB * centerY + triangle.depthC;
+
+#ifdef OCCLUSION_CULLER_SSE
+		const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 depthMax = _mm_set1_ps(triangle.depthMax);
+
+		for (int x = x0; x <= x1; x += 4)
+		{
+			__m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+
+			__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[0]), centerX), _mm_set1_ps(rowEdge[0])), _mm_set1_ps(triangle.edgeBias[0]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[1]), centerX), _mm_set1_ps(rowEdge[1])), _mm_set1_ps(triangle.edgeBias[1])));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[2]), centerX), _mm_set1_ps(rowEdge[2])), _mm_set1_ps(triangle.edgeBias[2])));
+
+			if (_mm_movemask_ps(inside) == 0)
+				continue;
+
+			__m128 depth = _mm_min_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.depthA), centerX), _mm_set1_ps(rowDepth)), depthMax);
+			__m128 current = _mm_loadu_ps(row + x);
+			__m128 nearest = _mm_min_ps(current, depth);
+
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+		}
+#else
+		for (int x = x0; x <= x1; ++x)
+		{
+			float centerX = x + 0.5f;
+
+			bool inside = true;
+			for (int i = 0; i < 3; ++i)
+				inside = inside && (triangle.edgeA[i] * centerX + rowEdge[i] >= triangle.edgeBias[i]);
+
+			if (inside)
+				row[x] = std::min(row[x], std::min(triangle.depthA * centerX + rowDepth, triangle.depthMax));
+		}
+#endif
+	}
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <bit>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdint>
+
+#include "primitives.h"
+#include "mesh.h"
+
+enum class PrimitiveType : uint8_t
+{
+	Plane,
+	Cube,
+	Sphere,
+	Torus
+};
+
+// Type and exact parameters of generated geometry (segment counts are already quantized).
+// Sizes are compared by bit pattern like they are hashed, so NaN keys still find their entry
+struct PrimitiveKey
+{
+	PrimitiveType type = PrimitiveType::Plane;
+	float sizes[2] = {};
+	unsigned segments[2] = {};
+
+	bool operator==(const PrimitiveKey& other) const
+	{
+		return type == other.type
+			&& std::bit_cast<uint32_t>(sizes[0]) == std::bit_cast<uint32_t>(other.sizes[0])
+			&& std::bit_cast<uint32_t>(sizes[1]) == std::bit_cast<uint32_t>(other.sizes[1])
+			&& segments[0] == other.segments[0] && segments[1] == other.segments[1];
+	}
+};
+
+struct PrimitiveKeyHash
+{
+	size_t operator()(const PrimitiveKey& key) const
+	{
+		size_t hash = static_cast<size_t>(key.type);
+		auto combine = [&](uint32_t value) { hash ^= std::hash<uint32_t>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+
+		combine(std::bit_cast<uint32_t>(key.sizes[0]));
+		combine(std::bit_cast<uint32_t>(key.sizes[1]));
+		combine(key.segments[0]);
+		combine(key.segments[1]);
+		return hash;
+	}
+};
+
+// Cache of generated primitives. Geometry with the same type and parameters is generated once and uploaded
+// once, every Mesh created from geometry() shares the same buffers. Segment counts are rounded up to power of
+// two tiers, so close requests (60 and 64 lines) share one entry as well. CPU geometry can be requested from
+// any thread, GPU geometry only on the OpenGL context thread
+class PrimitiveRegistry
+{
+public:
+	static constexpr unsigned MinSegments = 4;
+	static constexpr unsigned MaxSegments = 256;
+
+private:
+	struct Entry
+	{
+		std::unique_ptr<Primitive> primitive;
+		std::shared_ptr<const MeshGeometry> geometry;
+	};
+
+	inline static std::mutex _mutex;
+	inline static std::unordered_map<PrimitiveKey, Entry, PrimitiveKeyHash> _entries;
+	inline static std::unordered_map<const Primitive*, Entry*> _entriesByPrimitive;
+
+public:
+	// Level of detail tier used for segment count
+	static unsigned quantizeSegments(unsigned segments)
+	{
+		return std::bit_ceil(std::clamp(segments, MinSegments, MaxSegments));
+	}
+
+	static const Primitive& plane(float width = 1.0f, float height = 1.0f)
+	{
+		return get({ PrimitiveType::Plane, { width, height } });
+	}
+
+	static const Primitive& cube(float size = 1.0f)
+	{
+		return get({ PrimitiveType::Cube, { size, 0.0f } });
+	}
+
+	static const Primitive& sphere(float radius = 1.0f, unsigned horizontalLines = 16, unsigned verticalLines = 32)
+	{
+		return get({ PrimitiveType::Sphere, { radius, 0.0f }, { quantizeSegments(horizontalLines), quantizeSegments(verticalLines) } });
+	}
+
+	static const Primitive& torus(float outerRadius = 1.0f, float innerRadius = 0.3f, unsigned horizontalLines = 16, unsigned verticalLines = 16)
+	{
+		return get({ PrimitiveType::Torus, { outerRadius, innerRadius }, { quantizeSegments(horizontalLines), quantizeSegments(verticalLines) } });
+	}
+
+	// Uploaded buffers of a primitive returned by this registry, uploaded on first request.
+	// Other primitives get their own buffers, which are not cached
+	static std::shared_ptr<const MeshGeometry> geometry(const Primitive& primitive)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		auto it = _entriesByPrimitive.find(&primitive);
+		if (it == _entriesByPrimitive.end())
+			return std::make_shared<MeshGeometry>(primitive.getVertices(), primitive.getIndices());
+
+		Entry& entry = *it->second;
+		if (!entry.geometry)
+			entry.geometry = std::make_shared<MeshGeometry>(primitive.getVertices(), primitive.getIndices());
+
+		return entry.geometry;
+	}
+
+	static size_t getCount()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _entries.size();
+	}
+
+	// Meshes keep their geometry alive, registry only drops its references (call before the context is destroyed)
+	static void clear()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_entriesByPrimitive.clear();
+		_entries.clear();
+	}
+
+private:
+	static const Primitive& get(PrimitiveKey key)
+	{
+		// -0 and +0 give the same geometry, adding zero turns -0 into +0
+		key.sizes[0] += 0.0f;
+		key.sizes[1] += 0.0f;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		auto [it, inserted] = _entries.try_emplace(key);
+		if (inserted)
+		{
+			it->second.primitive = create(key);
+			_entriesByPrimitive[it->second.primitive.get()] = &it->second;
+		}
+
+		return *it->second.primitive;
+	}
+
+	static std::unique_ptr<Primitive> create(const PrimitiveKey& key)
+	{
+		switch (key.type)
+		{
+		case PrimitiveType::Plane:
+			return std::make_unique<Plane>(key.sizes[0], key.sizes[1]);
+		case PrimitiveType::Cube:
+			return std::make_unique<Cube>(key.sizes[0]);
+		case PrimitiveType::Sphere:
+			return std::make_unique<Sphere>(key.sizes[0], key.segments[0], key.segments[1]);
+		case PrimitiveType::Torus:
+			return std::make_unique<Torus>(key.sizes[0], key.sizes[1], key.segments[0], key.segments[1]);
+		}
+
+		return std::make_unique<Primitive>();
+	}
+};
@@ -0,0 +1,913 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <iostream>
+#include <glad.h>
+#include <glm.hpp>
+
+#include "mesh.h"
+#include "bounds.h"
+#include "scene_graph.h"
+#include "object_buffer.h"
+#include "job_system.h"
+#include "aabb_tree.h"
+#include "occlusion_culler.h"
+#include "depth_pyramid.h"
+#include "shader.h"
+
+using EntityID = uint32_t;
+constexpr EntityID InvalidEntity = UINT32_MAX;
+
+// Layout of one command for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+	GLuint count = 0;
+	GLuint instanceCount = 0;
+	GLuint firstIndex = 0;
+	GLint baseVertex = 0;
+	GLuint baseInstance = 0;
+};
+
+// Consecutive commands using the same mesh, submitted with one multi-draw call
+struct DrawBatch
+{
+	const Mesh* mesh = nullptr;
+	uint32_t firstCommand = 0;
+	uint32_t commandCount = 0;
+};
+
+// Draw range and levels of detail of one mesh for GPU culling (std430 layout, see gpu_cull.comp)
+struct GPUMeshInfo
+{
+	static constexpr uint32_t MaxLODs = 4;
+
+	uint32_t indexCount = 0;
+	uint32_t commandOffset = 0;		// First command of this mesh in indirect buffer
+	uint32_t lodCount = 1;
+	uint32_t padding = 0;
+	uint32_t lodMeshes[MaxLODs] = {};	// Level 0 is the mesh itself
+	float lodScreenSizes[MaxLODs] = {};	// Level is used below this projected size (fraction of screen height)
+};
+
+// Render objects stored as separate arrays (structure of arrays) indexed by dense object index.
+// Every system walks only the arrays it needs: transforms go over dirty objects, culling over world bounds
+// and draw-list building over visible objects. Object index is also the index into ObjectBuffer (gl_BaseInstance),
+// removal swaps the last object into the hole, so arrays stay dense. Mesh transforms are not used, only geometry
+class RenderWorld
+{
+private:
+	static constexpr uint32_t NoIndex = UINT32_MAX;
+
+	// Buffer bindings of GPU culling (ObjectBuffer is 1)
+	static constexpr GLuint MeshInfoBindingPoint = 2;
+	static constexpr GLuint CommandBindingPoint = 3;
+	static constexpr GLuint DrawCountBindingPoint = 4;
+	static constexpr GLuint CullGroupSize = 64;
+
+	// Counts of GPU culling are read back this many frames later, so reading never waits for the GPU
+	static constexpr size_t GPUStatsLatency = 3;
+
+	// Objects per job of parallel systems
+	static constexpr size_t TransformBatchSize = 4096;
+	static constexpr size_t CullBatchSize = 16384;
+	static constexpr size_t DrawListBatchSize = 16384;
+
+	// Indexed by object index
+	std::vector<glm::vec3> _positions;
+	std::vector<glm::vec3> _rotations;
+	std::vector<glm::vec3> _scales;
+	std::vector<glm::mat4> _worldMatrices;
+	std::vector<AABB> _localBounds;
+	std::vector<glm::vec4> _worldSpheres;		// xyz = center, w = radius
+	std::vector<uint32_t> _meshIds;
+	std::vector<uint8_t> _isDirty;
+	std::vector<EntityID> _entities;
+	std::vector<int32_t> _proxyIds;			// Leaf in spatial index (user data = entity ID)
+
+	// Indexed by entity ID
+	std::vector<uint32_t> _entityIndices;
+	std::vector<EntityID> _freeEntities;
+
+	// Meshes referenced by objects, draw list is grouped by mesh ID
+	std::vector<const Mesh*> _meshes;
+	std::unordered_map<const Mesh*, uint32_t> _meshIndices;
+
+	// GPU culling: every mesh owns a range of commands large enough for all objects which can select it,
+	// ranges change only when objects are created or destroyed
+	std::vector<GPUMeshInfo> _meshInfos;
+	std::vector<uint32_t> _meshObjectCounts;
+	std::vector<uint32_t> _meshCommandCapacities;
+	bool _isMeshInfoDirty = true;
+
+	// World bounds hierarchy for frustum, ray and proximity queries
+	DynamicAABBTree _spatialIndex;
+
+	// Objects whose transform changed since last updateTransforms()
+	std::vector<uint32_t> _dirtyList;
+
+	// Per frame results
+	std::vector<uint32_t> _visible;
+	std::vector<std::vector<uint32_t>> _visibleBatches;
+	std::vector<uint32_t> _sortedVisible;
+	std::vector<uint32_t> _meshOffsets;
+	std::vector<uint32_t> _meshCursors;
+	std::vector<std::vector<uint64_t>> _drawKeyBatches;
+	std::vector<size_t> _occludedBatches;
+	size_t _occludedCount = 0;
+	std::vector<uint64_t> _drawKeys;
+	std::vector<uint64_t> _drawKeysScratch;
+	std::vector<size_t> _drawKeyRuns;
+	std::vector<DrawElementsIndirectCommand> _drawCommands;
+	std::vector<DrawBatch> _drawBatches;
+
+	ObjectBuffer _objectBuffer;
+
+	GLuint _indirectBuffer = 0;
+	size_t _indirectCapacity = 0;
+
+	GLuint _meshInfoBuffer = 0;
+	GLuint _gpuCommandBuffer = 0;
+	GLuint _drawCountBuffer = 0;
+	size_t _gpuCommandCapacity = 0;
+
+	// Copies of draw counts (one per mesh, occluded count last) waiting for their fence
+	struct GPUStatsReadback
+	{
+		GLuint buffer = 0;
+		GLsync fence = nullptr;
+		size_t counterCount = 0;
+	};
+
+	GPUStatsReadback _gpuStats[GPUStatsLatency];
+	size_t _gpuStatsFrame = 0;
+	bool _isCulledOnGPU = false;
+	size_t _gpuVisibleCount = 0;
+	size_t _gpuOccludedCount = 0;
+
+public:
+	RenderWorld()
+	{
+		glGenBuffers(1, &_indirectBuffer);
+		glGenBuffers(1, &_meshInfoBuffer);
+		glGenBuffers(1, &_gpuCommandBuffer);
+		glGenBuffers(1, &_drawCountBuffer);
+
+		for (auto& stats : _gpuStats)
+		{
+			glGenBuffers(1, &stats.buffer);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, stats.buffer);
+			glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint), nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	~RenderWorld()
+	{
+		if (_indirectBuffer) glDeleteBuffers(1, &_indirectBuffer);
+		if (_meshInfoBuffer) glDeleteBuffers(1, &_meshInfoBuffer);
+		if (_gpuCommandBuffer) glDeleteBuffers(1, &_gpuCommandBuffer);
+		if (_drawCountBuffer) glDeleteBuffers(1, &_drawCountBuffer);
+
+		for (auto& stats : _gpuStats)
+		{
+			if (stats.fence) glDeleteSync(stats.fence);
+			if (stats.buffer) glDeleteBuffers(1, &stats.buffer);
+		}
+	}
+
+	RenderWorld(const RenderWorld&) = delete;
+	RenderWorld& operator=(const RenderWorld&) = delete;
+
+	size_t size() const { return _entities.size(); }
+	// Of last buildDrawList(), or of the GPU culling GPUStatsLatency frames ago when cullOnGPU() was used
+	size_t getVisibleCount() const { return _isCulledOnGPU ? _gpuVisibleCount : _visible.size(); }
+	size_t getOccludedCount() const { return _isCulledOnGPU ? _gpuOccludedCount : _occludedCount; }
+	size_t getDrawCommandCount() const { return _drawCommands.size(); }
+	size_t getDrawBatchCount() const { return _drawBatches.size(); }
+
+	bool isValid(EntityID entity) const { return entity < _entityIndices.size() && _entityIndices[entity] != NoIndex; }
+
+	void reserve(size_t count)
+	{
+		_positions.reserve(count);
+		_rotations.reserve(count);
+		_scales.reserve(count);
+		_worldMatrices.reserve(count);
+		_localBounds.reserve(count);
+		_worldSpheres.reserve(count);
+		_meshIds.reserve(count);
+		_isDirty.reserve(count);
+		_entities.reserve(count);
+		_proxyIds.reserve(count);
+		_objectBuffer.reserve(count);
+	}
+
+	// Mesh has to be indexed and outlive the entity, material index points into MaterialTable
+	EntityID createEntity(const Mesh& mesh, uint32_t materialIndex, const Transform& transform = Transform())
+	{
+		if (mesh.getIndexCount() == 0)
+		{
+			std::cerr << "ERROR::RENDER_WORLD::MESH_NOT_INDEXED" << "\n";
+			return InvalidEntity;
+		}
+
+		EntityID entity;
+		if (!_freeEntities.empty())
+		{
+			entity = _freeEntities.back();
+			_freeEntities.pop_back();
+		}
+		else
+		{
+			entity = static_cast<EntityID>(_entityIndices.size());
+			_entityIndices.push_back(NoIndex);
+		}
+
+		uint32_t index = static_cast<uint32_t>(_entities.size());
+		_entityIndices[entity] = index;
+
+		_positions.push_back(transform.position);
+		_rotations.push_back(transform.rotation);
+		_scales.push_back(transform.scale);
+		_worldMatrices.push_back(glm::mat4(1.0f));
+		_localBounds.push_back(mesh.getBounds());
+		_worldSpheres.push_back(glm::vec4(0.0f));
+		_meshIds.push_back(getMeshId(mesh));
+		_meshObjectCounts[_meshIds.back()]++;
+		_isMeshInfoDirty = true;
+		_isDirty.push_back(0);
+		_entities.push_back(entity);
+		_proxyIds.push_back(DynamicAABBTree::NullNode);
+
+		GPUObjectData objectData;
+		objectData.boundsCenter = glm::vec4(mesh.getBounds().getCenter(), 0.0f);
+		objectData.boundsExtents = glm::vec4(mesh.getBounds().getExtents(), 0.0f);
+		objectData.materialIndex = materialIndex;
+		objectData.meshIndex = _meshIds.back();
+		_objectBuffer.add(objectData);
+
+		markDirty(index);
+		return entity;
+	}
+
+	void destroyEntity(EntityID entity)
+	{
+		if (!isValid(entity))
+			return;
+
+		uint32_t index = _entityIndices[entity];
+		uint32_t last = static_cast<uint32_t>(_entities.size() - 1);
+
+		if (_proxyIds[index] != DynamicAABBTree::NullNode)
+			_spatialIndex.destroyProxy(_proxyIds[index]);
+
+		_meshObjectCounts[_meshIds[index]]--;
+		_isMeshInfoDirty = true;
+
+		// Move last object into the removed slot
+		if (index != last)
+		{
+			_positions[index] = _positions[last];
+			_rotations[index] = _rotations[last];
+			_scales[index] = _scales[last];
+			_worldMatrices[index] = _worldMatrices[last];
+			_localBounds[index] = _localBounds[last];
+			_worldSpheres[index] = _worldSpheres[last];
+			_meshIds[index] = _meshIds[last];
+			_entities[index] = _entities[last];
+			_proxyIds[index] = _proxyIds[last];
+			_entityIndices[_entities[index]] = index;
+			_objectBuffer.set(index, _objectBuffer.get(last));
+
+			if (_isDirty[last])
+			{
+				_isDirty[last] = 0;
+				markDirty(index);
+			}
+		}
+
+		_positions.pop_back();
+		_rotations.pop_back();
+		_scales.pop_back();
+		_worldMatrices.pop_back();
+		_localBounds.pop_back();
+		_worldSpheres.pop_back();
+		_meshIds.pop_back();
+		_isDirty.pop_back();
+		_entities.pop_back();
+		_proxyIds.pop_back();
+		_objectBuffer.removeLast();
+
+		_entityIndices[entity] = NoIndex;
+		_freeEntities.push_back(entity);
+	}
+
+	// Transform changes only mark the object, matrices are recomputed in updateTransforms()
+	void setPosition(EntityID entity, const glm::vec3& position) { _positions[markDirty(_entityIndices[entity])] = position; }
+	void setRotation(EntityID entity, const glm::vec3& rotation) { _rotations[markDirty(_entityIndices[entity])] = rotation; }
+	void setScale(EntityID entity, const glm::vec3& scale) { _scales[markDirty(_entityIndices[entity])] = scale; }
+	void move(EntityID entity, const glm::vec3& deltaPosition) { _positions[markDirty(_entityIndices[entity])] += deltaPosition; }
+	void rotate(EntityID entity, const glm::vec3& deltaRotation) { _rotations[markDirty(_entityIndices[entity])] += deltaRotation; }
+
+	void setMaterial(EntityID entity, uint32_t materialIndex)
+	{
+		uint32_t index = _entityIndices[entity];
+		GPUObjectData objectData = _objectBuffer.get(index);
+		objectData.materialIndex = materialIndex;
+		_objectBuffer.set(index, objectData);
+	}
+
+	// Simpler mesh drawn by GPU culling instead of the mesh when object's projected size (fraction of screen height)
+	// is below maxScreenSize. Levels can be added in any order, LOD mesh has to be indexed and outlive the world
+	void addMeshLOD(const Mesh& mesh, const Mesh& lodMesh, float maxScreenSize)
+	{
+		if (lodMesh.getIndexCount() == 0)
+		{
+			std::cerr << "ERROR::RENDER_WORLD::MESH_NOT_INDEXED" << "\n";
+			return;
+		}
+
+		uint32_t meshId = getMeshId(mesh);
+		uint32_t lodMeshId = getMeshId(lodMesh);
+		GPUMeshInfo& info = _meshInfos[meshId];
+
+		if (info.lodCount == GPUMeshInfo::MaxLODs)
+		{
+			std::cerr << "ERROR::RENDER_WORLD::TOO_MANY_LODS - at most " << GPUMeshInfo::MaxLODs << " levels per mesh" << "\n";
+			return;
+		}
+
+		// Keep levels ordered from the largest screen size
+		uint32_t level = info.lodCount++;
+		while (level > 1 && info.lodScreenSizes[level - 1] < maxScreenSize)
+		{
+			info.lodMeshes[level] = info.lodMeshes[level - 1];
+			info.lodScreenSizes[level] = info.lodScreenSizes[level - 1];
+			level--;
+		}
+
+		info.lodMeshes[level] = lodMeshId;
+		info.lodScreenSizes[level] = maxScreenSize;
+		_isMeshInfoDirty = true;
+	}
+
+	const glm::vec3& getPosition(EntityID entity) const { return _positions[_entityIndices[entity]]; }
+	const DynamicAABBTree& getSpatialIndex() const { return _spatialIndex; }
+
+	// Closest entity whose bounding sphere is hit by the ray (picking), valid after updateTransforms()
+	EntityID raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float* hitDistance = nullptr) const
+	{
+		glm::vec3 rayDirection = glm::normalize(direction);
+		EntityID closest = InvalidEntity;
+
+		_spatialIndex.queryRay(origin, rayDirection, maxDistance, [&](uint32_t entity, float)
+			{
+				const glm::vec4& sphere = _worldSpheres[_entityIndices[entity]];
+
+				// Ray and sphere intersection (ray starting inside hits at 0)
+				glm::vec3 offset = origin - glm::vec3(sphere);
+				float b = glm::dot(offset, rayDirection);
+				float c = glm::dot(offset, offset) - sphere.w * sphere.w;
+				float discriminant = b * b - c;
+
+				// Starts outside and points away, or misses
+				if ((c > 0.0f && b > 0.0f) || discriminant < 0.0f)
+					return maxDistance;
+
+				float distance = glm::max(-b - glm::sqrt(discriminant), 0.0f);
+				if (distance < maxDistance)
+				{
+					maxDistance = distance;
+					closest = entity;
+				}
+				return maxDistance;
+			});
+
+		if (hitDistance && closest != InvalidEntity)
+			*hitDistance = maxDistance;
+
+		return closest;
+	}
+
+	// Entities with bounds overlapping the sphere (proximity queries)
+	void querySphere(const glm::vec3& center, float radius, std::vector<EntityID>& result) const
+	{
+		_spatialIndex.querySphere(center, radius, [&](uint32_t entity)
+			{
+				const glm::vec4& sphere = _worldSpheres[_entityIndices[entity]];
+				if (glm::length(glm::vec3(sphere) - center) <= sphere.w + radius)
+					result.push_back(entity);
+				return true;
+			});
+	}
+
+	void queryAABB(const AABB& box, std::vector<EntityID>& result) const
+	{
+		_spatialIndex.queryAABB(box, [&](uint32_t entity)
+			{
+				uint32_t index = _entityIndices[entity];
+				if (_localBounds[index].transformed(_worldMatrices[index]).overlaps(box))
+					result.push_back(entity);
+				return true;
+			});
+	}
+	const glm::mat4& getWorldMatrix(EntityID entity) const { return _worldMatrices[_entityIndices[entity]]; }
+
+	// Transform system: recompute world matrices and bounds of changed objects only
+	void updateTransforms()
+	{
+		compactDirtyList();
+		updateTransformRange(0, _dirtyList.size());
+		commitDirtyObjects();
+	}
+
+	// Same as above, matrices are computed on worker threads
+	void updateTransforms(JobSystem& jobs)
+	{
+		compactDirtyList();
+		jobs.parallelFor(_dirtyList.size(), TransformBatchSize, [this](size_t begin, size_t end) { updateTransformRange(begin, end); });
+		commitDirtyObjects();
+	}
+
+	// Culling system: objects whose bounding sphere intersects the frustum, hidden subtrees
+	// of the spatial index are skipped as a whole
+	void cull(const Frustum& frustum)
+	{
+		_visible.clear();
+
+		_spatialIndex.queryFrustum(frustum, [this, &frustum](uint32_t entity)
+			{
+				uint32_t index = _entityIndices[entity];
+				const glm::vec4& sphere = _worldSpheres[index];
+
+				if (frustum.intersects(glm::vec3(sphere), sphere.w))
+					_visible.push_back(index);
+				return true;
+			});
+
+		// Index order keeps neighbouring objects mergeable into instances
+		std::sort(_visible.begin(), _visible.end());
+	}
+
+	// Linear scan over all objects, every batch collects its own list, lists are joined in order.
+	// With many visible objects this is faster than walking the tree
+	void cull(const Frustum& frustum, JobSystem& jobs)
+	{
+		size_t batchCount = (_worldSpheres.size() + CullBatchSize - 1) / CullBatchSize;
+		_visibleBatches.resize(batchCount);
+
+		jobs.parallelFor(_worldSpheres.size(), CullBatchSize, [this, &frustum](size_t begin, size_t end)
+			{
+				std::vector<uint32_t>& visible = _visibleBatches[begin / CullBatchSize];
+				visible.clear();
+				cullRange(frustum, begin, end, visible);
+			});
+
+		_visible.clear();
+		for (const auto& visible : _visibleBatches)
+			_visible.insert(_visible.end(), visible.begin(), visible.end());
+	}
+
+	// Draw-list system: group objects from cull() by mesh with counting sort (linear time)
+	void buildDrawList()
+	{
+		_meshOffsets.assign(_meshes.size() + 1, 0);
+		for (uint32_t index : _visible)
+			_meshOffsets[_meshIds[index] + 1]++;
+
+		for (size_t mesh = 0; mesh < _meshes.size(); ++mesh)
+			_meshOffsets[mesh + 1] += _meshOffsets[mesh];
+
+		// Stable, so objects of one mesh stay in index order
+		_sortedVisible.resize(_visible.size());
+		_meshCursors.assign(_meshOffsets.begin(), _meshOffsets.end() - 1);
+		for (uint32_t index : _visible)
+			_sortedVisible[_meshCursors[_meshIds[index]]++] = index;
+
+		packDrawCommands();
+	}
+
+	// Frame split into parallel command generation: every batch of objects is culled, gets sort keys
+	// (mesh, coarse front-to-back depth, object index) and is sorted in its own buffer on a worker thread.
+	// Sorted buffers are merged in parallel rounds, only packing of indirect commands runs serially.
+	// No GL calls are made here, the result is replayed by render() on the context thread.
+	// Objects inside the frustum are also tested against occlusion depth when a rasterized culler is given
+	void buildDrawList(const Frustum& frustum, JobSystem& jobs, const OcclusionCuller* occlusion = nullptr)
+	{
+		size_t objectCount = _worldSpheres.size();
+		size_t batchCount = (objectCount + DrawListBatchSize - 1) / DrawListBatchSize;
+		_drawKeyBatches.resize(batchCount);
+		_occludedBatches.assign(batchCount, 0);
+
+		const glm::vec4& nearPlane = frustum.planes[4];
+		float depthRange = glm::max(nearPlane.w + frustum.planes[5].w, 1e-3f);
+
+		jobs.parallelFor(objectCount, DrawListBatchSize, [this, &frustum, &nearPlane, depthRange, occlusion](size_t begin, size_t end)
+			{
+				std::vector<uint64_t>& keys = _drawKeyBatches[begin / DrawListBatchSize];
+				keys.clear();
+
+				size_t occluded = 0;
+				for (size_t i = begin; i < end; ++i)
+				{
+					const glm::vec4& sphere = _worldSpheres[i];
+					if (!frustum.intersects(glm::vec3(sphere), sphere.w))
+						continue;
+
+					if (occlusion && !occlusion->isVisible(_localBounds[i], _worldMatrices[i]))
+					{
+						occluded++;
+						continue;
+					}
+
+					// Square root spends more depth buckets close to the camera
+					float depth = glm::clamp((glm::dot(glm::vec3(nearPlane), glm::vec3(sphere)) + nearPlane.w) / depthRange, 0.0f, 1.0f);
+					uint64_t depthBucket = static_cast<uint64_t>(glm::sqrt(depth) * 255.0f);
+
+					keys.push_back((uint64_t(_meshIds[i]) << 40) | (depthBucket << 32) | i);
+				}
+
+				std::sort(keys.begin(), keys.end());
+				_occludedBatches[begin / DrawListBatchSize] = occluded;
+			});
+
+		_occludedCount = 0;
+		for (size_t occluded : _occludedBatches)
+			_occludedCount += occluded;
+
+		// Join batch buffers, each one stays a sorted run
+		_drawKeyRuns.assign(1, 0);
+		for (const auto& keys : _drawKeyBatches)
+			_drawKeyRuns.push_back(_drawKeyRuns.back() + keys.size());
+
+		_drawKeys.resize(_drawKeyRuns.back());
+		jobs.parallelFor(batchCount, 1, [this](size_t begin, size_t end)
+			{
+				for (size_t batch = begin; batch < end; ++batch)
+					std::copy(_drawKeyBatches[batch].begin(), _drawKeyBatches[batch].end(), _drawKeys.begin() + _drawKeyRuns[batch]);
+			});
+
+		mergeDrawKeyRuns(jobs);
+
+		_sortedVisible.resize(_drawKeys.size());
+		jobs.parallelFor(_drawKeys.size(), DrawListBatchSize, [this](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+					_sortedVisible[i] = static_cast<uint32_t>(_drawKeys[i]);
+			});
+
+		// Visible objects in draw order
+		_visible = _sortedVisible;
+
+		packDrawCommands();
+	}
+
+	// Upload changed object data and draw list, then issue one multi-draw per mesh.
+	// Shader has to read object data from ObjectBuffer (see vertex_shader_batched.vert) and be in use
+	void render()
+	{
+		_objectBuffer.upload();
+		_objectBuffer.bind();
+
+		if (_drawCommands.empty())
+			return;
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBuffer);
+
+		size_t bytes = _drawCommands.size() * sizeof(DrawElementsIndirectCommand);
+		if (bytes > _indirectCapacity)
+		{
+			_indirectCapacity = std::max(bytes, _indirectCapacity * 2);
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, _indirectCapacity, nullptr, GL_STREAM_DRAW);
+		}
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, bytes, _drawCommands.data());
+
+		for (const auto& batch : _drawBatches)
+		{
+			glBindVertexArray(batch.mesh->getVAO());
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(batch.firstCommand * sizeof(DrawElementsIndirectCommand)), batch.commandCount, 0);
+		}
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+	// GPU-driven alternative of cull()/buildDrawList()/render(): compute shader (gpu_cull.comp) tests every object
+	// against the frustum and the depth pyramid of the last frame (optional), selects level of detail and appends
+	// one command per surviving object into the range of its mesh. CPU work does not depend on object count.
+	// lodScale is projection_matrix[1][1], it converts distance and radius into fraction of screen height
+	void cullOnGPU(const Shader& cullShader, const Frustum& frustum, const glm::vec3& cameraPosition, float lodScale, const DepthPyramid* depthPyramid = nullptr)
+	{
+		_isCulledOnGPU = true;
+		readGPUStats();
+
+		_objectBuffer.upload();
+		_objectBuffer.bind();
+
+		if (_isMeshInfoDirty)
+			updateGPUDrawRanges();
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MeshInfoBindingPoint, _meshInfoBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CommandBindingPoint, _gpuCommandBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DrawCountBindingPoint, _drawCountBuffer);
+
+		// Counts start at zero every frame, null data clears to zero
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _drawCountBuffer);
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+		if (_entities.empty())
+		{
+			_gpuVisibleCount = _gpuOccludedCount = 0;
+			return;
+		}
+
+		cullShader.use();
+		cullShader.set("object_count", static_cast<unsigned>(_entities.size()));
+		for (int i = 0; i < 6; ++i)
+			cullShader.set("frustum_planes[" + std::to_string(i) + "]", frustum.planes[i]);
+		cullShader.set("camera_position", cameraPosition);
+		cullShader.set("lod_scale", lodScale);
+
+		bool useOcclusion = depthPyramid && depthPyramid->isValid();
+		cullShader.set("occlusion_enabled", useOcclusion);
+		if (useOcclusion)
+		{
+			depthPyramid->bind(0);
+			cullShader.set("pyramid_view_projection", depthPyramid->getViewProjection());
+			cullShader.set("pyramid_size", glm::vec2(depthPyramid->getWidth(), depthPyramid->getHeight()));
+		}
+
+		Shader::dispatch(static_cast<GLuint>((_entities.size() + CullGroupSize - 1) / CullGroupSize));
+
+		// Commands and counts are consumed as indirect draw parameters and copied for the stats
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+		copyGPUStats();
+	}
+
+	// Draw commands written by cullOnGPU(), draw count of every mesh is read by the GPU as well
+	void renderOnGPU()
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _gpuCommandBuffer);
+		glBindBuffer(GL_PARAMETER_BUFFER, _drawCountBuffer);
+
+		for (size_t meshId = 0; meshId < _meshes.size(); ++meshId)
+		{
+			if (_meshCommandCapacities[meshId] == 0)
+				continue;
+
+			glBindVertexArray(_meshes[meshId]->getVAO());
+			glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(_meshInfos[meshId].commandOffset * sizeof(DrawElementsIndirectCommand)),
+				static_cast<GLintptr>(meshId * sizeof(GLuint)), _meshCommandCapacities[meshId], 0);
+		}
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_PARAMETER_BUFFER, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+private:
+	// Command range of every mesh fits all objects whose base mesh or any of its levels is the mesh
+	void updateGPUDrawRanges()
+	{
+		_meshCommandCapacities.assign(_meshes.size(), 0);
+		for (size_t meshId = 0; meshId < _meshes.size(); ++meshId)
+		{
+			const GPUMeshInfo& info = _meshInfos[meshId];
+			for (uint32_t level = 0; level < info.lodCount; ++level)
+				_meshCommandCapacities[info.lodMeshes[level]] += _meshObjectCounts[meshId];
+		}
+
+		uint32_t commandCount = 0;
+		for (size_t meshId = 0; meshId < _meshes.size(); ++meshId)
+		{
+			_meshInfos[meshId].commandOffset = commandCount;
+			commandCount += _meshCommandCapacities[meshId];
+		}
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _meshInfoBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, _meshInfos.size() * sizeof(GPUMeshInfo), _meshInfos.data(), GL_DYNAMIC_DRAW);
+
+		// Written and read only by the GPU
+		if (commandCount > _gpuCommandCapacity)
+		{
+			_gpuCommandCapacity = std::max<size_t>(commandCount, _gpuCommandCapacity * 2);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, _gpuCommandBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, _gpuCommandCapacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+		}
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _drawCountBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, (_meshes.size() + 1) * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		_isMeshInfoDirty = false;
+	}
+
+	// Slot written GPUStatsLatency frames ago is read when its copy finished, otherwise the sample is skipped
+	void readGPUStats()
+	{
+		GPUStatsReadback& stats = _gpuStats[_gpuStatsFrame % GPUStatsLatency];
+		if (!stats.fence)
+			return;
+
+		GLenum status = glClientWaitSync(stats.fence, 0, 0);
+		glDeleteSync(stats.fence);
+		stats.fence = nullptr;
+
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			return;
+
+		std::vector<GLuint> counts(stats.counterCount);
+		glBindBuffer(GL_COPY_READ_BUFFER, stats.buffer);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, counts.size() * sizeof(GLuint), counts.data());
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+		_gpuOccludedCount = counts.back();
+		_gpuVisibleCount = 0;
+		for (size_t meshId = 0; meshId + 1 < counts.size(); ++meshId)
+			_gpuVisibleCount += counts[meshId];
+	}
+
+	void copyGPUStats()
+	{
+		GPUStatsReadback& stats = _gpuStats[_gpuStatsFrame % GPUStatsLatency];
+		_gpuStatsFrame++;
+
+		size_t size = (_meshes.size() + 1) * sizeof(GLuint);
+		if (stats.counterCount != _meshes.size() + 1)
+		{
+			stats.counterCount = _meshes.size() + 1;
+			glBindBuffer(GL_COPY_WRITE_BUFFER, stats.buffer);
+			glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_READ);
+		}
+
+		glBindBuffer(GL_COPY_READ_BUFFER, _drawCountBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, stats.buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		stats.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	// Pairs of neighbouring sorted runs are merged in parallel until one run is left
+	void mergeDrawKeyRuns(JobSystem& jobs)
+	{
+		_drawKeysScratch.resize(_drawKeys.size());
+
+		while (_drawKeyRuns.size() > 2)
+		{
+			size_t runCount = _drawKeyRuns.size() - 1;
+			size_t pairCount = (runCount + 1) / 2;
+
+			jobs.parallelFor(pairCount, 1, [this, runCount](size_t begin, size_t end)
+				{
+					for (size_t pair = begin; pair < end; ++pair)
+					{
+						size_t first = pair * 2;
+						auto output = _drawKeysScratch.begin() + _drawKeyRuns[first];
+
+						// Odd run without pair is only copied
+						if (first + 1 == runCount)
+						{
+							std::copy(_drawKeys.begin() + _drawKeyRuns[first], _drawKeys.begin() + _drawKeyRuns[first + 1], output);
+							continue;
+						}
+
+						std::merge(_drawKeys.begin() + _drawKeyRuns[first], _drawKeys.begin() + _drawKeyRuns[first + 1],
+							_drawKeys.begin() + _drawKeyRuns[first + 1], _drawKeys.begin() + _drawKeyRuns[first + 2], output);
+					}
+				});
+
+			std::vector<size_t> runs;
+			for (size_t run = 0; run < runCount; run += 2)
+				runs.push_back(_drawKeyRuns[run]);
+			runs.push_back(_drawKeyRuns.back());
+
+			_drawKeyRuns.swap(runs);
+			_drawKeys.swap(_drawKeysScratch);
+		}
+	}
+
+	// Turn visible objects sorted by mesh into indirect commands, neighbouring objects of one mesh are merged into instances
+	void packDrawCommands()
+	{
+		_drawCommands.clear();
+		_drawBatches.clear();
+
+		for (size_t i = 0; i < _sortedVisible.size(); ++i)
+		{
+			uint32_t index = _sortedVisible[i];
+			const Mesh* mesh = _meshes[_meshIds[index]];
+
+			if (_drawBatches.empty() || _drawBatches.back().mesh != mesh)
+			{
+				DrawBatch batch;
+				batch.mesh = mesh;
+				batch.firstCommand = static_cast<uint32_t>(_drawCommands.size());
+				_drawBatches.push_back(batch);
+			}
+			else
+			{
+				DrawElementsIndirectCommand& previous = _drawCommands.back();
+				if (previous.baseInstance + previous.instanceCount == index)
+				{
+					previous.instanceCount++;
+					continue;
+				}
+			}
+
+			_drawCommands.push_back({ static_cast<GLuint>(mesh->getIndexCount()), 1, 0, 0, index });
+			_drawBatches.back().commandCount++;
+		}
+	}
+
+	// Drop entries of removed objects and duplicates, so every object is updated once
+	void compactDirtyList()
+	{
+		size_t count = 0;
+		for (uint32_t index : _dirtyList)
+		{
+			if (index < _entities.size() && _isDirty[index])
+			{
+				_isDirty[index] = 0;
+				_dirtyList[count++] = index;
+			}
+		}
+		_dirtyList.resize(count);
+	}
+
+	void updateTransformRange(size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			uint32_t index = _dirtyList[i];
+
+			glm::mat4 worldMatrix = Transform::compose(_positions[index], _rotations[index], _scales[index]);
+			_worldMatrices[index] = worldMatrix;
+
+			glm::vec3 absScale = glm::abs(_scales[index]);
+			float maxScale = glm::max(absScale.x, glm::max(absScale.y, absScale.z));
+
+			const AABB& bounds = _localBounds[index];
+			glm::vec3 center = glm::vec3(worldMatrix * glm::vec4(bounds.getCenter(), 1.0f));
+			_worldSpheres[index] = glm::vec4(center, glm::length(bounds.getExtents()) * maxScale);
+		}
+	}
+
+	// Object buffer and spatial index are not thread safe, so they are updated on one thread
+	void commitDirtyObjects()
+	{
+		for (uint32_t index : _dirtyList)
+		{
+			_objectBuffer.setModelMatrix(index, _worldMatrices[index]);
+
+			// Tree changes only when object leaves its fat box
+			AABB worldBounds = _localBounds[index].transformed(_worldMatrices[index]);
+			if (_proxyIds[index] == DynamicAABBTree::NullNode)
+				_proxyIds[index] = _spatialIndex.createProxy(worldBounds, _entities[index]);
+			else
+				_spatialIndex.moveProxy(_proxyIds[index], worldBounds);
+		}
+
+		_dirtyList.clear();
+	}
+
+	void cullRange(const Frustum& frustum, size_t begin, size_t end, std::vector<uint32_t>& visible) const
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			const glm::vec4& sphere = _worldSpheres[i];
+			if (frustum.intersects(glm::vec3(sphere), sphere.w))
+				visible.push_back(static_cast<uint32_t>(i));
+		}
+	}
+
+	uint32_t getMeshId(const Mesh& mesh)
+	{
+		auto [it, inserted] = _meshIndices.try_emplace(&mesh, static_cast<uint32_t>(_meshes.size()));
+		if (inserted)
+		{
+			_meshes.push_back(&mesh);
+			_meshObjectCounts.push_back(0);
+
+			GPUMeshInfo info;
+			info.indexCount = static_cast<uint32_t>(mesh.getIndexCount());
+			info.lodMeshes[0] = it->second;
+			_meshInfos.push_back(info);
+		}
+
+		return it->second;
+	}
+
+	uint32_t markDirty(uint32_t index)
+	{
+		if (!_isDirty[index])
+		{
+			_isDirty[index] = 1;
+			_dirtyList.push_back(index);
+		}
+		return index;
+	}
+};
@@ -1,45 +1,755 @@
-#pragma once
-
-#include <map>
-#include <memory>
-#include <string>
-
-#include "shader.h"
-#include "texture.h"
-
-class ResourceManager
-{
-public:
-	static std::map<std::string, std::shared_ptr<Shader>> Shaders;
-	static std::map<std::string, std::shared_ptr<Texture>> Textures;
-
-	static std::shared_ptr<Shader> loadShader(const std::string& name, const std::string& vertexPath, const std::string& fragmentPath)
-	{
-		auto s = std::make_shared<Shader>(vertexPath, fragmentPath);
-		Shaders[name] = s;
-		return s;
-	}
-
-	static std::shared_ptr<Texture> loadTexture(const std::string& name, const std::string& texturePath, GLenum textureType = GL_TEXTURE_2D)
-	{
-		auto t = std::make_shared<Texture>(texturePath, textureType);
-		Textures[name] = t;
-		return t;
-	}
-
-	static std::shared_ptr<Shader> getShader(const std::string& name)
-	{
-		return Shaders.count(name) ? Shaders[name] : nullptr;
-	}
-
-	static std::shared_ptr<Texture> getTexture(const std::string& name)
-	{
-		return Textures.count(name) ? Textures[name] : nullptr;
-	}
-
-	static void clear()
-	{
-		Shaders.clear();
-		Textures.clear();
-	}
-};
\ No newline at end of file
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <climits>
+#include <cctype>
+#include <filesystem>
+#include <unordered_map>
+#include <array>
+#include <mutex>
+#include <shared_mutex>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iostream>
+
+#include "shader.h"
+#include "texture.h"
+#include "model.h"
+#include "thread_pool.h"
+#include "job_system.h"
+#include "async_io.h"
+#include "cooked_asset.h"
+
+// Index into resource pool plus generation of the slot, stale handles resolve to nullptr
+template<typename T>
+struct ResourceHandle
+{
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	bool isValid() const { return index != UINT32_MAX; }
+
+	bool operator==(const ResourceHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const ResourceHandle& other) const { return !(*this == other); }
+};
+
+struct ResourcePoolStats
+{
+	size_t resourceCount = 0;
+	size_t unusedCount = 0;		// Loaded but not referenced (candidates for eviction)
+	size_t usedBytes = 0;
+	size_t budgetBytes = 0;
+	size_t loads = 0;
+	size_t cacheHits = 0;
+	size_t evictions = 0;
+};
+
+// GPU memory taken by resources (used for budgets)
+inline size_t getResourceBytes(const Shader&) { return 0; }
+inline size_t getResourceBytes(const Texture& texture) { return texture.getResidentBytes(); }
+inline size_t getResourceBytes(const Model& model) { return model.getGPUBytes(); }
+
+// Slot storage with sharded canonical key lookup, reference counts and LRU list of unreferenced resources.
+// Lookups and loads can run on any thread, creation and destruction of resources happens on the context thread
+template<typename T>
+class ResourcePool
+{
+private:
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+	static constexpr size_t ShardCount = 16;
+
+	struct Slot
+	{
+		std::unique_ptr<T> resource;
+		std::string key;
+		uint32_t generation = 1;
+		uint32_t refCount = 0;
+		size_t bytes = 0;
+
+		// LRU list links (only for loaded slots with zero references)
+		uint32_t lruPrev = InvalidIndex;
+		uint32_t lruNext = InvalidIndex;
+	};
+
+	// Loaded resource or load in flight (its future is shared by every requester)
+	struct Entry
+	{
+		ResourceHandle<T> handle;
+		std::shared_future<ResourceHandle<T>> future;
+		uint32_t pendingRefs = 0;
+		bool isLoaded = false;
+	};
+
+	struct Shard
+	{
+		std::mutex mutex;
+		std::unordered_map<std::string, Entry> entries;
+	};
+
+	// Lock order: shard mutex first, then slots mutex
+	std::array<Shard, ShardCount> _shards;
+
+	mutable std::shared_mutex _slotsMutex;
+	std::vector<Slot> _slots;
+	std::vector<uint32_t> _freeSlots;
+
+	// Least recently released resource is at the head
+	uint32_t _lruHead = InvalidIndex;
+	uint32_t _lruTail = InvalidIndex;
+
+	size_t _budgetBytes = SIZE_MAX;
+	ResourcePoolStats _stats;
+	std::atomic<size_t> _cacheHits = 0;
+
+public:
+	// Budget is enforced by trim() on the context thread
+	void setBudget(size_t budgetBytes)
+	{
+		std::unique_lock<std::shared_mutex> lock(_slotsMutex);
+		_budgetBytes = budgetBytes;
+	}
+
+	// Returns future of referenced handle. loadData runs as background job, create on the context thread.
+	// Concurrent requests for the same key share one load and every request holds its own reference
+	template<typename LoadData, typename Create>
+	std::shared_future<ResourceHandle<T>> acquireAsync(const std::string& key, JobSystem& jobs, GLTaskQueue& contextQueue, LoadData loadData, Create create)
+	{
+		std::shared_future<ResourceHandle<T>> future;
+		auto promise = beginLoad(key, future);
+		if (!promise)
+			return future;
+
+		jobs.runBackground([this, key, promise, loadData, create, &contextQueue]()
+			{
+				std::shared_ptr<decltype(loadData())> data;
+				if (!runLoadStep(key, *promise, [&]() { data = std::make_shared<decltype(loadData())>(loadData()); }))
+					return;
+
+				contextQueue.push([this, key, promise, data, create]()
+					{
+						std::unique_ptr<T> resource;
+						if (runLoadStep(key, *promise, [&]() { resource = create(std::move(*data)); }))
+							finishLoad(key, std::move(resource), *promise);
+					});
+			});
+
+		return future;
+	}
+
+	// Same as acquireAsync, but the file is first read by asynchronous I/O and then decoded as background job
+	template<typename Decode, typename Create>
+	std::shared_future<ResourceHandle<T>> acquireAsyncFile(const std::string& key, const std::string& path, AsyncFileReader& reader,
+		JobSystem& jobs, GLTaskQueue& contextQueue, Decode decode, Create create)
+	{
+		std::shared_future<ResourceHandle<T>> future;
+		auto promise = beginLoad(key, future);
+		if (!promise)
+			return future;
+
+		auto decodeAndCreate = [this, key, promise, decode, create, &jobs, &contextQueue](AssetBlob&& file)
+			{
+				auto blob = std::make_shared<AssetBlob>(std::move(file));
+
+				jobs.runBackground([this, key, promise, blob, decode, create, &contextQueue]()
+					{
+						std::shared_ptr<decltype(decode(*blob))> data;
+						bool isDecoded = runLoadStep(key, *promise, [&]() { data = std::make_shared<decltype(decode(*blob))>(decode(*blob)); });
+
+						// Return I/O buffer before waiting for the context thread
+						*blob = AssetBlob();
+
+						if (!isDecoded)
+							return;
+
+						contextQueue.push([this, key, promise, data, create]()
+							{
+								std::unique_ptr<T> resource;
+								if (runLoadStep(key, *promise, [&]() { resource = create(std::move(*data)); }))
+									finishLoad(key, std::move(resource), *promise);
+							});
+					});
+			};
+
+		// Pack entries are already mapped in memory
+		if (AssetFileSystem::isInPack(path))
+			decodeAndCreate(AssetFileSystem::read(path));
+		else
+			reader.read(path, decodeAndCreate);
+
+		return future;
+	}
+
+	// Add reference to already loaded resource
+	bool acquire(ResourceHandle<T> handle)
+	{
+		std::unique_lock<std::shared_mutex> lock(_slotsMutex);
+
+		Slot* slot = getSlot(handle);
+		if (!slot)
+			return false;
+
+		if (slot->refCount++ == 0)
+			unlinkLRU(handle.index);
+
+		return true;
+	}
+
+	// Drop reference, resource stays cached until trim() has to evict it
+	void release(ResourceHandle<T> handle)
+	{
+		std::unique_lock<std::shared_mutex> lock(_slotsMutex);
+
+		Slot* slot = getSlot(handle);
+		if (!slot || slot->refCount == 0)
+			return;
+
+		if (--slot->refCount == 0)
+			linkLRU(handle.index);
+	}
+
+	// Pointer stays valid as long as the caller holds reference
+	T* get(ResourceHandle<T> handle) const
+	{
+		std::shared_lock<std::shared_mutex> lock(_slotsMutex);
+
+		const Slot* slot = getSlot(handle);
+		return slot ? slot->resource.get() : nullptr;
+	}
+
+	// Evict unused resources until usage fits the budget (context thread only)
+	void trim()
+	{
+		size_t usedBytes;
+		size_t budgetBytes;
+
+		{
+			std::unique_lock<std::shared_mutex> lock(_slotsMutex);
+			refreshBytes();
+			usedBytes = _stats.usedBytes;
+			budgetBytes = _budgetBytes;
+		}
+
+		if (usedBytes > budgetBytes)
+			evictUnused(usedBytes - budgetBytes);
+	}
+
+	// Evict every unused resource (context thread only)
+	void purgeUnused()
+	{
+		evictUnused(SIZE_MAX);
+	}
+
+	// Destroy every resource, all handles become stale (context thread only, no loads may be in flight)
+	void clear()
+	{
+		std::vector<std::unique_ptr<T>> resources;
+
+		for (auto& shard : _shards)
+		{
+			std::lock_guard<std::mutex> shardLock(shard.mutex);
+			shard.entries.clear();
+		}
+
+		{
+			std::unique_lock<std::shared_mutex> lock(_slotsMutex);
+			_freeSlots.clear();
+
+			for (uint32_t index = 0; index < _slots.size(); ++index)
+			{
+				Slot& slot = _slots[index];
+				if (slot.resource)
+					slot.generation++;
+
+				resources.push_back(std::move(slot.resource));
+				slot.key.clear();
+				slot.refCount = 0;
+				slot.bytes = 0;
+				slot.lruPrev = InvalidIndex;
+				slot.lruNext = InvalidIndex;
+				_freeSlots.push_back(index);
+			}
+
+			_lruHead = InvalidIndex;
+			_lruTail = InvalidIndex;
+			_stats.usedBytes = 0;
+			_stats.resourceCount = 0;
+		}
+	}
+
+	ResourcePoolStats getStats() const
+	{
+		std::shared_lock<std::shared_mutex> lock(_slotsMutex);
+
+		ResourcePoolStats stats = _stats;
+		stats.budgetBytes = _budgetBytes;
+		stats.cacheHits = _cacheHits;
+		stats.unusedCount = 0;
+		for (uint32_t index = _lruHead; index != InvalidIndex; index = _slots[index].lruNext)
+			stats.unusedCount++;
+		return stats;
+	}
+
+private:
+	Shard& getShard(const std::string& key)
+	{
+		return _shards[std::hash<std::string>()(key) % ShardCount];
+	}
+
+	static std::shared_future<ResourceHandle<T>> makeReadyFuture(ResourceHandle<T> handle)
+	{
+		std::promise<ResourceHandle<T>> promise;
+		promise.set_value(handle);
+		return promise.get_future().share();
+	}
+
+	// Returns promise the caller has to fulfil if it should start the load, otherwise future of cached or in flight load
+	std::shared_ptr<std::promise<ResourceHandle<T>>> beginLoad(const std::string& key, std::shared_future<ResourceHandle<T>>& future)
+	{
+		Shard& shard = getShard(key);
+		std::lock_guard<std::mutex> shardLock(shard.mutex);
+
+		auto it = shard.entries.find(key);
+		if (it != shard.entries.end())
+		{
+			Entry& entry = it->second;
+			_cacheHits++;
+
+			if (!entry.isLoaded)
+			{
+				entry.pendingRefs++;
+				future = entry.future;
+				return nullptr;
+			}
+
+			acquire(entry.handle);
+			future = makeReadyFuture(entry.handle);
+			return nullptr;
+		}
+
+		auto promise = std::make_shared<std::promise<ResourceHandle<T>>>();
+
+		Entry& entry = shard.entries[key];
+		entry.future = promise->get_future().share();
+		entry.pendingRefs = 1;
+
+		future = entry.future;
+		return promise;
+	}
+
+	// Runs on the context thread once the resource is created
+	// Loaders report errors without exceptions, but allocation failures or third party code can still throw on a worker.
+	// The load then completes with invalid handle instead of blocking its waiters forever, later requests retry it
+	template<typename Step>
+	bool runLoadStep(const std::string& key, std::promise<ResourceHandle<T>>& promise, Step step)
+	{
+		try
+		{
+			step();
+			return true;
+		}
+		catch (const std::exception& exception)
+		{
+			std::cerr << "ERROR::RESOURCE::LOAD_FAILED - " << key << ": " << exception.what() << "\n";
+		}
+		catch (...)
+		{
+			std::cerr << "ERROR::RESOURCE::LOAD_FAILED - " << key << ": unknown exception\n";
+		}
+
+		{
+			Shard& shard = getShard(key);
+			std::lock_guard<std::mutex> shardLock(shard.mutex);
+			shard.entries.erase(key);
+		}
+
+		promise.set_value(ResourceHandle<T>());
+		return false;
+	}
+
+	void finishLoad(const std::string& key, std::unique_ptr<T> resource, std::promise<ResourceHandle<T>>& promise)
+	{
+		size_t bytes = resource ? getResourceBytes(*resource) : 0;
+		ResourceHandle<T> handle;
+
+		{
+			Shard& shard = getShard(key);
+			std::lock_guard<std::mutex> shardLock(shard.mutex);
+
+			// Pool was cleared while loading
+			auto it = shard.entries.find(key);
+			if (it == shard.entries.end())
+			{
+				promise.set_value(handle);
+				return;
+			}
+
+			Entry& entry = it->second;
+
+			{
+				std::unique_lock<std::shared_mutex> lock(_slotsMutex);
+
+				uint32_t index;
+				if (!_freeSlots.empty())
+				{
+					index = _freeSlots.back();
+					_freeSlots.pop_back();
+				}
+				else
+				{
+					index = static_cast<uint32_t>(_slots.size());
+					_slots.emplace_back();
+				}
+
+				Slot& slot = _slots[index];
+				slot.resource = std::move(resource);
+				slot.key = key;
+				slot.refCount = entry.pendingRefs;
+				slot.bytes = bytes;
+
+				_stats.usedBytes += bytes;
+				_stats.resourceCount++;
+				_stats.loads++;
+
+				handle = { index, slot.generation };
+			}
+
+			entry.handle = handle;
+			entry.future = {};
+			entry.pendingRefs = 0;
+			entry.isLoaded = true;
+		}
+
+		promise.set_value(handle);
+
+		// Make room for the new resource from unused ones
+		trim();
+	}
+
+	// Sizes change after load (e.g. texture streaming changes resident mips), so they are queried again
+	// on the context thread before the budget is checked (slots mutex held exclusively)
+	void refreshBytes()
+	{
+		for (Slot& slot : _slots)
+		{
+			if (!slot.resource)
+				continue;
+
+			size_t bytes = getResourceBytes(*slot.resource);
+			_stats.usedBytes = _stats.usedBytes - slot.bytes + bytes;
+			slot.bytes = bytes;
+		}
+	}
+
+	void evictUnused(size_t bytesNeeded)
+	{
+		size_t freedBytes = 0;
+
+		while (freedBytes < bytesNeeded)
+		{
+			uint32_t index;
+			uint32_t generation;
+			std::string key;
+
+			{
+				std::shared_lock<std::shared_mutex> lock(_slotsMutex);
+				if (_lruHead == InvalidIndex)
+					return;
+
+				index = _lruHead;
+				generation = _slots[index].generation;
+				key = _slots[index].key;
+			}
+
+			std::unique_ptr<T> resource;
+
+			{
+				Shard& shard = getShard(key);
+				std::lock_guard<std::mutex> shardLock(shard.mutex);
+				std::unique_lock<std::shared_mutex> lock(_slotsMutex);
+
+				// Could have been acquired again in the meantime
+				Slot& slot = _slots[index];
+				if (slot.generation != generation || slot.refCount != 0 || !slot.resource)
+					continue;
+
+				unlinkLRU(index);
+				shard.entries.erase(key);
+
+				freedBytes += slot.bytes;
+				_stats.usedBytes -= slot.bytes;
+				_stats.resourceCount--;
+				_stats.evictions++;
+
+				// New generation invalidates all handles to the evicted resource
+				resource = std::move(slot.resource);
+				slot.key.clear();
+				slot.bytes = 0;
+				slot.generation++;
+				_freeSlots.push_back(index);
+			}
+
+			// GPU object is destroyed outside of the locks
+			resource.reset();
+		}
+	}
+
+	Slot* getSlot(ResourceHandle<T> handle)
+	{
+		if (handle.index >= _slots.size() || _slots[handle.index].generation != handle.generation || !_slots[handle.index].resource)
+			return nullptr;
+		return &_slots[handle.index];
+	}
+
+	const Slot* getSlot(ResourceHandle<T> handle) const
+	{
+		return const_cast<ResourcePool*>(this)->getSlot(handle);
+	}
+
+	void linkLRU(uint32_t index)
+	{
+		Slot& slot = _slots[index];
+		slot.lruPrev = _lruTail;
+		slot.lruNext = InvalidIndex;
+
+		if (_lruTail != InvalidIndex)
+			_slots[_lruTail].lruNext = index;
+		else
+			_lruHead = index;
+
+		_lruTail = index;
+	}
+
+	void unlinkLRU(uint32_t index)
+	{
+		Slot& slot = _slots[index];
+
+		if (slot.lruPrev != InvalidIndex)
+			_slots[slot.lruPrev].lruNext = slot.lruNext;
+		else if (_lruHead == index)
+			_lruHead = slot.lruNext;
+
+		if (slot.lruNext != InvalidIndex)
+			_slots[slot.lruNext].lruPrev = slot.lruPrev;
+		else if (_lruTail == index)
+			_lruTail = slot.lruPrev;
+
+		slot.lruPrev = InvalidIndex;
+		slot.lruNext = InvalidIndex;
+	}
+};
+
+using ShaderHandle = ResourceHandle<Shader>;
+using TextureHandle = ResourceHandle<Texture>;
+using ModelHandle = ResourceHandle<Model>;
+
+class ResourceManager
+{
+private:
+	inline static ResourcePool<Shader> _shaders;
+	inline static ResourcePool<Texture> _textures;
+	inline static ResourcePool<Model> _models;
+
+	// Constructed during static initialization, so the main thread is the default context thread
+	inline static GLTaskQueue _contextQueue;
+
+	// I/O completions queue decode jobs, so the job system has to be created first (and destroyed last)
+	static AsyncFileReader& getReader()
+	{
+		getJobSystem();
+		static AsyncFileReader reader;
+		return reader;
+	}
+
+public:
+	// Same file loaded through different (relative, differently written) paths is stored only once
+	static std::string canonicalPath(const std::string& path)
+	{
+		if (path.empty())
+			return path;
+
+		std::error_code error;
+		std::string canonical = std::filesystem::weakly_canonical(std::filesystem::path(path), error).generic_string();
+		if (error)
+			canonical = std::filesystem::path(path).lexically_normal().generic_string();
+
+#ifdef _WIN32
+		// Windows file system is case insensitive
+		std::transform(canonical.begin(), canonical.end(), canonical.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+#endif
+		return canonical;
+	}
+
+	// One scheduler for asset decoding and frame work, so loads do not oversubscribe the cores.
+	// First call has to come from the main thread, it becomes worker 0 of the job system
+	static JobSystem& getJobSystem()
+	{
+		static JobSystem jobSystem;
+		return jobSystem;
+	}
+
+	// Thread which owns the OpenGL context and calls update()
+	static void setContextThread(std::thread::id threadId = std::this_thread::get_id()) { _contextQueue.setContextThread(threadId); }
+
+	// Asynchronous loading, can be called from any thread. Files are read by asynchronous I/O and decoded by background jobs,
+	// OpenGL objects are created during update() on the context thread
+	// Cooked assets (see CookedAssets) are preferred over source files when present
+	static std::shared_future<ShaderHandle> loadShaderAsync(const std::string& vertexPath, const std::string& fragmentPath, const std::string& geometryPath = "")
+	{
+		std::string key = canonicalPath(vertexPath) + "|" + canonicalPath(fragmentPath) + "|" + canonicalPath(geometryPath);
+		return _shaders.acquireAsync(key, getJobSystem(), _contextQueue,
+			[=]()
+			{
+				return Shader::readSources(CookedAssets::resolveShaderPath(vertexPath), CookedAssets::resolveShaderPath(fragmentPath),
+					CookedAssets::resolveShaderPath(geometryPath));
+			},
+			[](ShaderSources&& sources) { return std::make_unique<Shader>(sources); });
+	}
+
+	static std::shared_future<ShaderHandle> loadComputeShaderAsync(const std::string& computePath)
+	{
+		return _shaders.acquireAsync("compute|" + canonicalPath(computePath), getJobSystem(), _contextQueue,
+			[=]() { return Shader::readComputeSource(CookedAssets::resolveShaderPath(computePath)); },
+			[](ShaderSources&& sources) { return std::make_unique<Shader>(sources); });
+	}
+
+	static std::shared_future<TextureHandle> loadTextureAsync(const std::string& texturePath, GLenum textureType = GL_TEXTURE_2D, bool streamed = false)
+	{
+		std::string key = canonicalPath(texturePath) + "|" + std::to_string(textureType) + (streamed ? "|streamed" : "");
+		auto create = [=](TextureData&& data) { return std::make_unique<Texture>(std::move(data), textureType, streamed); };
+
+		std::string cookedPath = CookedAssets::getCookedTexturePath(texturePath);
+		if (AssetFileSystem::exists(cookedPath))
+		{
+			return _textures.acquireAsyncFile(key, cookedPath, getReader(), getJobSystem(), _contextQueue,
+				[=](const AssetBlob& file)
+				{
+					TextureData data = CookedAssets::decodeTexture(file, cookedPath);
+					if (!data.isValid())
+						data = TextureData::load(texturePath, streamed && textureType == GL_TEXTURE_2D);
+					return data;
+				}, create);
+		}
+
+		return _textures.acquireAsyncFile(key, texturePath, getReader(), getJobSystem(), _contextQueue,
+			[=](const AssetBlob& file) { return TextureData::decode(file, texturePath, streamed && textureType == GL_TEXTURE_2D); }, create);
+	}
+
+	static std::shared_future<ModelHandle> loadModelAsync(const std::string& modelPath)
+	{
+		// glTF files are memory mapped on a worker instead of read by asynchronous I/O, vertex data is uploaded from the mapping
+		if (GltfLoader::isGltfPath(modelPath))
+		{
+			return _models.acquireAsync(canonicalPath(modelPath), getJobSystem(), _contextQueue,
+				[=]() { return GltfLoader::load(modelPath); }, [](GltfSceneData&& scene) { return std::make_unique<Model>(std::move(scene)); });
+		}
+
+		auto create = [](std::vector<MeshData>&& meshes) { return std::make_unique<Model>(meshes); };
+
+		std::string cookedPath = CookedAssets::getCookedMeshPath(modelPath);
+		if (AssetFileSystem::exists(cookedPath))
+		{
+			return _models.acquireAsyncFile(canonicalPath(modelPath), cookedPath, getReader(), getJobSystem(), _contextQueue,
+				[=](const AssetBlob& file)
+				{
+					// Stale cook (older vertex layout) or corrupt file, the source model still loads
+					std::vector<MeshData> meshes = CookedAssets::decodeMeshes(file, cookedPath);
+					if (meshes.empty())
+						meshes = Model::loadMeshData(modelPath);
+					return meshes;
+				}, create);
+		}
+
+		return _models.acquireAsyncFile(canonicalPath(modelPath), modelPath, getReader(), getJobSystem(), _contextQueue,
+			[=](const AssetBlob& file) { return Model::buildMeshlets(Model::parseMeshData(file, modelPath)); }, create);
+	}
+
+	// Blocking loads (CPU work still runs on job system workers, so parallel requests from other threads are not serialized)
+	static ShaderHandle loadShader(const std::string& vertexPath, const std::string& fragmentPath, const std::string& geometryPath = "")
+	{
+		return wait(loadShaderAsync(vertexPath, fragmentPath, geometryPath));
+	}
+
+	static ShaderHandle loadComputeShader(const std::string& computePath)
+	{
+		return wait(loadComputeShaderAsync(computePath));
+	}
+
+	static TextureHandle loadTexture(const std::string& texturePath, GLenum textureType = GL_TEXTURE_2D, bool streamed = false)
+	{
+		return wait(loadTextureAsync(texturePath, textureType, streamed));
+	}
+
+	static ModelHandle loadModel(const std::string& modelPath)
+	{
+		return wait(loadModelAsync(modelPath));
+	}
+
+	// Wait for asynchronous load, on the context thread pending uploads are processed meanwhile
+	template<typename HandleT>
+	static HandleT wait(const std::shared_future<HandleT>& future)
+	{
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			if (!_contextQueue.isContextThread())
+				future.wait();
+			else if (_contextQueue.execute(1) == 0)
+				std::this_thread::yield();
+		}
+
+		return future.get();
+	}
+
+	// Create GPU objects of finished loads and apply budgets, call once per frame on the context thread
+	static void update(size_t maxUploads = SIZE_MAX)
+	{
+		_contextQueue.execute(maxUploads);
+
+		_shaders.trim();
+		_textures.trim();
+		_models.trim();
+	}
+
+	// O(1) access, returns nullptr for stale handles
+	static Shader* get(ShaderHandle handle) { return _shaders.get(handle); }
+	static Texture* get(TextureHandle handle) { return _textures.get(handle); }
+	static Model* get(ModelHandle handle) { return _models.get(handle); }
+
+	// Reference counting
+	static void acquire(ShaderHandle handle) { _shaders.acquire(handle); }
+	static void acquire(TextureHandle handle) { _textures.acquire(handle); }
+	static void acquire(ModelHandle handle) { _models.acquire(handle); }
+
+	static void release(ShaderHandle handle) { _shaders.release(handle); }
+	static void release(TextureHandle handle) { _textures.release(handle); }
+	static void release(ModelHandle handle) { _models.release(handle); }
+
+	// Memory budgets for unreferenced GPU resources (least recently released are evicted first)
+	static void setTextureBudget(size_t budgetBytes) { _textures.setBudget(budgetBytes); }
+	static void setMeshBudget(size_t budgetBytes) { _models.setBudget(budgetBytes); }
+
+	static ResourcePoolStats getShaderStats() { return _shaders.getStats(); }
+	static ResourcePoolStats getTextureStats() { return _textures.getStats(); }
+	static ResourcePoolStats getMeshStats() { return _models.getStats(); }
+
+	// Evict every unused resource
+	static void purgeUnused()
+	{
+		_shaders.purgeUnused();
+		_textures.purgeUnused();
+		_models.purgeUnused();
+	}
+
+	// Has to be called before OpenGL context is destroyed (with no loads in flight)
+	static void clear()
+	{
+		_shaders.clear();
+		_textures.clear();
+		_models.clear();
+	}
+};
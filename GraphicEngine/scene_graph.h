@@ -0,0 +1,302 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <glm.hpp>
+#include <gtc/matrix_transform.hpp>
+
+using SceneNodeID = uint32_t;
+constexpr SceneNodeID InvalidSceneNode = UINT32_MAX;
+
+// Translation, rotation (Euler angles in degrees, same order as Mesh) and scale
+struct Transform
+{
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::vec3 rotation = glm::vec3(0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+
+	glm::mat4 toMatrix() const { return compose(position, rotation, scale); }
+
+	static glm::mat4 compose(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale)
+	{
+		glm::mat4 matrix = glm::translate(glm::mat4(1.0f), position);
+		matrix = glm::rotate(matrix, glm::radians(rotation.x), { 1,0,0 });
+		matrix = glm::rotate(matrix, glm::radians(rotation.y), { 0,1,0 });
+		matrix = glm::rotate(matrix, glm::radians(rotation.z), { 0,0,1 });
+		return glm::scale(matrix, scale);
+	}
+
+	// Inverse of compose for matrices without shear (shear of non-uniformly scaled hierarchies is dropped)
+	static Transform decompose(const glm::mat4& matrix)
+	{
+		Transform transform;
+		transform.position = glm::vec3(matrix[3]);
+
+		glm::vec3 axes[3] = { glm::vec3(matrix[0]), glm::vec3(matrix[1]), glm::vec3(matrix[2]) };
+		for (int i = 0; i < 3; ++i)
+		{
+			transform.scale[i] = glm::length(axes[i]);
+			axes[i] = (transform.scale[i] > 0.0f) ? axes[i] / transform.scale[i] : glm::vec3(0.0f);
+		}
+
+		// Mirroring is kept in scale, so the rest is proper rotation
+		if (glm::dot(glm::cross(axes[0], axes[1]), axes[2]) < 0.0f)
+		{
+			transform.scale.x = -transform.scale.x;
+			axes[0] = -axes[0];
+		}
+
+		// Rotation is Rx * Ry * Rz, axes[column][row]. atan2 keeps y precise near +-90 degrees where asin is not
+		float sinY = glm::clamp(axes[2][0], -1.0f, 1.0f);
+		float cosY = std::sqrt(axes[2][1] * axes[2][1] + axes[2][2] * axes[2][2]);
+		transform.rotation.y = std::atan2(sinY, cosY);
+
+		if (cosY > 1e-6f)
+		{
+			transform.rotation.x = std::atan2(-axes[2][1], axes[2][2]);
+			transform.rotation.z = std::atan2(-axes[1][0], axes[0][0]);
+		}
+		else
+		{
+			// Gimbal lock, only the sum (or difference) of x and z is defined
+			transform.rotation.x = std::atan2(sinY > 0.0f ? axes[0][1] : -axes[0][1], axes[1][1]);
+			transform.rotation.z = 0.0f;
+		}
+
+		transform.rotation = glm::degrees(transform.rotation);
+		return transform;
+	}
+};
+
+// Transform hierarchy stored in flat arrays in depth-first order: parent is always before its children
+// and every subtree is one contiguous range, so update() is a single linear pass.
+// Node IDs stay stable, array indices change when the hierarchy changes
+class SceneGraph
+{
+private:
+	static constexpr uint32_t NoParent = UINT32_MAX;
+
+	// Indexed by array position
+	std::vector<uint32_t> _parents;
+	std::vector<uint32_t> _subtreeSizes;	// Including the node itself
+	std::vector<Transform> _localTransforms;
+	std::vector<glm::mat4> _worldMatrices;
+	std::vector<uint8_t> _isDirty;
+	std::vector<SceneNodeID> _nodeIds;
+
+	// Indexed by node ID
+	std::vector<uint32_t> _nodeIndices;
+	std::vector<SceneNodeID> _freeIds;
+
+	// Nodes whose world matrix changed in last update()
+	std::vector<SceneNodeID> _updatedNodes;
+
+public:
+	SceneGraph() = default;
+
+	size_t getNodeCount() const { return _parents.size(); }
+
+	bool isValid(SceneNodeID node) const { return node < _nodeIndices.size() && _nodeIndices[node] != NoParent; }
+
+	SceneNodeID createNode(SceneNodeID parent = InvalidSceneNode, const Transform& localTransform = Transform())
+	{
+		if (parent != InvalidSceneNode && !isValid(parent))
+		{
+			std::cerr << "ERROR::SCENE_GRAPH::INVALID_PARENT" << "\n";
+			parent = InvalidSceneNode;
+		}
+
+		SceneNodeID node;
+		if (!_freeIds.empty())
+		{
+			node = _freeIds.back();
+			_freeIds.pop_back();
+		}
+		else
+		{
+			node = static_cast<SceneNodeID>(_nodeIndices.size());
+			_nodeIndices.push_back(NoParent);
+		}
+
+		// New node goes to the end of the parent's subtree (or end of the array for root nodes)
+		uint32_t parentIndex = parent == InvalidSceneNode ? NoParent : _nodeIndices[parent];
+		uint32_t index = parentIndex == NoParent ? static_cast<uint32_t>(_parents.size()) : parentIndex + _subtreeSizes[parentIndex];
+
+		_parents.insert(_parents.begin() + index, parentIndex);
+		_subtreeSizes.insert(_subtreeSizes.begin() + index, 1);
+		_localTransforms.insert(_localTransforms.begin() + index, localTransform);
+		_worldMatrices.insert(_worldMatrices.begin() + index, glm::mat4(1.0f));
+		_isDirty.insert(_isDirty.begin() + index, 1);
+		_nodeIds.insert(_nodeIds.begin() + index, node);
+
+		for (uint32_t ancestor = parentIndex; ancestor != NoParent; ancestor = _parents[ancestor])
+			_subtreeSizes[ancestor]++;
+
+		shiftParents(index + 1, index, 1);
+		reindex(index);
+		return node;
+	}
+
+	// Destroys the node together with its whole subtree
+	void destroyNode(SceneNodeID node)
+	{
+		if (!isValid(node))
+			return;
+
+		uint32_t index = _nodeIndices[node];
+		uint32_t count = _subtreeSizes[index];
+
+		for (uint32_t ancestor = _parents[index]; ancestor != NoParent; ancestor = _parents[ancestor])
+			_subtreeSizes[ancestor] -= count;
+
+		for (uint32_t i = index; i < index + count; ++i)
+		{
+			_nodeIndices[_nodeIds[i]] = NoParent;
+			_freeIds.push_back(_nodeIds[i]);
+		}
+
+		eraseRange(index, count);
+		shiftParents(index, index, -static_cast<int64_t>(count));
+		reindex(index);
+	}
+
+	// Move node with its subtree under new parent (InvalidSceneNode makes it root), local transform is kept
+	bool setParent(SceneNodeID node, SceneNodeID parent)
+	{
+		if (!isValid(node) || (parent != InvalidSceneNode && !isValid(parent)))
+			return false;
+
+		uint32_t index = _nodeIndices[node];
+		uint32_t count = _subtreeSizes[index];
+
+		// Node cannot be attached into its own subtree
+		if (parent != InvalidSceneNode && _nodeIndices[parent] >= index && _nodeIndices[parent] < index + count)
+		{
+			std::cerr << "ERROR::SCENE_GRAPH::CYCLIC_PARENT" << "\n";
+			return false;
+		}
+
+		// Cut subtree out (parents stored relative to the subtree start)
+		std::vector<uint32_t> parents(_parents.begin() + index, _parents.begin() + index + count);
+		std::vector<uint32_t> subtreeSizes(_subtreeSizes.begin() + index, _subtreeSizes.begin() + index + count);
+		std::vector<Transform> localTransforms(_localTransforms.begin() + index, _localTransforms.begin() + index + count);
+		std::vector<SceneNodeID> nodeIds(_nodeIds.begin() + index, _nodeIds.begin() + index + count);
+
+		for (uint32_t i = 1; i < count; ++i)
+			parents[i] -= index;
+
+		for (uint32_t ancestor = _parents[index]; ancestor != NoParent; ancestor = _parents[ancestor])
+			_subtreeSizes[ancestor] -= count;
+
+		eraseRange(index, count);
+		shiftParents(index, index, -static_cast<int64_t>(count));
+
+		// Insert it at the end of the new parent's subtree
+		uint32_t parentIndex = parent == InvalidSceneNode ? NoParent : _nodeIndices[parent];
+		if (parentIndex != NoParent && parentIndex > index)
+			parentIndex -= count;
+
+		uint32_t target = parentIndex == NoParent ? static_cast<uint32_t>(_parents.size()) : parentIndex + _subtreeSizes[parentIndex];
+
+		shiftParents(target, target, count);
+
+		parents[0] = parentIndex;
+		for (uint32_t i = 1; i < count; ++i)
+			parents[i] += target;
+
+		_parents.insert(_parents.begin() + target, parents.begin(), parents.end());
+		_subtreeSizes.insert(_subtreeSizes.begin() + target, subtreeSizes.begin(), subtreeSizes.end());
+		_localTransforms.insert(_localTransforms.begin() + target, localTransforms.begin(), localTransforms.end());
+		_worldMatrices.insert(_worldMatrices.begin() + target, count, glm::mat4(1.0f));
+		_isDirty.insert(_isDirty.begin() + target, count, 1);
+		_nodeIds.insert(_nodeIds.begin() + target, nodeIds.begin(), nodeIds.end());
+
+		for (uint32_t ancestor = parentIndex; ancestor != NoParent; ancestor = _parents[ancestor])
+			_subtreeSizes[ancestor] += count;
+
+		reindex(std::min(index, target));
+		return true;
+	}
+
+	SceneNodeID getParent(SceneNodeID node) const
+	{
+		uint32_t parentIndex = _parents[_nodeIndices[node]];
+		return parentIndex == NoParent ? InvalidSceneNode : _nodeIds[parentIndex];
+	}
+
+	// Local transform changes only mark the node, world matrices are recomputed in update()
+	const Transform& getLocalTransform(SceneNodeID node) const { return _localTransforms[_nodeIndices[node]]; }
+	void setLocalTransform(SceneNodeID node, const Transform& transform) { _localTransforms[markDirty(node)] = transform; }
+
+	void setPosition(SceneNodeID node, const glm::vec3& position) { _localTransforms[markDirty(node)].position = position; }
+	void setRotation(SceneNodeID node, const glm::vec3& rotation) { _localTransforms[markDirty(node)].rotation = rotation; }
+	void setScale(SceneNodeID node, const glm::vec3& scale) { _localTransforms[markDirty(node)].scale = scale; }
+	void move(SceneNodeID node, const glm::vec3& deltaPosition) { _localTransforms[markDirty(node)].position += deltaPosition; }
+	void rotate(SceneNodeID node, const glm::vec3& deltaRotation) { _localTransforms[markDirty(node)].rotation += deltaRotation; }
+
+	// Valid after update()
+	const glm::mat4& getWorldMatrix(SceneNodeID node) const { return _worldMatrices[_nodeIndices[node]]; }
+
+	const std::vector<SceneNodeID>& getUpdatedNodes() const { return _updatedNodes; }
+
+	// Recompute world matrices of dirty nodes and their descendants, clean subtrees are skipped
+	void update()
+	{
+		_updatedNodes.clear();
+
+		for (uint32_t i = 0; i < _parents.size(); ++i)
+		{
+			uint32_t parent = _parents[i];
+
+			// Parent is always processed first, so its flag already carries changes of all ancestors
+			if (parent != NoParent && _isDirty[parent])
+				_isDirty[i] = 1;
+
+			if (!_isDirty[i])
+				continue;
+
+			glm::mat4 local = _localTransforms[i].toMatrix();
+			_worldMatrices[i] = parent == NoParent ? local : _worldMatrices[parent] * local;
+			_updatedNodes.push_back(_nodeIds[i]);
+		}
+
+		std::fill(_isDirty.begin(), _isDirty.end(), 0);
+	}
+
+private:
+	uint32_t markDirty(SceneNodeID node)
+	{
+		uint32_t index = _nodeIndices[node];
+		_isDirty[index] = 1;
+		return index;
+	}
+
+	void eraseRange(uint32_t index, uint32_t count)
+	{
+		_parents.erase(_parents.begin() + index, _parents.begin() + index + count);
+		_subtreeSizes.erase(_subtreeSizes.begin() + index, _subtreeSizes.begin() + index + count);
+		_localTransforms.erase(_localTransforms.begin() + index, _localTransforms.begin() + index + count);
+		_worldMatrices.erase(_worldMatrices.begin() + index, _worldMatrices.begin() + index + count);
+		_isDirty.erase(_isDirty.begin() + index, _isDirty.begin() + index + count);
+		_nodeIds.erase(_nodeIds.begin() + index, _nodeIds.begin() + index + count);
+	}
+
+	// Parent indices at or after the threshold moved by delta (for nodes from the given position on)
+	void shiftParents(uint32_t from, uint32_t threshold, int64_t delta)
+	{
+		for (uint32_t i = from; i < _parents.size(); ++i)
+		{
+			if (_parents[i] != NoParent && _parents[i] >= threshold)
+				_parents[i] = static_cast<uint32_t>(_parents[i] + delta);
+		}
+	}
+
+	void reindex(uint32_t from)
+	{
+		for (uint32_t i = from; i < _nodeIds.size(); ++i)
+			_nodeIndices[_nodeIds[i]] = i;
+	}
+};
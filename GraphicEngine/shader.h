@@ -1,199 +1,324 @@
-#pragma once
-
-#include <string>
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <vector>
-#include <unordered_map>
-#include <type_traits>
-#include <glad.h>
-#include <fwd.hpp>
-#include <gtc/type_ptr.hpp>
-
-class Shader
-{
-private:
-	GLuint _id = 0;
-	mutable std::unordered_map<std::string, GLint> _uniformCache;
-
-public:
-	Shader(const std::string& vertexPath, const std::string& fragmentPath, const std::string& geometryPath = "")
-	{
-		GLuint vertexShader = loadShader(vertexPath, GL_VERTEX_SHADER);
-		GLuint geometryShader = 0;
-		GLuint fragmentShader = loadShader(fragmentPath, GL_FRAGMENT_SHADER);
-
-		// Only load geometry shader if a valid path was provided
-		if (!geometryPath.empty())
-			geometryShader = loadShader(geometryPath, GL_GEOMETRY_SHADER);
-
-		// Link the shaders into a program
-		_id = linkProgram(vertexShader, geometryShader, fragmentShader);
-
-		// Cleanup shader objects (but only if they were created)
-		if (vertexShader)
-			glDeleteShader(vertexShader);
-
-		if (geometryShader)
-			glDeleteShader(geometryShader);
-
-		if (fragmentShader)
-			glDeleteShader(fragmentShader);
-
-		// Validate
-		if (!_id)
-			std::cerr << "ERROR::SHADER::PROGRAM_CREATION_FAILED" << "\n";
-	}
-
-	~Shader()
-	{
-		if (_id) glDeleteProgram(_id);
-	}
-
-	void use() const
-	{
-		if (_id) glUseProgram(_id);
-	}
-
-	template<typename T>
-	void set(const std::string& name, const T& value) const
-	{
-		GLint loc = getUniformLocation(name);
-
-		if constexpr (std::is_same_v<T, int>)
-			glUniform1i(loc, value);
-
-		else if constexpr (std::is_same_v<T, bool>)
-			glUniform1i(loc, (int)value);
-
-		else if constexpr (std::is_same_v<T, float>)
-			glUniform1f(loc, value);
-
-		else if constexpr (std::is_same_v<T, glm::vec2>)
-			glUniform2fv(loc, 1, glm::value_ptr(value));
-
-		else if constexpr (std::is_same_v<T, glm::vec3>)
-			glUniform3fv(loc, 1, glm::value_ptr(value));
-
-		else if constexpr (std::is_same_v<T, glm::vec4>)
-			glUniform4fv(loc, 1, glm::value_ptr(value));
-
-		else if constexpr (std::is_same_v<T, glm::mat3>)
-			glUniformMatrix3fv(loc, 1, GL_FALSE, glm::value_ptr(value));
-
-		else if constexpr (std::is_same_v<T, glm::mat4>)
-			glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(value));
-
-		else
-			std::cerr << "ERROR::SHADER::SET_UNIFORM::UNSUPPORTED_TYPE for uniform '" << name << "'\n";
-	}
-
-private:
-	GLuint loadShader(const std::string& shaderPath, GLenum shaderType) const
-	{
-		// Read shader file
-		std::string fileContent = readFile(shaderPath);
-		if (fileContent.empty())
-		{
-			std::cerr << "ERROR::SHADER::FILE_NOT_FOUND - " << shaderPath << "\n";
-			return 0;
-		}
-
-		const GLchar* shaderCode = fileContent.c_str();
-
-		// Create shader and compile it
-		GLuint shader = glCreateShader(shaderType);
-		glShaderSource(shader, 1, &shaderCode, NULL);
-		glCompileShader(shader);
-
-		// Check compilation status
-		GLint success = 0;
-		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-
-		// If compilation failed, print log and return 0
-		if (!success)
-		{
-			GLint logLength = 0;
-			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
-
-			std::vector<GLchar> infoLog(logLength);
-			glGetShaderInfoLog(shader, logLength, NULL, infoLog.data());
-
-			std::cerr << "ERROR::SHADER::COMPILATION_FAILED - " << shaderPath << "\n" << infoLog.data() << "\n";
-
-			glDeleteShader(shader);
-			return 0;
-		}
-
-		return shader;
-	}
-
-	GLuint linkProgram(GLuint vertexShader, GLuint geometryShader, GLuint fragmentShader) const
-	{
-		// Validate shaders
-		if (vertexShader == 0 || fragmentShader == 0)
-		{
-			std::cerr << "ERROR::SHADER::LINK_PROGRAM::INVALID_SHADER" << "\n";
-			return 0;
-		}
-
-		// Create program, then attach and link shaders to it
-		GLuint program = glCreateProgram();
-
-		glAttachShader(program, vertexShader);
-		if (geometryShader != 0)
-			glAttachShader(program, geometryShader);
-		glAttachShader(program, fragmentShader);
-
-		glLinkProgram(program);
-
-		// Check for linking errors
-		GLint success = 0;
-		glGetProgramiv(program, GL_LINK_STATUS, &success);
-
-		// If linking failed, print log and return 0
-		if (!success)
-		{
-			GLint logLength = 0;
-			glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
-
-			std::vector<GLchar> infoLog(logLength);
-			glGetProgramInfoLog(program, logLength, NULL, infoLog.data());
-
-			std::cerr << "ERROR::SHADER::PROGRAM::LINK_FAILED" << "\n" << infoLog.data() << "\n";
-
-			glDeleteProgram(program);
-			return 0;
-		}
-
-		return program;
-	}
-
-	GLint getUniformLocation(const std::string& name) const
-	{
-		auto uniform = _uniformCache.find(name);
-		if (uniform != _uniformCache.end())
-			return uniform->second;
-
-		std::cout << "SHADER::GET_UNIFORM_LOCATION::CACHING - " << name << "\n";
-
-		GLint location = glGetUniformLocation(_id, name.c_str());
-		_uniformCache[name] = location;
-		return location;
-	}
-
-	std::string readFile(const std::string& filePath) const
-	{
-		std::ifstream file(filePath);
-		if (!file.is_open())
-		{
-			std::cerr << "ERROR::SHADER::READ_FILE_FAILED - " << filePath << "\n";
-			return "";
-		}
-
-		std::stringstream ss;
-		ss << file.rdbuf();
-		return ss.str();
-	}
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <unordered_map>
+#include <set>
+#include <filesystem>
+#include <type_traits>
+#include <algorithm>
+#include <initializer_list>
+#include <glad.h>
+#include <fwd.hpp>
+#include <gtc/type_ptr.hpp>
+
+#include "asset_pack.h"
+
+// Shader source code, can be read on any thread and compiled on the OpenGL context thread
+struct ShaderSources
+{
+	std::string vertexPath;
+	std::string fragmentPath;
+	std::string geometryPath;
+	std::string computePath;
+
+	std::string vertexSource;
+	std::string fragmentSource;
+	std::string geometrySource;
+	std::string computeSource;
+};
+
+class Shader
+{
+private:
+	GLuint _id = 0;
+	mutable std::unordered_map<std::string, GLint> _uniformCache;
+
+public:
+	Shader(const std::string& vertexPath, const std::string& fragmentPath, const std::string& geometryPath = "")
+		: Shader(readSources(vertexPath, fragmentPath, geometryPath)) {
+	}
+
+	explicit Shader(const ShaderSources& sources)
+	{
+		// Compute program has no other stages
+		if (!sources.computePath.empty())
+		{
+			GLuint computeShader = compileShader(sources.computeSource, sources.computePath, GL_COMPUTE_SHADER);
+			_id = linkProgram({ computeShader });
+
+			if (computeShader)
+				glDeleteShader(computeShader);
+
+			if (!_id)
+				std::cerr << "ERROR::SHADER::PROGRAM_CREATION_FAILED" << "\n";
+			return;
+		}
+
+		GLuint vertexShader = compileShader(sources.vertexSource, sources.vertexPath, GL_VERTEX_SHADER);
+		GLuint geometryShader = 0;
+		GLuint fragmentShader = compileShader(sources.fragmentSource, sources.fragmentPath, GL_FRAGMENT_SHADER);
+
+		// Only load geometry shader if a valid path was provided
+		if (!sources.geometryPath.empty())
+			geometryShader = compileShader(sources.geometrySource, sources.geometryPath, GL_GEOMETRY_SHADER);
+
+		// Link the shaders into a program
+		if (vertexShader != 0 && fragmentShader != 0)
+			_id = linkProgram({ vertexShader, geometryShader, fragmentShader });
+		else
+			std::cerr << "ERROR::SHADER::LINK_PROGRAM::INVALID_SHADER" << "\n";
+
+		// Cleanup shader objects (but only if they were created)
+		if (vertexShader)
+			glDeleteShader(vertexShader);
+
+		if (geometryShader)
+			glDeleteShader(geometryShader);
+
+		if (fragmentShader)
+			glDeleteShader(fragmentShader);
+
+		// Validate
+		if (!_id)
+			std::cerr << "ERROR::SHADER::PROGRAM_CREATION_FAILED" << "\n";
+	}
+
+	~Shader()
+	{
+		if (_id) glDeleteProgram(_id);
+	}
+
+	void use() const
+	{
+		if (_id) glUseProgram(_id);
+	}
+
+	// Read all shader files (no OpenGL calls)
+	static ShaderSources readSources(const std::string& vertexPath, const std::string& fragmentPath, const std::string& geometryPath = "")
+	{
+		ShaderSources sources;
+		sources.vertexPath = vertexPath;
+		sources.fragmentPath = fragmentPath;
+		sources.geometryPath = geometryPath;
+
+		sources.vertexSource = readFile(vertexPath);
+		sources.fragmentSource = readFile(fragmentPath);
+		if (!geometryPath.empty())
+			sources.geometrySource = readFile(geometryPath);
+
+		return sources;
+	}
+
+	// Read compute shader file (no OpenGL calls)
+	static ShaderSources readComputeSource(const std::string& computePath)
+	{
+		ShaderSources sources;
+		sources.computePath = computePath;
+		sources.computeSource = readFile(computePath);
+		return sources;
+	}
+
+	// Resolve #include "file" (relative to including file), normalize line endings.
+	// Cooked shaders are already resolved, so this only expands loose source files
+	static bool preprocess(const std::string& path, std::string& output, std::set<std::string>& includeStack)
+	{
+		std::string canonical = std::filesystem::path(path).lexically_normal().generic_string();
+		if (includeStack.count(canonical))
+		{
+			std::cerr << "ERROR::SHADER::RECURSIVE_INCLUDE - " << path << "\n";
+			return false;
+		}
+
+		AssetBlob file = AssetFileSystem::read(path);
+		if (!file.isValid())
+		{
+			std::cerr << "ERROR::SHADER::READ_FILE_FAILED - " << path << "\n";
+			return false;
+		}
+
+		includeStack.insert(canonical);
+
+		std::istringstream stream(file.toString());
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+
+			size_t directive = line.find_first_not_of(" \t");
+			if (directive != std::string::npos && line.compare(directive, 8, "#include") == 0)
+			{
+				size_t open = line.find('"', directive);
+				size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+
+				if (close == std::string::npos)
+				{
+					std::cerr << "ERROR::SHADER::INVALID_INCLUDE - " << path << ": " << line << "\n";
+					return false;
+				}
+
+				std::string includePath = (std::filesystem::path(path).parent_path() / line.substr(open + 1, close - open - 1)).generic_string();
+				if (!preprocess(includePath, output, includeStack))
+					return false;
+
+				continue;
+			}
+
+			output += line;
+			output += '\n';
+		}
+
+		includeStack.erase(canonical);
+		return true;
+	}
+
+	// Run compute program (has to be in use), results are visible to other commands only after glMemoryBarrier
+	static void dispatch(GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1)
+	{
+		glDispatchCompute(std::max(groupsX, 1u), std::max(groupsY, 1u), std::max(groupsZ, 1u));
+	}
+
+	template<typename T>
+	void set(const std::string& name, const T& value) const
+	{
+		GLint loc = getUniformLocation(name);
+
+		if constexpr (std::is_same_v<T, int>)
+			glUniform1i(loc, value);
+
+		else if constexpr (std::is_same_v<T, bool>)
+			glUniform1i(loc, (int)value);
+
+		else if constexpr (std::is_same_v<T, unsigned>)
+			glUniform1ui(loc, value);
+
+		else if constexpr (std::is_same_v<T, float>)
+			glUniform1f(loc, value);
+
+		else if constexpr (std::is_same_v<T, glm::vec2>)
+			glUniform2fv(loc, 1, glm::value_ptr(value));
+
+		else if constexpr (std::is_same_v<T, glm::vec3>)
+			glUniform3fv(loc, 1, glm::value_ptr(value));
+
+		else if constexpr (std::is_same_v<T, glm::vec4>)
+			glUniform4fv(loc, 1, glm::value_ptr(value));
+
+		else if constexpr (std::is_same_v<T, glm::mat3>)
+			glUniformMatrix3fv(loc, 1, GL_FALSE, glm::value_ptr(value));
+
+		else if constexpr (std::is_same_v<T, glm::mat4>)
+			glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(value));
+
+		else
+			std::cerr << "ERROR::SHADER::SET_UNIFORM::UNSUPPORTED_TYPE for uniform '" << name << "'\n";
+	}
+
+private:
+	GLuint compileShader(const std::string& fileContent, const std::string& shaderPath, GLenum shaderType) const
+	{
+		if (fileContent.empty())
+		{
+			std::cerr << "ERROR::SHADER::FILE_NOT_FOUND - " << shaderPath << "\n";
+			return 0;
+		}
+
+		const GLchar* shaderCode = fileContent.c_str();
+
+		// Create shader and compile it
+		GLuint shader = glCreateShader(shaderType);
+		glShaderSource(shader, 1, &shaderCode, NULL);
+		glCompileShader(shader);
+
+		// Check compilation status
+		GLint success = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+		// If compilation failed, print log and return 0
+		if (!success)
+		{
+			GLint logLength = 0;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+
+			std::vector<GLchar> infoLog(logLength);
+			glGetShaderInfoLog(shader, logLength, NULL, infoLog.data());
+
+			std::cerr << "ERROR::SHADER::COMPILATION_FAILED - " << shaderPath << "\n" << infoLog.data() << "\n";
+
+			glDeleteShader(shader);
+			return 0;
+		}
+
+		return shader;
+	}
+
+	// Zero entries are optional stages that are not present
+	GLuint linkProgram(std::initializer_list<GLuint> shaders) const
+	{
+		// Validate shaders
+		if (std::all_of(shaders.begin(), shaders.end(), [](GLuint shader) { return shader == 0; }))
+		{
+			std::cerr << "ERROR::SHADER::LINK_PROGRAM::INVALID_SHADER" << "\n";
+			return 0;
+		}
+
+		// Create program, then attach and link shaders to it
+		GLuint program = glCreateProgram();
+
+		for (GLuint shader : shaders)
+		{
+			if (shader != 0)
+				glAttachShader(program, shader);
+		}
+
+		glLinkProgram(program);
+
+		// Check for linking errors
+		GLint success = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+		// If linking failed, print log and return 0
+		if (!success)
+		{
+			GLint logLength = 0;
+			glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+
+			std::vector<GLchar> infoLog(logLength);
+			glGetProgramInfoLog(program, logLength, NULL, infoLog.data());
+
+			std::cerr << "ERROR::SHADER::PROGRAM::LINK_FAILED" << "\n" << infoLog.data() << "\n";
+
+			glDeleteProgram(program);
+			return 0;
+		}
+
+		return program;
+	}
+
+	GLint getUniformLocation(const std::string& name) const
+	{
+		auto uniform = _uniformCache.find(name);
+		if (uniform != _uniformCache.end())
+			return uniform->second;
+
+		std::cout << "SHADER::GET_UNIFORM_LOCATION::CACHING - " << name << "\n";
+
+		GLint location = glGetUniformLocation(_id, name.c_str());
+		_uniformCache[name] = location;
+		return location;
+	}
+
+	static std::string readFile(const std::string& filePath)
+	{
+		std::string source;
+		std::set<std::string> includeStack;
+		if (!preprocess(filePath, source, includeStack))
+			return "";
+
+		return source;
+	}
 };
\ No newline at end of file
@@ -0,0 +1,321 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <glad.h>
+#include <glm.hpp>
+
+#include "primitives.h"
+#include "mesh.h"
+#include "bounds.h"
+#include "shader.h"
+
+using StaticObjectID = uint32_t;
+constexpr StaticObjectID InvalidStaticObject = UINT32_MAX;
+
+struct StaticBatchStats
+{
+	size_t objectCount = 0;
+	size_t chunkCount = 0;
+	size_t drawnChunks = 0;			// During last render()
+	size_t rebuiltChunks = 0;		// During last update()
+};
+
+// Geometry which never moves, merged per material and spatial chunk into shared vertex and index buffers with
+// positions already in world space, so hundreds of props are drawn with a handful of draw calls. Objects are
+// assigned to a chunk by the center of their world bounds, chunks keep the merged bounds for frustum culling.
+// Adding or removing objects marks only their chunk, update() rebuilds marked chunks from the CPU copies
+template<typename MaterialT>
+class StaticBatcher
+{
+public:
+	// Edge of the cubic cells chunks are built from (world units)
+	static constexpr float DefaultChunkSize = 64.0f;
+
+private:
+	static constexpr uint32_t NoChunk = UINT32_MAX;
+
+	struct StaticObject
+	{
+		std::vector<Vertex> vertices;		// World space
+		std::vector<GLuint> indices;
+		AABB worldBounds;
+		uint32_t chunk = NoChunk;
+	};
+
+	struct Chunk
+	{
+		const MaterialT* material = nullptr;
+		std::vector<StaticObjectID> objects;
+		AABB bounds;
+		bool isDirty = false;
+
+		GLuint vao = 0;
+		GLuint vbo = 0;
+		GLuint ebo = 0;
+		size_t vertexCount = 0;
+		size_t indexCount = 0;
+	};
+
+	// Indexed by object ID
+	std::vector<StaticObject> _objects;
+	std::vector<StaticObjectID> _freeObjects;
+
+	std::vector<Chunk> _chunks;
+	std::map<std::pair<const MaterialT*, uint64_t>, uint32_t> _chunkIndices;
+	std::vector<uint32_t> _dirtyChunks;
+	std::vector<uint32_t> _visibleChunks;
+
+	float _chunkSize = DefaultChunkSize;
+	StaticBatchStats _stats;
+
+public:
+	explicit StaticBatcher(float chunkSize = DefaultChunkSize)
+		: _chunkSize(std::max(chunkSize, 1e-3f)) {
+	}
+
+	~StaticBatcher()
+	{
+		for (auto& chunk : _chunks)
+			releaseBuffers(chunk);
+	}
+
+	StaticBatcher(const StaticBatcher&) = delete;
+	StaticBatcher& operator=(const StaticBatcher&) = delete;
+
+	bool isValid(StaticObjectID object) const { return object < _objects.size() && _objects[object].chunk != NoChunk; }
+	const StaticBatchStats& getStats() const { return _stats; }
+
+	// Vertices in all chunks (drawn or not)
+	size_t getVertexCount() const
+	{
+		size_t total = 0;
+		for (const auto& chunk : _chunks)
+			total += chunk.vertexCount;
+		return total;
+	}
+
+	// Copies geometry transformed by model matrix, material has to outlive the batcher
+	StaticObjectID add(const Primitive& geometry, const MaterialT& material, const glm::mat4& modelMatrix)
+	{
+		return add(geometry.getVertices(), geometry.getIndices(), material, modelMatrix);
+	}
+
+	StaticObjectID add(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, const MaterialT& material, const glm::mat4& modelMatrix)
+	{
+		if (vertices.empty() || indices.size() < 3)
+			return InvalidStaticObject;
+
+		StaticObjectID id;
+		if (!_freeObjects.empty())
+		{
+			id = _freeObjects.back();
+			_freeObjects.pop_back();
+		}
+		else
+		{
+			id = static_cast<StaticObjectID>(_objects.size());
+			_objects.emplace_back();
+		}
+
+		StaticObject& object = _objects[id];
+		object.indices = indices;
+		object.vertices.resize(vertices.size());
+		object.worldBounds = AABB();
+
+		// Normals follow the inverse transpose, so non-uniform scale keeps them perpendicular
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
+		float handedness = (glm::determinant(glm::mat3(modelMatrix)) < 0.0f) ? -1.0f : 1.0f;
+
+		for (size_t v = 0; v < vertices.size(); ++v)
+		{
+			Vertex vertex = vertices[v];
+			vertex.position = glm::vec3(modelMatrix * glm::vec4(vertex.position, 1.0f));
+
+			glm::vec3 normal = normalMatrix * vertex.normal;
+			float length = glm::length(normal);
+			vertex.normal = (length > 0.0f) ? normal / length : vertex.normal;
+
+			// Tangents follow the surface, mirroring flips the bitangent
+			if (vertex.tangent != 0)
+			{
+				glm::vec4 tangent = unpackTangent(vertex.tangent);
+				glm::vec3 transformed = glm::mat3(modelMatrix) * glm::vec3(tangent);
+				float tangentLength = glm::length(transformed);
+				if (tangentLength > 0.0f)
+					vertex.tangent = packTangent(transformed / tangentLength, tangent.w * handedness);
+			}
+
+			object.vertices[v] = vertex;
+			object.worldBounds.expand(vertex.position);
+		}
+
+		object.chunk = findChunk(material, object.worldBounds.getCenter());
+		_chunks[object.chunk].objects.push_back(id);
+		markDirty(object.chunk);
+
+		_stats.objectCount++;
+		return id;
+	}
+
+	void remove(StaticObjectID id)
+	{
+		if (!isValid(id))
+			return;
+
+		StaticObject& object = _objects[id];
+		std::vector<StaticObjectID>& chunkObjects = _chunks[object.chunk].objects;
+		chunkObjects.erase(std::find(chunkObjects.begin(), chunkObjects.end(), id));
+		markDirty(object.chunk);
+
+		object = StaticObject();
+		_freeObjects.push_back(id);
+		_stats.objectCount--;
+	}
+
+	// Rebuilds buffers of chunks changed since last update, has to be called on the OpenGL context thread
+	void update()
+	{
+		_stats.rebuiltChunks = _dirtyChunks.size();
+
+		for (uint32_t chunkIndex : _dirtyChunks)
+			rebuild(_chunks[chunkIndex]);
+		_dirtyChunks.clear();
+
+		_stats.chunkCount = 0;
+		for (const auto& chunk : _chunks)
+			_stats.chunkCount += chunk.indexCount > 0;
+	}
+
+	// Draws chunks in the frustum, sorted by material so every material is applied once
+	void render(Shader& shader, const Frustum& frustum)
+	{
+		_visibleChunks.clear();
+		for (uint32_t chunkIndex = 0; chunkIndex < _chunks.size(); ++chunkIndex)
+		{
+			const Chunk& chunk = _chunks[chunkIndex];
+			if (chunk.indexCount > 0 && frustum.intersects(chunk.bounds))
+				_visibleChunks.push_back(chunkIndex);
+		}
+
+		_stats.drawnChunks = _visibleChunks.size();
+		if (_visibleChunks.empty())
+			return;
+
+		std::sort(_visibleChunks.begin(), _visibleChunks.end(),
+			[&](uint32_t a, uint32_t b) { return std::less<const MaterialT*>()(_chunks[a].material, _chunks[b].material); });
+
+		// Positions are in world space already
+		shader.use();
+		shader.set("model_matrix", glm::mat4(1.0f));
+
+		const MaterialT* appliedMaterial = nullptr;
+		for (uint32_t chunkIndex : _visibleChunks)
+		{
+			const Chunk& chunk = _chunks[chunkIndex];
+			if (chunk.material != appliedMaterial)
+			{
+				chunk.material->apply(shader);
+				appliedMaterial = chunk.material;
+			}
+
+			glBindVertexArray(chunk.vao);
+			glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(chunk.indexCount), GL_UNSIGNED_INT, nullptr);
+		}
+
+		glBindVertexArray(0);
+	}
+
+private:
+	uint32_t findChunk(const MaterialT& material, const glm::vec3& position)
+	{
+		// 21 bits per axis, cells around the origin
+		glm::ivec3 cell = glm::ivec3(glm::floor(position / _chunkSize));
+		glm::uvec3 biased = glm::uvec3(glm::clamp(cell + (1 << 20), glm::ivec3(0), glm::ivec3((1 << 21) - 1)));
+		uint64_t cellKey = (uint64_t(biased.x) << 42) | (uint64_t(biased.y) << 21) | uint64_t(biased.z);
+
+		auto [it, inserted] = _chunkIndices.try_emplace({ &material, cellKey }, static_cast<uint32_t>(_chunks.size()));
+		if (inserted)
+		{
+			_chunks.emplace_back();
+			_chunks.back().material = &material;
+		}
+
+		return it->second;
+	}
+
+	void markDirty(uint32_t chunkIndex)
+	{
+		if (_chunks[chunkIndex].isDirty)
+			return;
+
+		_chunks[chunkIndex].isDirty = true;
+		_dirtyChunks.push_back(chunkIndex);
+	}
+
+	void rebuild(Chunk& chunk)
+	{
+		chunk.isDirty = false;
+		chunk.bounds = AABB();
+
+		std::vector<Vertex> vertices;
+		std::vector<GLuint> indices;
+
+		for (StaticObjectID id : chunk.objects)
+		{
+			const StaticObject& object = _objects[id];
+			GLuint baseVertex = static_cast<GLuint>(vertices.size());
+
+			vertices.insert(vertices.end(), object.vertices.begin(), object.vertices.end());
+			for (GLuint index : object.indices)
+				indices.push_back(baseVertex + index);
+
+			chunk.bounds.expand(object.worldBounds);
+		}
+
+		chunk.vertexCount = vertices.size();
+		chunk.indexCount = indices.size();
+
+		if (indices.empty())
+		{
+			releaseBuffers(chunk);
+			return;
+		}
+
+		if (!chunk.vao)
+			createBuffers(chunk);
+
+		glBindVertexArray(chunk.vao);
+		glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+		glBindVertexArray(0);
+	}
+
+	static void createBuffers(Chunk& chunk)
+	{
+		glGenVertexArrays(1, &chunk.vao);
+		glBindVertexArray(chunk.vao);
+
+		glGenBuffers(1, &chunk.vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+
+		glGenBuffers(1, &chunk.ebo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk.ebo);
+
+		Vertex::setupAttributes();
+
+		glBindVertexArray(0);
+	}
+
+	static void releaseBuffers(Chunk& chunk)
+	{
+		if (chunk.vao) glDeleteVertexArrays(1, &chunk.vao);
+		if (chunk.vbo) glDeleteBuffers(1, &chunk.vbo);
+		if (chunk.ebo) glDeleteBuffers(1, &chunk.ebo);
+		chunk.vao = chunk.vbo = chunk.ebo = 0;
+	}
+};
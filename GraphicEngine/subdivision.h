@@ -0,0 +1,565 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <glm.hpp>
+
+#include "asset_pack.h"
+#include "vertex.h"
+#include "half_edge.h"
+#include "job_system.h"
+
+// Implementation part of tiny_obj_loader.h has no include guard, it is compiled once through model.h (libs.h)
+#ifndef TINY_OBJ_LOADER_H_
+#include "tiny_obj_loader.h"
+#endif
+
+// Control cage of a subdivision surface: polygons with per corner texture coordinates and sharp edges
+struct SubdivisionCage
+{
+	// Sharpness at which an edge stays sharp at every level
+	static constexpr float InfiniteSharpness = 10.0f;
+
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> faceSizes;
+	std::vector<uint32_t> faceVertices;
+	std::vector<glm::vec2> cornerTextureCoords;		// Same order as face vertices
+
+	// Every level of subdivision lowers sharpness by one, edge is smooth from the level it reaches zero
+	std::vector<glm::uvec2> creaseEdges;
+	std::vector<float> creaseSharpness;
+
+	// Polygons are kept as they are, "t crease 2/1/0 a b sharpness" tags mark creases (zero based vertex indices)
+	static bool parseObj(const AssetBlob& file, const std::string& filepath, SubdivisionCage& cage)
+	{
+		cage = SubdivisionCage();
+
+		if (!file.isValid())
+		{
+			std::cerr << "ERROR::SUBDIVISION::READ_CAGE_FAILED - " << filepath << "\n";
+			return false;
+		}
+
+		tinyobj::attrib_t vertexAttributes;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+
+		MemoryStreamBuffer buffer(file.data(), file.size());
+		std::istream stream(&buffer);
+
+		if (!tinyobj::LoadObj(&vertexAttributes, &shapes, &materials, &warn, &err, &stream, nullptr, false))
+		{
+			std::cerr << "ERROR::SUBDIVISION::PARSE_CAGE_FAILED - " << filepath << " " << err << "\n";
+			return false;
+		}
+
+		size_t vertexCount = vertexAttributes.vertices.size() / 3;
+		cage.positions.resize(vertexCount);
+		std::memcpy(cage.positions.data(), vertexAttributes.vertices.data(), vertexCount * sizeof(glm::vec3));
+
+		for (const auto& shape : shapes)
+		{
+			size_t corner = 0;
+			for (unsigned char faceSize : shape.mesh.num_face_vertices)
+			{
+				cage.faceSizes.push_back(faceSize);
+				for (unsigned char i = 0; i < faceSize; ++i, ++corner)
+				{
+					const tinyobj::index_t& index = shape.mesh.indices[corner];
+					cage.faceVertices.push_back(static_cast<uint32_t>(index.vertex_index));
+
+					glm::vec2 textureCoord(0.0f);
+					if (index.texcoord_index >= 0)
+						textureCoord = { vertexAttributes.texcoords[2 * index.texcoord_index], vertexAttributes.texcoords[2 * index.texcoord_index + 1] };
+					cage.cornerTextureCoords.push_back(textureCoord);
+				}
+			}
+
+			for (const auto& tag : shape.mesh.tags)
+			{
+				if (tag.name != "crease" || tag.intValues.size() < 2 || tag.floatValues.empty())
+					continue;
+
+				// Pairs of vertices with one sharpness, or one sharpness per edge of a vertex chain
+				for (size_t i = 0; i + 1 < tag.intValues.size(); ++i)
+				{
+					cage.creaseEdges.push_back({ static_cast<uint32_t>(tag.intValues[i]), static_cast<uint32_t>(tag.intValues[i + 1]) });
+					cage.creaseSharpness.push_back(tag.floatValues[std::min(i, tag.floatValues.size() - 1)]);
+				}
+			}
+		}
+
+		if (cage.faceSizes.empty())
+		{
+			std::cerr << "ERROR::SUBDIVISION::EMPTY_CAGE - " << filepath << "\n";
+			return false;
+		}
+
+		return true;
+	}
+};
+
+struct StencilEntry
+{
+	uint32_t index;
+	float weight;
+};
+
+// Sparse matrix in compressed rows, row i is sum of weights[k] * source[indices[k]] for k in [offsets[i], offsets[i + 1])
+struct StencilTable
+{
+	std::vector<uint32_t> offsets = { 0 };
+	std::vector<uint32_t> indices;
+	std::vector<float> weights;
+
+	size_t getRowCount() const { return offsets.size() - 1; }
+
+	void apply(const glm::vec3* source, glm::vec3* result, size_t begin, size_t end) const
+	{
+		for (size_t row = begin; row < end; ++row)
+		{
+			glm::vec3 sum(0.0f);
+			for (uint32_t k = offsets[row]; k < offsets[row + 1]; ++k)
+				sum += weights[k] * source[indices[k]];
+			result[row] = sum;
+		}
+	}
+};
+
+// Catmull-Clark subdivision surface refined uniformly up to the maximum level when built.
+// Every level keeps stencils from the cage to its vertices, so evaluating a level after the cage moved (animation)
+// is one sparse matrix multiply, followed by normals and the drawn vertices. All passes run on the job system when one is given.
+// Supports polygons of any size, boundaries and semi-sharp creases (edge and vertex rules blend by fractional
+// sharpness). Texture coordinates are interpolated linearly per face, so seams in the cage stay seams
+class SubdivisionSurface
+{
+public:
+	static constexpr int DefaultMaxLevel = 4;
+
+private:
+	static constexpr size_t BatchSize = 1024;
+	static constexpr uint32_t MaxValence = 64;		// Further edges of a vertex are ignored
+
+	struct Level
+	{
+		HalfEdgeMesh topology;
+		std::vector<float> edgeSharpness;
+		std::vector<glm::vec2> cornerTextureCoords;		// Per half-edge
+		StencilTable stencils;							// Cage vertices to vertices of this level
+
+		// Drawn vertices are unique pairs of level vertex and texture coordinate
+		std::vector<uint32_t> drawVertices;
+		std::vector<glm::vec2> drawTextureCoords;
+		std::vector<uint32_t> indices;
+	};
+
+	std::vector<Level> _levels;
+	size_t _cageVertexCount = 0;
+
+	// Evaluation scratch
+	std::vector<glm::vec3> _positions;
+	std::vector<glm::vec3> _faceNormals;
+	std::vector<glm::vec3> _normals;
+
+public:
+	SubdivisionSurface() = default;
+
+	bool isValid() const { return !_levels.empty(); }
+	int getMaxLevel() const { return static_cast<int>(_levels.size()) - 1; }
+	size_t getCageVertexCount() const { return _cageVertexCount; }
+
+	size_t getVertexCount(int level) const { return _levels[level].drawVertices.size(); }
+	const std::vector<uint32_t>& getIndices(int level) const { return _levels[level].indices; }
+	const HalfEdgeMesh& getTopology(int level) const { return _levels[level].topology; }
+	const StencilTable& getStencils(int level) const { return _levels[level].stencils; }
+
+	// Refines the cage to every level up to maxLevel (each level has 4 times more faces)
+	bool build(const SubdivisionCage& cage, JobSystem* jobSystem = nullptr, int maxLevel = DefaultMaxLevel)
+	{
+		_levels.clear();
+		_cageVertexCount = cage.positions.size();
+
+		for (uint32_t vertex : cage.faceVertices)
+		{
+			if (vertex >= _cageVertexCount)
+			{
+				std::cerr << "ERROR::SUBDIVISION::INVALID_CAGE - vertex index out of range\n";
+				return false;
+			}
+		}
+
+		Level& base = _levels.emplace_back();
+		base.topology = HalfEdgeMesh::fromPolygons(_cageVertexCount, cage.faceSizes, cage.faceVertices, jobSystem);
+		base.cornerTextureCoords = cage.cornerTextureCoords;
+		base.cornerTextureCoords.resize(base.topology.getHalfEdgeCount(), glm::vec2(0.0f));
+		base.edgeSharpness.assign(base.topology.getEdgeCount(), 0.0f);
+		applyCreases(base, cage);
+
+		for (uint32_t v = 0; v < _cageVertexCount; ++v)
+		{
+			base.stencils.indices.push_back(v);
+			base.stencils.weights.push_back(1.0f);
+			base.stencils.offsets.push_back(v + 1);
+		}
+
+		for (int level = 1; level <= maxLevel; ++level)
+		{
+			Level child = refine(_levels.back(), jobSystem);
+			_levels.push_back(std::move(child));
+		}
+
+		for (auto& level : _levels)
+			buildDrawData(level);
+
+		return true;
+	}
+
+	// Fills vertices of the level from cage positions (normals are averaged face normals of the level)
+	void evaluate(int level, const std::vector<glm::vec3>& cagePositions, std::vector<Vertex>& vertices, JobSystem* jobSystem = nullptr)
+	{
+		const Level& data = _levels[level];
+		const HalfEdgeMesh& topology = data.topology;
+
+		_positions.resize(topology.getVertexCount());
+		forEach(jobSystem, _positions.size(), [&](size_t begin, size_t end)
+			{
+				data.stencils.apply(cagePositions.data(), _positions.data(), begin, end);
+			});
+
+		topology.computeVertexNormals(_positions.data(), _faceNormals, _normals, jobSystem);
+
+		vertices.resize(data.drawVertices.size());
+		forEach(jobSystem, vertices.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					uint32_t v = data.drawVertices[i];
+					vertices[i] = { _positions[v], _normals[v], glm::vec3(1.0f), data.drawTextureCoords[i] };
+				}
+			});
+	}
+
+private:
+	// Serial without job system
+	template<typename Function>
+	static void forEach(JobSystem* jobSystem, size_t count, const Function& function)
+	{
+		if (jobSystem)
+			jobSystem->parallelFor(count, BatchSize, function);
+		else if (count > 0)
+			function(size_t(0), count);
+	}
+
+	static void applyCreases(Level& level, const SubdivisionCage& cage)
+	{
+		const HalfEdgeMesh& topology = level.topology;
+
+		for (size_t i = 0; i < cage.creaseEdges.size(); ++i)
+		{
+			uint32_t a = cage.creaseEdges[i].x, b = cage.creaseEdges[i].y;
+			if (a >= topology.getVertexCount() || b >= topology.getVertexCount())
+				continue;
+
+			for (uint32_t h : topology.getOutgoing(a))
+			{
+				if (topology.getTarget(h) == b || topology.getOrigin(topology.getPrev(h)) == b)
+				{
+					uint32_t edge = topology.getEdge(topology.getTarget(h) == b ? h : topology.getPrev(h));
+					level.edgeSharpness[edge] = std::max(cage.creaseSharpness[i], 0.0f);
+					break;
+				}
+			}
+		}
+	}
+
+	// Rows are computed in parallel batches and concatenated, rowFunction(row, entries) appends weights of one row
+	template<typename RowFunction>
+	static StencilTable buildStencils(size_t rowCount, JobSystem* jobSystem, const RowFunction& rowFunction)
+	{
+		std::vector<StencilTable> batches((rowCount + BatchSize - 1) / BatchSize);
+
+		forEach(jobSystem, rowCount, [&](size_t begin, size_t end)
+			{
+				StencilTable& batch = batches[begin / BatchSize];
+				std::vector<StencilEntry> entries;
+
+				for (size_t row = begin; row < end; ++row)
+				{
+					entries.clear();
+					rowFunction(static_cast<uint32_t>(row), entries);
+
+					// Merge weights of the same source vertex
+					std::sort(entries.begin(), entries.end(), [](const StencilEntry& a, const StencilEntry& b) { return a.index < b.index; });
+					for (size_t i = 0; i < entries.size();)
+					{
+						StencilEntry merged = entries[i++];
+						while (i < entries.size() && entries[i].index == merged.index)
+							merged.weight += entries[i++].weight;
+
+						if (merged.weight != 0.0f)
+						{
+							batch.indices.push_back(merged.index);
+							batch.weights.push_back(merged.weight);
+						}
+					}
+
+					batch.offsets.push_back(static_cast<uint32_t>(batch.indices.size()));
+				}
+			});
+
+		StencilTable table;
+		table.offsets.reserve(rowCount + 1);
+		for (const auto& batch : batches)
+		{
+			uint32_t base = static_cast<uint32_t>(table.indices.size());
+			for (size_t i = 1; i < batch.offsets.size(); ++i)
+				table.offsets.push_back(base + batch.offsets[i]);
+
+			table.indices.insert(table.indices.end(), batch.indices.begin(), batch.indices.end());
+			table.weights.insert(table.weights.end(), batch.weights.begin(), batch.weights.end());
+		}
+
+		return table;
+	}
+
+	// Child vertices are parent vertex points, then edge points, then face points.
+	// Corner h of a parent face becomes child quad h (vertex point, edge point, face point, previous edge point)
+	static Level refine(const Level& parent, JobSystem* jobSystem)
+	{
+		const HalfEdgeMesh& topology = parent.topology;
+		uint32_t vertexCount = static_cast<uint32_t>(topology.getVertexCount());
+		uint32_t edgeCount = static_cast<uint32_t>(topology.getEdgeCount());
+		uint32_t faceCount = static_cast<uint32_t>(topology.getFaceCount());
+		uint32_t halfEdgeCount = static_cast<uint32_t>(topology.getHalfEdgeCount());
+
+		auto sharpness = [&](uint32_t edge)
+			{
+				return topology.isBoundaryEdge(edge) ? SubdivisionCage::InfiniteSharpness : parent.edgeSharpness[edge];
+			};
+
+		auto addFacePoint = [&](uint32_t face, float weight, std::vector<StencilEntry>& entries)
+			{
+				uint32_t first = topology.getFaceHalfEdge(face), size = topology.getFaceSize(face);
+				for (uint32_t h = first; h < first + size; ++h)
+					entries.push_back({ topology.getOrigin(h), weight / size });
+			};
+
+		auto addEdgePoint = [&](uint32_t edge, std::vector<StencilEntry>& entries)
+			{
+				uint32_t h = topology.getEdgeHalfEdge(edge);
+				float sharpWeight = std::clamp(sharpness(edge), 0.0f, 1.0f);
+				float endpointWeight = 0.5f * sharpWeight + 0.25f * (1.0f - sharpWeight);
+
+				entries.push_back({ topology.getOrigin(h), endpointWeight });
+				entries.push_back({ topology.getTarget(h), endpointWeight });
+
+				if (sharpWeight < 1.0f)
+				{
+					addFacePoint(topology.getFace(h), 0.25f * (1.0f - sharpWeight), entries);
+					addFacePoint(topology.getFace(topology.getTwin(h)), 0.25f * (1.0f - sharpWeight), entries);
+				}
+			};
+
+		auto addVertexPoint = [&](uint32_t vertex, std::vector<StencilEntry>& entries)
+			{
+				auto outgoing = topology.getOutgoing(vertex);
+				if (outgoing.empty())
+				{
+					entries.push_back({ vertex, 1.0f });
+					return;
+				}
+
+				// Incident edges with their other endpoint, incoming boundary edges have no outgoing half-edge
+				struct IncidentEdge { uint32_t edge, other; };
+				IncidentEdge edges[MaxValence];
+				uint32_t n = 0;
+				for (uint32_t h : outgoing)
+				{
+					uint32_t prev = topology.getPrev(h);
+					if (n < MaxValence)
+						edges[n++] = { topology.getEdge(h), topology.getTarget(h) };
+					if (topology.isBoundary(prev) && n < MaxValence)
+						edges[n++] = { topology.getEdge(prev), topology.getOrigin(prev) };
+				}
+
+				auto countSharp = [&](float threshold)
+					{
+						uint32_t count = 0;
+						for (uint32_t i = 0; i < n; ++i)
+							count += sharpness(edges[i].edge) > threshold;
+						return count;
+					};
+
+				// Smooth (fewer than 2 sharp edges), crease (2) or corner (more), sharp means above threshold
+				auto addRule = [&](uint32_t sharpCount, float threshold, float weight)
+					{
+						if (sharpCount < 2)
+						{
+							float edgeWeight = weight / (float(n) * n);
+							entries.push_back({ vertex, weight * (n - 2.0f) / n });
+							for (uint32_t i = 0; i < n; ++i)
+								entries.push_back({ edges[i].other, edgeWeight });
+							for (uint32_t h : outgoing)
+								addFacePoint(topology.getFace(h), edgeWeight, entries);
+						}
+						else if (sharpCount == 2)
+						{
+							entries.push_back({ vertex, weight * 0.75f });
+							for (uint32_t i = 0; i < n; ++i)
+							{
+								if (sharpness(edges[i].edge) > threshold)
+									entries.push_back({ edges[i].other, weight * 0.125f });
+							}
+						}
+						else
+						{
+							entries.push_back({ vertex, weight });
+						}
+					};
+
+				auto ruleOf = [](uint32_t sharpCount) { return std::min(sharpCount, 3u) == 1 ? 0u : std::min(sharpCount, 3u); };
+
+				uint32_t parentCount = countSharp(0.0f);
+				uint32_t childCount = countSharp(1.0f);
+				if (ruleOf(parentCount) == ruleOf(childCount))
+				{
+					addRule(parentCount, 0.0f, 1.0f);
+					return;
+				}
+
+				// Semi-sharp edges turn smooth during this step, blend by their average sharpness
+				float fraction = 0.0f;
+				for (uint32_t i = 0; i < n; ++i)
+				{
+					float s = sharpness(edges[i].edge);
+					if (s > 0.0f)
+						fraction += std::min(s, 1.0f);
+				}
+				fraction /= parentCount;
+
+				addRule(parentCount, 0.0f, fraction);
+				addRule(childCount, 1.0f, 1.0f - fraction);
+			};
+
+		Level child;
+		StencilTable local = buildStencils(vertexCount + edgeCount + faceCount, jobSystem, [&](uint32_t row, std::vector<StencilEntry>& entries)
+			{
+				if (row < vertexCount)
+					addVertexPoint(row, entries);
+				else if (row < vertexCount + edgeCount)
+					addEdgePoint(row - vertexCount, entries);
+				else
+					addFacePoint(row - vertexCount - edgeCount, 1.0f, entries);
+			});
+
+		std::vector<glm::vec2> faceTextureCoords(faceCount, glm::vec2(0.0f));
+		for (uint32_t h = 0; h < halfEdgeCount; ++h)
+			faceTextureCoords[topology.getFace(h)] += parent.cornerTextureCoords[h] / float(topology.getFaceSize(topology.getFace(h)));
+
+		std::vector<uint32_t> faceSizes(halfEdgeCount, 4);
+		std::vector<uint32_t> faceVertices(halfEdgeCount * 4);
+		child.cornerTextureCoords.resize(halfEdgeCount * 4);
+
+		forEach(jobSystem, halfEdgeCount, [&](size_t begin, size_t end)
+			{
+				for (uint32_t h = static_cast<uint32_t>(begin); h < end; ++h)
+				{
+					uint32_t next = topology.getNext(h), prev = topology.getPrev(h);
+					const auto& textureCoords = parent.cornerTextureCoords;
+
+					faceVertices[4 * h + 0] = topology.getOrigin(h);
+					faceVertices[4 * h + 1] = vertexCount + topology.getEdge(h);
+					faceVertices[4 * h + 2] = vertexCount + edgeCount + topology.getFace(h);
+					faceVertices[4 * h + 3] = vertexCount + topology.getEdge(prev);
+
+					child.cornerTextureCoords[4 * h + 0] = textureCoords[h];
+					child.cornerTextureCoords[4 * h + 1] = 0.5f * (textureCoords[h] + textureCoords[next]);
+					child.cornerTextureCoords[4 * h + 2] = faceTextureCoords[topology.getFace(h)];
+					child.cornerTextureCoords[4 * h + 3] = 0.5f * (textureCoords[prev] + textureCoords[h]);
+				}
+			});
+
+		child.topology = HalfEdgeMesh::fromPolygons(vertexCount + edgeCount + faceCount, faceSizes, faceVertices, jobSystem);
+
+		// Halves of a parent edge (vertex point to edge point) inherit its sharpness lowered by one
+		child.edgeSharpness.assign(child.topology.getEdgeCount(), 0.0f);
+		for (uint32_t edge = 0; edge < child.edgeSharpness.size(); ++edge)
+		{
+			uint32_t h = child.topology.getEdgeHalfEdge(edge);
+			uint32_t a = child.topology.getOrigin(h), b = child.topology.getTarget(h);
+			uint32_t vertexPoint = std::min(a, b), edgePoint = std::max(a, b);
+
+			if (vertexPoint < vertexCount && edgePoint >= vertexCount && edgePoint < vertexCount + edgeCount)
+			{
+				float s = parent.edgeSharpness[edgePoint - vertexCount];
+				child.edgeSharpness[edge] = (s >= SubdivisionCage::InfiniteSharpness) ? s : std::max(s - 1.0f, 0.0f);
+			}
+		}
+
+		// Compose with the parent stencils, so rows reference cage vertices
+		child.stencils = buildStencils(local.getRowCount(), jobSystem, [&](uint32_t row, std::vector<StencilEntry>& entries)
+			{
+				const StencilTable& composite = parent.stencils;
+
+				for (uint32_t k = local.offsets[row]; k < local.offsets[row + 1]; ++k)
+				{
+					uint32_t source = local.indices[k];
+					for (uint32_t j = composite.offsets[source]; j < composite.offsets[source + 1]; ++j)
+						entries.push_back({ composite.indices[j], local.weights[k] * composite.weights[j] });
+				}
+			});
+
+		return child;
+	}
+
+	// Splits vertices with different texture coordinates per corner and triangulates faces as fans
+	static void buildDrawData(Level& level)
+	{
+		const HalfEdgeMesh& topology = level.topology;
+		size_t halfEdgeCount = topology.getHalfEdgeCount();
+
+		std::vector<uint32_t> corners(halfEdgeCount);
+		for (uint32_t h = 0; h < halfEdgeCount; ++h)
+			corners[h] = h;
+
+		auto key = [&](uint32_t h)
+			{
+				const glm::vec2& uv = level.cornerTextureCoords[h];
+				return std::make_tuple(topology.getOrigin(h), uv.x, uv.y);
+			};
+		std::sort(corners.begin(), corners.end(), [&](uint32_t a, uint32_t b) { return key(a) < key(b); });
+
+		std::vector<uint32_t> cornerDrawVertices(halfEdgeCount);
+		level.drawVertices.clear();
+		level.drawTextureCoords.clear();
+
+		for (size_t i = 0; i < corners.size(); ++i)
+		{
+			if (i == 0 || key(corners[i]) != key(corners[i - 1]))
+			{
+				level.drawVertices.push_back(topology.getOrigin(corners[i]));
+				level.drawTextureCoords.push_back(level.cornerTextureCoords[corners[i]]);
+			}
+			cornerDrawVertices[corners[i]] = static_cast<uint32_t>(level.drawVertices.size() - 1);
+		}
+
+		level.indices.clear();
+		for (uint32_t f = 0; f < topology.getFaceCount(); ++f)
+		{
+			uint32_t first = topology.getFaceHalfEdge(f);
+			for (uint32_t i = 1; i + 1 < topology.getFaceSize(f); ++i)
+			{
+				level.indices.push_back(cornerDrawVertices[first]);
+				level.indices.push_back(cornerDrawVertices[first + i]);
+				level.indices.push_back(cornerDrawVertices[first + i + 1]);
+			}
+		}
+	}
+};
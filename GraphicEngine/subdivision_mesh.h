@@ -0,0 +1,189 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <glad.h>
+#include <glm.hpp>
+
+#include "subdivision.h"
+#include "mesh.h"
+#include "bounds.h"
+#include "shader.h"
+
+// Subdivision surface drawn at the level matching its size on screen. The level is chosen per model from the
+// projected average cage edge length, so the whole surface uses one level and stays crack free. Level changes
+// and cage animation re-evaluate the surface through its stencil tables and upload the new vertices
+class SubdivisionMesh
+{
+private:
+	SubdivisionSurface _surface;
+	std::vector<glm::vec3> _cagePositions;
+	AABB _cageBounds;
+	float _averageEdgeLength = 0.0f;
+
+	float _targetEdgePixels = 8.0f;
+	int _level = -1;
+	bool _isCageDirty = false;
+	std::vector<Vertex> _vertices;
+
+	GLuint _vao = 0;
+	GLuint _vbo = 0;
+	GLuint _ebo = 0;
+	size_t _indexCount = 0;
+
+	glm::mat4 _modelMatrix = glm::mat4(1.0f);
+
+public:
+	SubdivisionMesh() = default;
+
+	~SubdivisionMesh()
+	{
+		release();
+	}
+
+	SubdivisionMesh(const SubdivisionMesh&) = delete;
+	SubdivisionMesh& operator=(const SubdivisionMesh&) = delete;
+
+	bool isValid() const { return _vao != 0; }
+	int getLevel() const { return _level; }
+	int getMaxLevel() const { return _surface.getMaxLevel(); }
+	size_t getTriangleCount() const { return _indexCount / 3; }
+	const std::vector<glm::vec3>& getCagePositions() const { return _cagePositions; }
+
+	// Edge length on screen the selected level aims for, smaller values subdivide more
+	void setTargetEdgeLength(float pixels) { _targetEdgePixels = std::max(pixels, 0.5f); }
+
+	// Loads OBJ cage and builds tables of every level, has to be called on the OpenGL context thread
+	bool open(const std::string& cagePath, JobSystem& jobSystem, int maxLevel = SubdivisionSurface::DefaultMaxLevel)
+	{
+		release();
+
+		SubdivisionCage cage;
+		if (!SubdivisionCage::parseObj(AssetFileSystem::read(cagePath), cagePath, cage))
+			return false;
+
+		if (!_surface.build(cage, &jobSystem, std::max(maxLevel, 0)))
+			return false;
+
+		setCagePositions(cage.positions);
+
+		glGenVertexArrays(1, &_vao);
+		glBindVertexArray(_vao);
+
+		glGenBuffers(1, &_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+
+		glGenBuffers(1, &_ebo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+
+		Vertex::setupAttributes();
+
+		glBindVertexArray(0);
+		return true;
+	}
+
+	// New cage positions (same topology), surface is re-evaluated on next update
+	void setCagePositions(const std::vector<glm::vec3>& positions)
+	{
+		if (positions.size() != _surface.getCageVertexCount())
+			return;
+
+		_cagePositions = positions;
+		_isCageDirty = true;
+
+		_cageBounds = AABB();
+		for (const auto& position : _cagePositions)
+			_cageBounds.expand(position);
+
+		const HalfEdgeMesh& cageTopology = _surface.getTopology(0);
+		float totalLength = 0.0f;
+		for (uint32_t edge = 0; edge < cageTopology.getEdgeCount(); ++edge)
+		{
+			uint32_t h = cageTopology.getEdgeHalfEdge(edge);
+			totalLength += glm::distance(_cagePositions[cageTopology.getOrigin(h)], _cagePositions[cageTopology.getTarget(h)]);
+		}
+		_averageEdgeLength = totalLength / std::max<size_t>(cageTopology.getEdgeCount(), 1);
+	}
+
+	// Picks level for the camera and evaluates the surface when level or cage changed.
+	// projectionScale is viewport height / (2 * tan(fov / 2)), so edge lengths are compared in pixels
+	void update(JobSystem& jobSystem, const glm::mat4& modelMatrix, const glm::vec3& cameraPosition, float projectionScale)
+	{
+		if (!isValid())
+			return;
+
+		_modelMatrix = modelMatrix;
+
+		int level = selectLevel(cameraPosition, projectionScale);
+		if (level == _level && !_isCageDirty)
+			return;
+
+		bool isLevelChanged = level != _level;
+		_level = level;
+		_isCageDirty = false;
+
+		_surface.evaluate(_level, _cagePositions, _vertices, &jobSystem);
+
+		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+		if (isLevelChanged)
+		{
+			const std::vector<uint32_t>& indices = _surface.getIndices(_level);
+			_indexCount = indices.size();
+
+			glBufferData(GL_ARRAY_BUFFER, _vertices.size() * sizeof(Vertex), _vertices.data(), GL_DYNAMIC_DRAW);
+
+			glBindVertexArray(_vao);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+			glBindVertexArray(0);
+		}
+		else
+		{
+			glBufferSubData(GL_ARRAY_BUFFER, 0, _vertices.size() * sizeof(Vertex), _vertices.data());
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void render(const Shader& shader)
+	{
+		if (_indexCount == 0)
+			return;
+
+		shader.use();
+		shader.set("model_matrix", _modelMatrix);
+
+		glBindVertexArray(_vao);
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(_indexCount), GL_UNSIGNED_INT, nullptr);
+		glBindVertexArray(0);
+	}
+
+private:
+	// Every level halves edge lengths, so the level is log2 of projected edge length over the target
+	int selectLevel(const glm::vec3& cameraPosition, float projectionScale) const
+	{
+		glm::vec3 center = glm::vec3(_modelMatrix * glm::vec4(_cageBounds.getCenter(), 1.0f));
+		float maxScale = std::max({ glm::length(glm::vec3(_modelMatrix[0])), glm::length(glm::vec3(_modelMatrix[1])), glm::length(glm::vec3(_modelMatrix[2])) });
+		float radius = glm::length(_cageBounds.getExtents()) * maxScale;
+
+		// Nearest point of the bounding sphere, camera inside gets the finest level
+		float distance = glm::distance(cameraPosition, center) - radius;
+		if (distance <= 1e-3f)
+			return getMaxLevel();
+
+		float pixels = _averageEdgeLength * maxScale * projectionScale / distance;
+		int level = static_cast<int>(std::ceil(std::log2(std::max(pixels / _targetEdgePixels, 1.0f))));
+		return std::clamp(level, 0, getMaxLevel());
+	}
+
+	void release()
+	{
+		if (_vao) glDeleteVertexArrays(1, &_vao);
+		if (_vbo) glDeleteBuffers(1, &_vbo);
+		if (_ebo) glDeleteBuffers(1, &_ebo);
+		_vao = _vbo = _ebo = 0;
+
+		_indexCount = 0;
+		_level = -1;
+	}
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <glm.hpp>
+
+#include "vertex.h"
+
+// Tangent frames for normal mapping with MikkTSpace conventions: face tangents come from texture coordinate
+// derivatives, are projected into the plane of the vertex normal and weighted by corner angle. Corners are
+// accumulated when they share position, normal, texture coordinate and UV winding, so corners with mirrored
+// UVs get their own vertex and the bitangent sign stays constant per vertex. Shaders rebuild the bitangent as
+// sign * cross(normal, tangent) from interpolated (not normalized) vectors
+class TangentSpace
+{
+public:
+	// Fills Vertex::tangent, may append vertices and remap indices where mirrored UVs meet
+	static void generate(std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+	{
+		struct GroupKey
+		{
+			glm::vec3 position;
+			glm::vec3 normal;
+			glm::vec2 textureCoord;
+			uint32_t isMirrored;
+		};
+
+		struct GroupKeyHash
+		{
+			size_t operator()(const GroupKey& key) const { return std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(&key), sizeof(GroupKey))); }
+		};
+
+		struct GroupKeyEqual
+		{
+			bool operator()(const GroupKey& a, const GroupKey& b) const { return std::memcmp(&a, &b, sizeof(GroupKey)) == 0; }
+		};
+
+		size_t cornerCount = indices.size() - indices.size() % 3;
+
+		std::unordered_map<GroupKey, uint32_t, GroupKeyHash, GroupKeyEqual> groupIndices;
+		groupIndices.reserve(vertices.size());
+
+		std::vector<GroupKey> groups;
+		std::vector<glm::vec3> groupTangents;
+		std::vector<uint32_t> cornerGroups(cornerCount);
+
+		for (size_t triangle = 0; triangle < cornerCount; triangle += 3)
+		{
+			const Vertex* corners[3] = { &vertices[indices[triangle]], &vertices[indices[triangle + 1]], &vertices[indices[triangle + 2]] };
+
+			glm::vec3 edge1 = corners[1]->position - corners[0]->position;
+			glm::vec3 edge2 = corners[2]->position - corners[0]->position;
+			glm::vec2 delta1 = corners[1]->textureCoord - corners[0]->textureCoord;
+			glm::vec2 delta2 = corners[2]->textureCoord - corners[0]->textureCoord;
+
+			// Direction of increasing u, flipped with the UV winding (determinant sign)
+			float determinant = delta1.x * delta2.y - delta2.x * delta1.y;
+			bool isMirrored = determinant < 0.0f;
+			glm::vec3 faceTangent = (edge1 * delta2.y - edge2 * delta1.y) * (isMirrored ? -1.0f : 1.0f);
+
+			// Degenerate UVs or triangles add nothing, their vertices get tangents from neighbours or a fallback
+			glm::vec3 faceNormal = glm::cross(edge1, edge2);
+			float longestEdge = std::max({ glm::dot(edge1, edge1), glm::dot(edge2, edge2), glm::dot(edge2 - edge1, edge2 - edge1) });
+			bool isDegenerate = glm::dot(faceNormal, faceNormal) <= 1e-12f * longestEdge * longestEdge;
+			if (determinant == 0.0f || isDegenerate || !std::isfinite(glm::dot(faceTangent, faceTangent)))
+				faceTangent = glm::vec3(0.0f);
+
+			for (int k = 0; k < 3; ++k)
+			{
+				const Vertex& vertex = *corners[k];
+				glm::vec3 normal = safeNormalize(vertex.normal, glm::vec3(0.0f, 0.0f, 1.0f));
+
+				glm::vec3 toNext = safeNormalize(corners[(k + 1) % 3]->position - vertex.position, glm::vec3(0.0f));
+				glm::vec3 toPrev = safeNormalize(corners[(k + 2) % 3]->position - vertex.position, glm::vec3(0.0f));
+				float angle = std::acos(std::clamp(glm::dot(toNext, toPrev), -1.0f, 1.0f));
+
+				glm::vec3 projected = safeNormalize(faceTangent - normal * glm::dot(normal, faceTangent), glm::vec3(0.0f));
+
+				GroupKey key = { vertex.position, vertex.normal, vertex.textureCoord, isMirrored ? 1u : 0u };
+				auto [it, inserted] = groupIndices.try_emplace(key, static_cast<uint32_t>(groups.size()));
+				if (inserted)
+				{
+					groups.push_back(key);
+					groupTangents.push_back(glm::vec3(0.0f));
+				}
+
+				groupTangents[it->second] += projected * angle;
+				cornerGroups[triangle + k] = it->second;
+			}
+		}
+
+		std::vector<uint32_t> packedTangents(groups.size());
+		for (size_t group = 0; group < groups.size(); ++group)
+		{
+			glm::vec3 normal = safeNormalize(groups[group].normal, glm::vec3(0.0f, 0.0f, 1.0f));
+			glm::vec3 tangent = groupTangents[group] - normal * glm::dot(normal, groupTangents[group]);
+
+			// Any direction in the tangent plane when no face had usable UVs
+			glm::vec3 axis = (std::abs(normal.x) < 0.9f) ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			tangent = safeNormalize(tangent, glm::normalize(axis - normal * glm::dot(normal, axis)));
+
+			packedTangents[group] = packTangent(tangent, groups[group].isMirrored ? -1.0f : 1.0f);
+		}
+
+		// Corners of one vertex in different groups (mirrored UVs meeting) get copies of the vertex
+		constexpr uint32_t NoGroup = UINT32_MAX;
+		std::vector<uint32_t> vertexGroups(vertices.size(), NoGroup);
+		std::unordered_map<uint64_t, unsigned> copies;
+
+		for (size_t corner = 0; corner < cornerCount; ++corner)
+		{
+			unsigned vertex = indices[corner];
+			uint32_t group = cornerGroups[corner];
+
+			if (vertexGroups[vertex] == NoGroup)
+			{
+				vertexGroups[vertex] = group;
+				vertices[vertex].tangent = packedTangents[group];
+			}
+			else if (vertexGroups[vertex] != group)
+			{
+				auto [it, inserted] = copies.try_emplace((uint64_t(vertex) << 32) | group, static_cast<unsigned>(vertices.size()));
+				if (inserted)
+				{
+					Vertex copy = vertices[vertex];
+					copy.tangent = packedTangents[group];
+					vertices.push_back(copy);
+				}
+				indices[corner] = it->second;
+			}
+		}
+	}
+
+private:
+	static glm::vec3 safeNormalize(const glm::vec3& vector, const glm::vec3& fallback)
+	{
+		float length = glm::length(vector);
+		return (length > 1e-12f && std::isfinite(length)) ? vector / length : fallback;
+	}
+};
@@ -1,93 +1,425 @@
-#pragma once
-
-#include <string>
-#include <iostream>
-#include <glad.h>
-
-#include "stb_image.h"
-
-class Texture
-{
-private:
-	GLuint _id = 0;
-	GLenum _type = 0;
-
-	int _width = 0;
-	int _height = 0;
-
-public:
-	Texture(const std::string& texturePath, GLenum textureType = GL_TEXTURE_2D)
-	{
-		unsigned char* data = loadImageData(texturePath, _width, _height);
-
-		if (!data)
-		{
-			return;
-		}
-
-		_type = textureType;
-
-		// Create texture and bind it
-		glGenTextures(1, &_id);
-		glBindTexture(_type, _id);
-
-		// Texture wrapping
-		glTexParameteri(_type, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(_type, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-		// Filtering
-		glTexParameteri(_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// Determine format
-		//GLenum format = GL_RGB;
-		//if (nrChannels == 1) format = GL_RED;
-		//else if (nrChannels == 3) format = GL_RGB;
-		//else if (nrChannels == 4) format = GL_RGBA;
-
-		// Upload texture
-		glTexImage2D(_type, 0, GL_RGBA, _width, _height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(_type);
-
-		glBindTexture(_type, 0);
-
-		stbi_image_free(data);
-	}
-
-	~Texture()
-	{
-		if (_id) glDeleteTextures(1, &_id);
-	}
-
-	GLuint getID() const { return _id; }
-
-	GLenum getType() const { return _type; }
-
-	void bind(const GLint textureUnit) const
-	{
-		if (_id && _type)
-		{
-			glActiveTexture(GL_TEXTURE0 + textureUnit);
-			glBindTexture(_type, _id);
-		}
-	}
-
-	void unbind() const
-	{
-		if (_type) glBindTexture(_type, 0);
-	}
-
-private:
-	unsigned char* loadImageData(const std::string& texturePath, int& width, int& height) const
-	{
-		stbi_set_flip_vertically_on_load(true);
-		unsigned char* data = stbi_load(texturePath.c_str(), &width, &height, NULL, STBI_rgb_alpha);
-
-		if (!data)
-		{
-			std::cerr << "Failed to load texture: " << texturePath << "\n";
-		}
-
-		return data;
-	}
-};
\ No newline at end of file
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+#include <glad.h>
+
+#include "stb_image.h"
+#include "asset_pack.h"
+
+// Decoded RGBA8 image, can be loaded on any thread and turned into Texture on the OpenGL context thread
+struct TextureData
+{
+	int width = 0;
+	int height = 0;
+
+	// Level 0 only, unless the whole mip chain was generated
+	std::vector<std::vector<unsigned char>> mips;
+
+	bool isValid() const { return !mips.empty(); }
+
+	static int computeMipCount(int width, int height)
+	{
+		int count = 1;
+		for (int size = std::max(width, height); size > 1; size >>= 1)
+			count++;
+		return count;
+	}
+
+	static TextureData load(const std::string& texturePath, bool buildMipChain = false)
+	{
+		// Asset pack entry or loose file
+		return decode(AssetFileSystem::read(texturePath), texturePath, buildMipChain);
+	}
+
+	// Decode image file already in memory. Rows are flipped to bottom-up order, except for formats whose texture
+	// coordinates have the origin at the top (glTF)
+	static TextureData decode(const AssetBlob& file, const std::string& texturePath, bool buildMipChain = false, bool flipVertically = true)
+	{
+		return decode(file.isValid() ? file.data() : nullptr, file.size(), texturePath, buildMipChain, flipVertically);
+	}
+
+	static TextureData decode(const unsigned char* fileData, size_t fileSize, const std::string& texturePath, bool buildMipChain = false, bool flipVertically = true)
+	{
+		if (fileData && isKTX2(fileData, fileSize))
+		{
+			TextureData textureData = decodeKTX2(fileData, fileSize, texturePath, flipVertically);
+			if (textureData.isValid() && buildMipChain && static_cast<int>(textureData.mips.size()) != computeMipCount(textureData.width, textureData.height))
+			{
+				textureData.mips.resize(1);
+				textureData.generateMipChain();
+			}
+
+			return textureData;
+		}
+
+		TextureData textureData;
+
+		// Thread local flag, loading can run on worker threads
+		stbi_set_flip_vertically_on_load_thread(flipVertically);
+		unsigned char* data = fileData ? stbi_load_from_memory(fileData, static_cast<int>(fileSize), &textureData.width, &textureData.height, NULL, STBI_rgb_alpha) : nullptr;
+
+		if (!data)
+		{
+			std::cerr << "Failed to load texture: " << texturePath << "\n";
+			return textureData;
+		}
+
+		textureData.mips.emplace_back(data, data + size_t(textureData.width) * textureData.height * 4);
+		stbi_image_free(data);
+
+		if (buildMipChain)
+			textureData.generateMipChain();
+
+		return textureData;
+	}
+
+	static bool isKTX2(const unsigned char* data, size_t size)
+	{
+		static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+		return size >= sizeof(identifier) && std::memcmp(data, identifier, sizeof(identifier)) == 0;
+	}
+
+	// KTX2 container with uncompressed 8 bit RGBA or RGB levels, stored mip levels are kept when the chain is complete.
+	// Basis Universal and supercompressed payloads need a transcoder and are rejected
+	static TextureData decodeKTX2(const unsigned char* data, size_t size, const std::string& texturePath, bool flipVertically)
+	{
+		constexpr uint32_t FormatR8G8B8Unorm = 23;
+		constexpr uint32_t FormatR8G8B8Srgb = 29;
+		constexpr uint32_t FormatR8G8B8A8Unorm = 37;
+		constexpr uint32_t FormatR8G8B8A8Srgb = 43;
+		constexpr size_t HeaderSize = 80;
+		constexpr size_t LevelEntrySize = 24;
+
+		TextureData textureData;
+
+		auto read32 = [&](size_t offset) { uint32_t value; std::memcpy(&value, data + offset, sizeof(value)); return value; };
+		auto read64 = [&](size_t offset) { uint64_t value; std::memcpy(&value, data + offset, sizeof(value)); return value; };
+
+		if (size < HeaderSize)
+		{
+			std::cerr << "ERROR::TEXTURE::KTX2_TRUNCATED - " << texturePath << "\n";
+			return textureData;
+		}
+
+		uint32_t format = read32(12);
+		uint32_t width = read32(20);
+		uint32_t height = read32(24);
+		uint32_t depth = read32(28);
+		uint32_t layerCount = read32(32);
+		uint32_t faceCount = read32(36);
+		uint32_t levelCount = std::max(read32(40), 1u);
+		uint32_t supercompression = read32(44);
+
+		if (format == 0 || supercompression != 0)
+		{
+			std::cerr << "ERROR::TEXTURE::KTX2_UNSUPPORTED - " << texturePath << " (Basis Universal or supercompressed data)\n";
+			return textureData;
+		}
+
+		int channels = (format == FormatR8G8B8A8Unorm || format == FormatR8G8B8A8Srgb) ? 4 : ((format == FormatR8G8B8Unorm || format == FormatR8G8B8Srgb) ? 3 : 0);
+		if (channels == 0 || depth > 1 || layerCount > 1 || faceCount != 1 || width == 0 || height == 0 || width > 32768 || height > 32768)
+		{
+			std::cerr << "ERROR::TEXTURE::KTX2_UNSUPPORTED - " << texturePath << " (format " << format << ", only 2D RGBA8 / RGB8)\n";
+			return textureData;
+		}
+
+		if (size < HeaderSize + size_t(levelCount) * LevelEntrySize)
+		{
+			std::cerr << "ERROR::TEXTURE::KTX2_TRUNCATED - " << texturePath << "\n";
+			return textureData;
+		}
+
+		textureData.width = static_cast<int>(width);
+		textureData.height = static_cast<int>(height);
+
+		// Partial chains are not used, the rest is generated from level 0
+		int storedLevels = (static_cast<int>(levelCount) == computeMipCount(textureData.width, textureData.height)) ? static_cast<int>(levelCount) : 1;
+
+		for (int level = 0; level < storedLevels; ++level)
+		{
+			uint64_t offset = read64(HeaderSize + level * LevelEntrySize);
+			uint64_t length = read64(HeaderSize + level * LevelEntrySize + 8);
+
+			size_t mipWidth = std::max<size_t>(1, width >> level);
+			size_t mipHeight = std::max<size_t>(1, height >> level);
+			size_t rowSize = mipWidth * channels;
+
+			if (offset > size || length > size - offset || length < rowSize * mipHeight)
+			{
+				std::cerr << "ERROR::TEXTURE::KTX2_TRUNCATED - " << texturePath << "\n";
+				textureData.mips.clear();
+				return textureData;
+			}
+
+			// Rows are stored top to bottom
+			std::vector<unsigned char>& mip = textureData.mips.emplace_back(mipWidth * mipHeight * 4);
+			for (size_t y = 0; y < mipHeight; ++y)
+			{
+				const unsigned char* sourceRow = data + offset + (flipVertically ? mipHeight - 1 - y : y) * rowSize;
+				unsigned char* targetRow = mip.data() + y * mipWidth * 4;
+
+				if (channels == 4)
+				{
+					std::memcpy(targetRow, sourceRow, rowSize);
+					continue;
+				}
+
+				for (size_t x = 0; x < mipWidth; ++x)
+				{
+					targetRow[x * 4 + 0] = sourceRow[x * 3 + 0];
+					targetRow[x * 4 + 1] = sourceRow[x * 3 + 1];
+					targetRow[x * 4 + 2] = sourceRow[x * 3 + 2];
+					targetRow[x * 4 + 3] = 255;
+				}
+			}
+		}
+
+		return textureData;
+	}
+
+	// Generate all mip levels on CPU with 2x2 box filter
+	void generateMipChain()
+	{
+		int mipCount = computeMipCount(width, height);
+		mips.resize(mipCount);
+
+		for (int level = 1; level < mipCount; ++level)
+		{
+			const std::vector<unsigned char>& source = mips[level - 1];
+			std::vector<unsigned char>& target = mips[level];
+
+			int sourceWidth = std::max(1, width >> (level - 1));
+			int sourceHeight = std::max(1, height >> (level - 1));
+			int mipWidth = std::max(1, width >> level);
+			int mipHeight = std::max(1, height >> level);
+
+			target.resize(size_t(mipWidth) * mipHeight * 4);
+
+			for (int y = 0; y < mipHeight; ++y)
+			{
+				int y0 = std::min(2 * y, sourceHeight - 1);
+				int y1 = std::min(2 * y + 1, sourceHeight - 1);
+
+				for (int x = 0; x < mipWidth; ++x)
+				{
+					int x0 = std::min(2 * x, sourceWidth - 1);
+					int x1 = std::min(2 * x + 1, sourceWidth - 1);
+
+					for (int channel = 0; channel < 4; ++channel)
+					{
+						int sum =
+							source[(y0 * sourceWidth + x0) * 4 + channel] +
+							source[(y0 * sourceWidth + x1) * 4 + channel] +
+							source[(y1 * sourceWidth + x0) * 4 + channel] +
+							source[(y1 * sourceWidth + x1) * 4 + channel];
+
+						target[(y * mipWidth + x) * 4 + channel] = static_cast<unsigned char>((sum + 2) / 4);
+					}
+				}
+			}
+		}
+	}
+};
+
+class Texture
+{
+public:
+	// Mip levels with this size (or smaller) stay resident for the whole lifetime of a streamed texture
+	static constexpr int StreamingMinResidentSize = 64;
+
+private:
+	GLuint _id = 0;
+	GLenum _type = 0;
+
+	int _width = 0;
+	int _height = 0;
+
+	// Mip residency (levels _residentBaseLevel.._mipCount-1 are in GPU memory)
+	int _mipCount = 0;
+	int _residentBaseLevel = 0;
+	int _pinnedBaseLevel = 0;
+
+	// Streamed textures keep CPU copy of every evictable mip level, so it can be streamed in again any time
+	// (pinned levels are never evicted, their copies are released after upload)
+	bool _isStreamed = false;
+	std::vector<std::vector<unsigned char>> _mipChain;
+
+public:
+	Texture(const std::string& texturePath, GLenum textureType = GL_TEXTURE_2D, bool streamed = false)
+		: Texture(TextureData::load(texturePath, streamed && textureType == GL_TEXTURE_2D), textureType, streamed) {
+	}
+
+	// Create texture from already decoded data (has to be called on the OpenGL context thread)
+	Texture(TextureData&& textureData, GLenum textureType = GL_TEXTURE_2D, bool streamed = false)
+	{
+		if (!textureData.isValid())
+		{
+			return;
+		}
+
+		_width = textureData.width;
+		_height = textureData.height;
+		_type = textureType;
+		_mipCount = TextureData::computeMipCount(_width, _height);
+		_isStreamed = streamed && _type == GL_TEXTURE_2D;
+
+		// Create texture and bind it
+		glGenTextures(1, &_id);
+		glBindTexture(_type, _id);
+
+		// Texture wrapping
+		glTexParameteri(_type, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(_type, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		// Filtering
+		glTexParameteri(_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// Determine format
+		//GLenum format = GL_RGB;
+		//if (nrChannels == 1) format = GL_RED;
+		//else if (nrChannels == 3) format = GL_RGB;
+		//else if (nrChannels == 4) format = GL_RGBA;
+
+		if (_isStreamed)
+		{
+			if (static_cast<int>(textureData.mips.size()) != _mipCount)
+				textureData.generateMipChain();
+
+			_mipChain = std::move(textureData.mips);
+
+			// Start with only the small mips resident, finer ones are streamed in on demand
+			_pinnedBaseLevel = _mipCount - 1;
+			while (_pinnedBaseLevel > 0 && std::max(getMipWidth(_pinnedBaseLevel - 1), getMipHeight(_pinnedBaseLevel - 1)) <= StreamingMinResidentSize)
+				_pinnedBaseLevel--;
+
+			_residentBaseLevel = _pinnedBaseLevel;
+			for (int level = _mipCount - 1; level >= _residentBaseLevel; --level)
+			{
+				uploadMip(level);
+				std::vector<unsigned char>().swap(_mipChain[level]);
+			}
+
+			// Sampling is restricted to resident levels only
+			glTexParameteri(_type, GL_TEXTURE_BASE_LEVEL, _residentBaseLevel);
+			glTexParameteri(_type, GL_TEXTURE_MAX_LEVEL, _mipCount - 1);
+		}
+		else if (static_cast<int>(textureData.mips.size()) == _mipCount && _type == GL_TEXTURE_2D)
+		{
+			// Mip chain is already present (cooked texture)
+			for (int level = 0; level < _mipCount; ++level)
+				glTexImage2D(_type, level, GL_RGBA, getMipWidth(level), getMipHeight(level), 0, GL_RGBA, GL_UNSIGNED_BYTE, textureData.mips[level].data());
+		}
+		else
+		{
+			// Upload texture
+			glTexImage2D(_type, 0, GL_RGBA, _width, _height, 0, GL_RGBA, GL_UNSIGNED_BYTE, textureData.mips[0].data());
+			glGenerateMipmap(_type);
+		}
+
+		glBindTexture(_type, 0);
+	}
+
+	~Texture()
+	{
+		if (_id) glDeleteTextures(1, &_id);
+	}
+
+	GLuint getID() const { return _id; }
+
+	GLenum getType() const { return _type; }
+
+	int getWidth() const { return _width; }
+	int getHeight() const { return _height; }
+
+	// Mip residency
+	bool isStreamed() const { return _isStreamed; }
+	int getMipCount() const { return _mipCount; }
+	int getResidentBaseLevel() const { return _residentBaseLevel; }
+	int getPinnedBaseLevel() const { return _pinnedBaseLevel; }
+
+	int getMipWidth(int level) const { return std::max(1, _width >> level); }
+	int getMipHeight(int level) const { return std::max(1, _height >> level); }
+	size_t getMipBytes(int level) const { return size_t(getMipWidth(level)) * getMipHeight(level) * 4; }
+
+	size_t getResidentBytes() const
+	{
+		size_t bytes = 0;
+		for (int level = _residentBaseLevel; level < _mipCount; ++level)
+			bytes += getMipBytes(level);
+		return bytes;
+	}
+
+	// Upload next finer mip level, returns false if texture is already fully resident
+	bool streamInMip()
+	{
+		if (!_isStreamed || _residentBaseLevel == 0)
+			return false;
+
+		int level = _residentBaseLevel - 1;
+
+		glBindTexture(_type, _id);
+		uploadMip(level);
+		glTexParameteri(_type, GL_TEXTURE_BASE_LEVEL, level);
+		glBindTexture(_type, 0);
+
+		_residentBaseLevel = level;
+		return true;
+	}
+
+	// Release finest resident mip level, returns false if only pinned levels are left
+	bool evictMip()
+	{
+		if (!_isStreamed || _residentBaseLevel >= _pinnedBaseLevel)
+			return false;
+
+		int level = _residentBaseLevel;
+
+		// Move base level first so the texture never references a released level
+		glBindTexture(_type, _id);
+		glTexParameteri(_type, GL_TEXTURE_BASE_LEVEL, level + 1);
+		glTexImage2D(_type, level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindTexture(_type, 0);
+
+		_residentBaseLevel = level + 1;
+		return true;
+	}
+
+	void bind(const GLint textureUnit) const
+	{
+		if (_id && _type)
+		{
+			glActiveTexture(GL_TEXTURE0 + textureUnit);
+			glBindTexture(_type, _id);
+		}
+	}
+
+	void unbind() const
+	{
+		if (_type) glBindTexture(_type, 0);
+	}
+
+	// Source channel read by each sampled channel, e.g. to sample one channel of packed metallic-roughness maps as red
+	void setSwizzle(GLint red, GLint green, GLint blue, GLint alpha)
+	{
+		if (!_id)
+			return;
+
+		const GLint swizzle[4] = { red, green, blue, alpha };
+
+		glBindTexture(_type, _id);
+		glTexParameteriv(_type, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+		glBindTexture(_type, 0);
+	}
+
+private:
+	void uploadMip(int level) const
+	{
+		glTexImage2D(_type, level, GL_RGBA, getMipWidth(level), getMipHeight(level), 0, GL_RGBA, GL_UNSIGNED_BYTE, _mipChain[level].data());
+	}
+};
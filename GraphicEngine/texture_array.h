@@ -0,0 +1,399 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <glad.h>
+#include <glm.hpp>
+
+#include "texture.h"
+
+// Skyline bottom-left rectangle packer
+class RectanglePacker
+{
+private:
+	struct SkylineNode
+	{
+		int x = 0;
+		int y = 0;
+		int width = 0;
+	};
+
+	int _width = 0;
+	int _height = 0;
+	std::vector<SkylineNode> _skyline;
+
+public:
+	RectanglePacker(int width, int height)
+		: _width(width), _height(height)
+	{
+		_skyline.push_back({ 0, 0, width });
+	}
+
+	int getWidth() const { return _width; }
+	int getHeight() const { return _height; }
+
+	// Find place for rectangle, returns false if it does not fit anymore
+	bool pack(int width, int height, glm::ivec2& position)
+	{
+		int bestIndex = -1;
+		int bestTop = INT_MAX;
+		int bestWidth = INT_MAX;
+
+		for (size_t i = 0; i < _skyline.size(); ++i)
+		{
+			int y = fitAt(i, width, height);
+			if (y < 0)
+				continue;
+
+			// Prefer lowest top edge, then the narrowest segment
+			if (y + height < bestTop || (y + height == bestTop && _skyline[i].width < bestWidth))
+			{
+				bestIndex = static_cast<int>(i);
+				bestTop = y + height;
+				bestWidth = _skyline[i].width;
+				position = { _skyline[i].x, y };
+			}
+		}
+
+		if (bestIndex < 0)
+			return false;
+
+		addSkylineLevel(bestIndex, position.x, position.y + height, width);
+		return true;
+	}
+
+private:
+	// Returns y where rectangle fits when placed at the start of the node, -1 if it does not
+	int fitAt(size_t index, int width, int height) const
+	{
+		int x = _skyline[index].x;
+		if (x + width > _width)
+			return -1;
+
+		int y = 0;
+		int remaining = width;
+
+		for (size_t i = index; remaining > 0; ++i)
+		{
+			if (i >= _skyline.size())
+				return -1;
+
+			y = std::max(y, _skyline[i].y);
+			if (y + height > _height)
+				return -1;
+
+			remaining -= _skyline[i].width;
+		}
+
+		return y;
+	}
+
+	void addSkylineLevel(int index, int x, int y, int width)
+	{
+		_skyline.insert(_skyline.begin() + index, { x, y, width });
+
+		// Shrink or remove nodes covered by the new one
+		for (size_t i = index + 1; i < _skyline.size(); )
+		{
+			SkylineNode& node = _skyline[i];
+			int previousEnd = _skyline[i - 1].x + _skyline[i - 1].width;
+
+			if (node.x >= previousEnd)
+				break;
+
+			int shrink = previousEnd - node.x;
+			node.x += shrink;
+			node.width -= shrink;
+
+			if (node.width > 0)
+				break;
+
+			_skyline.erase(_skyline.begin() + i);
+		}
+
+		// Merge neighbours with same height
+		for (size_t i = 0; i + 1 < _skyline.size(); )
+		{
+			if (_skyline[i].y == _skyline[i + 1].y)
+			{
+				_skyline[i].width += _skyline[i + 1].width;
+				_skyline.erase(_skyline.begin() + i + 1);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+};
+
+// GL_TEXTURE_2D_ARRAY with immutable RGBA8 storage
+class TextureArray
+{
+private:
+	GLuint _id = 0;
+
+	int _width = 0;
+	int _height = 0;
+	int _layers = 0;
+
+public:
+	TextureArray(int width, int height, int layers)
+		: _width(width), _height(height), _layers(layers)
+	{
+		int mipCount = 1;
+		for (int size = std::max(width, height); size > 1; size >>= 1)
+			mipCount++;
+
+		glGenTextures(1, &_id);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _id);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, mipCount, GL_RGBA8, width, height, layers);
+
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	~TextureArray()
+	{
+		if (_id) glDeleteTextures(1, &_id);
+	}
+
+	TextureArray(const TextureArray&) = delete;
+	TextureArray& operator=(const TextureArray&) = delete;
+
+	GLuint getID() const { return _id; }
+	int getWidth() const { return _width; }
+	int getHeight() const { return _height; }
+	int getLayerCount() const { return _layers; }
+
+	// Upload whole RGBA8 layer (mip 0)
+	void uploadLayer(int layer, const unsigned char* data)
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _id);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, _width, _height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	void generateMipmaps()
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _id);
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	void bind(const GLint textureUnit) const
+	{
+		glActiveTexture(GL_TEXTURE0 + textureUnit);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _id);
+	}
+};
+
+// Location of packed texture: array, layer and sub-rectangle of the layer in UV space
+struct TextureRef
+{
+	int arrayIndex = -1;
+	int layer = 0;
+	glm::vec4 uvRect = { 0.0f, 0.0f, 1.0f, 1.0f };		// xy offset, zw scale
+};
+
+// Groups textures of the same size and format into array layers, small ones are packed into atlas layers
+class TextureArrayBuilder
+{
+public:
+	static constexpr int SmallTextureSize = 256;
+	static constexpr int AtlasPageSize = 1024;
+	static constexpr int AtlasPadding = 4;
+
+private:
+	struct Image
+	{
+		std::string path;
+		int width = 0;
+		int height = 0;
+		GLenum format = GL_RGBA8;
+		std::vector<unsigned char> pixels;
+	};
+
+	std::vector<Image> _images;
+	std::vector<TextureRef> _refs;
+	std::vector<std::unique_ptr<TextureArray>> _arrays;
+
+public:
+	TextureArrayBuilder() = default;
+
+	// Queue texture for packing, returns texture id used to look up its TextureRef (-1 on failure)
+	int add(const std::string& texturePath)
+	{
+		Image image;
+		image.path = texturePath;
+
+		stbi_set_flip_vertically_on_load(true);
+		unsigned char* data = stbi_load(texturePath.c_str(), &image.width, &image.height, NULL, STBI_rgb_alpha);
+
+		if (!data)
+		{
+			std::cerr << "Failed to load texture: " << texturePath << "\n";
+			return -1;
+		}
+
+		image.pixels.assign(data, data + size_t(image.width) * image.height * 4);
+		stbi_image_free(data);
+
+		_images.push_back(std::move(image));
+		return static_cast<int>(_images.size() - 1);
+	}
+
+	// Create texture arrays and resolve references (call once), CPU images are released afterwards
+	void build()
+	{
+		if (!_arrays.empty())
+			return;
+
+		GLint maxLayers = 256;
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+		maxLayers = std::max(maxLayers, 1);
+
+		_refs.assign(_images.size(), TextureRef());
+
+		// Large textures are grouped by size and format, each one gets own layer
+		std::map<std::tuple<int, int, GLenum>, std::vector<size_t>> groups;
+		std::vector<size_t> smallImages;
+
+		for (size_t i = 0; i < _images.size(); ++i)
+		{
+			const Image& image = _images[i];
+			if (image.width <= SmallTextureSize && image.height <= SmallTextureSize)
+				smallImages.push_back(i);
+			else
+				groups[{ image.width, image.height, image.format }].push_back(i);
+		}
+
+		for (const auto& [key, members] : groups)
+		{
+			for (size_t first = 0; first < members.size(); first += maxLayers)
+			{
+				size_t count = std::min(members.size() - first, size_t(maxLayers));
+				auto textureArray = std::make_unique<TextureArray>(std::get<0>(key), std::get<1>(key), static_cast<int>(count));
+
+				for (size_t layer = 0; layer < count; ++layer)
+				{
+					size_t imageIndex = members[first + layer];
+					textureArray->uploadLayer(static_cast<int>(layer), _images[imageIndex].pixels.data());
+					_refs[imageIndex] = { static_cast<int>(_arrays.size()), static_cast<int>(layer) };
+				}
+
+				textureArray->generateMipmaps();
+				_arrays.push_back(std::move(textureArray));
+			}
+		}
+
+		if (!smallImages.empty())
+			buildAtlas(smallImages, maxLayers);
+
+		for (auto& image : _images)
+			image.pixels = {};
+	}
+
+	const TextureRef& getRef(int textureId) const
+	{
+		static const TextureRef empty;
+		return (textureId >= 0 && textureId < static_cast<int>(_refs.size())) ? _refs[textureId] : empty;
+	}
+
+	const std::vector<std::unique_ptr<TextureArray>>& getArrays() const { return _arrays; }
+
+private:
+	void buildAtlas(std::vector<size_t>& imageIndices, int maxLayers)
+	{
+		// Tallest first gives better skyline packing
+		std::sort(imageIndices.begin(), imageIndices.end(), [this](size_t a, size_t b)
+			{
+				return _images[a].height > _images[b].height;
+			});
+
+		std::vector<RectanglePacker> pages;
+		std::vector<std::vector<unsigned char>> pagePixels;
+		std::vector<std::pair<int, size_t>> placements;		// page, image
+
+		int arrayIndex = static_cast<int>(_arrays.size());
+		float pageSize = static_cast<float>(AtlasPageSize);
+
+		for (size_t imageIndex : imageIndices)
+		{
+			const Image& image = _images[imageIndex];
+			int paddedWidth = image.width + 2 * AtlasPadding;
+			int paddedHeight = image.height + 2 * AtlasPadding;
+
+			glm::ivec2 position;
+			int page = 0;
+			while (page < static_cast<int>(pages.size()) && !pages[page].pack(paddedWidth, paddedHeight, position))
+				page++;
+
+			if (page == static_cast<int>(pages.size()))
+			{
+				if (page >= maxLayers)
+				{
+					std::cerr << "ERROR::TEXTURE_ARRAY::ATLAS_FULL - " << image.path << "\n";
+					continue;
+				}
+
+				pages.emplace_back(AtlasPageSize, AtlasPageSize);
+				pagePixels.emplace_back(size_t(AtlasPageSize) * AtlasPageSize * 4, 0);
+				pages.back().pack(paddedWidth, paddedHeight, position);
+			}
+
+			blitPadded(image, pagePixels[page], position.x, position.y);
+
+			_refs[imageIndex] =
+			{
+				arrayIndex,
+				page,
+				{
+					(position.x + AtlasPadding) / pageSize,
+					(position.y + AtlasPadding) / pageSize,
+					image.width / pageSize,
+					image.height / pageSize
+				}
+			};
+		}
+
+		if (pages.empty())
+			return;
+
+		auto atlas = std::make_unique<TextureArray>(AtlasPageSize, AtlasPageSize, static_cast<int>(pages.size()));
+		for (size_t page = 0; page < pages.size(); ++page)
+			atlas->uploadLayer(static_cast<int>(page), pagePixels[page].data());
+
+		atlas->generateMipmaps();
+		_arrays.push_back(std::move(atlas));
+	}
+
+	// Copy image into page with its border pixels repeated into the padding (reduces bleeding between entries)
+	static void blitPadded(const Image& image, std::vector<unsigned char>& page, int pageX, int pageY)
+	{
+		for (int y = -AtlasPadding; y < image.height + AtlasPadding; ++y)
+		{
+			int sourceY = glm::clamp(y, 0, image.height - 1);
+
+			for (int x = -AtlasPadding; x < image.width + AtlasPadding; ++x)
+			{
+				int sourceX = glm::clamp(x, 0, image.width - 1);
+
+				const unsigned char* source = &image.pixels[(size_t(sourceY) * image.width + sourceX) * 4];
+				unsigned char* target = &page[(size_t(pageY + AtlasPadding + y) * AtlasPageSize + (pageX + AtlasPadding + x)) * 4];
+
+				std::copy(source, source + 4, target);
+			}
+		}
+	}
+};
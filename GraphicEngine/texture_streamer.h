@@ -0,0 +1,265 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+
+#include "texture.h"
+#include "mesh.h"
+#include "camera.h"
+
+struct TextureStreamingStats
+{
+	size_t textureCount = 0;
+	size_t pendingCount = 0;		// Textures still coarser than requested
+	size_t residentBytes = 0;
+	size_t budgetBytes = 0;
+	size_t uploadedBytes = 0;		// During last update
+	size_t evictedBytes = 0;		// During last update
+};
+
+class TextureStreamer
+{
+private:
+	struct Entry
+	{
+		Texture* texture = nullptr;
+		float requestedLevel = FLT_MAX;		// Finest mip level requested this frame
+		uint64_t lastRequestFrame = 0;
+	};
+
+	std::vector<Entry> _entries;
+	std::unordered_map<const Texture*, size_t> _lookup;
+
+	size_t _budgetBytes = 0;
+	size_t _uploadBytesPerFrame = 0;
+	float _mipBias = 0.0f;
+	uint64_t _frame = 0;
+
+	TextureStreamingStats _stats;
+
+public:
+	explicit TextureStreamer(size_t budgetBytes = 256ull * 1024 * 1024, size_t uploadBytesPerFrame = 16ull * 1024 * 1024)
+		: _budgetBytes(budgetBytes), _uploadBytesPerFrame(uploadBytesPerFrame) {
+	}
+
+	// Settings
+	void setBudget(size_t budgetBytes) { _budgetBytes = budgetBytes; }
+	void setUploadLimit(size_t uploadBytesPerFrame) { _uploadBytesPerFrame = uploadBytesPerFrame; }
+	void setMipBias(float bias) { _mipBias = bias; }
+
+	const TextureStreamingStats& getStats() const { return _stats; }
+
+	// Register streamed texture (fully resident textures are ignored)
+	void add(Texture* texture)
+	{
+		if (!texture || !texture->isStreamed() || _lookup.count(texture))
+			return;
+
+		_lookup[texture] = _entries.size();
+		_entries.push_back({ texture });
+	}
+
+	void remove(const Texture* texture)
+	{
+		auto it = _lookup.find(texture);
+		if (it == _lookup.end())
+			return;
+
+		// Swap with last entry to keep the array dense
+		size_t index = it->second;
+		_lookup.erase(it);
+
+		if (index != _entries.size() - 1)
+		{
+			_entries[index] = _entries.back();
+			_lookup[_entries[index].texture] = index;
+		}
+
+		_entries.pop_back();
+	}
+
+	// Reset requests, must be called before any request of the frame
+	void beginFrame()
+	{
+		_frame++;
+
+		for (auto& entry : _entries)
+			entry.requestedLevel = FLT_MAX;
+	}
+
+	// Ask for the texture to be resident at least up to given mip level this frame
+	void request(const Texture* texture, float mipLevel)
+	{
+		auto it = _lookup.find(texture);
+		if (it == _lookup.end())
+			return;
+
+		Entry& entry = _entries[it->second];
+		entry.requestedLevel = std::min(entry.requestedLevel, mipLevel);
+		entry.lastRequestFrame = _frame;
+	}
+
+	// Request every texture of the material for the mesh seen from the camera
+	template<typename MaterialT>
+	void requestMaterial(const MaterialT& material, const Mesh& mesh, const Camera& camera, float viewportHeight)
+	{
+		for (const Texture* texture : material.getTextures())
+		{
+			if (texture)
+				request(texture, estimateMipLevel(mesh, camera, viewportHeight, std::max(texture->getWidth(), texture->getHeight())));
+		}
+	}
+
+	// Mip level where one texel covers roughly one pixel at the nearest point of the mesh
+	static float estimateMipLevel(const Mesh& mesh, const Camera& camera, float viewportHeight, int textureSize)
+	{
+		if (textureSize <= 0 || viewportHeight <= 0.0f)
+			return 0.0f;
+
+		BoundingSphere sphere = mesh.getWorldBoundingSphere();
+		float distance = glm::max(glm::length(sphere.center - camera.Position) - sphere.radius, camera.NearPlane);
+
+		// Pixels covered by one world unit at that distance
+		float pixelsPerWorldUnit = viewportHeight / (2.0f * distance * glm::tan(glm::radians(camera.Zoom) * 0.5f));
+
+		// Texels covered by one world unit of the surface (least stretched axis wins)
+		glm::vec3 worldScale = mesh.getWorldScale();
+		float minScale = glm::max(glm::min(worldScale.x, glm::min(worldScale.y, worldScale.z)), 1e-6f);
+		float texelsPerWorldUnit = textureSize / (mesh.getWorldUnitsPerUV() * minScale);
+
+		return glm::max(0.0f, glm::log2(texelsPerWorldUnit / pixelsPerWorldUnit));
+	}
+
+	// Stream in requested mips and evict unused ones to stay within budget
+	void update()
+	{
+		_stats.uploadedBytes = 0;
+		_stats.evictedBytes = 0;
+
+		size_t residentBytes = 0;
+		for (const auto& entry : _entries)
+			residentBytes += entry.texture->getResidentBytes();
+
+		// Textures with the biggest difference between wanted and resident level go first
+		std::vector<size_t> pending;
+		for (size_t i = 0; i < _entries.size(); ++i)
+		{
+			if (getWantedLevel(_entries[i]) < _entries[i].texture->getResidentBaseLevel())
+				pending.push_back(i);
+		}
+
+		std::sort(pending.begin(), pending.end(), [this](size_t a, size_t b)
+			{
+				int deficitA = _entries[a].texture->getResidentBaseLevel() - getWantedLevel(_entries[a]);
+				int deficitB = _entries[b].texture->getResidentBaseLevel() - getWantedLevel(_entries[b]);
+				return deficitA > deficitB;
+			});
+
+		size_t pendingCount = 0;
+
+		for (size_t index : pending)
+		{
+			Texture* texture = _entries[index].texture;
+			int wantedLevel = getWantedLevel(_entries[index]);
+
+			while (texture->getResidentBaseLevel() > wantedLevel)
+			{
+				size_t bytes = texture->getMipBytes(texture->getResidentBaseLevel() - 1);
+
+				// Always allow at least one upload, so a single big mip cannot stall streaming forever
+				if (_stats.uploadedBytes > 0 && _stats.uploadedBytes + bytes > _uploadBytesPerFrame)
+					break;
+
+				if (residentBytes + bytes > _budgetBytes && !evict(residentBytes + bytes - _budgetBytes, residentBytes))
+					break;
+
+				texture->streamInMip();
+				residentBytes += bytes;
+				_stats.uploadedBytes += bytes;
+			}
+
+			if (texture->getResidentBaseLevel() > wantedLevel)
+				pendingCount++;
+		}
+
+		// Budget could have been lowered in the meantime
+		if (residentBytes > _budgetBytes)
+			evict(residentBytes - _budgetBytes, residentBytes);
+
+		_stats.textureCount = _entries.size();
+		_stats.pendingCount = pendingCount;
+		_stats.residentBytes = residentBytes;
+		_stats.budgetBytes = _budgetBytes;
+	}
+
+private:
+	int getWantedLevel(const Entry& entry) const
+	{
+		int pinnedLevel = entry.texture->getPinnedBaseLevel();
+
+		// Not requested this frame, finer mips are kept only as cache
+		if (entry.requestedLevel == FLT_MAX)
+			return pinnedLevel;
+
+		int level = static_cast<int>(glm::floor(entry.requestedLevel + _mipBias));
+		return glm::clamp(level, 0, pinnedLevel);
+	}
+
+	// Evict mips that are finer than wanted, least recently requested textures first.
+	// All or nothing: nothing is released unless enough bytes can be freed, so a failed request does not leave textures half evicted
+	bool evict(size_t bytesNeeded, size_t& residentBytes)
+	{
+		std::vector<size_t> candidates;
+		for (size_t i = 0; i < _entries.size(); ++i)
+		{
+			if (_entries[i].texture->getResidentBaseLevel() < getWantedLevel(_entries[i]))
+				candidates.push_back(i);
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [this](size_t a, size_t b)
+			{
+				return _entries[a].lastRequestFrame < _entries[b].lastRequestFrame;
+			});
+
+		// Plan new base level of every candidate first
+		std::vector<std::pair<Texture*, int>> plan;
+		size_t freedBytes = 0;
+
+		for (size_t index : candidates)
+		{
+			if (freedBytes >= bytesNeeded)
+				break;
+
+			Texture* texture = _entries[index].texture;
+			int wantedLevel = getWantedLevel(_entries[index]);
+			int level = texture->getResidentBaseLevel();
+
+			while (freedBytes < bytesNeeded && level < wantedLevel)
+				freedBytes += texture->getMipBytes(level++);
+
+			plan.push_back({ texture, level });
+		}
+
+		if (freedBytes < bytesNeeded)
+			return false;
+
+		// Commit
+		for (const auto& [texture, level] : plan)
+		{
+			while (texture->getResidentBaseLevel() < level)
+			{
+				size_t bytes = texture->getMipBytes(texture->getResidentBaseLevel());
+				texture->evictMip();
+
+				residentBytes -= bytes;
+				_stats.evictedBytes += bytes;
+			}
+		}
+
+		return true;
+	}
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+
+// Fixed set of worker threads executing queued tasks in FIFO order
+class ThreadPool
+{
+private:
+	std::vector<std::thread> _workers;
+	std::deque<std::function<void()>> _tasks;
+
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _isStopping = false;
+
+public:
+	explicit ThreadPool(unsigned threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1)
+	{
+		for (unsigned i = 0; i < std::max(1u, threadCount); ++i)
+			_workers.emplace_back([this]() { workerLoop(); });
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_isStopping = true;
+		}
+
+		_condition.notify_all();
+
+		for (auto& worker : _workers)
+			worker.join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	size_t getThreadCount() const { return _workers.size(); }
+
+	void submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_tasks.push_back(std::move(task));
+		}
+
+		_condition.notify_one();
+	}
+
+private:
+	void workerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_condition.wait(lock, [this]() { return _isStopping || !_tasks.empty(); });
+
+				// Finish queued work before stopping
+				if (_tasks.empty())
+					return;
+
+				task = std::move(_tasks.front());
+				_tasks.pop_front();
+			}
+
+			task();
+		}
+	}
+};
+
+// Tasks that have to run on the thread owning the OpenGL context (e.g. creation of GL objects)
+class GLTaskQueue
+{
+private:
+	std::deque<std::function<void()>> _tasks;
+	std::mutex _mutex;
+	std::thread::id _contextThread = std::this_thread::get_id();
+
+public:
+	void setContextThread(std::thread::id threadId) { _contextThread = threadId; }
+	bool isContextThread() const { return std::this_thread::get_id() == _contextThread; }
+
+	void push(std::function<void()> task)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_tasks.push_back(std::move(task));
+	}
+
+	// Run queued tasks on the context thread, returns number of executed tasks
+	size_t execute(size_t maxTasks = SIZE_MAX)
+	{
+		size_t executed = 0;
+
+		while (executed < maxTasks)
+		{
+			std::function<void()> task;
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (_tasks.empty())
+					break;
+
+				task = std::move(_tasks.front());
+				_tasks.pop_front();
+			}
+
+			task();
+			executed++;
+		}
+
+		return executed;
+	}
+};
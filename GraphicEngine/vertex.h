@@ -1 +1,39 @@
-#pragma once
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <glm.hpp>
+
+struct Vertex
+{
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec3 color;
+	glm::vec2 textureCoord;
+	uint32_t tangent = 0;		// Packed by packTangent, zero when the mesh has no tangent space
+
+	// Attribute layout of the bound VAO for Vertex data in the bound array buffer, shared by every mesh type.
+	// Defined in mesh.h, so this header stays usable without OpenGL
+	static inline void setupAttributes();
+};
+
+// Unit tangent in 10 bits per axis and bitangent sign in 2 bits (GL_INT_2_10_10_10_REV, normalized).
+// Bitangent is sign * cross(normal, tangent)
+inline uint32_t packTangent(const glm::vec3& tangent, float sign)
+{
+	auto pack = [](float value) { return static_cast<uint32_t>(static_cast<int32_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 511.0f))) & 0x3FFu; };
+	return pack(tangent.x) | (pack(tangent.y) << 10) | (pack(tangent.z) << 20) | ((sign < 0.0f ? 0x3u : 0x1u) << 30);
+}
+
+// xyz = tangent, w = bitangent sign
+inline glm::vec4 unpackTangent(uint32_t packed)
+{
+	auto unpack = [](uint32_t bits, int width)
+		{
+			int32_t value = static_cast<int32_t>(bits << (32 - width)) >> (32 - width);
+			return std::max(static_cast<float>(value) / ((1 << (width - 1)) - 1), -1.0f);
+		};
+
+	return { unpack(packed & 0x3FFu, 10), unpack((packed >> 10) & 0x3FFu, 10), unpack((packed >> 20) & 0x3FFu, 10), unpack(packed >> 30, 2) };
+}